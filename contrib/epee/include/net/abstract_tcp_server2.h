@@ -61,6 +61,8 @@
 #define MONERO_DEFAULT_LOG_CATEGORY "net"
 
 #define ABSTRACT_SERVER_SEND_QUE_MAX_COUNT 1000
+#define ABSTRACT_SERVER_SEND_GATHER_MAX_COUNT 64
+#define ABSTRACT_SERVER_SEND_GATHER_MAX_BYTES (256 * 1024)
 
 namespace epee
 {
@@ -157,6 +159,12 @@ namespace net_utils
     /// Handle completion of a write operation.
     void handle_write(const boost::system::error_code& e, size_t cb);
 
+    /// Write the front of m_send_que in one gathered write, deferred by the upload limit if needed. m_send_que_lock must be held.
+    void start_write();
+
+    /// Request the next read, deferred by `delay` seconds for the download limit.
+    void start_read(double delay);
+
     /// reset connection timeout timer and callback
     void reset_timer(boost::posix_time::milliseconds ms, bool add);
     boost::posix_time::milliseconds get_default_timeout();
@@ -179,6 +187,7 @@ namespace net_utils
     boost::shared_ptr<connection<t_protocol_handler> > m_self_ref; // the reference to hold
     critical_section m_self_refs_lock;
     critical_section m_chunking_lock; // held while we add small chunks of the big do_send() to small do_send_chunk()
+    size_t m_send_que_writing = 0; // slices at the front of m_send_que that the current write sends, guarded by m_send_que_lock
     critical_section m_shutdown_lock; // held while shutting down
     
     t_connection_type m_connection_type;
@@ -190,6 +199,8 @@ namespace net_utils
     boost::mutex m_throttle_speed_out_mutex;
 
     boost::asio::deadline_timer m_timer;
+    boost::asio::deadline_timer m_throttle_timer_in; // defers reads past the download limit
+    boost::asio::deadline_timer m_throttle_timer_out; // defers writes past the upload limit
     bool m_local;
     bool m_ready_to_close;
     std::string m_host;
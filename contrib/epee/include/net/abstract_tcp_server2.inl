@@ -105,6 +105,8 @@ PRAGMA_WARNING_DISABLE_VS(4355)
 		m_throttle_speed_in("speed_in", "throttle_speed_in"),
 		m_throttle_speed_out("speed_out", "throttle_speed_out"),
 		m_timer(GET_IO_SERVICE(socket_)),
+		m_throttle_timer_in(GET_IO_SERVICE(socket_)),
+		m_throttle_timer_out(GET_IO_SERVICE(socket_)),
 		m_local(false),
 		m_ready_to_close(false)
   {
@@ -351,29 +353,10 @@ PRAGMA_WARNING_DISABLE_VS(4355)
 			epee::net_utils::network_throttle_manager::network_throttle_manager::get_global_throttle_in().handle_trafic_exact(bytes_transferred);
 		}
 
-		double delay=0; // will be calculated - how much we should sleep to obey speed limit etc
-
-
-		if (speed_limit_is_enabled()) {
-			do // keep sleeping if we should sleep
-			{
-				{ //_scope_dbg1("CRITICAL_REGION_LOCAL");
-					CRITICAL_REGION_LOCAL(	epee::net_utils::network_throttle_manager::m_lock_get_global_throttle_in );
-					delay = epee::net_utils::network_throttle_manager::get_global_throttle_in().get_sleep_time_after_tick( bytes_transferred );
-				}
-
-				if (m_was_shutdown)
-					return;
-				
-				delay *= 0.5;
-				long int ms = (long int)(delay * 100);
-				if (ms > 0) {
-					reset_timer(boost::posix_time::milliseconds(ms + 1), true);
-					boost::this_thread::sleep_for(boost::chrono::milliseconds(ms));
-				}
-			} while(delay > 0);
-		} // any form of sleeping
-		
+		double delay=0; // how long to hold off the next read to obey the download limit
+		if (speed_limit_is_enabled())
+			delay = reserve_recv(bytes_transferred);
+
       //_info("[sock " << socket().native_handle() << "] RECV " << bytes_transferred);
       logger_handle_net_read(bytes_transferred);
       context.m_last_recv = time(NULL);
@@ -395,12 +378,7 @@ PRAGMA_WARNING_DISABLE_VS(4355)
       }else
       {
         reset_timer(get_timeout_from_bytes_read(bytes_transferred), false);
-        async_read_some(boost::asio::buffer(buffer_),
-          strand_.wrap(
-            boost::bind(&connection<t_protocol_handler>::handle_read, connection<t_protocol_handler>::shared_from_this(),
-              boost::asio::placeholders::error,
-              boost::asio::placeholders::bytes_transferred)));
-        //_info("[sock " << socket().native_handle() << "]Async read requested.");
+        start_read(delay);
       }
     }else
     {
@@ -692,16 +670,8 @@ PRAGMA_WARNING_DISABLE_VS(4355)
 
         auto size_now = m_send_que.front().size();
         MDEBUG("do_send_chunk() NOW SENSD: packet="<<size_now<<" B");
-        if (speed_limit_is_enabled())
-			do_send_handler_write( m_send_que.back().data(), m_send_que.back().size() ); // (((H)))
-
-        CHECK_AND_ASSERT_MES( size_now == m_send_que.front().size(), false, "Unexpected queue size");
         reset_timer(get_default_timeout(), false);
-            async_write(boost::asio::buffer(m_send_que.front().data(), size_now ) ,
-                                 strand_.wrap(
-                                 std::bind(&connection<t_protocol_handler>::handle_write, self, std::placeholders::_1, std::placeholders::_2)
-                                 )
-                                 );
+        start_write();
         //_dbg3("(chunk): " << size_now);
         //logger_handle_net_write(size_now);
         //_info("[sock " << socket().native_handle() << "] Async send requested " << m_send_que.front().size());
@@ -803,6 +773,8 @@ PRAGMA_WARNING_DISABLE_VS(4355)
     m_was_shutdown = true;
     // Initiate graceful connection closure.
     m_timer.cancel();
+    m_throttle_timer_in.cancel();
+    m_throttle_timer_out.cancel();
     boost::system::error_code ignored_ec;
     if (m_ssl_support == epee::net_utils::ssl_support_t::e_ssl_support_enabled)
     {
@@ -873,11 +845,6 @@ PRAGMA_WARNING_DISABLE_VS(4355)
     }
     logger_handle_net_write(cb);
 
-                // The single sleeping that is needed for correctly handling "out" speed throttling
-		if (speed_limit_is_enabled()) {
-			sleep_before_packet(cb, 1, 1);
-		}
-
     bool do_shutdown = false;
     CRITICAL_REGION_BEGIN(m_send_que_lock);
     if(m_send_que.empty())
@@ -886,7 +853,9 @@ PRAGMA_WARNING_DISABLE_VS(4355)
       return;
     }
 
-    m_send_que.pop_front();
+    CHECK_AND_ASSERT_MES(m_send_que_writing <= m_send_que.size(), void(), "Unexpected send queue size");
+    m_send_que.erase(m_send_que.begin(), m_send_que.begin() + m_send_que_writing);
+    m_send_que_writing = 0;
     if(m_send_que.empty())
     {
       if(boost::interprocess::ipcdetail::atomic_read32(&m_want_close_connection))
@@ -897,17 +866,8 @@ PRAGMA_WARNING_DISABLE_VS(4355)
     {
       //have more data to send
 		reset_timer(get_default_timeout(), false);
-		auto size_now = m_send_que.front().size();
-		MDEBUG("handle_write() NOW SENDS: packet="<<size_now<<" B" <<", from  queue size="<<m_send_que.size());
-		if (speed_limit_is_enabled())
-			do_send_handler_write_from_queue(e, m_send_que.front().size() , m_send_que.size()); // (((H)))
-		CHECK_AND_ASSERT_MES( size_now == m_send_que.front().size(), void(), "Unexpected queue size");
-		  async_write(boost::asio::buffer(m_send_que.front().data(), size_now) , 
-           strand_.wrap(
-            std::bind(&connection<t_protocol_handler>::handle_write, connection<t_protocol_handler>::shared_from_this(), std::placeholders::_1, std::placeholders::_2)
-			  )
-          );
-      //_dbg3("(normal)" << size_now);
+		MDEBUG("handle_write() NOW SENDS: from  queue size="<<m_send_que.size());
+		start_write();
     }
     CRITICAL_REGION_END();
 
@@ -918,6 +878,92 @@ PRAGMA_WARNING_DISABLE_VS(4355)
     CATCH_ENTRY_L0("connection<t_protocol_handler>::handle_write", void());
   }
 
+  //---------------------------------------------------------------------------------
+  // Each connection holds at most one reservation of the global limit at a time (its next write),
+  // and the limit hands out time in the order it was asked, so throttled connections take turns
+  // instead of sleeping on the io_service threads they share with everybody else.
+  //
+  // Whatever was queued while the previous write was in flight (chunks of a big message, or the
+  // small notifications relayed to this peer meanwhile) goes out in a single gathered write, so a
+  // busy connection costs one syscall and one lock round per batch rather than per message.
+  template<class t_protocol_handler>
+  void connection<t_protocol_handler>::start_write()
+  {
+    auto self = connection<t_protocol_handler>::shared_from_this();
+    std::vector<boost::asio::const_buffer> buffers;
+    size_t size_now = 0;
+    for (const byte_slice& slice : m_send_que)
+    {
+      if (!buffers.empty() && (buffers.size() >= ABSTRACT_SERVER_SEND_GATHER_MAX_COUNT || size_now + slice.size() > ABSTRACT_SERVER_SEND_GATHER_MAX_BYTES))
+        break;
+      buffers.emplace_back(slice.data(), slice.size());
+      size_now += slice.size();
+    }
+    m_send_que_writing = buffers.size();
+
+    if (speed_limit_is_enabled())
+      do_send_handler_write_from_queue(boost::system::error_code(), size_now, m_send_que.size()); // (((H)))
+
+    // byte_slice storage does not move with the slice, and the slices stay queued until handle_write
+    const auto write = [this, self, buffers]()
+    {
+      async_write(buffers,
+        strand_.wrap(
+          std::bind(&connection<t_protocol_handler>::handle_write, self, std::placeholders::_1, std::placeholders::_2)
+        )
+      );
+    };
+
+    const double delay = speed_limit_is_enabled() ? reserve_send(size_now) : 0;
+    const long int ms = (long int)(delay * 1000);
+    if (ms <= 0)
+    {
+      write();
+      return;
+    }
+
+    MTRACE("Deferring write of packet_size=" << size_now << " for " << ms << " ms");
+    reset_timer(boost::posix_time::milliseconds(ms), true);
+    m_throttle_timer_out.expires_from_now(boost::posix_time::milliseconds(ms));
+    m_throttle_timer_out.async_wait(strand_.wrap([this, self, write](const boost::system::error_code& ec)
+    {
+      if (ec || m_was_shutdown)
+        return;
+      CRITICAL_REGION_LOCAL(m_send_que_lock);
+      if (!m_send_que.empty())
+        write();
+    }));
+  }
+  //---------------------------------------------------------------------------------
+  template<class t_protocol_handler>
+  void connection<t_protocol_handler>::start_read(const double delay)
+  {
+    auto self = connection<t_protocol_handler>::shared_from_this();
+    const auto read = [this, self]()
+    {
+      async_read_some(boost::asio::buffer(buffer_),
+        strand_.wrap(
+          boost::bind(&connection<t_protocol_handler>::handle_read, self,
+            boost::asio::placeholders::error,
+            boost::asio::placeholders::bytes_transferred)));
+    };
+
+    const long int ms = (long int)(delay * 1000);
+    if (ms <= 0)
+    {
+      read();
+      return;
+    }
+
+    MTRACE("Deferring read for " << ms << " ms");
+    reset_timer(boost::posix_time::milliseconds(ms), true);
+    m_throttle_timer_in.expires_from_now(boost::posix_time::milliseconds(ms));
+    m_throttle_timer_in.async_wait(strand_.wrap([this, self, read](const boost::system::error_code& ec)
+    {
+      if (!ec && !m_was_shutdown)
+        read();
+    }));
+  }
   //---------------------------------------------------------------------------------
   template<class t_protocol_handler>
   void connection<t_protocol_handler>::setRpcStation()
@@ -183,8 +183,9 @@ class connection_basic { // not-templated base class for rapid developmet of som
 		static void set_tos_flag(int tos); // ToS / QoS flag
 		static int get_tos_flag();
 
-		// handlers and sleep
-		void sleep_before_packet(size_t packet_size, int phase, int q_len); // execute a sleep ; phase is not really used now(?)
+		// rate limiting - these never sleep, the caller defers the transfer instead
+		static double reserve_send(size_t packet_size); ///< count packet_size bytes against the global upload limit, \return seconds to wait before writing them
+		static double reserve_recv(size_t packet_size); ///< count received bytes against the global download limit, \return seconds to wait before reading more
 		static void save_limit_to_file(int limit); ///< for dr-monero
 		static double get_sleep_time(size_t cb);
 };
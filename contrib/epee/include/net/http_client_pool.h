@@ -0,0 +1,125 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <boost/optional/optional.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "net/abstract_http_client.h"
+
+namespace epee
+{
+namespace net_utils
+{
+namespace http
+{
+  /*! \brief Connections to one HTTP server, handed out one request at a time
+      so that several requests can be in flight together.
+
+      Every client handed out has the server, login, SSL and proxy settings
+      last given to the pool. Clients go back to the pool when their `lease`
+      is destroyed and keep their connection open for the next request;
+      changing the settings drops them instead. */
+  class client_pool
+  {
+  public:
+    //! Exclusive use of one pooled client, returned to the pool on destruction.
+    class lease
+    {
+      friend class client_pool;
+
+      client_pool* pool_;
+      std::unique_ptr<abstract_http_client> client_;
+      std::uint64_t generation_;
+      std::uint64_t sent_;     //!< `client_->get_bytes_sent()` when leased
+      std::uint64_t received_; //!< `client_->get_bytes_received()` when leased
+
+      lease(client_pool& pool, std::unique_ptr<abstract_http_client> client, std::uint64_t generation);
+
+    public:
+      lease() noexcept
+        : pool_(nullptr), client_(), generation_(0), sent_(0), received_(0)
+      {}
+
+      lease(lease&& rhs) noexcept;
+      lease& operator=(lease&& rhs) noexcept;
+      ~lease() noexcept;
+
+      explicit operator bool() const noexcept { return bool(client_); }
+      abstract_http_client& operator*() const noexcept { return *client_; }
+      abstract_http_client* operator->() const noexcept { return client_.get(); }
+    };
+
+    //! Keeps at most `max_idle` connections open between requests.
+    explicit client_pool(std::unique_ptr<http_client_factory> factory, std::size_t max_idle = 4);
+    client_pool(const client_pool&) = delete;
+    client_pool& operator=(const client_pool&) = delete;
+
+    //! \return False if `address` cannot be parsed; the settings are unchanged then.
+    bool set_server(const std::string& address, boost::optional<login> user, ssl_options_t ssl_options = ssl_support_t::e_ssl_support_autodetect);
+    bool set_proxy(const std::string& address);
+    void set_auto_connect(bool auto_connect);
+
+    //! Close the idle connections. Leased clients are dropped when they come back.
+    void disconnect();
+
+    //! \return An idle client, or a new one if all are in use.
+    lease acquire();
+
+    //! \return Traffic of the requests made on clients that came back to the pool.
+    std::uint64_t get_bytes_sent() const;
+    std::uint64_t get_bytes_received() const;
+
+  private:
+    void release(lease& source) noexcept;
+    void invalidate(); //!< Drop idle clients and those leased now. Lock must be held.
+
+    mutable boost::mutex sync_;
+    const std::unique_ptr<http_client_factory> factory_;
+    std::vector<std::unique_ptr<abstract_http_client>> idle_;
+    const std::size_t max_idle_;
+    std::string address_;
+    boost::optional<login> user_;
+    ssl_options_t ssl_options_;
+    std::string proxy_;
+    bool auto_connect_;
+    std::uint64_t generation_;
+    std::uint64_t sent_;
+    std::uint64_t received_;
+  };
+} // http
+} // net_utils
+} // epee
@@ -36,6 +36,8 @@
 #include "to_nonconst_iterator.h"
 #include "http_auth.h"
 #include "http_base.h"
+#include "http_request_parser.h"
+#include "span.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
 #define MONERO_DEFAULT_LOG_CATEGORY "net.http"
@@ -94,33 +96,8 @@ namespace net_utils
 			virtual bool handle_request(const http::http_request_info& query_info, http_response_info& response);
 
 		private:
-			enum machine_state{
-				http_state_retriving_comand_line,
-				http_state_retriving_header,
-				http_state_retriving_body,
-				http_state_connection_close,
-				http_state_error
-			};
-
-			enum body_transfer_type{
-				http_body_transfer_chunked,
-				http_body_transfer_measure,//mean "Content-Length" valid
-				http_body_transfer_chunked_instead_measure, 
-				http_body_transfer_connection_close,
-				http_body_transfer_multipart,
-				http_body_transfer_undefined
-			};
-
-			bool handle_buff_in(std::string& buf);
-
-			bool analize_cached_request_header_and_invoke_state(size_t pos);
-
-			bool handle_invoke_query_line();
-			bool parse_cached_header(http_header_info& body_info, const std::string& m_cache_to_process, size_t pos);
-			std::string::size_type match_end_of_header(const std::string& buf);
-			bool get_len_from_content_lenght(const std::string& str, size_t& len);
-			bool handle_retriving_query_body();
-			bool handle_query_measure();
+			bool handle_buff_in(epee::span<const char>& buf);
+
 			bool set_ready_state();
 			bool slash_to_back_slash(std::string& str);
 			std::string get_file_mime_tipe(const std::string& path);
@@ -133,15 +110,11 @@ namespace net_utils
 			std::string get_not_found_response_body(const std::string& URI);
 
 			std::string m_root_path;
-			std::string m_cache;
-			machine_state m_state;
-			body_transfer_type m_body_transfer_type;
-			bool m_is_stop_handling;
+			request_parser m_parser;
 			http::http_request_info m_query_info;
-			size_t m_len_summary, m_len_remain;
 			config_type& m_config;
 			bool m_want_close;
-			size_t m_newlines;
+			bool m_failed;
 		protected:
 			i_service_endpoint* m_psnd_hndlr; 
 			t_connection_context& m_conn_context;
@@ -28,6 +28,7 @@
 #include <boost/regex.hpp>
 #include <boost/lexical_cast.hpp>
 #include "http_protocol_handler.h"
+#include "http_request_parser.h"
 #include "reg_exp_definer.h"
 #include "string_tools.h"
 #include "file_io_utils.h"
@@ -37,10 +38,6 @@
 #undef MONERO_DEFAULT_LOG_CATEGORY
 #define MONERO_DEFAULT_LOG_CATEGORY "net.http"
 
-#define HTTP_MAX_URI_LEN		 9000 
-#define HTTP_MAX_HEADER_LEN		 100000
-#define HTTP_MAX_STARTING_NEWLINES       8
-
 namespace epee
 {
 namespace net_utils
@@ -198,14 +195,10 @@ namespace net_utils
 		//--------------------------------------------------------------------------------------------
 		template<class t_connection_context>
 		simple_http_connection_handler<t_connection_context>::simple_http_connection_handler(i_service_endpoint* psnd_hndlr, config_type& config, t_connection_context& conn_context):
-		m_state(http_state_retriving_comand_line),
-		m_body_transfer_type(http_body_transfer_undefined),
-		m_is_stop_handling(false),
-		m_len_summary(0),
-		m_len_remain(0),
+		m_parser(),
 		m_config(config),
 		m_want_close(false),
-		m_newlines(0),
+		m_failed(false),
 		m_psnd_hndlr(psnd_hndlr),
 		m_conn_context(conn_context)
 	{
@@ -215,355 +208,57 @@ namespace net_utils
     template<class t_connection_context>
 	bool simple_http_connection_handler<t_connection_context>::set_ready_state()
 	{
-		m_is_stop_handling = false;
-		m_state = http_state_retriving_comand_line;
-		m_body_transfer_type = http_body_transfer_undefined;
+		m_parser.reset();
 		m_query_info.clear();
-		m_len_summary = 0;
-		m_newlines = 0;
 		return true;
 	}
 	//--------------------------------------------------------------------------------------------
   template<class t_connection_context>
 	bool simple_http_connection_handler<t_connection_context>::handle_recv(const void* ptr, size_t cb)
 	{
-		std::string buf((const char*)ptr, cb);
-		//LOG_PRINT_L0("HTTP_RECV: " << ptr << "\r\n" << buf);
-		//file_io_utils::save_string_to_file(string_tools::get_current_module_folder() + "/" + boost::lexical_cast<std::string>(ptr), std::string((const char*)ptr, cb));
-
+		epee::span<const char> buf{static_cast<const char*>(ptr), cb};
 		bool res = handle_buff_in(buf);
-		if(m_want_close/*m_state == http_state_connection_close || m_state == http_state_error*/)
+		if(m_want_close)
 			return false;
 		return res;
 	}
 	//--------------------------------------------------------------------------------------------
   template<class t_connection_context>
-	bool simple_http_connection_handler<t_connection_context>::handle_buff_in(std::string& buf)
-	{
-
-		size_t ndel;
-
-		if(m_cache.size())
-			m_cache += buf;
-		else
-			m_cache.swap(buf);
-
-		m_is_stop_handling = false;
-		while(!m_is_stop_handling)
-		{
-			switch(m_state)
-			{
-			case http_state_retriving_comand_line:
-				//The HTTP protocol does not place any a priori limit on the length of a URI.  (c)RFC2616
-				//but we forebly restirct it len to HTTP_MAX_URI_LEN to make it more safely
-				if(!m_cache.size())
-					break;
-
-				//check_and_handle_fake_response();
-				ndel = m_cache.find_first_not_of("\r\n");
-				if (ndel != 0)
-				{
-          //some times it could be that before query line cold be few line breaks
-          //so we have to be calm without panic with assers
-					m_newlines += std::string::npos == ndel ? m_cache.size() : ndel;
-					if (m_newlines > HTTP_MAX_STARTING_NEWLINES)
-					{
-						LOG_ERROR("simple_http_connection_handler::handle_buff_out: Too many starting newlines");
-						m_state = http_state_error;
-						return false;
-					}
-					m_cache.erase(0, ndel);
-					break;
-				}
-
-				if(std::string::npos != m_cache.find('\n', 0))
-					handle_invoke_query_line();
-				else
-				{
-					m_is_stop_handling = true;
-					if(m_cache.size() > HTTP_MAX_URI_LEN)
-					{
-						LOG_ERROR_CC(m_conn_context, "simple_http_connection_handler::handle_buff_out: Too long URI line");
-						m_state = http_state_error;
-						return false;
-					}
-				}
-				break;
-			case http_state_retriving_header:
-				{
-					std::string::size_type pos = match_end_of_header(m_cache);
-					if(std::string::npos == pos)
-					{
-						m_is_stop_handling = true;
-						if(m_cache.size() > HTTP_MAX_HEADER_LEN)
-						{
-							LOG_ERROR_CC(m_conn_context, "simple_http_connection_handler::handle_buff_in: Too long header area");
-							m_state = http_state_error;
-							return false;
-						}	
-						break;
-					}
-					if (!analize_cached_request_header_and_invoke_state(pos))
-						return false;
-					break;
-				}
-			case http_state_retriving_body:
-				return handle_retriving_query_body();
-			case http_state_connection_close:
-				return false;
-			default:
-				LOG_ERROR_CC(m_conn_context, "simple_http_connection_handler::handle_char_out: Wrong state: " << m_state);
-				return false;
-			case http_state_error:
-				LOG_ERROR_CC(m_conn_context, "simple_http_connection_handler::handle_char_out: Error state!!!");
-				return false;
-			}
-
-			if(!m_cache.size())
-				m_is_stop_handling = true;
-		}
-
-		return true;
-	}
-	//--------------------------------------------------------------------------------------------
-	inline bool analize_http_method(const boost::smatch& result, http::http_method& method, int& http_ver_major, int& http_ver_minor)
-	{
-		CHECK_AND_ASSERT_MES(result[0].matched, false, "simple_http_connection_handler::analize_http_method() assert failed...");
-		if (!boost::conversion::try_lexical_convert<int>(result[11], http_ver_major))
-			return false;
-		if (!boost::conversion::try_lexical_convert<int>(result[12], http_ver_minor))
-			return false;
-
-		if(result[3].matched)
-			method = http::http_method_options;
-		else if(result[4].matched)
-			method = http::http_method_get;
-		else if(result[5].matched)
-			method = http::http_method_head;
-		else if(result[6].matched)
-			method = http::http_method_post;
-		else if(result[7].matched)
-			method = http::http_method_put;
-		else 
-			method = http::http_method_etc;
-
-		return true;
-	}
-
-  //--------------------------------------------------------------------------------------------
-  template<class t_connection_context>
-	bool simple_http_connection_handler<t_connection_context>::handle_invoke_query_line()
-	{ 
-		STATIC_REGEXP_EXPR_1(rexp_match_command_line, "^(((OPTIONS)|(GET)|(HEAD)|(POST)|(PUT)|(DELETE)|(TRACE)) (\\S+) HTTP/(\\d+)\\.(\\d+))\r?\n", boost::regex::icase | boost::regex::normal);
-		//											    123         4     5      6      7     8        9        10          11     12    
-		//size_t match_len = 0;
-		boost::smatch result;	
-		if(boost::regex_search(m_cache, result, rexp_match_command_line, boost::match_default) && result[0].matched)
-		{
-			if (!analize_http_method(result, m_query_info.m_http_method, m_query_info.m_http_ver_hi, m_query_info.m_http_ver_hi))
-			{
-				m_state = http_state_error;
-				MERROR("Failed to analyze method");
-				return false;
-			}
-			m_query_info.m_URI = result[10];
-			if (!parse_uri(m_query_info.m_URI, m_query_info.m_uri_content))
-			{
-				m_state = http_state_error;
-				MERROR("Failed to parse URI: m_query_info.m_URI");
-				return false;
-			}
-			m_query_info.m_http_method_str = result[2];
-			m_query_info.m_full_request_str = result[0];
-
-			m_cache.erase(m_cache.begin(),  to_nonsonst_iterator(m_cache, result[0].second));
-
-			m_state = http_state_retriving_header;
-
-			return true;
-		}else
-		{
-			m_state = http_state_error;
-			LOG_ERROR_CC(m_conn_context, "simple_http_connection_handler<t_connection_context>::handle_invoke_query_line(): Failed to match first line: " << m_cache);
-			return false;
-		}
-
-		return false;
-	}
-	//--------------------------------------------------------------------------------------------
-  template<class t_connection_context>
-	std::string::size_type simple_http_connection_handler<t_connection_context>::match_end_of_header(const std::string& buf)
+	bool simple_http_connection_handler<t_connection_context>::handle_buff_in(epee::span<const char>& buf)
 	{
-
-    //Here we returning head size, including terminating sequence (\r\n\r\n or \n\n)
-		std::string::size_type res = buf.find("\r\n\r\n");
-		if(std::string::npos != res)
-			return res+4;
-		res = buf.find("\n\n");
-		if(std::string::npos != res)
-			return res+2;
-		return res;
-	}
-	//--------------------------------------------------------------------------------------------
-  template<class t_connection_context>
-	bool simple_http_connection_handler<t_connection_context>::analize_cached_request_header_and_invoke_state(size_t pos)
-	{ 
-		LOG_PRINT_L3("HTTP HEAD:\r\n" << m_cache.substr(0, pos));
-
-		m_query_info.m_full_request_buf_size = pos;
-    m_query_info.m_request_head.assign(m_cache.begin(), m_cache.begin()+pos); 
-
-		if(!parse_cached_header(m_query_info.m_header_info, m_cache, pos))
+		if(m_failed)
 		{
-			LOG_ERROR_CC(m_conn_context, "simple_http_connection_handler<t_connection_context>::analize_cached_request_header_and_invoke_state(): failed to anilize request header: " << m_cache);
-			m_state = http_state_error;
+			LOG_ERROR_CC(m_conn_context, "simple_http_connection_handler::handle_buff_in: Error state!!!");
 			return false;
 		}
 
-		m_cache.erase(0, pos);
-
-		std::string req_command_str = m_query_info.m_full_request_str;
-    //if we have POST or PUT command, it is very possible tha we will get body
-    //but now, we suppose than we have body only in case of we have "ContentLength" 
-		if(m_query_info.m_header_info.m_content_length.size())
+		//parse in place, several (pipelined) requests can be in one buffer
+		while(!m_want_close)
 		{
-			m_state = http_state_retriving_body;
-			m_body_transfer_type = http_body_transfer_measure;
-			if(!get_len_from_content_lenght(m_query_info.m_header_info.m_content_length, m_len_summary))
+			switch(m_parser.parse(buf, m_query_info))
 			{
-				LOG_ERROR_CC(m_conn_context, "simple_http_connection_handler<t_connection_context>::analize_cached_request_header_and_invoke_state(): Failed to get_len_from_content_lenght();, m_query_info.m_content_length="<<m_query_info.m_header_info.m_content_length);
-				m_state = http_state_error;
+			case request_parser::status::incomplete:
+				return true;
+			case request_parser::status::complete:
+				break;
+			case request_parser::status::error:
+			default:
+				LOG_ERROR_CC(m_conn_context, "simple_http_connection_handler::handle_buff_in: Failed to parse request");
+				m_failed = true;
 				return false;
 			}
-			if(0 == m_len_summary)
-			{	//current query finished, next will be next query
-				if(handle_request_and_send_response(m_query_info))
-					set_ready_state();
-				else
-					m_state = http_state_error;
-			}
-			m_len_remain = m_len_summary;
-		}else
-		{//current query finished, next will be next query
-			handle_request_and_send_response(m_query_info);
-			set_ready_state();
-		}
 
-		return true;
-	}
-	//-----------------------------------------------------------------------------------
-  template<class t_connection_context>
-	bool simple_http_connection_handler<t_connection_context>::handle_retriving_query_body()
-	{
-		switch(m_body_transfer_type)
-		{
-		case http_body_transfer_measure:
-			return handle_query_measure();
-		case http_body_transfer_chunked:
-		case http_body_transfer_connection_close:
-		case http_body_transfer_multipart:
-		case http_body_transfer_undefined:
-		default:
-			LOG_ERROR_CC(m_conn_context, "simple_http_connection_handler<t_connection_context>::handle_retriving_query_body(): Unexpected m_body_query_type state:" << m_body_transfer_type);
-			m_state = http_state_error;
-			return false;
-		}
-
-		return true;
-	}
-	//-----------------------------------------------------------------------------------
-  template<class t_connection_context>
-	bool simple_http_connection_handler<t_connection_context>::handle_query_measure()
-	{
-
-		if(m_len_remain >= m_cache.size())
-		{
-			m_len_remain -= m_cache.size();
-			m_query_info.m_body += m_cache;
-			m_cache.clear();
-		}else
-		{
-			m_query_info.m_body.append(m_cache.begin(), m_cache.begin() + m_len_remain);
-			m_cache.erase(0, m_len_remain);
-			m_len_remain = 0;
-		}
-
-		if(!m_len_remain)
-		{
-			if(handle_request_and_send_response(m_query_info))
-				set_ready_state();
-			else
-				m_state = http_state_error;
-		}
-		return true;
-	}
-	//--------------------------------------------------------------------------------------------
-  template<class t_connection_context>
-	bool simple_http_connection_handler<t_connection_context>::parse_cached_header(http_header_info& body_info, const std::string& m_cache_to_process, size_t pos)
-	{ 
-		STATIC_REGEXP_EXPR_1(rexp_mach_field, 
-			"\n?((Connection)|(Referer)|(Content-Length)|(Content-Type)|(Transfer-Encoding)|(Content-Encoding)|(Host)|(Cookie)|(User-Agent)|(Origin)"
-			//  12            3         4                5              6                   7                  8      9        10           11
-			"|([\\w-]+?)) ?: ?((.*?)(\r?\n))[^\t ]",	
-			//11             1213   14 
-			boost::regex::icase | boost::regex::normal);
-
-		boost::smatch		result;
-		std::string::const_iterator it_current_bound = m_cache_to_process.begin();
-		std::string::const_iterator it_end_bound = m_cache_to_process.begin()+pos;
-
-		body_info.clear();
-
-		//lookup all fields and fill well-known fields
-		while( boost::regex_search( it_current_bound, it_end_bound, result, rexp_mach_field, boost::match_default) && result[0].matched) 
-		{
-			const size_t field_val = 14;
-			const size_t field_etc_name = 12;
-
-			int i = 2; //start position = 2
-			if(result[i++].matched)//"Connection"
-				body_info.m_connection = result[field_val];
-			else if(result[i++].matched)//"Referer"
-				body_info.m_referer = result[field_val];
-			else if(result[i++].matched)//"Content-Length"
-				body_info.m_content_length = result[field_val];
-			else if(result[i++].matched)//"Content-Type"
-				body_info.m_content_type = result[field_val];
-			else if(result[i++].matched)//"Transfer-Encoding"
-				body_info.m_transfer_encoding = result[field_val];
-			else if(result[i++].matched)//"Content-Encoding"
-				body_info.m_content_encoding = result[field_val];
-			else if(result[i++].matched)//"Host"
-				body_info.m_host = result[field_val];
-			else if(result[i++].matched)//"Cookie"
-				body_info.m_cookie = result[field_val];
-			else if(result[i++].matched)//"User-Agent"
-				body_info.m_user_agent = result[field_val];
-			else if(result[i++].matched)//"Origin"
-				body_info.m_origin = result[field_val];
-			else if(result[i++].matched)//e.t.c (HAVE TO BE MATCHED!)
-				body_info.m_etc_fields.push_back(std::pair<std::string, std::string>(result[field_etc_name], result[field_val]));
-			else
+			LOG_PRINT_L3("HTTP request parsed in " << m_parser.parse_time() << " ns");
+			const bool has_body = !m_query_info.m_header_info.m_content_length.empty();
+			if(!handle_request_and_send_response(m_query_info) && has_body)
 			{
-				LOG_ERROR_CC(m_conn_context, "simple_http_connection_handler<t_connection_context>::parse_cached_header() not matched last entry in:" << m_cache_to_process);
+				m_failed = true;
+				return true;
 			}
-
-			it_current_bound = result[(int)result.size()-1]. first;
+			set_ready_state();
+			if(buf.empty())
+				return true;
 		}
-		return  true;
-	}
-	//-----------------------------------------------------------------------------------
-  template<class t_connection_context>
-	bool simple_http_connection_handler<t_connection_context>::get_len_from_content_lenght(const std::string& str, size_t& OUT len)
-	{
-		STATIC_REGEXP_EXPR_1(rexp_mach_field, "\\d+", boost::regex::normal);
-		std::string res;
-		boost::smatch result;
-		if(!(boost::regex_search( str, result, rexp_mach_field, boost::match_default) && result[0].matched))
-			return false;
-
-		try { len = boost::lexical_cast<size_t>(result[0]); }
-		catch(...) { return false; }
 		return true;
 	}
 	//-----------------------------------------------------------------------------------
@@ -660,7 +355,6 @@ namespace net_utils
 			{
         //closing connection after sending
 				buf += "Connection: close\r\n";
-				m_state = http_state_connection_close;
 				m_want_close = true;
 			}
 		}
@@ -0,0 +1,110 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "http_base.h"
+#include "span.h"
+
+#define HTTP_MAX_URI_LEN		 9000
+#define HTTP_MAX_HEADER_LEN		 100000
+#define HTTP_MAX_STARTING_NEWLINES       8
+
+namespace epee
+{
+namespace net_utils
+{
+namespace http
+{
+  //! Totals over every request completed by a `request_parser`.
+  struct request_parser_stats
+  {
+    std::uint64_t count; //!< Requests parsed
+    std::uint64_t time;  //!< Nanoseconds spent in `request_parser::parse`
+  };
+
+  request_parser_stats get_request_parser_stats() noexcept;
+  void clear_request_parser_stats() noexcept;
+
+  /*! \brief Incremental HTTP/1.x request parser.
+
+      Works directly on each receive buffer: the request line, headers and
+      body are appended to their `http_request_info` fields as bytes arrive,
+      and every byte is examined once, so nothing is buffered or re-scanned
+      between reads. Bytes after a complete request are left in the input for
+      the next (pipelined) request. */
+  class request_parser
+  {
+  public:
+    enum class status : std::uint8_t
+    {
+      incomplete, //!< All input consumed, need more
+      complete,   //!< Request is ready, input starts at the next request
+      error       //!< Malformed request; connection should be dropped
+    };
+
+    request_parser() noexcept;
+
+    //! Start a new request. `out` given to `parse` must be cleared too.
+    void reset() noexcept;
+
+    /*! Consume bytes from `in` into `out`. `out` must be the same object,
+        and otherwise untouched, until `complete` or `error` is returned. */
+    status parse(epee::span<const char>& in, http_request_info& out);
+
+    //! \return Nanoseconds spent in `parse` for the current request.
+    std::uint64_t parse_time() const noexcept { return time_; }
+
+  private:
+    enum class state : std::uint8_t
+    {
+      newlines,
+      request_line,
+      headers,
+      body,
+      done,
+      failed
+    };
+
+    status run(epee::span<const char>& in, http_request_info& out);
+    bool finish_request_line(http_request_info& out);
+    void finish_header_line(http_request_info& out, std::size_t begin, std::size_t end);
+    bool finish_headers(http_request_info& out);
+
+    std::uint64_t time_;
+    std::size_t newlines_;
+    std::size_t line_start_; //!< Offset of current line in `m_request_head`
+    std::size_t remaining_;  //!< Body bytes still expected
+    state state_;
+  };
+}
+}
+}
@@ -89,8 +89,9 @@ namespace levin
   template<class t_connection_context = net_utils::connection_context_base>
   struct levin_commands_handler
   {
-    virtual int invoke(int command, const epee::span<const uint8_t> in_buff, byte_stream& buff_out, t_connection_context& context)=0;
-    virtual int notify(int command, const epee::span<const uint8_t> in_buff, t_connection_context& context)=0;
+    //! `in_buff` is a view of the received body, handlers may keep a `clone()` of it without copying.
+    virtual int invoke(int command, const byte_slice& in_buff, byte_stream& buff_out, t_connection_context& context)=0;
+    virtual int notify(int command, const byte_slice& in_buff, t_connection_context& context)=0;
     virtual void callback(t_connection_context& context){};
 
     virtual void on_connection_new(t_connection_context& context){};
@@ -34,6 +34,8 @@
 #include <atomic>
 #include <deque>
 
+#include "byte_slice.h"
+#include "byte_stream.h"
 #include "levin_base.h"
 #include "buffer.h"
 #include "misc_language.h"
@@ -134,7 +136,25 @@ public:
 template<class t_connection_context = net_utils::connection_context_base>
 class async_protocol_handler
 {
-  std::string m_fragment_buffer;
+  //! Read the header of a fragmented message from `fragment` and check its size. \return False if the connection must be closed.
+  bool read_fragmented_head(const epee::span<const uint8_t> fragment, bucket_head2& head)
+  {
+    if (fragment.size() < sizeof(bucket_head2))
+    {
+      MERROR(m_connection_context << "Fragmented data too small for levin header");
+      return false;
+    }
+    std::memcpy(std::addressof(head), fragment.data(), sizeof(bucket_head2));
+    const size_t max_bytes = m_connection_context.get_max_bytes(head.m_command);
+    if(head.m_cb > std::min<size_t>(m_max_packet_size, max_bytes))
+    {
+      MERROR(m_connection_context << "Maximum packet size exceed!, m_max_packet_size = " << std::min<size_t>(m_max_packet_size, max_bytes)
+        << ", packet header received " << head.m_cb << ", command " << head.m_command
+        << ", connection will be closed.");
+      return false;
+    }
+    return true;
+  }
 
   bool send_message(byte_slice message)
   {
@@ -183,7 +203,11 @@ public:
   t_connection_context& m_connection_context;
   std::atomic<uint64_t> m_max_packet_size;
 
-  net_utils::buffer m_cache_in_buffer;
+  net_utils::buffer m_cache_in_buffer; //!< Bytes of the next header
+  byte_stream m_fragment_buffer; //!< Fragments received so far, starting with the header of the whole message
+  byte_stream m_message_buffer; //!< Body of the current message, handed to the handlers once complete
+  byte_stream* m_body_out; //!< Where the body of the current packet goes, null to drop it
+  uint64_t m_body_received;
   stream_state m_state;
 
   int32_t m_oponent_protocol_ver;
@@ -311,7 +335,9 @@ public:
             m_config(config), 
             m_connection_context(conn_context),
             m_max_packet_size(config.m_initial_max_packet_size),
-            m_cache_in_buffer(4 * 1024),
+            m_cache_in_buffer(sizeof(bucket_head2)),
+            m_body_out(nullptr),
+            m_body_received(0),
             m_state(stream_state_head)
   {
     m_close_called = 0;
@@ -421,26 +447,58 @@ public:
     const uint64_t max_packet_size = m_max_packet_size;
     CHECK_AND_ASSERT_MES(max_packet_size >= m_cache_in_buffer.size(), false, "Bad m_cache_in_buffer.size()");
     CHECK_AND_ASSERT_MES(max_packet_size - m_cache_in_buffer.size() >= m_fragment_buffer.size(), false, "Bad m_cache_in_buffer.size() + m_fragment_buffer.size()");
+    const uint64_t buffered = m_cache_in_buffer.size() + m_fragment_buffer.size();
+    CHECK_AND_ASSERT_MES(max_packet_size - buffered >= m_message_buffer.size(), false, "Bad m_message_buffer.size()");
 
     // flipped to subtraction; prevent overflow since m_max_packet_size is variable and public
-    if(cb > max_packet_size - m_cache_in_buffer.size() - m_fragment_buffer.size())
+    if(cb > max_packet_size - buffered - m_message_buffer.size())
     {
       MWARNING(m_connection_context << "Maximum packet size exceed!, m_max_packet_size = " << max_packet_size
-                          << ", packet received " << m_cache_in_buffer.size() +  cb 
+                          << ", packet received " << buffered + m_message_buffer.size() + cb
                           << ", connection will be closed.");
       return false;
     }
 
-    m_cache_in_buffer.append((const char*)ptr, cb);
-
+    /* Only headers go through m_cache_in_buffer. Bodies are copied once,
+       straight into the buffer that is handed to the command handlers (or
+       into the reassembly buffer for fragments), which has been sized from
+       the header after its size was checked. */
+    epee::span<const uint8_t> in{static_cast<const uint8_t*>(ptr), cb};
     bool is_continue = true;
     while(is_continue)
     {
       switch(m_state)
       {
       case stream_state_body:
-        if(m_cache_in_buffer.size() < m_current_head.m_cb)
         {
+          const bool first_fragment = m_body_out == std::addressof(m_fragment_buffer) && (m_current_head.m_flags & LEVIN_PACKET_BEGIN);
+          size_t taken = std::min<uint64_t>(m_current_head.m_cb - m_body_received, in.size());
+          if (first_fragment && m_body_received < sizeof(bucket_head2))
+            taken = std::min(taken, sizeof(bucket_head2) - m_body_received);
+          if (m_body_out && taken)
+            m_body_out->write(in.data(), taken);
+          in.remove_prefix(taken);
+          m_body_received += taken;
+
+          /* The first fragment starts with the header of the whole message,
+             and every fragment carries the same amount of data, so the
+             reassembly buffer is sized once for all of them as soon as that
+             header is in, rather than growing (and copying) as fragments
+             come. */
+          if (first_fragment && taken && m_body_received == sizeof(bucket_head2))
+          {
+            bucket_head2 head;
+            if (!read_fragmented_head({m_fragment_buffer.data(), m_fragment_buffer.size()}, head))
+              return false;
+            const size_t fragment_size = m_current_head.m_cb;
+            const size_t total = sizeof(bucket_head2) + head.m_cb;
+            m_fragment_buffer.reserve((total + fragment_size - 1) / fragment_size * fragment_size - m_fragment_buffer.size());
+          }
+        }
+        if(m_body_received < m_current_head.m_cb)
+        {
+          if (!in.empty())
+            break; // stopped at the header of a fragmented message, keep reading
           is_continue = false;
           if(cb >= MIN_BYTES_WANTED)
           {
@@ -450,51 +508,32 @@ public:
               //async call scenario
               boost::shared_ptr<invoke_response_handler_base> response_handler = m_invoke_response_handlers.front();
               response_handler->reset_timer();
-              MDEBUG(m_connection_context << "LEVIN_PACKET partial msg received. len=" << cb << ", current total " << m_cache_in_buffer.size() << "/" << m_current_head.m_cb << " (" << (100.0f * m_cache_in_buffer.size() / (m_current_head.m_cb ? m_current_head.m_cb : 1)) << "%)");
+              MDEBUG(m_connection_context << "LEVIN_PACKET partial msg received. len=" << cb << ", current total " << m_body_received << "/" << m_current_head.m_cb << " (" << (100.0f * m_body_received / (m_current_head.m_cb ? m_current_head.m_cb : 1)) << "%)");
             }
           }
           break;
         }
 
+        m_state = stream_state_head;
+        if (!m_body_out)
+          break; // noise message, skip to next message
+
         {
-          std::string temp{};
-          epee::span<const uint8_t> buff_to_invoke = m_cache_in_buffer.carve((std::string::size_type)m_current_head.m_cb);
-          m_state = stream_state_head;
+          byte_slice message;
 
           // abstract_tcp_server2.h manages max bandwidth for a p2p link
-          if (!(m_current_head.m_flags & (LEVIN_PACKET_REQUEST | LEVIN_PACKET_RESPONSE)))
+          if (m_body_out == std::addressof(m_fragment_buffer))
           {
-            // special noise/fragment command
-            static constexpr const uint32_t both_flags = (LEVIN_PACKET_BEGIN | LEVIN_PACKET_END);
-            if ((m_current_head.m_flags & both_flags) == both_flags)
-              break; // noise message, skip to next message
-
-            if (m_current_head.m_flags & LEVIN_PACKET_BEGIN)
-              m_fragment_buffer.clear();
-
-            m_fragment_buffer.append(reinterpret_cast<const char*>(buff_to_invoke.data()), buff_to_invoke.size());
             if (!(m_current_head.m_flags & LEVIN_PACKET_END))
               break; // skip to next message
 
-            if (m_fragment_buffer.size() < sizeof(bucket_head2))
-            {
-              MERROR(m_connection_context << "Fragmented data too small for levin header");
-              return false;
-            }
-
-            temp = std::move(m_fragment_buffer);
-            m_fragment_buffer.clear();
-            std::memcpy(std::addressof(m_current_head), std::addressof(temp[0]), sizeof(bucket_head2));
-            const size_t max_bytes = m_connection_context.get_max_bytes(m_current_head.m_command);
-            if(m_current_head.m_cb > std::min<size_t>(max_packet_size, max_bytes))
-            {
-              MERROR(m_connection_context << "Maximum packet size exceed!, m_max_packet_size = " << std::min<size_t>(max_packet_size, max_bytes)
-                << ", packet header received " << m_current_head.m_cb << ", command " << m_current_head.m_command
-                << ", connection will be closed.");
+            message = byte_slice{std::move(m_fragment_buffer), false};
+            if (!read_fragmented_head(epee::to_span(message), m_current_head))
               return false;
-            }
-            buff_to_invoke = {reinterpret_cast<const uint8_t*>(temp.data()) + sizeof(bucket_head2), temp.size() - sizeof(bucket_head2)};
+            message.remove_prefix(sizeof(bucket_head2));
           }
+          else
+            message = byte_slice{std::move(m_message_buffer), false};
 
           bool is_response = (m_oponent_protocol_ver == LEVIN_PROTOCOL_VER_1 && m_current_head.m_flags&LEVIN_PACKET_RESPONSE);
 
@@ -518,7 +557,7 @@ public:
               invoke_response_handlers_guard.unlock();
 
               if(timer_cancelled)
-                response_handler->handle(m_current_head.m_return_code, buff_to_invoke, m_connection_context);
+                response_handler->handle(m_current_head.m_return_code, epee::to_span(message), m_connection_context);
             }
             else
             {
@@ -531,8 +570,7 @@ public:
               }else
               {
                 CRITICAL_REGION_BEGIN(m_local_inv_buff_lock);
-                m_local_inv_buff = std::string((const char*)buff_to_invoke.data(), buff_to_invoke.size());
-                buff_to_invoke = epee::span<const uint8_t>((const uint8_t*)NULL, 0);
+                m_local_inv_buff = std::string((const char*)message.data(), message.size());
                 m_invoke_result_code = m_current_head.m_return_code;
                 CRITICAL_REGION_END();
                 boost::interprocess::ipcdetail::atomic_write32(&m_invoke_buf_ready, 1);
@@ -544,7 +582,7 @@ public:
             {
               levin::message_writer return_message{32 * 1024};
               const uint32_t return_code = m_config.m_pcommands_handler->invoke(
-                m_current_head.m_command, buff_to_invoke, return_message.buffer, m_connection_context
+                m_current_head.m_command, message, return_message.buffer, m_connection_context
               );
 
               // peer_id remains unset if dropped
@@ -555,18 +593,15 @@ public:
                 return false;
             }
             else
-              m_config.m_pcommands_handler->notify(m_current_head.m_command, buff_to_invoke, m_connection_context);
-          }
-          // reuse small buffer
-          if (!temp.empty() && temp.capacity() <= 64 * 1024)
-          {
-            temp.clear();
-            m_fragment_buffer = std::move(temp);
+              m_config.m_pcommands_handler->notify(m_current_head.m_command, message, m_connection_context);
           }
         }
         break;
       case stream_state_head:
         {
+          const size_t taken = std::min(sizeof(bucket_head2) - m_cache_in_buffer.size(), in.size());
+          m_cache_in_buffer.append(in.data(), taken);
+          in.remove_prefix(taken);
           if(m_cache_in_buffer.size() < sizeof(bucket_head2))
           {
             if(m_cache_in_buffer.size() >= sizeof(uint64_t) && *((uint64_t*)m_cache_in_buffer.span(8).data()) != SWAP64LE(LEVIN_SIGNATURE))
@@ -607,6 +642,26 @@ public:
               << ", connection will be closed.");
             return false;
           }
+
+          m_body_received = 0;
+          m_body_out = std::addressof(m_message_buffer);
+          if (!(m_current_head.m_flags & (LEVIN_PACKET_REQUEST | LEVIN_PACKET_RESPONSE)))
+          {
+            // special noise/fragment command
+            static constexpr const uint32_t both_flags = (LEVIN_PACKET_BEGIN | LEVIN_PACKET_END);
+            if ((m_current_head.m_flags & both_flags) == both_flags)
+              m_body_out = nullptr; // noise is dropped as it arrives
+            else
+            {
+              if (m_current_head.m_flags & LEVIN_PACKET_BEGIN)
+                m_fragment_buffer.clear();
+              m_body_out = std::addressof(m_fragment_buffer);
+            }
+          }
+
+          // the size passed the checks above, so make room for the whole body now
+          if (m_body_out)
+            m_body_out->reserve(m_current_head.m_cb);
         }
         break;
       default:
@@ -693,13 +748,13 @@ public:
     }
 
     uint64_t ticks_start = misc_utils::get_tick_count();
-    size_t prev_size = 0;
+    uint64_t prev_size = 0;
 
     while(!boost::interprocess::ipcdetail::atomic_read32(&m_invoke_buf_ready) && !m_protocol_released)
     {
-      if(m_cache_in_buffer.size() - prev_size >= MIN_BYTES_WANTED)
+      if(m_body_received - prev_size >= MIN_BYTES_WANTED)
       {
-        prev_size = m_cache_in_buffer.size();
+        prev_size = m_body_received;
         ticks_start = misc_utils::get_tick_count();
       }
       if(misc_utils::get_tick_count() - ticks_start > m_config.m_invoke_timeout)
@@ -69,6 +69,9 @@ class network_throttle : public i_network_throttle {
 		uint64_t m_total_packets;
 		uint64_t m_total_bytes;
 
+		double m_tokens; // token bucket for reserve(), in bytes; negative when reservations are queued
+		network_time_seconds m_tokens_time; // when m_tokens was last refilled, 0 before the first reserve()
+
 		std::string m_name; // my name for debug and logs
 		std::string m_nameshort; // my name for debug and logs (used in log file name)
 
@@ -93,6 +96,7 @@ class network_throttle : public i_network_throttle {
 
 		virtual network_time_seconds get_sleep_time_after_tick(size_t packet_size); ///< increase the timer if needed, and get the package size
 		virtual network_time_seconds get_sleep_time(size_t packet_size) const; ///< gets the Delay (recommended Delay time) from calc. (not safe: only if time didnt change?) TODO
+		virtual network_time_seconds reserve(size_t packet_size); ///< take packet_size bytes from the token bucket, \return seconds until they are covered by the target speed
 
 		virtual size_t get_recommended_size_of_planned_transport() const; ///< what should be the size (bytes) of next data block to be transported
 		virtual size_t get_recommended_size_of_planned_transport_window(double force_window) const;  ///< ditto, but for given windows time frame
@@ -144,6 +144,7 @@ class i_network_throttle {
 
 		virtual network_time_seconds get_sleep_time(size_t packet_size) const =0; // gets the D (recommended Delay time) from calc
 		virtual network_time_seconds get_sleep_time_after_tick(size_t packet_size) =0; // ditto, but first tick the timer
+		virtual network_time_seconds reserve(size_t packet_size) =0; // token bucket: take packet_size bytes now, returns how long to wait before using them (0 = now)
 
 		virtual size_t get_recommended_size_of_planned_transport() const =0; // what should be the recommended limit of data size that we can transport over current network_throttle in near future
 
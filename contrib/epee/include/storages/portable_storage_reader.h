@@ -0,0 +1,203 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "misc_log_ex.h"
+#include "portable_storage.h"
+#include "portable_storage_base.h"
+#include "portable_storage_bin_utils.h"
+#include "portable_storage_val_converters.h"
+#include "span.h"
+
+namespace epee
+{
+  namespace serialization
+  {
+    //! Field positions of one section in a `binary_reader` buffer.
+    struct section_view
+    {
+      struct entry
+      {
+        boost::string_ref name;
+        const std::uint8_t* value; //!< Points to the type byte
+        std::uint8_t type;
+      };
+
+      std::vector<entry> entries; //!< Sorted by name
+    };
+
+    //! Read position in an array of a `binary_reader` buffer.
+    struct array_view
+    {
+      const std::uint8_t* next;
+      std::size_t remaining;
+      std::uint8_t type;
+      section_view* element; //!< Reused for each section of the array
+    };
+
+    /*! \brief Reads the portable storage binary format without building a
+        `section` tree.
+
+        Provides the part of the `portable_storage` interface that `load()`
+        uses (see keyvalue_serialization_overloads.h). `load_from_binary`
+        validates the whole buffer and applies the limits exactly like
+        `portable_storage`; afterwards only the field positions of the
+        sections being read are kept, and values are decoded straight into
+        the destination fields. The source buffer must outlive the reader. */
+    class binary_reader
+    {
+    public:
+      typedef section_view* hsection;
+      typedef array_view* harray;
+      typedef storage_entry meta_entry;
+      typedef portable_storage::limits_t limits_t;
+
+      binary_reader();
+      binary_reader(const binary_reader&) = delete;
+      binary_reader& operator=(const binary_reader&) = delete;
+
+      bool load_from_binary(const epee::span<const std::uint8_t> source, const limits_t *limits = nullptr);
+      bool load_from_binary(const std::string& source, const limits_t *limits = nullptr)
+      {
+        return load_from_binary(epee::strspan<std::uint8_t>(source), limits);
+      }
+
+      hsection open_section(boost::string_ref name, hsection parent, bool create_if_notexist = false);
+
+      template<typename T>
+      bool get_value(boost::string_ref name, T& value, hsection parent)
+      {
+        const section_view::entry* const field = find(name, parent);
+        if (!field)
+          return false;
+        const std::uint8_t* position = field->value + 1;
+        read_value(field->type, position, value);
+        return true;
+      }
+
+      bool get_value(boost::string_ref name, storage_entry& value, hsection parent);
+
+      template<typename T>
+      harray get_first_value(boost::string_ref name, T& value, hsection parent)
+      {
+        const harray array = open_array(name, parent);
+        if (!array || !get_next_value(array, value))
+          return nullptr;
+        return array;
+      }
+
+      template<typename T>
+      bool get_next_value(harray array, T& value)
+      {
+        CHECK_AND_ASSERT(array, false);
+        if (!array->remaining)
+          return false;
+        --array->remaining;
+        read_value(array->type, array->next, value);
+        return true;
+      }
+
+      harray get_first_section(boost::string_ref name, hsection& child, hsection parent);
+      bool get_next_section(harray array, hsection& child);
+
+    private:
+      const section_view::entry* find(boost::string_ref name, hsection parent) const;
+      harray open_array(boost::string_ref name, hsection parent);
+
+      //! Record the fields of the section at `position`. \return End of the section.
+      const std::uint8_t* index(section_view& view, const std::uint8_t* position, bool validate);
+
+      void skip_value(const std::uint8_t*& position, std::uint8_t type, std::size_t depth, bool validate);
+      void skip_array(const std::uint8_t*& position, std::uint8_t type, std::size_t depth, bool validate);
+      void skip_section(const std::uint8_t*& position, std::size_t depth, bool validate);
+      void need(const std::uint8_t* position, std::size_t bytes) const;
+
+      static std::size_t read_varint(const std::uint8_t*& position) noexcept;
+      static void read_string(const std::uint8_t*& position, std::string& value);
+
+      template<typename T>
+      static T read_pod(const std::uint8_t*& position) noexcept
+      {
+        T value;
+        std::memcpy(std::addressof(value), position, sizeof(value));
+        position += sizeof(value);
+        return CONVERT_POD(value);
+      }
+
+      template<typename T>
+      static void read_string(const std::uint8_t*& position, T& value)
+      {
+        std::string temp;
+        read_string(position, temp);
+        convert_t(temp, value);
+      }
+
+      //! Values were checked by `load_from_binary`, only conversions can fail
+      template<typename T>
+      static void read_value(const std::uint8_t type, const std::uint8_t*& position, T& value)
+      {
+        switch (type)
+        {
+        case SERIALIZE_TYPE_INT64:  convert_t(read_pod<std::int64_t>(position), value); break;
+        case SERIALIZE_TYPE_INT32:  convert_t(read_pod<std::int32_t>(position), value); break;
+        case SERIALIZE_TYPE_INT16:  convert_t(read_pod<std::int16_t>(position), value); break;
+        case SERIALIZE_TYPE_INT8:   convert_t(read_pod<std::int8_t>(position), value); break;
+        case SERIALIZE_TYPE_UINT64: convert_t(read_pod<std::uint64_t>(position), value); break;
+        case SERIALIZE_TYPE_UINT32: convert_t(read_pod<std::uint32_t>(position), value); break;
+        case SERIALIZE_TYPE_UINT16: convert_t(read_pod<std::uint16_t>(position), value); break;
+        case SERIALIZE_TYPE_UINT8:  convert_t(read_pod<std::uint8_t>(position), value); break;
+        case SERIALIZE_TYPE_DUOBLE: convert_t(read_pod<double>(position), value); break;
+        case SERIALIZE_TYPE_BOOL:   convert_t(bool(read_pod<std::uint8_t>(position)), value); break;
+        case SERIALIZE_TYPE_STRING: read_string(position, value); break;
+        default:
+          ASSERT_MES_AND_THROW("WRONG DATA CONVERSION: from type code=" << unsigned(type) << " to type " << typeid(T).name());
+        }
+      }
+
+      section_view root_;
+      std::deque<section_view> sections_;
+      std::deque<array_view> arrays_;
+      const std::uint8_t* end_;
+      std::size_t objects_;
+      std::size_t fields_;
+      std::size_t strings_;
+      limits_t limits_;
+    };
+  }
+}
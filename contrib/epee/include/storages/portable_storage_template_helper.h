@@ -31,13 +31,13 @@
 #include "byte_slice.h"
 #include "parserse_base_utils.h" /// TODO: (mj-xmr) This will be reduced in an another PR
 #include "portable_storage.h"
+#include "portable_storage_reader.h"
+#include "portable_storage_writer.h"
 #include "file_io_utils.h"
 #include "span.h"
 
 namespace epee
 {
-  class byte_stream;
-
   namespace serialization
   {
     //-----------------------------------------------------------------------------------------------------------
@@ -65,10 +65,13 @@ namespace epee
     template<class t_struct>
     bool store_t_to_json(t_struct& str_in, std::string& json_buff, size_t indent = 0, bool insert_newlines = true)
     {
-      portable_storage ps;
-      str_in.store(ps);
-      ps.dump_as_json(json_buff, indent, insert_newlines);
+      TRY_ENTRY();
+      json_buff.clear();
+      json_writer out{json_buff, indent, insert_newlines};
+      str_in.store(out);
+      out.finish();
       return true;
+      CATCH_ENTRY("store_t_to_json", false);
     }
     //-----------------------------------------------------------------------------------------------------------
     template<class t_struct>
@@ -90,7 +93,7 @@ namespace epee
     template<class t_struct>
     bool load_t_from_binary(t_struct& out, const epee::span<const uint8_t> binary_buff, const epee::serialization::portable_storage::limits_t *limits = NULL)
     {
-      portable_storage ps;
+      binary_reader ps;
       bool rs = ps.load_from_binary(binary_buff, limits);
       if(!rs)
         return false;
@@ -117,9 +120,15 @@ namespace epee
     template<class t_struct>
     bool store_t_to_binary(t_struct& str_in, byte_slice& binary_buff, size_t initial_buffer_size = 8192)
     {
-      portable_storage ps;
-      str_in.store(ps);
-      return ps.store_to_binary(binary_buff, initial_buffer_size);
+      TRY_ENTRY();
+      byte_stream ss;
+      ss.reserve(initial_buffer_size);
+      binary_writer out{ss};
+      str_in.store(out);
+      out.finish();
+      binary_buff = byte_slice{std::move(ss)};
+      return true;
+      CATCH_ENTRY("store_t_to_binary", false);
     }
     //-----------------------------------------------------------------------------------------------------------
     template<class t_struct>
@@ -133,9 +142,12 @@ namespace epee
     template<class t_struct>
     bool store_t_to_binary(t_struct& str_in, byte_stream& binary_buff)
     {
-      portable_storage ps;
-      str_in.store(ps);
-      return ps.store_to_binary(binary_buff);
+      TRY_ENTRY();
+      binary_writer out{binary_buff};
+      str_in.store(out);
+      out.finish();
+      return true;
+      CATCH_ENTRY("store_t_to_binary", false);
     }
 
   }
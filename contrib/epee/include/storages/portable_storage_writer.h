@@ -0,0 +1,255 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "byte_stream.h"
+#include "misc_log_ex.h"
+#include "portable_storage_base.h"
+#include "portable_storage_to_bin.h"
+
+namespace epee
+{
+  namespace serialization
+  {
+    //! Handle to an open section or array of a `stream_writer`.
+    struct stream_handle
+    {
+      stream_handle(std::nullptr_t = nullptr) noexcept
+        : depth(0)
+      {}
+
+      explicit stream_handle(std::size_t depth) noexcept
+        : depth(depth)
+      {}
+
+      explicit operator bool() const noexcept { return depth != 0; }
+
+      std::size_t depth; //!< Position in the writer stack, 0 is the root section
+    };
+
+    template<typename T> struct stream_type_code;
+    template<> struct stream_type_code<std::uint64_t> : std::integral_constant<std::uint8_t, SERIALIZE_TYPE_UINT64> {};
+    template<> struct stream_type_code<std::uint32_t> : std::integral_constant<std::uint8_t, SERIALIZE_TYPE_UINT32> {};
+    template<> struct stream_type_code<std::uint16_t> : std::integral_constant<std::uint8_t, SERIALIZE_TYPE_UINT16> {};
+    template<> struct stream_type_code<std::uint8_t> : std::integral_constant<std::uint8_t, SERIALIZE_TYPE_UINT8> {};
+    template<> struct stream_type_code<std::int64_t> : std::integral_constant<std::uint8_t, SERIALIZE_TYPE_INT64> {};
+    template<> struct stream_type_code<std::int32_t> : std::integral_constant<std::uint8_t, SERIALIZE_TYPE_INT32> {};
+    template<> struct stream_type_code<std::int16_t> : std::integral_constant<std::uint8_t, SERIALIZE_TYPE_INT16> {};
+    template<> struct stream_type_code<std::int8_t> : std::integral_constant<std::uint8_t, SERIALIZE_TYPE_INT8> {};
+    template<> struct stream_type_code<double> : std::integral_constant<std::uint8_t, SERIALIZE_TYPE_DUOBLE> {};
+    template<> struct stream_type_code<bool> : std::integral_constant<std::uint8_t, SERIALIZE_TYPE_BOOL> {};
+    template<> struct stream_type_code<std::string> : std::integral_constant<std::uint8_t, SERIALIZE_TYPE_STRING> {};
+
+    /*! \brief Base of the DOM-free portable storage writers.
+
+        Provides the part of the `portable_storage` interface that `store()`
+        uses (see keyvalue_serialization_overloads.h), but every value is
+        written to the output as soon as it is given instead of going into a
+        `section` tree first. Fields come out in the order they are
+        serialized, and an open section or array is closed as soon as
+        something is written to one of its parents - handles are only valid
+        until then, which is always the case for the `KV_SERIALIZE` macros.
+        Field names in a section must be unique. */
+    class stream_writer
+    {
+    public:
+      typedef stream_handle hsection;
+      typedef stream_handle harray;
+      typedef storage_entry meta_entry;
+
+      virtual ~stream_writer() = default;
+
+      //! Close every open section, including the root. Call once after `store()`.
+      void finish();
+
+    protected:
+      struct frame
+      {
+        std::size_t count; //!< Fields or elements written so far
+        std::size_t mark;  //!< Count position (binary) or indent (json)
+        std::uint8_t type; //!< Element type of an array, 0 for a section
+      };
+
+      stream_writer() = default;
+      stream_writer(const stream_writer&) = delete;
+      stream_writer& operator=(const stream_writer&) = delete;
+
+      //! Close everything above `handle`. \return Index of `handle` frame.
+      std::size_t enter(stream_handle handle);
+
+      //! Close everything above `parent`, which must be a section. \return Index of `parent` frame.
+      std::size_t enter_section(stream_handle parent);
+
+      //! Close everything above `array` and check its element type. \return Index of `array` frame.
+      std::size_t enter_array(stream_handle array, std::uint8_t type);
+
+      stream_handle push(std::size_t mark, std::uint8_t type);
+
+      virtual void close(const frame& top) = 0;
+
+      std::vector<frame> frames_;
+    };
+
+    //! Writes the portable storage binary format directly into a `byte_stream`.
+    class binary_writer final : public stream_writer
+    {
+      byte_stream& out_;
+
+      void write_name(stream_handle parent, boost::string_ref name);
+      void write_name(stream_handle parent, boost::string_ref name, std::uint8_t type);
+
+      //! Push a frame whose count is patched in, at a fixed width, when it is closed
+      stream_handle begin(std::uint8_t type);
+
+      virtual void close(const frame& top) override final;
+
+      template<typename T>
+      void write_value(const T& value)
+      {
+        static_assert(std::is_arithmetic<T>::value, "unexpected value type");
+        const T converted = CONVERT_POD(value);
+        out_.write(reinterpret_cast<const char*>(std::addressof(converted)), sizeof(converted));
+      }
+
+      void write_value(const std::string& value)
+      {
+        put_string(out_, value);
+      }
+
+    public:
+      //! Writes the storage header; `out` must outlive `this`.
+      explicit binary_writer(byte_stream& out);
+
+      hsection open_section(boost::string_ref name, hsection parent, bool create_if_notexist = true);
+
+      template<typename T>
+      bool set_value(boost::string_ref name, const T& value, hsection parent)
+      {
+        write_name(parent, name, stream_type_code<T>::value);
+        write_value(value);
+        return true;
+      }
+
+      bool set_value(boost::string_ref name, const storage_entry& value, hsection parent);
+
+      template<typename T>
+      harray insert_first_value(boost::string_ref name, const T& value, hsection parent)
+      {
+        write_name(parent, name, stream_type_code<T>::value | SERIALIZE_FLAG_ARRAY);
+        const harray array = begin(stream_type_code<T>::value);
+        insert_next_value(array, value);
+        return array;
+      }
+
+      template<typename T>
+      bool insert_next_value(harray array, const T& value)
+      {
+        ++frames_[enter_array(array, stream_type_code<T>::value)].count;
+        write_value(value);
+        return true;
+      }
+
+      harray insert_first_section(boost::string_ref name, hsection& child, hsection parent);
+      bool insert_next_section(harray array, hsection& child);
+    };
+
+    //! Writes the same JSON as `portable_storage::dump_as_json` directly into a string.
+    class json_writer final : public stream_writer
+    {
+      std::string& out_;
+      const bool newlines_;
+
+      //! \return Indent of the values in the `parent` section
+      std::size_t write_name(stream_handle parent, boost::string_ref name);
+      void begin_element(stream_handle array, std::uint8_t type);
+      void write_indent(std::size_t indent);
+      void write_string(boost::string_ref value); //!< Quoted and escaped like `transform_to_escape_sequence`
+
+      virtual void close(const frame& top) override final;
+
+      template<typename T>
+      void write_value(const T& value)
+      {
+        static_assert(std::is_integral<T>::value, "unexpected value type");
+        out_ += std::to_string(value);
+      }
+
+      void write_value(std::int8_t value) { out_ += std::to_string(int(value)); }
+      void write_value(std::uint8_t value) { out_ += std::to_string(int(value)); }
+      void write_value(bool value) { out_ += (value ? "true" : "false"); }
+      void write_value(double value);
+      void write_value(const std::string& value) { write_string(value); }
+
+    public:
+      //! Appends to `out`, which must outlive `this`.
+      json_writer(std::string& out, std::size_t indent = 0, bool insert_newlines = true);
+
+      hsection open_section(boost::string_ref name, hsection parent, bool create_if_notexist = true);
+
+      template<typename T>
+      bool set_value(boost::string_ref name, const T& value, hsection parent)
+      {
+        write_name(parent, name);
+        write_value(value);
+        return true;
+      }
+
+      bool set_value(boost::string_ref name, const storage_entry& value, hsection parent);
+
+      template<typename T>
+      harray insert_first_value(boost::string_ref name, const T& value, hsection parent)
+      {
+        const std::size_t indent = write_name(parent, name);
+        out_.push_back('[');
+        const harray array = push(indent, stream_type_code<T>::value);
+        insert_next_value(array, value);
+        return array;
+      }
+
+      template<typename T>
+      bool insert_next_value(harray array, const T& value)
+      {
+        begin_element(array, stream_type_code<T>::value);
+        write_value(value);
+        return true;
+      }
+
+      harray insert_first_section(boost::string_ref name, hsection& child, hsection parent);
+      bool insert_next_section(harray array, hsection& child);
+    };
+  }
+}
@@ -0,0 +1,193 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "net/http_client_pool.h"
+
+#include <stdexcept>
+#include <utility>
+
+#include "misc_log_ex.h"
+#include "net/net_parse_helpers.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "net.http"
+
+namespace epee
+{
+namespace net_utils
+{
+namespace http
+{
+  client_pool::lease::lease(client_pool& pool, std::unique_ptr<abstract_http_client> client, const std::uint64_t generation)
+    : pool_(std::addressof(pool)),
+      client_(std::move(client)),
+      generation_(generation),
+      sent_(client_->get_bytes_sent()),
+      received_(client_->get_bytes_received())
+  {}
+
+  client_pool::lease::lease(lease&& rhs) noexcept
+    : pool_(rhs.pool_),
+      client_(std::move(rhs.client_)),
+      generation_(rhs.generation_),
+      sent_(rhs.sent_),
+      received_(rhs.received_)
+  {
+    rhs.pool_ = nullptr;
+  }
+
+  client_pool::lease& client_pool::lease::operator=(lease&& rhs) noexcept
+  {
+    if (this != std::addressof(rhs))
+    {
+      if (pool_)
+        pool_->release(*this);
+      pool_ = rhs.pool_;
+      client_ = std::move(rhs.client_);
+      generation_ = rhs.generation_;
+      sent_ = rhs.sent_;
+      received_ = rhs.received_;
+      rhs.pool_ = nullptr;
+    }
+    return *this;
+  }
+
+  client_pool::lease::~lease() noexcept
+  {
+    if (pool_)
+      pool_->release(*this);
+  }
+
+  client_pool::client_pool(std::unique_ptr<http_client_factory> factory, const std::size_t max_idle)
+    : sync_(),
+      factory_(std::move(factory)),
+      idle_(),
+      max_idle_(max_idle),
+      address_(),
+      user_(),
+      ssl_options_(ssl_support_t::e_ssl_support_autodetect),
+      proxy_(),
+      auto_connect_(true),
+      generation_(0),
+      sent_(0),
+      received_(0)
+  {
+    CHECK_AND_ASSERT_THROW_MES(factory_ != nullptr, "client_pool needs an http_client_factory");
+  }
+
+  void client_pool::invalidate()
+  {
+    ++generation_;
+    idle_.clear();
+  }
+
+  bool client_pool::set_server(const std::string& address, boost::optional<login> user, ssl_options_t ssl_options)
+  {
+    http::url_content parsed{};
+    CHECK_AND_ASSERT_MES(parse_url(address, parsed), false, "failed to parse url: " << address);
+
+    const boost::lock_guard<boost::mutex> lock{sync_};
+    address_ = address;
+    user_ = std::move(user);
+    ssl_options_ = std::move(ssl_options);
+    invalidate();
+    return true;
+  }
+
+  bool client_pool::set_proxy(const std::string& address)
+  {
+    const boost::lock_guard<boost::mutex> lock{sync_};
+    proxy_ = address;
+    invalidate();
+    return true;
+  }
+
+  void client_pool::set_auto_connect(const bool auto_connect)
+  {
+    const boost::lock_guard<boost::mutex> lock{sync_};
+    auto_connect_ = auto_connect;
+    for (const auto& client : idle_)
+      client->set_auto_connect(auto_connect);
+  }
+
+  void client_pool::disconnect()
+  {
+    const boost::lock_guard<boost::mutex> lock{sync_};
+    invalidate();
+  }
+
+  client_pool::lease client_pool::acquire()
+  {
+    const boost::lock_guard<boost::mutex> lock{sync_};
+    std::unique_ptr<abstract_http_client> client;
+    if (idle_.empty())
+    {
+      client = factory_->create();
+      if (!address_.empty() && !client->set_server(address_, user_, ssl_options_))
+        throw std::runtime_error{"client_pool: invalid server address"};
+      if (!client->set_proxy(proxy_))
+        throw std::runtime_error{"client_pool: invalid proxy address"};
+      client->set_auto_connect(auto_connect_);
+    }
+    else
+    {
+      client = std::move(idle_.back());
+      idle_.pop_back();
+    }
+    return lease{*this, std::move(client), generation_};
+  }
+
+  void client_pool::release(lease& source) noexcept
+  {
+    std::unique_ptr<abstract_http_client> client = std::move(source.client_);
+    source.pool_ = nullptr;
+    if (!client)
+      return;
+
+    const boost::lock_guard<boost::mutex> lock{sync_};
+    sent_ += client->get_bytes_sent() - source.sent_;
+    received_ += client->get_bytes_received() - source.received_;
+    if (source.generation_ == generation_ && idle_.size() < max_idle_ && client->is_connected())
+      idle_.push_back(std::move(client));
+  }
+
+  std::uint64_t client_pool::get_bytes_sent() const
+  {
+    const boost::lock_guard<boost::mutex> lock{sync_};
+    return sent_;
+  }
+
+  std::uint64_t client_pool::get_bytes_received() const
+  {
+    const boost::lock_guard<boost::mutex> lock{sync_};
+    return received_;
+  }
+} // http
+} // net_utils
+} // epee
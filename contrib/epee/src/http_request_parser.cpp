@@ -0,0 +1,385 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "net/http_request_parser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/utility/string_ref.hpp>
+#include <cstring>
+#include <limits>
+
+#include "misc_log_ex.h"
+#include "misc_os_dependent.h"
+#include "net/net_parse_helpers.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "net.http"
+
+namespace epee
+{
+namespace net_utils
+{
+namespace http
+{
+  namespace
+  {
+    std::atomic<std::uint64_t> parsed_count{0};
+    std::atomic<std::uint64_t> parsed_time{0};
+
+    char to_lower(const char c) noexcept
+    {
+      return ('A' <= c && c <= 'Z') ? char(c - 'A' + 'a') : c;
+    }
+
+    //! `expected` must be lowercase
+    bool iequals(const boost::string_ref value, const boost::string_ref expected) noexcept
+    {
+      if (value.size() != expected.size())
+        return false;
+      for (std::size_t i = 0; i < value.size(); ++i)
+      {
+        if (to_lower(value[i]) != expected[i])
+          return false;
+      }
+      return true;
+    }
+
+    bool is_digit(const char c) noexcept
+    {
+      return '0' <= c && c <= '9';
+    }
+
+    bool is_name_char(const char c) noexcept
+    {
+      return is_digit(c) || ('a' <= to_lower(c) && to_lower(c) <= 'z') || c == '_' || c == '-';
+    }
+
+    //! Strips `\n` and an optional `\r` from the end of `line`
+    boost::string_ref strip_newline(boost::string_ref line) noexcept
+    {
+      if (!line.empty() && line.back() == '\n')
+        line.remove_suffix(1);
+      if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+      return line;
+    }
+
+    //! Reads the digits at the front of `source`.
+    bool read_number(boost::string_ref& source, std::size_t& out) noexcept
+    {
+      if (source.empty() || !is_digit(source[0]))
+        return false;
+      out = 0;
+      while (!source.empty() && is_digit(source[0]))
+      {
+        const std::size_t digit = source[0] - '0';
+        if ((std::numeric_limits<std::size_t>::max() - digit) / 10 < out)
+          return false;
+        out = out * 10 + digit;
+        source.remove_prefix(1);
+      }
+      return true;
+    }
+
+    http_method get_method(const boost::string_ref method) noexcept
+    {
+      if (iequals(method, "get"))
+        return http_method_get;
+      if (iequals(method, "post"))
+        return http_method_post;
+      if (iequals(method, "options"))
+        return http_method_options;
+      if (iequals(method, "head"))
+        return http_method_head;
+      if (iequals(method, "put"))
+        return http_method_put;
+      if (iequals(method, "delete") || iequals(method, "trace"))
+        return http_method_etc;
+      return http_method_unknown;
+    }
+  }
+
+  request_parser_stats get_request_parser_stats() noexcept
+  {
+    return {parsed_count.load(std::memory_order_relaxed), parsed_time.load(std::memory_order_relaxed)};
+  }
+
+  void clear_request_parser_stats() noexcept
+  {
+    parsed_count = 0;
+    parsed_time = 0;
+  }
+
+  request_parser::request_parser() noexcept
+    : time_(0), newlines_(0), line_start_(0), remaining_(0), state_(state::newlines)
+  {}
+
+  void request_parser::reset() noexcept
+  {
+    *this = request_parser{};
+  }
+
+  request_parser::status request_parser::parse(epee::span<const char>& in, http_request_info& out)
+  {
+    const std::uint64_t start = misc_utils::get_ns_count();
+    const status result = run(in, out);
+    time_ += misc_utils::get_ns_count() - start;
+    if (result == status::complete)
+    {
+      parsed_count.fetch_add(1, std::memory_order_relaxed);
+      parsed_time.fetch_add(time_, std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+  request_parser::status request_parser::run(epee::span<const char>& in, http_request_info& out)
+  {
+    while (!in.empty() || state_ == state::done || state_ == state::failed)
+    {
+      switch (state_)
+      {
+      case state::newlines:
+      {
+        // some clients send line breaks before the request line
+        std::size_t count = 0;
+        while (count < in.size() && (in[count] == '\r' || in[count] == '\n'))
+          ++count;
+        newlines_ += in.remove_prefix(count);
+        if (newlines_ > HTTP_MAX_STARTING_NEWLINES)
+        {
+          MERROR("Too many starting newlines");
+          state_ = state::failed;
+          break;
+        }
+        if (!in.empty())
+          state_ = state::request_line;
+        break;
+      }
+      case state::request_line:
+      {
+        const char* const newline = static_cast<const char*>(std::memchr(in.data(), '\n', in.size()));
+        const std::size_t length = newline ? newline - in.data() + 1 : in.size();
+        if (HTTP_MAX_URI_LEN < out.m_full_request_str.size() + length)
+        {
+          MERROR("Too long URI line");
+          state_ = state::failed;
+          break;
+        }
+        out.m_full_request_str.append(in.data(), length);
+        in.remove_prefix(length);
+        if (newline)
+          state_ = finish_request_line(out) ? state::headers : state::failed;
+        break;
+      }
+      case state::headers:
+      {
+        const char* const newline = static_cast<const char*>(std::memchr(in.data(), '\n', in.size()));
+        const std::size_t length = newline ? newline - in.data() + 1 : in.size();
+        if (HTTP_MAX_HEADER_LEN < out.m_request_head.size() + length)
+        {
+          MERROR("Too long header area");
+          state_ = state::failed;
+          break;
+        }
+        out.m_request_head.append(in.data(), length);
+        in.remove_prefix(length);
+        if (!newline)
+          break;
+
+        const std::size_t begin = line_start_;
+        line_start_ = out.m_request_head.size();
+        if (strip_newline({out.m_request_head.data() + begin, line_start_ - begin}).empty())
+        {
+          if (!finish_headers(out))
+            state_ = state::failed;
+          else if (remaining_)
+            state_ = state::body;
+          else
+            state_ = state::done;
+        }
+        else
+          finish_header_line(out, begin, line_start_);
+        break;
+      }
+      case state::body:
+      {
+        const std::size_t length = std::min(remaining_, in.size());
+        out.m_body.append(in.data(), length);
+        in.remove_prefix(length);
+        remaining_ -= length;
+        if (!remaining_)
+          state_ = state::done;
+        break;
+      }
+      case state::done:
+        return status::complete;
+      default:
+      case state::failed:
+        return status::error;
+      }
+    }
+    return status::incomplete;
+  }
+
+  bool request_parser::finish_request_line(http_request_info& out)
+  {
+    // METHOD SP URI SP HTTP/major.minor
+    boost::string_ref line = strip_newline(out.m_full_request_str);
+
+    const std::size_t method_end = line.find(' ');
+    if (method_end == boost::string_ref::npos)
+    {
+      MERROR("Failed to match first line: " << out.m_full_request_str);
+      return false;
+    }
+    const boost::string_ref method = line.substr(0, method_end);
+    out.m_http_method = get_method(method);
+    if (out.m_http_method == http_method_unknown)
+    {
+      MERROR("Failed to match first line: " << out.m_full_request_str);
+      return false;
+    }
+    line.remove_prefix(method_end + 1);
+
+    const std::size_t uri_end = line.find(' ');
+    if (uri_end == 0 || uri_end == boost::string_ref::npos)
+    {
+      MERROR("Failed to match first line: " << out.m_full_request_str);
+      return false;
+    }
+    const boost::string_ref uri = line.substr(0, uri_end);
+    line.remove_prefix(uri_end + 1);
+
+    std::size_t major = 0;
+    std::size_t minor = 0;
+    if (line.size() < 5 || !iequals(line.substr(0, 5), "http/"))
+    {
+      MERROR("Failed to match first line: " << out.m_full_request_str);
+      return false;
+    }
+    line.remove_prefix(5);
+    if (!read_number(line, major) || line.empty() || line[0] != '.')
+    {
+      MERROR("Failed to analyze method");
+      return false;
+    }
+    line.remove_prefix(1);
+    if (!read_number(line, minor) || !line.empty() ||
+        std::numeric_limits<int>::max() < major || std::numeric_limits<int>::max() < minor)
+    {
+      MERROR("Failed to analyze method");
+      return false;
+    }
+
+    out.m_http_method_str.assign(method.data(), method.size());
+    out.m_URI.assign(uri.data(), uri.size());
+    out.m_http_ver_hi = int(major);
+    out.m_http_ver_lo = int(minor);
+    if (!parse_uri(out.m_URI, out.m_uri_content))
+    {
+      MERROR("Failed to parse URI: " << out.m_URI);
+      return false;
+    }
+    return true;
+  }
+
+  void request_parser::finish_header_line(http_request_info& out, const std::size_t begin, const std::size_t end)
+  {
+    // Name ?: ?value
+    boost::string_ref line = strip_newline({out.m_request_head.data() + begin, end - begin});
+
+    std::size_t name_end = 0;
+    while (name_end < line.size() && is_name_char(line[name_end]))
+      ++name_end;
+    const boost::string_ref name = line.substr(0, name_end);
+    line.remove_prefix(name_end);
+    if (!line.empty() && line[0] == ' ')
+      line.remove_prefix(1);
+    if (name.empty() || line.empty() || line[0] != ':')
+    {
+      MDEBUG("Ignoring malformed header line: " << strip_newline({out.m_request_head.data() + begin, end - begin}));
+      return;
+    }
+    line.remove_prefix(1);
+    if (!line.empty() && line[0] == ' ')
+      line.remove_prefix(1);
+
+    http_header_info& info = out.m_header_info;
+    std::string* field = nullptr;
+    if (iequals(name, "connection"))
+      field = &info.m_connection;
+    else if (iequals(name, "referer"))
+      field = &info.m_referer;
+    else if (iequals(name, "content-length"))
+      field = &info.m_content_length;
+    else if (iequals(name, "content-type"))
+      field = &info.m_content_type;
+    else if (iequals(name, "transfer-encoding"))
+      field = &info.m_transfer_encoding;
+    else if (iequals(name, "content-encoding"))
+      field = &info.m_content_encoding;
+    else if (iequals(name, "host"))
+      field = &info.m_host;
+    else if (iequals(name, "cookie"))
+      field = &info.m_cookie;
+    else if (iequals(name, "user-agent"))
+      field = &info.m_user_agent;
+    else if (iequals(name, "origin"))
+      field = &info.m_origin;
+
+    if (field)
+      field->assign(line.data(), line.size());
+    else
+      info.m_etc_fields.emplace_back(std::string{name.data(), name.size()}, std::string{line.data(), line.size()});
+  }
+
+  bool request_parser::finish_headers(http_request_info& out)
+  {
+    out.m_full_request_buf_size = out.m_request_head.size();
+    LOG_PRINT_L3("HTTP HEAD:\r\n" << out.m_request_head);
+
+    // a body is only expected with "Content-Length"
+    remaining_ = 0;
+    const std::string& length = out.m_header_info.m_content_length;
+    if (length.empty())
+      return true;
+
+    boost::string_ref digits{length};
+    while (!digits.empty() && !is_digit(digits[0]))
+      digits.remove_prefix(1);
+    if (!read_number(digits, remaining_))
+    {
+      MERROR("Failed to get_len_from_content_lenght(), m_content_length=" << length);
+      return false;
+    }
+    return true;
+  }
+}
+}
+}
@@ -138,6 +138,8 @@ network_throttle::network_throttle(const std::string &nameshort, const std::stri
 	m_history.resize(m_window_size);
 	m_total_packets = 0;
 	m_total_bytes = 0;
+	m_tokens = 0;
+	m_tokens_time = 0;
 }
 
 void network_throttle::set_name(const std::string &name) 
@@ -220,6 +222,29 @@ network_time_seconds network_throttle::get_sleep_time_after_tick(size_t packet_s
 	return get_sleep_time(packet_size);
 }
 
+// The bucket refills at the target speed and holds at most one second of traffic. Reservations are
+// never refused: the bucket goes into debt instead, and every later caller waits until the debt in
+// front of it is paid. Callers reserving one chunk at a time are therefore served in turn, without
+// anybody sleeping on the thread that reserves.
+network_time_seconds network_throttle::reserve(size_t packet_size)
+{
+	if (m_target_speed <= 0)
+		return 0;
+
+	const network_time_seconds now = get_time_seconds();
+	const double capacity = m_target_speed;
+	if (m_tokens_time == 0)
+		m_tokens = capacity;
+	else
+		m_tokens = std::min(capacity, m_tokens + (now - m_tokens_time) * m_target_speed);
+	m_tokens_time = now;
+
+	m_tokens -= packet_size;
+	if (m_tokens >= 0)
+		return 0;
+	return -m_tokens / m_target_speed;
+}
+
 void network_throttle::logger_handle_net(const std::string &filename, double time, size_t size) {
     static boost::mutex mutex;
 
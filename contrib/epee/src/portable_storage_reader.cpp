@@ -0,0 +1,392 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "storages/portable_storage_reader.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "storages/portable_storage_from_bin.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "serialization"
+
+namespace epee
+{
+namespace serialization
+{
+  namespace
+  {
+    constexpr const std::size_t header_size = 4 + 4 + 1;
+
+    std::size_t pod_size(const std::uint8_t type) noexcept
+    {
+      switch (type)
+      {
+      case SERIALIZE_TYPE_INT64:
+      case SERIALIZE_TYPE_UINT64:
+      case SERIALIZE_TYPE_DUOBLE:
+        return 8;
+      case SERIALIZE_TYPE_INT32:
+      case SERIALIZE_TYPE_UINT32:
+        return 4;
+      case SERIALIZE_TYPE_INT16:
+      case SERIALIZE_TYPE_UINT16:
+        return 2;
+      case SERIALIZE_TYPE_INT8:
+      case SERIALIZE_TYPE_UINT8:
+      case SERIALIZE_TYPE_BOOL:
+        return 1;
+      default:
+        break;
+      }
+      return 0;
+    }
+
+    bool name_less(const section_view::entry& lhs, const section_view::entry& rhs) noexcept
+    {
+      return lhs.name < rhs.name;
+    }
+  }
+
+  binary_reader::binary_reader()
+    : root_(),
+      sections_(),
+      arrays_(),
+      end_(nullptr),
+      objects_(0),
+      fields_(0),
+      strings_(0),
+      limits_{std::numeric_limits<std::size_t>::max(), std::numeric_limits<std::size_t>::max(), std::numeric_limits<std::size_t>::max()}
+  {}
+
+  bool binary_reader::load_from_binary(const epee::span<const std::uint8_t> source, const limits_t *limits)
+  {
+    root_.entries.clear();
+    sections_.clear();
+    arrays_.clear();
+    objects_ = 0;
+    fields_ = 0;
+    strings_ = 0;
+    end_ = source.data() + source.size();
+
+    if (source.size() < header_size)
+    {
+      LOG_ERROR("binary_reader: wrong binary format, packet size = " << source.size() << " less than expected storage header size=" << header_size);
+      return false;
+    }
+    const std::uint8_t* position = source.data();
+    const std::uint32_t signature_a = read_pod<std::uint32_t>(position);
+    const std::uint32_t signature_b = read_pod<std::uint32_t>(position);
+    if (signature_a != PORTABLE_STORAGE_SIGNATUREA || signature_b != PORTABLE_STORAGE_SIGNATUREB)
+    {
+      LOG_ERROR("binary_reader: wrong binary format - signature mismatch");
+      return false;
+    }
+    const std::uint8_t version = read_pod<std::uint8_t>(position);
+    if (version != PORTABLE_STORAGE_FORMAT_VER)
+    {
+      LOG_ERROR("binary_reader: wrong binary format - unknown format ver = " << unsigned(version));
+      return false;
+    }
+
+    TRY_ENTRY();
+    CHECK_AND_ASSERT_THROW_MES(position != end_, "binary_reader: empty storage");
+    if (limits)
+      limits_ = *limits;
+    index(root_, position, true);
+    return true;
+    CATCH_ENTRY("binary_reader::load_from_binary", false);
+  }
+
+  void binary_reader::need(const std::uint8_t* const position, const std::size_t bytes) const
+  {
+    const std::size_t remaining = end_ - position;
+    CHECK_AND_ASSERT_THROW_MES(bytes <= remaining, " attempt to read " << bytes << " bytes from buffer with " << remaining << " bytes remained");
+  }
+
+  std::size_t binary_reader::read_varint(const std::uint8_t*& position) noexcept
+  {
+    const std::size_t bytes = std::size_t(1) << (*position & PORTABLE_RAW_SIZE_MARK_MASK);
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < bytes; ++i)
+      value |= std::uint64_t(position[i]) << (8 * i);
+    position += bytes;
+    return value >> 2;
+  }
+
+  void binary_reader::read_string(const std::uint8_t*& position, std::string& value)
+  {
+    const std::size_t length = read_varint(position);
+    value.assign(reinterpret_cast<const char*>(position), length);
+    position += length;
+  }
+
+  const std::uint8_t* binary_reader::index(section_view& view, const std::uint8_t* position, const bool validate)
+  {
+    view.entries.clear();
+
+    need(position, 1);
+    need(position, std::size_t(1) << (*position & PORTABLE_RAW_SIZE_MARK_MASK));
+    std::size_t count = read_varint(position);
+    if (validate)
+    {
+      CHECK_AND_ASSERT_THROW_MES(count <= limits_.n_fields - fields_, "Too many object fields");
+      fields_ += count;
+    }
+
+    // a field takes at least 4 bytes (name length, name, type and value)
+    view.entries.reserve(std::min<std::size_t>(count, (end_ - position) / 4));
+    while (count--)
+    {
+      need(position, 1);
+      const std::size_t length = *position++;
+      CHECK_AND_ASSERT_THROW_MES(length > 0, "Section name is missing");
+      need(position, length + 1);
+      const boost::string_ref name{reinterpret_cast<const char*>(position), length};
+      position += length;
+
+      const std::uint8_t type = *position;
+      view.entries.push_back({name, position, type});
+      ++position;
+      skip_value(position, type, 1, validate);
+    }
+
+    std::sort(view.entries.begin(), view.entries.end(), name_less);
+    const auto duplicate = std::adjacent_find(view.entries.begin(), view.entries.end(),
+      [] (const section_view::entry& lhs, const section_view::entry& rhs) { return lhs.name == rhs.name; });
+    CHECK_AND_ASSERT_THROW_MES(duplicate == view.entries.end(), "duplicate key: " << duplicate->name);
+    return position;
+  }
+
+  void binary_reader::skip_value(const std::uint8_t*& position, const std::uint8_t type, const std::size_t depth, const bool validate)
+  {
+    if (type & SERIALIZE_FLAG_ARRAY)
+      return skip_array(position, type & ~SERIALIZE_FLAG_ARRAY, depth, validate);
+
+    const std::size_t size = pod_size(type);
+    if (size)
+    {
+      need(position, size);
+      position += size;
+      return;
+    }
+
+    switch (type)
+    {
+    case SERIALIZE_TYPE_STRING:
+      if (validate)
+      {
+        CHECK_AND_ASSERT_THROW_MES(strings_ < limits_.n_strings, "Too many strings");
+        ++strings_;
+      }
+      skip_array(position, 0, depth, validate);
+      return;
+    case SERIALIZE_TYPE_OBJECT:
+      if (validate)
+      {
+        CHECK_AND_ASSERT_THROW_MES(objects_ < limits_.n_objects, "Too many objects");
+        ++objects_;
+      }
+      skip_section(position, depth + 1, validate);
+      return;
+    case SERIALIZE_TYPE_ARRAY:
+    {
+      need(position, 1);
+      const std::uint8_t array_type = *position++;
+      CHECK_AND_ASSERT_THROW_MES(array_type & SERIALIZE_FLAG_ARRAY, "wrong type sequenses");
+      skip_array(position, array_type & ~SERIALIZE_FLAG_ARRAY, depth + 1, validate);
+      return;
+    }
+    default:
+      break;
+    }
+    ASSERT_MES_AND_THROW("unknown entry_type code = " << unsigned(type));
+  }
+
+  // `type == 0` skips the characters of one string
+  void binary_reader::skip_array(const std::uint8_t*& position, const std::uint8_t type, const std::size_t depth, const bool validate)
+  {
+    CHECK_AND_ASSERT_THROW_MES(depth < EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL, "Wrong blob data in portable storage: recursion limitation (" << EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL << ") exceeded");
+    need(position, 1);
+    need(position, std::size_t(1) << (*position & PORTABLE_RAW_SIZE_MARK_MASK));
+    const std::size_t count = read_varint(position);
+    const std::size_t remaining = end_ - position;
+
+    if (type == 0)
+    {
+      CHECK_AND_ASSERT_THROW_MES(count < MAX_STRING_LEN_POSSIBLE, "to big string len value in storage: " << count);
+      CHECK_AND_ASSERT_THROW_MES(count <= remaining, "string len count value " << count << " goes out of remain storage len " << remaining);
+      position += count;
+      return;
+    }
+
+    const std::size_t size = pod_size(type);
+    if (size)
+    {
+      CHECK_AND_ASSERT_THROW_MES(count <= remaining / size, "Size sanity check failed");
+      position += count * size;
+      return;
+    }
+
+    switch (type)
+    {
+    case SERIALIZE_TYPE_STRING:
+      CHECK_AND_ASSERT_THROW_MES(count <= remaining / ps_min_bytes<std::string>::strict, "Size sanity check failed");
+      if (validate)
+      {
+        CHECK_AND_ASSERT_THROW_MES(count <= limits_.n_strings - strings_, "Too many strings");
+        strings_ += count;
+      }
+      for (std::size_t i = 0; i < count; ++i)
+        skip_array(position, 0, depth, validate);
+      return;
+    case SERIALIZE_TYPE_OBJECT:
+      CHECK_AND_ASSERT_THROW_MES(count <= remaining / ps_min_bytes<section>::strict, "Size sanity check failed");
+      if (validate)
+      {
+        CHECK_AND_ASSERT_THROW_MES(count <= limits_.n_objects - objects_, "Too many objects");
+        objects_ += count;
+      }
+      for (std::size_t i = 0; i < count; ++i)
+        skip_section(position, depth + 1, validate);
+      return;
+    case SERIALIZE_TYPE_ARRAY:
+      CHECK_AND_ASSERT_THROW_MES(count == 0, "Reading array entry is not supported");
+      return;
+    default:
+      break;
+    }
+    ASSERT_MES_AND_THROW("unknown entry_type code = " << unsigned(type));
+  }
+
+  void binary_reader::skip_section(const std::uint8_t*& position, const std::size_t depth, const bool validate)
+  {
+    CHECK_AND_ASSERT_THROW_MES(depth < EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL, "Wrong blob data in portable storage: recursion limitation (" << EPEE_PORTABLE_STORAGE_RECURSION_LIMIT_INTERNAL << ") exceeded");
+    need(position, 1);
+    need(position, std::size_t(1) << (*position & PORTABLE_RAW_SIZE_MARK_MASK));
+    std::size_t count = read_varint(position);
+    if (validate)
+    {
+      CHECK_AND_ASSERT_THROW_MES(count <= limits_.n_fields - fields_, "Too many object fields");
+      fields_ += count;
+    }
+
+    while (count--)
+    {
+      need(position, 1);
+      const std::size_t length = *position++;
+      CHECK_AND_ASSERT_THROW_MES(length > 0, "Section name is missing");
+      need(position, length + 1);
+      position += length;
+      const std::uint8_t type = *position++;
+      skip_value(position, type, depth, validate);
+    }
+  }
+
+  const section_view::entry* binary_reader::find(const boost::string_ref name, hsection parent) const
+  {
+    const section_view& view = parent ? *parent : root_;
+    const auto match = std::lower_bound(view.entries.begin(), view.entries.end(), name,
+      [] (const section_view::entry& lhs, const boost::string_ref rhs) { return lhs.name < rhs; });
+    if (match == view.entries.end() || match->name != name)
+      return nullptr;
+    return std::addressof(*match);
+  }
+
+  section_view* binary_reader::open_section(const boost::string_ref name, hsection parent, bool)
+  {
+    TRY_ENTRY();
+    const section_view::entry* const field = find(name, parent);
+    if (!field || field->type != SERIALIZE_TYPE_OBJECT)
+      return nullptr;
+    sections_.emplace_back();
+    index(sections_.back(), field->value + 1, false);
+    return std::addressof(sections_.back());
+    CATCH_ENTRY("binary_reader::open_section", nullptr);
+  }
+
+  bool binary_reader::get_value(const boost::string_ref name, storage_entry& value, hsection parent)
+  {
+    const section_view::entry* const field = find(name, parent);
+    if (!field)
+      return false;
+    throwable_buffer_reader source{field->value, std::size_t(end_ - field->value)};
+    value = source.load_storage_entry();
+    return true;
+  }
+
+  array_view* binary_reader::open_array(const boost::string_ref name, hsection parent)
+  {
+    const section_view::entry* const field = find(name, parent);
+    if (!field)
+      return nullptr;
+
+    const std::uint8_t* position = field->value + 1;
+    std::uint8_t type = field->type;
+    if (type == SERIALIZE_TYPE_ARRAY)
+      type = *position++;
+    if (!(type & SERIALIZE_FLAG_ARRAY))
+      return nullptr;
+
+    const std::size_t count = read_varint(position);
+    if (!count)
+      return nullptr;
+    arrays_.push_back({position, count, std::uint8_t(type & ~SERIALIZE_FLAG_ARRAY), nullptr});
+    return std::addressof(arrays_.back());
+  }
+
+  array_view* binary_reader::get_first_section(const boost::string_ref name, hsection& child, hsection parent)
+  {
+    TRY_ENTRY();
+    const harray array = open_array(name, parent);
+    if (!array || array->type != SERIALIZE_TYPE_OBJECT || !get_next_section(array, child))
+      return nullptr;
+    return array;
+    CATCH_ENTRY("binary_reader::get_first_section", nullptr);
+  }
+
+  bool binary_reader::get_next_section(harray array, hsection& child)
+  {
+    TRY_ENTRY();
+    CHECK_AND_ASSERT(array, false);
+    if (!array->remaining || array->type != SERIALIZE_TYPE_OBJECT)
+      return false;
+    if (!array->element)
+    {
+      sections_.emplace_back();
+      array->element = std::addressof(sections_.back());
+    }
+    --array->remaining;
+    array->next = index(*array->element, array->next, false);
+    child = array->element;
+    return true;
+    CATCH_ENTRY("binary_reader::get_next_section", false);
+  }
+}
+}
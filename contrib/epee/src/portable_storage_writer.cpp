@@ -0,0 +1,267 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "storages/portable_storage_writer.h"
+
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+#include "storages/portable_storage_to_json.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "serialization"
+
+namespace epee
+{
+namespace serialization
+{
+  void stream_writer::finish()
+  {
+    while (!frames_.empty())
+    {
+      close(frames_.back());
+      frames_.pop_back();
+    }
+  }
+
+  std::size_t stream_writer::enter(const stream_handle handle)
+  {
+    CHECK_AND_ASSERT_THROW_MES(handle.depth < frames_.size(), "stream_writer: section or array was already closed");
+    while (handle.depth + 1 < frames_.size())
+    {
+      close(frames_.back());
+      frames_.pop_back();
+    }
+    return handle.depth;
+  }
+
+  std::size_t stream_writer::enter_section(const stream_handle parent)
+  {
+    const std::size_t index = enter(parent);
+    CHECK_AND_ASSERT_THROW_MES(frames_[index].type == 0, "stream_writer: expected a section handle");
+    return index;
+  }
+
+  std::size_t stream_writer::enter_array(const stream_handle array, const std::uint8_t type)
+  {
+    const std::size_t index = enter(array);
+    CHECK_AND_ASSERT_THROW_MES(frames_[index].type == type, "stream_writer: unexpected array element type " << unsigned(type));
+    return index;
+  }
+
+  stream_handle stream_writer::push(const std::size_t mark, const std::uint8_t type)
+  {
+    frames_.push_back({0, mark, type});
+    return stream_handle{frames_.size() - 1};
+  }
+
+  binary_writer::binary_writer(byte_stream& out)
+    : stream_writer(), out_(out)
+  {
+    const std::uint32_t signature_a = SWAP32LE(PORTABLE_STORAGE_SIGNATUREA);
+    const std::uint32_t signature_b = SWAP32LE(PORTABLE_STORAGE_SIGNATUREB);
+    out_.write(reinterpret_cast<const char*>(&signature_a), sizeof(signature_a));
+    out_.write(reinterpret_cast<const char*>(&signature_b), sizeof(signature_b));
+    out_.put(PORTABLE_STORAGE_FORMAT_VER);
+    begin(0);
+  }
+
+  void binary_writer::write_name(const stream_handle parent, const boost::string_ref name)
+  {
+    CHECK_AND_ASSERT_THROW_MES(name.size() < std::numeric_limits<std::uint8_t>::max(), "storage_entry_name is too long: " << name.size() << ", val: " << name);
+    CHECK_AND_ASSERT_THROW_MES(!name.empty(), "storage_entry_name is empty");
+    ++frames_[enter_section(parent)].count;
+    out_.put(std::uint8_t(name.size()));
+    out_.write(name.data(), name.size());
+  }
+
+  void binary_writer::write_name(const stream_handle parent, const boost::string_ref name, const std::uint8_t type)
+  {
+    write_name(parent, name);
+    out_.put(type);
+  }
+
+  stream_handle binary_writer::begin(const std::uint8_t type)
+  {
+    // room for a 4 byte count, so closing never has to move the body
+    const stream_handle handle = push(out_.size(), type);
+    out_.put_n(0, 4);
+    return handle;
+  }
+
+  void binary_writer::close(const frame& top)
+  {
+    // readers take any width, no levin payload can hold more entries than this
+    CHECK_AND_ASSERT_THROW_MES(top.count <= 1073741823, "failed to pack varint - too big amount = " << top.count);
+    const std::uint32_t count = SWAP32LE(std::uint32_t((top.count << 2) | PORTABLE_RAW_SIZE_MARK_DWORD));
+    std::uint8_t* const position = out_.tellp() - out_.size() + top.mark;
+    std::memcpy(position, std::addressof(count), sizeof(count));
+  }
+
+  stream_handle binary_writer::open_section(const boost::string_ref name, const stream_handle parent, bool)
+  {
+    write_name(parent, name, SERIALIZE_TYPE_OBJECT);
+    return begin(0);
+  }
+
+  bool binary_writer::set_value(const boost::string_ref name, const storage_entry& value, const stream_handle parent)
+  {
+    write_name(parent, name);
+    return pack_entry_to_buff(out_, value); // writes the type too
+  }
+
+  stream_handle binary_writer::insert_first_section(const boost::string_ref name, stream_handle& child, const stream_handle parent)
+  {
+    write_name(parent, name, SERIALIZE_TYPE_OBJECT | SERIALIZE_FLAG_ARRAY);
+    const stream_handle array = begin(SERIALIZE_TYPE_OBJECT);
+    insert_next_section(array, child);
+    return array;
+  }
+
+  bool binary_writer::insert_next_section(const stream_handle array, stream_handle& child)
+  {
+    ++frames_[enter_array(array, SERIALIZE_TYPE_OBJECT)].count;
+    child = begin(0);
+    return true;
+  }
+
+  json_writer::json_writer(std::string& out, const std::size_t indent, const bool insert_newlines)
+    : stream_writer(), out_(out), newlines_(insert_newlines)
+  {
+    out_.push_back('{');
+    push(indent, 0);
+  }
+
+  std::size_t json_writer::write_name(const stream_handle parent, const boost::string_ref name)
+  {
+    frame& top = frames_[enter_section(parent)];
+    if (top.count++)
+      out_.push_back(',');
+    if (newlines_)
+      out_ += "\r\n";
+    write_indent(top.mark + 1);
+    write_string(name);
+    out_ += ": ";
+    return top.mark + 1;
+  }
+
+  void json_writer::begin_element(const stream_handle array, const std::uint8_t type)
+  {
+    if (frames_[enter_array(array, type)].count++)
+      out_.push_back(',');
+  }
+
+  void json_writer::write_indent(const std::size_t indent)
+  {
+    out_.append(indent * 2, ' ');
+  }
+
+  void json_writer::close(const frame& top)
+  {
+    if (top.type)
+    {
+      out_.push_back(']');
+      return;
+    }
+    if (newlines_)
+      out_ += "\r\n";
+    write_indent(top.mark);
+    out_.push_back('}');
+  }
+
+  void json_writer::write_value(const double value)
+  {
+    std::ostringstream ss;
+    ss << value;
+    out_ += ss.str();
+  }
+
+  void json_writer::write_string(const boost::string_ref value)
+  {
+    out_.push_back('"');
+    const char* start = value.data();
+    const char* const end = start + value.size();
+    for (const char* next = start; next != end; ++next)
+    {
+      const char* replacement = nullptr;
+      switch (*next)
+      {
+      case '\b': replacement = "\\b"; break;
+      case '\f': replacement = "\\f"; break;
+      case '\n': replacement = "\\n"; break;
+      case '\r': replacement = "\\r"; break;
+      case '\t': replacement = "\\t"; break;
+      case '\v': replacement = "\\v"; break;
+      case '"':  replacement = "\\\""; break;
+      case '\\': replacement = "\\\\"; break;
+      case '/':  replacement = "\\/"; break;
+      default: continue;
+      }
+      out_.append(start, next - start);
+      out_ += replacement;
+      start = next + 1;
+    }
+    out_.append(start, end - start);
+    out_.push_back('"');
+  }
+
+  stream_handle json_writer::open_section(const boost::string_ref name, const stream_handle parent, bool)
+  {
+    const std::size_t indent = write_name(parent, name);
+    out_.push_back('{');
+    return push(indent, 0);
+  }
+
+  bool json_writer::set_value(const boost::string_ref name, const storage_entry& value, const stream_handle parent)
+  {
+    const std::size_t indent = write_name(parent, name);
+    std::stringstream ss;
+    dump_as_json(ss, value, indent, newlines_);
+    out_ += ss.str();
+    return true;
+  }
+
+  stream_handle json_writer::insert_first_section(const boost::string_ref name, stream_handle& child, const stream_handle parent)
+  {
+    const std::size_t indent = write_name(parent, name);
+    out_.push_back('[');
+    const stream_handle array = push(indent, SERIALIZE_TYPE_OBJECT);
+    insert_next_section(array, child);
+    return array;
+  }
+
+  bool json_writer::insert_next_section(const stream_handle array, stream_handle& child)
+  {
+    begin_element(array, SERIALIZE_TYPE_OBJECT);
+    out_.push_back('{');
+    child = push(frames_[array.depth].mark, 0);
+    return true;
+  }
+}
+}
@@ -160,6 +160,11 @@ const command_line::arg_descriptor<bool> arg_db_salvage  = {
 , "Try to salvage a blockchain database if it seems corrupted"
 , false
 };
+const command_line::arg_descriptor<bool> arg_db_output_key_index  = {
+  "db-output-key-index"
+, "Build an index from output public keys to their global index (kept up to date from then on) for get_output_key_indices"
+, false
+};
 
 BlockchainDB *new_db()
 {
@@ -170,6 +175,7 @@ void BlockchainDB::init_options(boost::program_options::options_description& des
 {
   command_line::add_arg(desc, arg_db_sync_mode);
   command_line::add_arg(desc, arg_db_salvage);
+  command_line::add_arg(desc, arg_db_output_key_index);
 }
 
 void BlockchainDB::pop_block()
@@ -105,6 +105,7 @@ typedef std::pair<crypto::hash, uint64_t> tx_out_index;
 
 extern const command_line::arg_descriptor<std::string> arg_db_sync_mode;
 extern const command_line::arg_descriptor<bool, false> arg_db_salvage;
+extern const command_line::arg_descriptor<bool> arg_db_output_key_index;
 
 enum class relay_category : uint8_t
 {
@@ -139,6 +140,30 @@ struct tx_data_t
 };
 #pragma pack(pop)
 
+/**
+ * @brief where an output with a given public key was created
+ */
+struct output_key_index_t
+{
+  uint64_t     amount;        //!< the output's amount, 0 for RCT outputs
+  uint64_t     amount_index;  //!< the output's amount-specific (global) index
+  crypto::hash tx_hash;       //!< the transaction which created the output
+  uint64_t     local_index;   //!< the output's index in that transaction
+};
+
+/**
+ * @brief state of an incremental, in place blockchain pruning
+ */
+struct pruning_progress_t
+{
+  uint64_t txes_done;       //!< transactions gone through so far
+  uint64_t txes_total;      //!< transactions in the blockchain
+  uint64_t pruned_records;  //!< prunable records deleted by the last step
+  uint64_t pruned_bytes;    //!< bytes deleted by the last step
+  uint64_t free_pages;      //!< pages on the database free list, reused before the file grows
+  uint64_t page_size;       //!< the database page size
+};
+
 struct alt_block_data_t
 {
   uint64_t height;
@@ -193,6 +218,7 @@ struct txpool_tx_meta_t
 #define DBF_FASTEST    4
 #define DBF_RDONLY     8
 #define DBF_SALVAGE 0x10
+#define DBF_OUTPUT_KEY_INDEX 0x20
 
 /***********************************
  * Exception Definitions
@@ -1477,6 +1503,20 @@ public:
    */
   virtual void get_output_tx_and_index(const uint64_t& amount, const std::vector<uint64_t> &offsets, std::vector<tx_out_index> &indices) const = 0;
 
+  /**
+   * @brief looks up outputs by their public key
+   *
+   * This needs the output key index, which is built the first time the
+   * database is opened with DBF_OUTPUT_KEY_INDEX. Output keys are not
+   * unique on the chain, so each key may resolve to more than one output.
+   *
+   * @param keys a list of output public keys
+   * @param indices return-by-reference the outputs with each key, empty if there are none
+   *
+   * @return false if the database does not keep the output key index
+   */
+  virtual bool get_output_key_indices(const std::vector<crypto::public_key> &keys, std::vector<std::vector<output_key_index_t>> &indices) const = 0;
+
   /**
    * @brief gets outputs' data
    *
@@ -1626,6 +1666,31 @@ public:
    */
   virtual bool check_pruning() = 0;
 
+  /**
+   * @brief prunes part of the blockchain in place, in a single write transaction
+   *
+   * The first step sets the pruning seed, so new transactions are pruned
+   * as usual from then on. Each step then goes through the next max_txes
+   * stored transactions, in the same way as prune_blockchain. Progress is
+   * kept in the database, so pruning resumes where it stopped after a restart.
+   *
+   * @param max_txes the max number of transactions to go through
+   * @param progress return-by-reference the pruning state after this step
+   * @param pruning_seed the seed to use for the first step, 0 for default (highly recommended)
+   *
+   * @return true iff the whole blockchain is now pruned
+   */
+  virtual bool prune_blockchain_step(uint64_t max_txes, pruning_progress_t &progress, uint32_t pruning_seed = 0) = 0;
+
+  /**
+   * @brief gets the state of an incremental pruning
+   *
+   * @param progress return-by-reference the pruning state
+   *
+   * @return true iff an incremental pruning was started and is not finished
+   */
+  virtual bool get_pruning_progress(pruning_progress_t &progress) const = 0;
+
   /**
    * @brief get the max block size
    */
@@ -203,6 +203,7 @@ namespace
  *
  * output_txs       output ID    {txn hash, local index}
  * output_amounts   amount       [{amount output index, metadata}...]
+ * output_keys      output pubkey [{output ID, amount, amount output index}...]
  *
  * spent_keys       input hash   -
  *
@@ -218,6 +219,10 @@ namespace
  * (DUPFIXED saves 8 bytes per record.)
  *
  * The output_amounts table doesn't use a dummy key, but uses DUPSORT.
+ *
+ * The output_keys table is only filled once the DB has been opened with
+ * DBF_OUTPUT_KEY_INDEX. Output keys are not unique on the chain, so it
+ * also uses DUPSORT, with duplicates sorted by output ID.
  */
 const char* const LMDB_BLOCKS = "blocks";
 const char* const LMDB_BLOCK_HEIGHTS = "block_heights";
@@ -233,6 +238,7 @@ const char* const LMDB_TX_OUTPUTS = "tx_outputs";
 
 const char* const LMDB_OUTPUT_TXS = "output_txs";
 const char* const LMDB_OUTPUT_AMOUNTS = "output_amounts";
+const char* const LMDB_OUTPUT_KEYS = "output_keys";
 const char* const LMDB_SPENT_KEYS = "spent_keys";
 
 const char* const LMDB_TXPOOL_META = "txpool_meta";
@@ -358,6 +364,12 @@ typedef struct outtx {
     uint64_t local_index;
 } outtx;
 
+typedef struct outkeyref {
+    uint64_t output_id;
+    uint64_t amount;
+    uint64_t amount_index;
+} outkeyref;
+
 std::atomic<uint64_t> mdb_txn_safe::num_active_txns{0};
 std::atomic_flag mdb_txn_safe::creation_gate = ATOMIC_FLAG_INIT;
 
@@ -1091,9 +1103,44 @@ uint64_t BlockchainLMDB::add_output(const crypto::hash& tx_hash,
   if ((result = mdb_cursor_put(m_cur_output_amounts, &val_amount, &data, MDB_APPENDDUP)))
       throw0(DB_ERROR(lmdb_error("Failed to add output pubkey to db transaction: ", result).c_str()));
 
+  if (m_output_key_index)
+    add_output_key(ok.data.pubkey, ok.output_id, tx_output.amount, ok.amount_index);
+
   return ok.amount_index;
 }
 
+void BlockchainLMDB::add_output_key(const crypto::public_key& pubkey, uint64_t output_id, uint64_t amount, uint64_t amount_index)
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  mdb_txn_cursors *m_cursors = &m_wcursors;
+  CURSOR(output_keys)
+
+  outkeyref ref = {output_id, amount, amount_index};
+  MDB_val_set(k, pubkey);
+  MDB_val_set(v, ref);
+  int result = mdb_cursor_put(m_cur_output_keys, &k, &v, MDB_NODUPDATA);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to add output key to db transaction: ", result).c_str()));
+}
+
+void BlockchainLMDB::remove_output_key(const crypto::public_key& pubkey, uint64_t output_id)
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  mdb_txn_cursors *m_cursors = &m_wcursors;
+  CURSOR(output_keys)
+
+  MDB_val_set(k, pubkey);
+  MDB_val_set(v, output_id);
+  int result = mdb_cursor_get(m_cur_output_keys, &k, &v, MDB_GET_BOTH);
+  if (result == MDB_NOTFOUND)
+    throw0(DB_ERROR("Unexpected: output key not found in m_output_keys"));
+  else if (result)
+    throw0(DB_ERROR(lmdb_error("Error looking up output key: ", result).c_str()));
+  result = mdb_cursor_del(m_cur_output_keys, 0);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Error deleting output key: ", result).c_str()));
+}
+
 void BlockchainLMDB::add_tx_amount_output_indices(const uint64_t tx_id,
     const std::vector<uint64_t>& amount_output_indices)
 {
@@ -1158,6 +1205,8 @@ void BlockchainLMDB::remove_output(const uint64_t amount, const uint64_t& out_in
     throw0(DB_ERROR(lmdb_error("DB error attempting to get an output", result).c_str()));
 
   const pre_rct_outkey *ok = (const pre_rct_outkey *)v.mv_data;
+  const crypto::public_key pubkey = ok->data.pubkey;
+  const uint64_t output_id = ok->output_id;
   MDB_val_set(otxk, ok->output_id);
   result = mdb_cursor_get(m_cur_output_txs, (MDB_val *)&zerokval, &otxk, MDB_GET_BOTH);
   if (result == MDB_NOTFOUND)
@@ -1176,6 +1225,9 @@ void BlockchainLMDB::remove_output(const uint64_t amount, const uint64_t& out_in
   result = mdb_cursor_del(m_cur_output_amounts, 0);
   if (result)
     throw0(DB_ERROR(lmdb_error(std::string("Error deleting amount for output index ").append(boost::lexical_cast<std::string>(out_index).append(": ")).c_str(), result).c_str()));
+
+  if (m_output_key_index)
+    remove_output_key(pubkey, output_id);
 }
 
 void BlockchainLMDB::prune_outputs(uint64_t amount)
@@ -1202,10 +1254,15 @@ void BlockchainLMDB::prune_outputs(uint64_t amount)
   MINFO(num_elems << " outputs found");
   std::vector<uint64_t> output_ids;
   output_ids.reserve(num_elems);
+  std::vector<crypto::public_key> pubkeys;
+  if (m_output_key_index)
+    pubkeys.reserve(num_elems);
   while (1)
   {
     const pre_rct_outkey *okp = (const pre_rct_outkey *)v.mv_data;
     output_ids.push_back(okp->output_id);
+    if (m_output_key_index)
+      pubkeys.push_back(okp->data.pubkey);
     MDEBUG("output id " << okp->output_id);
     result = mdb_cursor_get(m_cur_output_amounts, &k, &v, MDB_NEXT_DUP);
     if (result == MDB_NOTFOUND)
@@ -1230,6 +1287,9 @@ void BlockchainLMDB::prune_outputs(uint64_t amount)
     if (result)
       throw0(DB_ERROR(lmdb_error("Error deleting output: ", result).c_str()));
   }
+
+  for (size_t i = 0; i < pubkeys.size(); ++i)
+    remove_output_key(pubkeys[i], output_ids[i]);
 }
 
 void BlockchainLMDB::add_spent_key(const crypto::key_image& k_image)
@@ -1294,6 +1354,7 @@ BlockchainLMDB::BlockchainLMDB(bool batch_transactions): BlockchainDB()
   m_write_txn = nullptr;
   m_write_batch_txn = nullptr;
   m_batch_active = false;
+  m_output_key_index = false;
   m_cum_size = 0;
   m_cum_count = 0;
 
@@ -1445,6 +1506,17 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
   lmdb_db_open(txn, LMDB_OUTPUT_TXS, MDB_INTEGERKEY | MDB_CREATE | MDB_DUPSORT | MDB_DUPFIXED, m_output_txs, "Failed to open db handle for m_output_txs");
   lmdb_db_open(txn, LMDB_OUTPUT_AMOUNTS, MDB_INTEGERKEY | MDB_DUPSORT | MDB_DUPFIXED | MDB_CREATE, m_output_amounts, "Failed to open db handle for m_output_amounts");
 
+  // this subdb is optional, so it may not be present when we open read-only
+  bool has_output_keys = true;
+  if (!(mdb_flags & MDB_RDONLY))
+    lmdb_db_open(txn, LMDB_OUTPUT_KEYS, MDB_DUPSORT | MDB_DUPFIXED | MDB_CREATE, m_output_keys, "Failed to open db handle for m_output_keys");
+  else if ((result = mdb_dbi_open(txn, LMDB_OUTPUT_KEYS, MDB_DUPSORT | MDB_DUPFIXED, &m_output_keys)))
+  {
+    if (result != MDB_NOTFOUND)
+      throw0(DB_OPEN_FAILURE(lmdb_error("Failed to open db handle for m_output_keys: ", result).c_str()));
+    has_output_keys = false;
+  }
+
   lmdb_db_open(txn, LMDB_SPENT_KEYS, MDB_INTEGERKEY | MDB_CREATE | MDB_DUPSORT | MDB_DUPFIXED, m_spent_keys, "Failed to open db handle for m_spent_keys");
 
   lmdb_db_open(txn, LMDB_TXPOOL_META, MDB_CREATE, m_txpool_meta, "Failed to open db handle for m_txpool_meta");
@@ -1467,6 +1539,8 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
   mdb_set_dupsort(txn, m_tx_indices, compare_hash32);
   mdb_set_dupsort(txn, m_output_amounts, compare_uint64);
   mdb_set_dupsort(txn, m_output_txs, compare_uint64);
+  if (has_output_keys)
+    mdb_set_dupsort(txn, m_output_keys, compare_uint64);
   mdb_set_dupsort(txn, m_block_info, compare_uint64);
   if (!(mdb_flags & MDB_RDONLY))
     mdb_set_dupsort(txn, m_txs_prunable_tip, compare_uint64);
@@ -1492,10 +1566,15 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
   LOG_PRINT_L2("Setting m_height to: " << db_stats.ms_entries);
   uint64_t m_height = db_stats.ms_entries;
 
+  // the index is kept up to date once built, whether or not it is asked for
+  MDB_val v;
+  MDB_val_str(k_output_key_index, "output_key_index");
+  m_output_key_index = has_output_keys && mdb_get(txn, m_properties, &k_output_key_index, &v) == MDB_SUCCESS;
+  const bool build_output_keys = (db_flags & DBF_OUTPUT_KEY_INDEX) && !m_output_key_index && !(mdb_flags & MDB_RDONLY);
+
   bool compatible = true;
 
   MDB_val_str(k, "version");
-  MDB_val v;
   auto get_result = mdb_get(txn, m_properties, &k, &v);
   if(get_result == MDB_SUCCESS)
   {
@@ -1523,6 +1602,8 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
       txn.commit();
       m_open = true;
       migrate(db_version);
+      if (build_output_keys)
+        build_output_key_index();
       return;
     }
 #endif
@@ -1569,6 +1650,9 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
   txn.commit();
 
   m_open = true;
+
+  if (build_output_keys)
+    build_output_key_index();
   // from here, init should be finished
 }
 
@@ -1641,6 +1725,8 @@ void BlockchainLMDB::reset()
     throw0(DB_ERROR(lmdb_error("Failed to drop m_output_txs: ", result).c_str()));
   if (auto result = mdb_drop(txn, m_output_amounts, 0))
     throw0(DB_ERROR(lmdb_error("Failed to drop m_output_amounts: ", result).c_str()));
+  if (auto result = mdb_drop(txn, m_output_keys, 0))
+    throw0(DB_ERROR(lmdb_error("Failed to drop m_output_keys: ", result).c_str()));
   if (auto result = mdb_drop(txn, m_spent_keys, 0))
     throw0(DB_ERROR(lmdb_error("Failed to drop m_spent_keys: ", result).c_str()));
   (void)mdb_drop(txn, m_hf_starting_heights, 0); // this one is dropped in new code
@@ -1655,6 +1741,15 @@ void BlockchainLMDB::reset()
   if (auto result = mdb_put(txn, m_properties, &k, &v, 0))
     throw0(DB_ERROR(lmdb_error("Failed to write version to database: ", result).c_str()));
 
+  // an empty output key index is complete
+  if (m_output_key_index)
+  {
+    MDB_val_str(ki, "output_key_index");
+    MDB_val_copy<uint32_t> vi(1);
+    if (auto result = mdb_put(txn, m_properties, &ki, &vi, 0))
+      throw0(DB_ERROR(lmdb_error("Failed to write output key index flag to database: ", result).c_str()));
+  }
+
   txn.commit();
   m_cum_size = 0;
   m_cum_count = 0;
@@ -2090,7 +2185,15 @@ bool BlockchainLMDB::prune_worker(int mode, uint32_t pruning_seed)
   }
 
   if (mode == prune_mode_check)
+  {
+    MDB_val_str(k_progress, "pruning_progress");
+    result = mdb_get(txn, m_properties, &k_progress, &v);
+    if (result && result != MDB_NOTFOUND)
+      throw0(DB_ERROR(lmdb_error("Failed to retrieve pruning progress: ", result).c_str()));
+    if (result == 0)
+      MWARNING("Incremental pruning in progress, prunable data is expected for transactions not gone through yet");
     MINFO("Checking blockchain pruning...");
+  }
   else
     MINFO("Pruning blockchain...");
 
@@ -2287,6 +2390,15 @@ bool BlockchainLMDB::prune_worker(int mode, uint32_t pruning_seed)
   const size_t pages1 = db_stats.ms_branch_pages + db_stats.ms_leaf_pages + db_stats.ms_overflow_pages;
   const size_t db_bytes = (pages0 - pages1) * db_stats.ms_psize;
 
+  if (mode == prune_mode_prune)
+  {
+    // a full pruning supersedes any incremental one in progress
+    MDB_val_str(k_progress, "pruning_progress");
+    result = mdb_del(txn, m_properties, &k_progress, NULL);
+    if (result && result != MDB_NOTFOUND)
+      throw0(DB_ERROR(lmdb_error("Failed to remove pruning progress: ", result).c_str()));
+  }
+
   mdb_cursor_close(c_txs_prunable_tip);
   mdb_cursor_close(c_txs_prunable);
   mdb_cursor_close(c_txs_pruned);
@@ -2317,6 +2429,238 @@ bool BlockchainLMDB::check_pruning()
   return prune_worker(prune_mode_check, 0);
 }
 
+// kept in the properties table while an incremental pruning is in progress
+struct mdb_pruning_progress
+{
+  crypto::hash next_tx_hash; // first transaction in tx_indices order not gone through yet
+  uint64_t txes_done;
+};
+
+static uint64_t get_free_pages(MDB_txn *txn)
+{
+  MDB_cursor *cur;
+  int result = mdb_cursor_open(txn, 0, &cur); // dbi 0 is the free list
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open a cursor for the free list: ", result).c_str()));
+  uint64_t pages = 0;
+  MDB_val k, v;
+  MDB_cursor_op op = MDB_FIRST;
+  while ((result = mdb_cursor_get(cur, &k, &v, op)) == 0)
+  {
+    // each record is a list of page numbers, prefixed by its size
+    mdb_size_t n_pages;
+    memcpy(&n_pages, v.mv_data, sizeof(n_pages));
+    pages += n_pages;
+    op = MDB_NEXT;
+  }
+  mdb_cursor_close(cur);
+  if (result != MDB_NOTFOUND)
+    throw0(DB_ERROR(lmdb_error("Failed to enumerate the free list: ", result).c_str()));
+  return pages;
+}
+
+bool BlockchainLMDB::prune_blockchain_step(uint64_t max_txes, pruning_progress_t &progress, uint32_t pruning_seed)
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  mdb_txn_safe txn;
+  auto result = mdb_txn_begin(m_env, NULL, 0, txn);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to create a transaction for the db: ", result).c_str()));
+
+  mdb_pruning_progress state;
+  MDB_val_str(k_seed, "pruning_seed");
+  MDB_val_str(k_progress, "pruning_progress");
+  MDB_val v;
+  result = mdb_get(txn, m_properties, &k_seed, &v);
+  if (result == MDB_NOTFOUND)
+  {
+    const uint32_t log_stripes = tools::get_pruning_log_stripes(pruning_seed);
+    if (log_stripes && log_stripes != CRYPTONOTE_PRUNING_LOG_STRIPES)
+      throw0(DB_ERROR("Pruning seed not in range"));
+    pruning_seed = tools::get_pruning_stripe(pruning_seed);
+    if (pruning_seed > (1ul << CRYPTONOTE_PRUNING_LOG_STRIPES))
+      throw0(DB_ERROR("Pruning seed not in range"));
+    if (pruning_seed == 0)
+      pruning_seed = tools::get_random_stripe();
+    pruning_seed = tools::make_pruning_seed(pruning_seed, CRYPTONOTE_PRUNING_LOG_STRIPES);
+    v.mv_data = &pruning_seed;
+    v.mv_size = sizeof(pruning_seed);
+    result = mdb_put(txn, m_properties, &k_seed, &v, 0);
+    if (result)
+      throw0(DB_ERROR("Failed to save pruning seed"));
+    state.next_tx_hash = crypto::null_hash;
+    state.txes_done = 0;
+    MINFO("Starting incremental blockchain pruning with seed " << epee::string_tools::to_string_hex(pruning_seed));
+  }
+  else if (result == 0)
+  {
+    if (v.mv_size != sizeof(uint32_t))
+      throw0(DB_ERROR("Failed to retrieve pruning seed: unexpected value size"));
+    memcpy(&pruning_seed, v.mv_data, sizeof(pruning_seed));
+    result = mdb_get(txn, m_properties, &k_progress, &v);
+    if (result == MDB_NOTFOUND)
+    {
+      // pruned already
+      txn.abort();
+      get_pruning_progress(progress);
+      return true;
+    }
+    if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to retrieve pruning progress: ", result).c_str()));
+    if (v.mv_size != sizeof(state))
+      throw0(DB_ERROR("Failed to retrieve pruning progress: unexpected value size"));
+    memcpy(&state, v.mv_data, sizeof(state));
+  }
+  else
+  {
+    throw0(DB_ERROR(lmdb_error("Failed to retrieve pruning seed: ", result).c_str()));
+  }
+
+  MDB_cursor *c_txs_pruned, *c_txs_prunable, *c_txs_prunable_tip, *c_tx_indices;
+  result = mdb_cursor_open(txn, m_txs_pruned, &c_txs_pruned);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open a cursor for txs_pruned: ", result).c_str()));
+  result = mdb_cursor_open(txn, m_txs_prunable, &c_txs_prunable);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open a cursor for txs_prunable: ", result).c_str()));
+  result = mdb_cursor_open(txn, m_txs_prunable_tip, &c_txs_prunable_tip);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open a cursor for txs_prunable_tip: ", result).c_str()));
+  result = mdb_cursor_open(txn, m_tx_indices, &c_tx_indices);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open a cursor for tx_indices: ", result).c_str()));
+  const uint64_t blockchain_height = height();
+
+  // the transaction we stopped at may have been popped since, start from the next one then
+  txindex ti;
+  memset(&ti, 0, sizeof(ti));
+  ti.key = state.next_tx_hash;
+  v.mv_size = sizeof(ti);
+  v.mv_data = (void *)&ti;
+  MDB_val k_indices = zerokval;
+  result = mdb_cursor_get(c_tx_indices, &k_indices, &v, MDB_GET_BOTH_RANGE);
+  uint64_t n_txes = 0, n_pruned_records = 0, n_bytes = 0;
+  bool done = false;
+  while (1)
+  {
+    if (result == MDB_NOTFOUND)
+    {
+      done = true;
+      break;
+    }
+    if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to enumerate transactions: ", result).c_str()));
+    memcpy(&ti, v.mv_data, sizeof(ti));
+    if (n_txes == max_txes)
+    {
+      state.next_tx_hash = ti.key;
+      break;
+    }
+    ++n_txes;
+
+    const uint64_t block_height = ti.data.block_id;
+    MDB_val_set(kp, ti.data.tx_id);
+    if (block_height + CRYPTONOTE_PRUNING_TIP_BLOCKS >= blockchain_height)
+    {
+      MDB_val_set(vp, block_height);
+      result = mdb_cursor_put(c_txs_prunable_tip, &kp, &vp, 0);
+      if (result)
+        throw0(DB_ERROR(lmdb_error("Failed to add prunable tx id to db transaction: ", result).c_str()));
+    }
+    if (!tools::has_unpruned_block(block_height, blockchain_height, pruning_seed) && !is_v1_tx(c_txs_pruned, &kp))
+    {
+      MDB_val vp;
+      result = mdb_cursor_get(c_txs_prunable, &kp, &vp, MDB_SET);
+      if (result && result != MDB_NOTFOUND)
+        throw0(DB_ERROR(lmdb_error("Error looking for transaction prunable data: ", result).c_str()));
+      if (result == 0)
+      {
+        ++n_pruned_records;
+        n_bytes += kp.mv_size + vp.mv_size;
+        result = mdb_cursor_del(c_txs_prunable, 0);
+        if (result)
+          throw0(DB_ERROR(lmdb_error("Failed to delete transaction prunable data: ", result).c_str()));
+      }
+    }
+
+    result = mdb_cursor_get(c_tx_indices, &k_indices, &v, MDB_NEXT_DUP);
+  }
+
+  if (done)
+  {
+    result = mdb_del(txn, m_properties, &k_progress, NULL);
+    if (result && result != MDB_NOTFOUND)
+      throw0(DB_ERROR(lmdb_error("Failed to remove pruning progress: ", result).c_str()));
+  }
+  else
+  {
+    state.txes_done += n_txes;
+    v.mv_size = sizeof(state);
+    v.mv_data = (void *)&state;
+    result = mdb_put(txn, m_properties, &k_progress, &v, 0);
+    if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to save pruning progress: ", result).c_str()));
+  }
+
+  mdb_cursor_close(c_tx_indices);
+  mdb_cursor_close(c_txs_prunable_tip);
+  mdb_cursor_close(c_txs_prunable);
+  mdb_cursor_close(c_txs_pruned);
+
+  txn.commit();
+
+  get_pruning_progress(progress);
+  progress.pruned_records = n_pruned_records;
+  progress.pruned_bytes = n_bytes;
+  if (done)
+    MINFO("Incremental blockchain pruning done");
+  return done;
+}
+
+bool BlockchainLMDB::get_pruning_progress(pruning_progress_t &progress) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(properties)
+
+  progress = pruning_progress_t();
+  MDB_stat db_stats;
+  int result = mdb_stat(m_txn, m_tx_indices, &db_stats);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to query m_tx_indices: ", result).c_str()));
+  progress.txes_total = db_stats.ms_entries;
+  progress.page_size = db_stats.ms_psize;
+  progress.free_pages = get_free_pages(m_txn);
+
+  MDB_val_str(k, "pruning_progress");
+  MDB_val v;
+  result = mdb_cursor_get(m_cur_properties, &k, &v, MDB_SET);
+  if (result == MDB_NOTFOUND)
+  {
+    MDB_val_str(k_seed, "pruning_seed");
+    result = mdb_cursor_get(m_cur_properties, &k_seed, &v, MDB_SET);
+    if (result && result != MDB_NOTFOUND)
+      throw0(DB_ERROR(lmdb_error("Failed to retrieve pruning seed: ", result).c_str()));
+    progress.txes_done = result == 0 ? progress.txes_total : 0;
+    return false;
+  }
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to retrieve pruning progress: ", result).c_str()));
+  if (v.mv_size != sizeof(mdb_pruning_progress))
+    throw0(DB_ERROR("Failed to retrieve pruning progress: unexpected value size"));
+  mdb_pruning_progress state;
+  memcpy(&state, v.mv_data, sizeof(state));
+  // transactions added or popped since the start make this approximate
+  progress.txes_done = std::min(state.txes_done, progress.txes_total);
+
+  TXN_POSTFIX_RDONLY();
+  return true;
+}
+
 bool BlockchainLMDB::for_all_txpool_txes(std::function<bool(const crypto::hash&, const txpool_tx_meta_t&, const cryptonote::blobdata_ref*)> f, bool include_blob, relay_category category) const
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
@@ -4212,6 +4556,51 @@ void BlockchainLMDB::get_output_tx_and_index(const uint64_t& amount, const std::
   LOG_PRINT_L3("db3: " << db3);
 }
 
+bool BlockchainLMDB::get_output_key_indices(const std::vector<crypto::public_key> &keys, std::vector<std::vector<output_key_index_t>> &indices) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+  indices.clear();
+
+  if (!m_output_key_index)
+    return false;
+  indices.resize(keys.size());
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(output_keys);
+  RCURSOR(output_txs);
+
+  for (size_t i = 0; i < keys.size(); ++i)
+  {
+    MDB_val_set(k, keys[i]);
+    MDB_val v;
+    MDB_cursor_op op = MDB_SET;
+    while (1)
+    {
+      int result = mdb_cursor_get(m_cur_output_keys, &k, &v, op);
+      op = MDB_NEXT_DUP;
+      if (result == MDB_NOTFOUND)
+        break;
+      if (result)
+        throw0(DB_ERROR(lmdb_error("Failed to enumerate output keys: ", result).c_str()));
+
+      const outkeyref *ref = (const outkeyref *)v.mv_data;
+      MDB_val_set(vot, ref->output_id);
+      result = mdb_cursor_get(m_cur_output_txs, (MDB_val *)&zerokval, &vot, MDB_GET_BOTH);
+      if (result == MDB_NOTFOUND)
+        throw0(DB_ERROR("Unexpected: global output index not found in m_output_txs"));
+      else if (result)
+        throw0(DB_ERROR(lmdb_error("DB error attempting to fetch output tx hash: ", result).c_str()));
+
+      const outtx *ot = (const outtx *)vot.mv_data;
+      indices[i].push_back({ref->amount, ref->amount_index, ot->tx_hash, ot->local_index});
+    }
+  }
+
+  TXN_POSTFIX_RDONLY();
+  return true;
+}
+
 std::map<uint64_t, std::tuple<uint64_t, uint64_t, uint64_t>> BlockchainLMDB::get_output_histogram(const std::vector<uint64_t> &amounts, bool unlocked, uint64_t recent_cutoff, uint64_t min_count) const
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
@@ -5670,6 +6059,101 @@ void BlockchainLMDB::migrate_4_5()
   txn.commit();
 }
 
+void BlockchainLMDB::build_output_key_index()
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  uint64_t i = 0, amount = 0, amount_index = 0;
+  int result;
+  mdb_txn_safe txn(false);
+  MDB_val k, v;
+  bool done = false;
+
+  MGINFO_YELLOW("Building the output key index - this may take a while:");
+
+  MDB_stat db_stats;
+  result = mdb_txn_begin(m_env, NULL, MDB_RDONLY, txn);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to create a transaction for the db: ", result).c_str()));
+  if ((result = mdb_stat(txn, m_output_txs, &db_stats)))
+    throw0(DB_ERROR(lmdb_error("Failed to query m_output_txs: ", result).c_str()));
+  const uint64_t num_outputs = db_stats.ms_entries;
+  txn.abort();
+
+  while (!done)
+  {
+    if (need_resize())
+    {
+      LOG_PRINT_L0("LMDB memory map needs to be resized, doing that now.");
+      do_resize();
+    }
+
+    result = mdb_txn_begin(m_env, NULL, 0, txn);
+    if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to create a transaction for the db: ", result).c_str()));
+
+    MDB_cursor *c_amounts, *c_keys;
+    result = mdb_cursor_open(txn, m_output_amounts, &c_amounts);
+    if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to open a cursor for output_amounts: ", result).c_str()));
+    result = mdb_cursor_open(txn, m_output_keys, &c_keys);
+    if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to open a cursor for output_keys: ", result).c_str()));
+
+    // pick up after the last output of the previous transaction
+    MDB_cursor_op op = MDB_FIRST;
+    if (i)
+    {
+      MDB_val_set(ka, amount);
+      MDB_val_set(va, amount_index);
+      result = mdb_cursor_get(c_amounts, &ka, &va, MDB_GET_BOTH);
+      if (result)
+        throw0(DB_ERROR(lmdb_error("Failed to find the last indexed output: ", result).c_str()));
+      op = MDB_NEXT;
+    }
+
+    for (size_t n = 0; n < 100000; ++n)
+    {
+      result = mdb_cursor_get(c_amounts, &k, &v, op);
+      op = MDB_NEXT;
+      if (result == MDB_NOTFOUND)
+      {
+        done = true;
+        break;
+      }
+      if (result)
+        throw0(DB_ERROR(lmdb_error("Failed to get a record from output_amounts: ", result).c_str()));
+
+      const pre_rct_outkey *okp = (const pre_rct_outkey *)v.mv_data;
+      amount = *(const uint64_t*)k.mv_data;
+      amount_index = okp->amount_index;
+      outkeyref ref = {okp->output_id, amount, amount_index};
+      MDB_val_set(kk, okp->data.pubkey);
+      MDB_val_set(vk, ref);
+      result = mdb_cursor_put(c_keys, &kk, &vk, MDB_NODUPDATA);
+      // left over from an interrupted build
+      if (result && result != MDB_KEYEXIST)
+        throw0(DB_ERROR(lmdb_error("Failed to put a record into output_keys: ", result).c_str()));
+      ++i;
+    }
+
+    if (done)
+    {
+      MDB_val_str(ki, "output_key_index");
+      MDB_val_copy<uint32_t> vi(1);
+      if ((result = mdb_put(txn, m_properties, &ki, &vi, 0)))
+        throw0(DB_ERROR(lmdb_error("Failed to write output key index flag to database: ", result).c_str()));
+    }
+    txn.commit();
+
+    LOGIF(el::Level::Info) {
+      std::cout << i << " / " << num_outputs << "  \r" << std::flush;
+    }
+  }
+
+  m_output_key_index = true;
+  MGINFO("Output key index built for " << i << " outputs");
+}
+
 void BlockchainLMDB::migrate(const uint32_t oldversion)
 {
   if (oldversion < 1)
@@ -104,6 +104,7 @@ public:
   virtual uint64_t get_indexing_base() const override { return 0; }
   virtual cryptonote::output_data_t get_output_key(const uint64_t& amount, const uint64_t& index, bool include_commitmemt) const override { return cryptonote::output_data_t(); }
   virtual cryptonote::tx_out_index get_output_tx_and_index_from_global(const uint64_t& index) const override { return cryptonote::tx_out_index(); }
+  virtual bool get_output_key_indices(const std::vector<crypto::public_key> &keys, std::vector<std::vector<cryptonote::output_key_index_t>> &indices) const override { return false; }
   virtual cryptonote::tx_out_index get_output_tx_and_index(const uint64_t& amount, const uint64_t& index) const override { return cryptonote::tx_out_index(); }
   virtual void get_output_tx_and_index(const uint64_t& amount, const std::vector<uint64_t> &offsets, std::vector<cryptonote::tx_out_index> &indices) const override {}
   virtual void get_output_key(const epee::span<const uint64_t> &amounts, const std::vector<uint64_t> &offsets, std::vector<cryptonote::output_data_t> &outputs, bool allow_partial = false) const override {}
@@ -155,6 +156,8 @@ public:
   virtual bool prune_blockchain(uint32_t pruning_seed = 0) override { return true; }
   virtual bool update_pruning() override { return true; }
   virtual bool check_pruning() override { return true; }
+  virtual bool prune_blockchain_step(uint64_t max_txes, cryptonote::pruning_progress_t &progress, uint32_t pruning_seed = 0) override { return true; }
+  virtual bool get_pruning_progress(cryptonote::pruning_progress_t &progress) const override { return false; }
   virtual void prune_outputs(uint64_t amount) override {}
 
   virtual uint64_t get_max_block_size() override { return 100000000; }
@@ -41,6 +41,7 @@
 #include "cryptonote_core/cryptonote_core.h"
 #include "cryptonote_core/blockchain.h"
 #include "blockchain_db/blockchain_db.h"
+#include "blockchain_scan.h"
 #include "version.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
@@ -51,7 +52,7 @@ using namespace epee;
 using namespace cryptonote;
 
 static bool stop_requested = false;
-static uint64_t cached_txes = 0, cached_blocks = 0, cached_outputs = 0, total_txes = 0, total_blocks = 0, total_outputs = 0;
+static std::atomic<uint64_t> cached_txes(0), cached_blocks(0), cached_outputs(0), total_txes(0), total_blocks(0), total_outputs(0);
 static bool opt_cache_outputs = false, opt_cache_txes = false, opt_cache_blocks = false;
 
 struct ancestor
@@ -173,6 +174,14 @@ struct ancestry_state_t
 };
 BOOST_CLASS_VERSION(ancestry_state_t, 2)
 
+struct block_ancestry_t
+{
+  cryptonote::block block;
+  std::vector<crypto::hash> txids;
+  std::vector<::tx_data_t> txes;
+  std::vector<crypto::hash> output_txids; // for every ring member of every tx, in order
+};
+
 static void add_ancestor(std::unordered_map<ancestor, unsigned int> &ancestry, uint64_t amount, uint64_t offset)
 {
   std::pair<std::unordered_map<ancestor, unsigned int>::iterator, bool> p = ancestry.insert(std::make_pair(ancestor{amount, offset}, 1));
@@ -223,7 +232,9 @@ static std::unordered_set<ancestor> get_ancestry(const std::unordered_map<crypto
   return i->second;
 }
 
-static bool get_block_from_height(ancestry_state_t &state, BlockchainDB *db, uint64_t height, cryptonote::block &b)
+// The lookups below only read the caches in state, and add to them if cache is not NULL.
+// Refresh passes NULL, since it looks up from several threads, and fills the caches in order.
+static bool get_block_from_height(const ancestry_state_t &state, BlockchainDB *db, uint64_t height, cryptonote::block &b, ancestry_state_t *cache)
 {
   ++total_blocks;
   if (state.block_cache.size() > height && !state.block_cache[height].miner_tx.vin.empty())
@@ -238,15 +249,15 @@ static bool get_block_from_height(ancestry_state_t &state, BlockchainDB *db, uin
     LOG_PRINT_L0("Bad block from db");
     return false;
   }
-  if (opt_cache_blocks)
+  if (opt_cache_blocks && cache)
   {
-    state.block_cache.resize(height + 1);
-    state.block_cache[height] = b;
+    cache->block_cache.resize(height + 1);
+    cache->block_cache[height] = b;
   }
   return true;
 }
 
-static bool get_transaction(ancestry_state_t &state, BlockchainDB *db, const crypto::hash &txid, ::tx_data_t &tx_data)
+static bool get_transaction(const ancestry_state_t &state, BlockchainDB *db, const crypto::hash &txid, ::tx_data_t &tx_data, ancestry_state_t *cache)
 {
   std::unordered_map<crypto::hash, ::tx_data_t>::const_iterator i = state.tx_cache.find(txid);
   ++total_txes;
@@ -270,12 +281,12 @@ static bool get_transaction(ancestry_state_t &state, BlockchainDB *db, const cry
     return false;
   }
   tx_data = ::tx_data_t(tx);
-  if (opt_cache_txes)
-    state.tx_cache.insert(std::make_pair(txid, tx_data));
+  if (opt_cache_txes && cache)
+    cache->tx_cache.insert(std::make_pair(txid, tx_data));
   return true;
 }
 
-static bool get_output_txid(ancestry_state_t &state, BlockchainDB *db, uint64_t amount, uint64_t offset, crypto::hash &txid)
+static bool get_output_txid(const ancestry_state_t &state, BlockchainDB *db, uint64_t amount, uint64_t offset, crypto::hash &txid, ancestry_state_t *cache)
 {
   ++total_outputs;
   std::unordered_map<ancestor, crypto::hash>::const_iterator i = state.output_cache.find({amount, offset});
@@ -288,7 +299,7 @@ static bool get_output_txid(ancestry_state_t &state, BlockchainDB *db, uint64_t
 
   const output_data_t od = db->get_output_key(amount, offset, false);
   cryptonote::block b;
-  if (!get_block_from_height(state, db, od.height, b))
+  if (!get_block_from_height(state, db, od.height, b, cache))
     return false;
 
   for (size_t out = 0; out < b.miner_tx.vout.size(); ++out)
@@ -299,8 +310,8 @@ static bool get_output_txid(ancestry_state_t &state, BlockchainDB *db, uint64_t
       if (txout.key == od.pubkey)
       {
         txid = cryptonote::get_transaction_hash(b.miner_tx);
-        if (opt_cache_outputs)
-          state.output_cache.insert(std::make_pair(ancestor{amount, offset}, txid));
+        if (opt_cache_outputs && cache)
+          cache->output_cache.insert(std::make_pair(ancestor{amount, offset}, txid));
         return true;
       }
     }
@@ -313,7 +324,7 @@ static bool get_output_txid(ancestry_state_t &state, BlockchainDB *db, uint64_t
   for (const crypto::hash &block_txid: b.tx_hashes)
   {
     ::tx_data_t tx_data3;
-    if (!get_transaction(state, db, block_txid, tx_data3))
+    if (!get_transaction(state, db, block_txid, tx_data3, cache))
       return false;
 
     for (size_t out = 0; out < tx_data3.vout.size(); ++out)
@@ -321,8 +332,8 @@ static bool get_output_txid(ancestry_state_t &state, BlockchainDB *db, uint64_t
       if (tx_data3.vout[out] == od.pubkey)
       {
         txid = block_txid;
-        if (opt_cache_outputs)
-          state.output_cache.insert(std::make_pair(ancestor{amount, offset}, txid));
+        if (opt_cache_outputs && cache)
+          cache->output_cache.insert(std::make_pair(ancestor{amount, offset}, txid));
         return true;
       }
     }
@@ -510,58 +521,61 @@ int main(int argc, char* argv[])
   {
     MINFO("Starting from height " << state.height);
     state.block_cache.reserve(db_height);
-    for (uint64_t h = state.height; h < db_height; ++h)
+    // blocks, txes and the txes creating their ring members are looked up in parallel,
+    // ancestry is then built up in chain order, since it depends on earlier txes
+    r = for_blocks_parallel<block_ancestry_t>(db, state.height, db_height, stop_requested,
+      [&](uint64_t h, const cryptonote::blobdata &bd, const cryptonote::block &b, block_ancestry_t &data)
     {
-      size_t block_ancestry_size = 0;
-      const cryptonote::blobdata bd = db->get_block_blob_from_height(h);
       ++total_blocks;
-      cryptonote::block b;
-      if (!cryptonote::parse_and_validate_block_from_blob(bd, b))
+      if (opt_cache_blocks)
+        data.block = b;
+      data.txids.reserve(1 + b.tx_hashes.size());
+      if (opt_include_coinbase)
+        data.txids.push_back(cryptonote::get_transaction_hash(b.miner_tx));
+      for (const auto &h: b.tx_hashes)
+        data.txids.push_back(h);
+      data.txes.resize(data.txids.size());
+      for (size_t n = 0; n < data.txids.size(); ++n)
       {
-        LOG_PRINT_L0("Bad block from db");
-        return 1;
+        const crypto::hash &txid = data.txids[n];
+        if (!get_transaction(state, db, txid, data.txes[n], NULL))
+          return false;
+        const ::tx_data_t &tx_data = data.txes[n];
+        for (size_t ring = 0; ring < tx_data.vin.size(); ++ring)
+        {
+          const uint64_t amount = tx_data.vin[ring].first;
+          for (uint64_t offset: tx_data.vin[ring].second)
+          {
+            // find the tx which created this output
+            crypto::hash output_txid;
+            if (!get_output_txid(state, db, amount, offset, output_txid, NULL))
+            {
+              LOG_PRINT_L0("Output originating transaction not found");
+              return false;
+            }
+            data.output_txids.push_back(output_txid);
+          }
+        }
       }
+      return true;
+    },
+      [&](uint64_t h, block_ancestry_t &data)
+    {
+      size_t block_ancestry_size = 0;
       if (opt_cache_blocks)
       {
         state.block_cache.resize(h + 1);
-        state.block_cache[h] = b;
+        state.block_cache[h] = std::move(data.block);
       }
-      std::vector<crypto::hash> txids;
-      txids.reserve(1 + b.tx_hashes.size());
-      if (opt_include_coinbase)
-        txids.push_back(cryptonote::get_transaction_hash(b.miner_tx));
-      for (const auto &h: b.tx_hashes)
-        txids.push_back(h);
-      for (const crypto::hash &txid: txids)
+      std::vector<crypto::hash>::const_iterator output_txid = data.output_txids.begin();
+      for (size_t n = 0; n < data.txids.size(); ++n)
       {
+        const crypto::hash &txid = data.txids[n];
+        const ::tx_data_t &tx_data = data.txes[n];
         printf("%lu/%lu               \r", (unsigned long)h, (unsigned long)db_height);
         fflush(stdout);
-        ::tx_data_t tx_data;
-        std::unordered_map<crypto::hash, ::tx_data_t>::const_iterator i = state.tx_cache.find(txid);
-        ++total_txes;
-        if (i != state.tx_cache.end())
-        {
-          ++cached_txes;
-          tx_data = i->second;
-        }
-        else
-        {
-          cryptonote::blobdata bd;
-          if (!db->get_pruned_tx_blob(txid, bd))
-          {
-            LOG_PRINT_L0("Failed to get txid " << txid << " from db");
-            return 1;
-          }
-          cryptonote::transaction tx;
-          if (!cryptonote::parse_and_validate_tx_base_from_blob(bd, tx))
-          {
-            LOG_PRINT_L0("Bad tx: " << txid);
-            return 1;
-          }
-          tx_data = ::tx_data_t(tx);
-          if (opt_cache_txes)
-            state.tx_cache.insert(std::make_pair(txid, tx_data));
-        }
+        if (opt_cache_txes)
+          state.tx_cache.insert(std::make_pair(txid, tx_data));
         if (tx_data.coinbase)
         {
           add_ancestry(state.ancestry, txid, std::unordered_set<ancestor>());
@@ -575,14 +589,10 @@ int main(int argc, char* argv[])
             for (uint64_t offset: absolute_offsets)
             {
               add_ancestry(state.ancestry, txid, ancestor{amount, offset});
-              // find the tx which created this output
-              crypto::hash output_txid;
-              if (!get_output_txid(state, db, amount, offset, output_txid))
-              {
-                LOG_PRINT_L0("Output originating transaction not found");
-                return 1;
-              }
-              add_ancestry(state.ancestry, txid, get_ancestry(state.ancestry, output_txid));
+              if (opt_cache_outputs)
+                state.output_cache.insert(std::make_pair(ancestor{amount, offset}, *output_txid));
+              add_ancestry(state.ancestry, txid, get_ancestry(state.ancestry, *output_txid));
+              ++output_txid;
             }
           }
         }
@@ -590,15 +600,16 @@ int main(int argc, char* argv[])
         block_ancestry_size += ancestry_size;
         MINFO(txid << ": " << ancestry_size);
       }
-      if (!txids.empty())
+      if (!data.txids.empty())
       {
         std::string stats_msg;
-        MINFO("Height " << h << ": " << (block_ancestry_size / txids.size()) << " average over " << txids.size() << stats_msg);
+        MINFO("Height " << h << ": " << (block_ancestry_size / data.txids.size()) << " average over " << data.txids.size() << stats_msg);
       }
       state.height = h;
-      if (stop_requested)
-        break;
-    }
+      return true;
+    });
+    if (!r)
+      return 1;
 
     LOG_PRINT_L0("Saving state data to " << state_file_path);
     std::ofstream state_data_out;
@@ -633,7 +644,7 @@ int main(int argc, char* argv[])
   else if (!opt_output_string.empty())
   {
     crypto::hash txid;
-    if (!get_output_txid(state, db, output_amount, output_offset, txid))
+    if (!get_output_txid(state, db, output_amount, output_offset, txid, &state))
     {
       LOG_PRINT_L0("Output not found in db");
       return 1;
@@ -676,7 +687,7 @@ int main(int argc, char* argv[])
         goto done;
 
       ::tx_data_t tx_data2;
-      if (!get_transaction(state, db, txid, tx_data2))
+      if (!get_transaction(state, db, txid, tx_data2, &state))
         return 1;
 
       const bool coinbase = tx_data2.coinbase;
@@ -694,7 +705,7 @@ int main(int argc, char* argv[])
 
             // find the tx which created this output
             crypto::hash output_txid;
-            if (!get_output_txid(state, db, amount, offset, output_txid))
+            if (!get_output_txid(state, db, amount, offset, output_txid, &state))
             {
               LOG_PRINT_L0("Output originating transaction not found");
               return 1;
@@ -32,6 +32,7 @@
 #include "common/unordered_containers_boost_serialization.h"
 #include "common/command_line.h"
 #include "common/varint.h"
+#include "common/threadpool.h"
 #include "serialization/crypto.h"
 #include "cryptonote_basic/cryptonote_boost_serialization.h"
 #include "cryptonote_core/tx_pool.h"
@@ -367,35 +368,69 @@ static bool for_all_transactions(const std::string &filename, uint64_t &start_id
 
   bool fret = true;
 
+  // transactions are parsed in batches on the thread pool, then handed to f in order
+  tools::threadpool &tpool = tools::threadpool::getInstance();
+  const size_t n_threads = std::max<size_t>(1, tpool.get_max_concurrency());
+  const size_t batch_size = 256 * n_threads;
+  std::vector<std::pair<uint64_t, blobdata>> blobs;
+  std::vector<cryptonote::transaction_prefix> txes;
+  std::unique_ptr<bool[]> parsed(new bool[batch_size]);
+  blobs.reserve(batch_size);
+
   k.mv_size = sizeof(uint64_t);
   k.mv_data = &start_idx;
   MDB_cursor_op op = MDB_SET;
-  while (1)
+  bool done = false;
+  while (!done)
   {
-    int ret = mdb_cursor_get(cur, &k, &v, op);
-    op = MDB_NEXT;
-    if (ret == MDB_NOTFOUND)
-      break;
-    if (ret)
-      throw std::runtime_error("Failed to enumerate transactions: " + std::string(mdb_strerror(ret)));
-
-    if (k.mv_size != sizeof(uint64_t))
-      throw std::runtime_error("Bad key size");
-    const uint64_t idx = *(uint64_t*)k.mv_data;
-    if (idx < start_idx)
-      continue;
+    blobs.clear();
+    while (blobs.size() < batch_size)
+    {
+      int ret = mdb_cursor_get(cur, &k, &v, op);
+      op = MDB_NEXT;
+      if (ret == MDB_NOTFOUND)
+      {
+        done = true;
+        break;
+      }
+      if (ret)
+        throw std::runtime_error("Failed to enumerate transactions: " + std::string(mdb_strerror(ret)));
+
+      if (k.mv_size != sizeof(uint64_t))
+        throw std::runtime_error("Bad key size");
+      const uint64_t idx = *(uint64_t*)k.mv_data;
+      if (idx < start_idx)
+        continue;
+      blobs.emplace_back(idx, blobdata(reinterpret_cast<char*>(v.mv_data), v.mv_size));
+    }
 
-    cryptonote::transaction_prefix tx;
-    blobdata bd;
-    bd.assign(reinterpret_cast<char*>(v.mv_data), v.mv_size);
-    binary_archive<false> ba{epee::strspan<std::uint8_t>(bd)};
-    bool r = do_serialize(ba, tx);
-    CHECK_AND_ASSERT_MES(r, false, "Failed to parse transaction from blob");
+    txes.clear();
+    txes.resize(blobs.size());
+    tools::threadpool::waiter waiter(tpool);
+    for (size_t t = 0; t < n_threads; ++t)
+    {
+      const size_t begin = blobs.size() * t / n_threads, end = blobs.size() * (t + 1) / n_threads;
+      if (begin == end)
+        continue;
+      tpool.submit(&waiter, [&blobs, &txes, &parsed, begin, end](){
+        for (size_t i = begin; i < end; ++i)
+        {
+          binary_archive<false> ba{epee::strspan<std::uint8_t>(blobs[i].second)};
+          parsed[i] = do_serialize(ba, txes[i]);
+        }
+      }, true);
+    }
+    CHECK_AND_ASSERT_MES(waiter.wait(), false, "Failed to parse transactions");
 
-    start_idx = *(uint64_t*)k.mv_data;
-    if (!f(tx)) {
-      fret = false;
-      break;
+    for (size_t i = 0; i < blobs.size(); ++i)
+    {
+      CHECK_AND_ASSERT_MES(parsed[i], false, "Failed to parse transaction from blob");
+      start_idx = blobs[i].first;
+      if (!f(txes[i])) {
+        fret = false;
+        done = true;
+        break;
+      }
     }
   }
 
@@ -910,6 +945,69 @@ static void add_key_image(MDB_txn *txn, const output_data &od, const crypto::key
   CHECK_AND_ASSERT_THROW_MES(!dbr, "Failed to set outputs: " + std::string(mdb_strerror(dbr)));
 }
 
+// spent offsets per amount, each sorted
+typedef std::unordered_map<uint64_t, std::vector<uint64_t>> spent_set_t;
+
+static void add_to_spent_set(spent_set_t &spent_set, std::vector<output_data> outs)
+{
+  std::sort(outs.begin(), outs.end(), [](const output_data &a, const output_data &b) {
+    return a.amount < b.amount || (a.amount == b.amount && a.offset < b.offset);
+  });
+  for (size_t n = 0; n < outs.size(); )
+  {
+    std::vector<uint64_t> &offsets = spent_set[outs[n].amount];
+    const size_t old_size = offsets.size();
+    const uint64_t amount = outs[n].amount;
+    for (; n < outs.size() && outs[n].amount == amount; ++n)
+      offsets.push_back(outs[n].offset);
+    std::inplace_merge(offsets.begin(), offsets.begin() + old_size, offsets.end());
+  }
+}
+
+struct chain_reaction_candidate
+{
+  output_data od;
+  size_t ring_size;
+};
+
+// Finds the ring members of outs which are the only ones left unspent in their ring, as per spent_set.
+// Only reads committed data, so it can run on any thread while no write transaction is active
+static void find_chain_reaction_candidates(const spent_set_t &spent_set, const output_data *outs, size_t n_outs, const bool &stop_requested, std::vector<chain_reaction_candidate> &candidates)
+{
+  MDB_txn *txn;
+  bool tx_active = false;
+  int dbr = mdb_txn_begin(env, NULL, MDB_RDONLY, &txn);
+  CHECK_AND_ASSERT_THROW_MES(!dbr, "Failed to create LMDB transaction: " + std::string(mdb_strerror(dbr)));
+  epee::misc_utils::auto_scope_leave_caller txn_dtor = epee::misc_utils::create_scope_leave_handler([&](){if (tx_active) mdb_txn_abort(txn);});
+  tx_active = true;
+
+  static const std::vector<uint64_t> no_offsets;
+  for (size_t n = 0; n < n_outs && !stop_requested; ++n)
+  {
+    const output_data &od = outs[n];
+    const auto it = spent_set.find(od.amount);
+    const std::vector<uint64_t> &spent = it == spent_set.end() ? no_offsets : it->second;
+    std::vector<crypto::key_image> key_images = get_key_images(txn, od);
+    for (const crypto::key_image &ki: key_images)
+    {
+      std::vector<uint64_t> relative_ring;
+      CHECK_AND_ASSERT_THROW_MES(get_relative_ring(txn, ki, relative_ring), "Relative ring not found");
+      std::vector<uint64_t> absolute = cryptonote::relative_output_offsets_to_absolute(relative_ring);
+      size_t known = 0;
+      uint64_t last_unknown = 0;
+      for (uint64_t out: absolute)
+      {
+        if (std::binary_search(spent.begin(), spent.end(), out))
+          ++known;
+        else
+          last_unknown = out;
+      }
+      if (known == absolute.size() - 1)
+        candidates.push_back({output_data(od.amount, last_unknown), absolute.size()});
+    }
+  }
+}
+
 static bool get_stat(MDB_txn *txn, const char *key, uint64_t &data)
 {
   MDB_val k, v;
@@ -1282,6 +1380,7 @@ int main(int argc, char* argv[])
   open_db(inputs[0], &env0, &txn0, &cur0, &dbi0);
 
   std::vector<output_data> work_spent;
+  spent_set_t spent_set;
 
   if (opt_historical_stat)
   {
@@ -1592,6 +1691,7 @@ int main(int argc, char* argv[])
     mdb_txn_abort(txn);
   }
 
+  add_to_spent_set(spent_set, work_spent);
   while (!work_spent.empty())
   {
     LOG_PRINT_L0("Secondary pass on " << work_spent.size() << " spent outputs");
@@ -1599,6 +1699,28 @@ int main(int argc, char* argv[])
     int dbr = resize_env(cache_dir.c_str());
     CHECK_AND_ASSERT_THROW_MES(!dbr, "Failed to resize LMDB database: " + std::string(mdb_strerror(dbr)));
 
+    // rings are checked in parallel against the outputs known to be spent at the start of the pass,
+    // outputs found during the pass are taken into account by the next one
+    std::vector<output_data> scan_spent = std::move(work_spent);
+    work_spent.clear();
+    tools::threadpool &tpool = tools::threadpool::getInstance();
+    const size_t n_chunks = std::min<size_t>(scan_spent.size(), 4 * std::max<size_t>(1, tpool.get_max_concurrency()));
+    std::vector<std::vector<chain_reaction_candidate>> candidates(n_chunks);
+    tools::threadpool::waiter waiter(tpool);
+    for (size_t c = 0; c < n_chunks; ++c)
+    {
+      const size_t begin = scan_spent.size() * c / n_chunks, end = scan_spent.size() * (c + 1) / n_chunks;
+      tpool.submit(&waiter, [&spent_set, &scan_spent, &stop_requested, &candidates, c, begin, end](){
+        find_chain_reaction_candidates(spent_set, scan_spent.data() + begin, end - begin, stop_requested, candidates[c]);
+      }, true);
+    }
+    CHECK_AND_ASSERT_THROW_MES(waiter.wait(), "Failed to scan spent outputs");
+    if (stop_requested)
+    {
+      MINFO("Stopping secondary passes. Secondary passes are not incremental, they will re-run fully.");
+      return 0;
+    }
+
     MDB_txn *txn;
     dbr = mdb_txn_begin(env, NULL, 0, &txn);
     CHECK_AND_ASSERT_THROW_MES(!dbr, "Failed to create LMDB transaction: " + std::string(mdb_strerror(dbr)));
@@ -1607,45 +1729,21 @@ int main(int argc, char* argv[])
     CHECK_AND_ASSERT_THROW_MES(!dbr, "Failed to open LMDB cursor: " + std::string(mdb_strerror(dbr)));
 
     std::vector<std::pair<uint64_t, uint64_t>> blackballs;
-    std::vector<output_data> scan_spent = std::move(work_spent);
-    work_spent.clear();
-    for (const output_data &od: scan_spent)
+    for (const std::vector<chain_reaction_candidate> &chunk: candidates)
     {
-      std::vector<crypto::key_image> key_images = get_key_images(txn, od);
-      for (const crypto::key_image &ki: key_images)
+      for (const chain_reaction_candidate &candidate: chunk)
       {
-        std::vector<uint64_t> relative_ring;
-        CHECK_AND_ASSERT_THROW_MES(get_relative_ring(txn, ki, relative_ring), "Relative ring not found");
-        std::vector<uint64_t> absolute = cryptonote::relative_output_offsets_to_absolute(relative_ring);
-        size_t known = 0;
-        uint64_t last_unknown = 0;
-        for (uint64_t out: absolute)
-        {
-          output_data new_od(od.amount, out);
-          if (is_output_spent(cur, new_od))
-            ++known;
-          else
-            last_unknown = out;
-        }
-        if (known == absolute.size() - 1)
+        if (!add_spent_output(cur, candidate.od))
+          continue;
+        const std::pair<uint64_t, uint64_t> output = std::make_pair(candidate.od.amount, candidate.od.offset);
+        if (opt_verbose)
         {
-          const std::pair<uint64_t, uint64_t> output = std::make_pair(od.amount, last_unknown);
-          if (opt_verbose)
-          {
-            MINFO("Marking output " << output.first << "/" << output.second << " as spent, due to being used in a " <<
-                absolute.size() << "-ring where all other outputs are known to be spent");
-          }
-          blackballs.push_back(output);
-          if (add_spent_output(cur, output_data(od.amount, last_unknown)))
-            inc_stat(txn, od.amount ? "pre-rct-chain-reaction" : "rct-chain-reaction");
-          work_spent.push_back(output_data(od.amount, last_unknown));
+          MINFO("Marking output " << output.first << "/" << output.second << " as spent, due to being used in a " <<
+              candidate.ring_size << "-ring where all other outputs are known to be spent");
         }
-      }
-
-      if (stop_requested)
-      {
-        MINFO("Stopping secondary passes. Secondary passes are not incremental, they will re-run fully.");
-        return 0;
+        blackballs.push_back(output);
+        inc_stat(txn, candidate.od.amount ? "pre-rct-chain-reaction" : "rct-chain-reaction");
+        work_spent.push_back(candidate.od);
       }
     }
     if (!blackballs.empty())
@@ -1656,6 +1754,7 @@ int main(int argc, char* argv[])
     mdb_cursor_close(cur);
     dbr = mdb_txn_commit(txn);
     CHECK_AND_ASSERT_THROW_MES(!dbr, "Failed to commit txn creating/opening database: " + std::string(mdb_strerror(dbr)));
+    add_to_spent_set(spent_set, work_spent);
   }
 
 skip_secondary_passes:
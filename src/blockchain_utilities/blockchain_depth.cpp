@@ -35,6 +35,7 @@
 #include "cryptonote_core/cryptonote_core.h"
 #include "cryptonote_core/blockchain.h"
 #include "blockchain_db/blockchain_db.h"
+#include "blockchain_scan.h"
 #include "version.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
@@ -44,6 +45,12 @@ namespace po = boost::program_options;
 using namespace epee;
 using namespace cryptonote;
 
+struct depth_step_t
+{
+  bool coinbase;
+  std::vector<crypto::hash> parents;
+};
+
 int main(int argc, char* argv[])
 {
   TRY_ENTRY();
@@ -190,6 +197,11 @@ int main(int argc, char* argv[])
     return 1;
   }
 
+  bool stop_requested = false;
+  tools::signal_handler::install([&stop_requested](int type) {
+    stop_requested = true;
+  });
+
   std::vector<uint64_t> depths;
   for (const crypto::hash &start_txid: start_txids)
   {
@@ -201,28 +213,31 @@ int main(int argc, char* argv[])
     while (!coinbase)
     {
       LOG_PRINT_L0("Considering "<< txids.size() << " transaction(s) at depth " << depth);
+      // the txes at this depth are looked up in parallel, their parents are then queued in order
       std::vector<crypto::hash> new_txids;
-      for (const crypto::hash &txid: txids)
+      r = for_range_parallel<depth_step_t>(db, 0, txids.size(), stop_requested, [&](uint64_t n, depth_step_t &step)
       {
+        const crypto::hash &txid = txids[n];
+        step.coinbase = false;
         cryptonote::blobdata bd;
         if (!db->get_pruned_tx_blob(txid, bd))
         {
           LOG_PRINT_L0("Failed to get txid " << txid << " from db");
-          return 1;
+          return false;
         }
         cryptonote::transaction tx;
         if (!cryptonote::parse_and_validate_tx_base_from_blob(bd, tx))
         {
           LOG_PRINT_L0("Bad tx: " << txid);
-          return 1;
+          return false;
         }
         for (size_t ring = 0; ring < tx.vin.size(); ++ring)
         {
           if (tx.vin[ring].type() == typeid(cryptonote::txin_gen))
           {
             MDEBUG(txid << " is a coinbase transaction");
-            coinbase = true;
-            goto done;
+            step.coinbase = true;
+            return true;
           }
           if (tx.vin[ring].type() == typeid(cryptonote::txin_to_key))
           {
@@ -238,7 +253,7 @@ int main(int argc, char* argv[])
               if (!cryptonote::parse_and_validate_block_from_blob(bd, b))
               {
                 LOG_PRINT_L0("Bad block from db");
-                return 1;
+                return false;
               }
               // find the tx which created this output
               bool found = false;
@@ -250,7 +265,7 @@ int main(int argc, char* argv[])
                   if (txout.key == od.pubkey)
                   {
                     found = true;
-                    new_txids.push_back(cryptonote::get_transaction_hash(b.miner_tx));
+                    step.parents.push_back(cryptonote::get_transaction_hash(b.miner_tx));
                     MDEBUG("adding txid: " << cryptonote::get_transaction_hash(b.miner_tx));
                     break;
                   }
@@ -258,7 +273,7 @@ int main(int argc, char* argv[])
                 else
                 {
                   LOG_PRINT_L0("Bad vout type in txid " << cryptonote::get_transaction_hash(b.miner_tx));
-                  return 1;
+                  return false;
                 }
               }
               for (const crypto::hash &block_txid: b.tx_hashes)
@@ -268,13 +283,13 @@ int main(int argc, char* argv[])
                 if (!db->get_pruned_tx_blob(block_txid, bd))
                 {
                   LOG_PRINT_L0("Failed to get txid " << block_txid << " from db");
-                  return 1;
+                  return false;
                 }
                 cryptonote::transaction tx2;
                 if (!cryptonote::parse_and_validate_tx_base_from_blob(bd, tx2))
                 {
                   LOG_PRINT_L0("Bad tx: " << block_txid);
-                  return 1;
+                  return false;
                 }
                 for (size_t out = 0; out < tx2.vout.size(); ++out)
                 {
@@ -284,7 +299,7 @@ int main(int argc, char* argv[])
                     if (txout.key == od.pubkey)
                     {
                       found = true;
-                      new_txids.push_back(block_txid);
+                      step.parents.push_back(block_txid);
                       MDEBUG("adding txid: " << block_txid);
                       break;
                     }
@@ -292,31 +307,40 @@ int main(int argc, char* argv[])
                   else
                   {
                     LOG_PRINT_L0("Bad vout type in txid " << block_txid);
-                    return 1;
+                    return false;
                   }
                 }
               }
               if (!found)
               {
                 LOG_PRINT_L0("Output originating transaction not found");
-                return 1;
+                return false;
               }
             }
           }
           else
           {
             LOG_PRINT_L0("Bad vin type in txid " << txid);
-            return 1;
+            return false;
           }
         }
-      }
+        return true;
+      }, [&](uint64_t n, const depth_step_t &step)
+      {
+        if (step.coinbase)
+          coinbase = true;
+        else if (!coinbase)
+          new_txids.insert(new_txids.end(), step.parents.begin(), step.parents.end());
+        return true;
+      }, 1);
+      if (!r || stop_requested)
+        return 1;
       if (!coinbase)
       {
         std::swap(txids, new_txids);
         ++depth;
       }
     }
-done:
     LOG_PRINT_L0("Min depth for txid " << start_txid << ": " << depth);
     depths.push_back(depth);
   }
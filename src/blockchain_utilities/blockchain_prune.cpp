@@ -234,6 +234,18 @@ static void copy_table(MDB_env *env0, MDB_env *env1, const char *table, unsigned
   mdb_dbi_close(env0, dbi0);
 }
 
+static bool has_table(MDB_env *env, const char *table, unsigned int flags)
+{
+  MDB_txn *txn;
+  MDB_dbi dbi;
+  int dbr = mdb_txn_begin(env, NULL, MDB_RDONLY, &txn);
+  if (dbr) throw std::runtime_error("Failed to create LMDB transaction: " + std::string(mdb_strerror(dbr)));
+  dbr = mdb_dbi_open(txn, table, flags, &dbi);
+  mdb_txn_abort(txn);
+  if (dbr && dbr != MDB_NOTFOUND) throw std::runtime_error("Failed to open LMDB dbi: " + std::string(mdb_strerror(dbr)));
+  return dbr == 0;
+}
+
 static bool is_v1_tx(MDB_cursor *c_txs_pruned, MDB_val *tx_id)
 {
   MDB_val v;
@@ -457,6 +469,8 @@ int main(int argc, char* argv[])
   , "fast:1000"
   };
   const command_line::arg_descriptor<bool> arg_copy_pruned_database  = {"copy-pruned-database",  "Copy database anyway if already pruned"};
+  const command_line::arg_descriptor<bool> arg_in_place  = {"in-place",  "Prune the database in place in small steps, resuming where a previous run stopped. "
+    "The file does not shrink, but the freed space is reused before it grows again"};
 
   command_line::add_arg(desc_cmd_sett, cryptonote::arg_data_dir);
   command_line::add_arg(desc_cmd_sett, cryptonote::arg_testnet_on);
@@ -464,6 +478,7 @@ int main(int argc, char* argv[])
   command_line::add_arg(desc_cmd_sett, arg_log_level);
   command_line::add_arg(desc_cmd_sett, arg_db_sync_mode);
   command_line::add_arg(desc_cmd_sett, arg_copy_pruned_database);
+  command_line::add_arg(desc_cmd_sett, arg_in_place);
   command_line::add_arg(desc_cmd_only, command_line::arg_help);
 
   po::options_description desc_options("Allowed options");
@@ -499,6 +514,7 @@ int main(int argc, char* argv[])
   bool opt_stagenet = command_line::get_arg(vm, cryptonote::arg_stagenet_on);
   network_type net_type = opt_testnet ? TESTNET : opt_stagenet ? STAGENET : MAINNET;
   bool opt_copy_pruned_database = command_line::get_arg(vm, arg_copy_pruned_database);
+  bool opt_in_place = command_line::get_arg(vm, arg_in_place);
   std::string data_dir = command_line::get_arg(vm, cryptonote::arg_data_dir);
   while (boost::ends_with(data_dir, "/") || boost::ends_with(data_dir, "\\"))
     data_dir.pop_back();
@@ -511,6 +527,50 @@ int main(int argc, char* argv[])
     return 1;
   }
 
+  if (opt_in_place)
+  {
+    std::unique_ptr<BlockchainDB> db(new_db());
+    if (!db)
+    {
+      MERROR("Failed to initialize a database");
+      throw std::runtime_error("Failed to initialize a database");
+    }
+    const boost::filesystem::path path = boost::filesystem::path(data_dir) / db->get_db_name();
+    MINFO("Loading blockchain from folder " << path << " ...");
+    try
+    {
+      db->open(path.string(), db_flags);
+    }
+    catch (const std::exception& e)
+    {
+      MERROR("Error opening database: " << e.what());
+      return 1;
+    }
+
+    bool stop_requested = false;
+    tools::signal_handler::install([&stop_requested](int type) {
+      stop_requested = true;
+    });
+
+    MINFO("Pruning in place...");
+    pruning_progress_t progress;
+    bool done;
+    while (!(done = db->prune_blockchain_step(CRYPTONOTE_PRUNING_BACKGROUND_STEP_TXES, progress)) && !stop_requested)
+    {
+      std::cout << "\r" << progress.txes_done << "/" << progress.txes_total << " transactions, " <<
+          progress.free_pages * progress.page_size / 1024 / 1024 << " MB free         \r" << std::flush;
+    }
+    std::cout << std::endl;
+    db->close();
+    if (!done)
+    {
+      MINFO("Stopped at " << progress.txes_done << "/" << progress.txes_total << " transactions, run again to resume");
+      return 0;
+    }
+    MINFO("Blockchain pruned OK, " << progress.free_pages * progress.page_size / 1024 / 1024 << " MB free in the database for reuse");
+    return 0;
+  }
+
   // If we wanted to use the memory pool, we would set up a fake_core.
 
   // Use Blockchain instead of lower-level BlockchainDB for two reasons:
@@ -611,6 +671,9 @@ int main(int argc, char* argv[])
   copy_table(env0, env1, "tx_outputs", MDB_INTEGERKEY, MDB_APPEND);
   copy_table(env0, env1, "output_txs", MDB_INTEGERKEY | MDB_DUPSORT | MDB_DUPFIXED, MDB_APPENDDUP, BlockchainLMDB::compare_uint64);
   copy_table(env0, env1, "output_amounts", MDB_INTEGERKEY | MDB_DUPSORT | MDB_DUPFIXED, MDB_APPENDDUP, BlockchainLMDB::compare_uint64);
+  // optional, see --db-output-key-index
+  if (has_table(env0, "output_keys", MDB_DUPSORT | MDB_DUPFIXED))
+    copy_table(env0, env1, "output_keys", MDB_DUPSORT | MDB_DUPFIXED, MDB_APPENDDUP, BlockchainLMDB::compare_uint64);
   copy_table(env0, env1, "spent_keys", MDB_INTEGERKEY | MDB_DUPSORT | MDB_DUPFIXED, MDB_NODUPDATA, BlockchainLMDB::compare_hash32);
   copy_table(env0, env1, "txpool_meta", 0, MDB_NODUPDATA, BlockchainLMDB::compare_hash32);
   copy_table(env0, env1, "txpool_blob", 0, MDB_NODUPDATA, BlockchainLMDB::compare_hash32);
@@ -0,0 +1,148 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "common/threadpool.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "blockchain_db/blockchain_db.h"
+
+// items (heights) handed to a worker at a time, each job runs in its own read txn
+#define BLOCKCHAIN_SCAN_ITEMS_PER_JOB 64
+// jobs per thread between two merges, bounds how many per item results are kept in memory
+#define BLOCKCHAIN_SCAN_JOBS_PER_THREAD 8
+
+/**
+ * @brief run map over [start, stop) on the threadpool, then reduce in order
+ *
+ * The range is cut into jobs of items_per_job consecutive items, each of
+ * which runs map(index, T&) under its own read transaction. Once a window
+ * of jobs is done, reduce(index, T&) is called on the calling thread for
+ * every item of that window in increasing index order, so the result does
+ * not depend on the number of threads. map never runs concurrently with
+ * reduce, so it may read (but not modify) state that reduce updates.
+ *
+ * Stops between windows when stop_requested is set, in which case the
+ * unfinished window is dropped.
+ *
+ * @return false if map or reduce returned false, or map threw
+ */
+template<typename T, typename Map, typename Reduce>
+bool for_range_parallel(cryptonote::BlockchainDB *db, uint64_t start, uint64_t stop, const bool &stop_requested, const Map &map, const Reduce &reduce, uint64_t items_per_job = BLOCKCHAIN_SCAN_ITEMS_PER_JOB)
+{
+  tools::threadpool &tpool = tools::threadpool::getInstance();
+  const uint64_t n_threads = std::max<uint64_t>(1, tpool.get_max_concurrency());
+  items_per_job = std::max<uint64_t>(1, items_per_job);
+  const uint64_t window_size = items_per_job * n_threads * BLOCKCHAIN_SCAN_JOBS_PER_THREAD;
+
+  std::vector<T> results;
+  for (uint64_t window_start = start; window_start < stop && !stop_requested; )
+  {
+    const uint64_t window_stop = window_start + std::min(stop - window_start, window_size);
+    const size_t n_jobs = (window_stop - window_start + items_per_job - 1) / items_per_job;
+    results.clear();
+    results.resize(window_stop - window_start);
+    std::unique_ptr<bool[]> ok(new bool[n_jobs]);
+
+    tools::threadpool::waiter waiter(tpool);
+    for (size_t job = 0; job < n_jobs; ++job)
+    {
+      const uint64_t begin = window_start + job * items_per_job;
+      const uint64_t end = std::min(window_stop, begin + items_per_job);
+      ok[job] = false;
+      tpool.submit(&waiter, [db, &map, &results, &ok, &stop_requested, window_start, job, begin, end](){
+        cryptonote::db_rtxn_guard rtxn_guard(db);
+        for (uint64_t i = begin; i < end; ++i)
+        {
+          if (stop_requested || !map(i, results[i - window_start]))
+            return;
+        }
+        ok[job] = true;
+      }, true);
+    }
+    if (!waiter.wait())
+      return false;
+    if (stop_requested)
+      break;
+    for (size_t job = 0; job < n_jobs; ++job)
+      if (!ok[job])
+        return false;
+
+    for (uint64_t i = window_start; i < window_stop; ++i)
+      if (!reduce(i, results[i - window_start]))
+        return false;
+    window_start = window_stop;
+  }
+  return true;
+}
+
+/**
+ * @brief for_range_parallel over block heights, with the block already read and parsed
+ *
+ * map is called as map(height, block_blob, block, T&) and may use db to
+ * fetch the block's transactions, which happens in the job's read txn.
+ */
+template<typename T, typename Map, typename Reduce>
+bool for_blocks_parallel(cryptonote::BlockchainDB *db, uint64_t start, uint64_t stop, const bool &stop_requested, const Map &map, const Reduce &reduce)
+{
+  return for_range_parallel<T>(db, start, stop, stop_requested, [db, &map](uint64_t height, T &data) {
+    const cryptonote::blobdata bd = db->get_block_blob_from_height(height);
+    cryptonote::block b;
+    if (!cryptonote::parse_and_validate_block_from_blob(bd, b))
+    {
+      LOG_PRINT_L0("Bad block from db at height " << height);
+      return false;
+    }
+    return map(height, bd, b, data);
+  }, reduce);
+}
+
+/**
+ * @brief read and parse the pruned part of a transaction, for use from a map callback
+ */
+inline bool get_pruned_transaction(cryptonote::BlockchainDB *db, const crypto::hash &txid, cryptonote::transaction &tx, cryptonote::blobdata *blob = NULL)
+{
+  cryptonote::blobdata bd;
+  if (!db->get_pruned_tx_blob(txid, bd))
+  {
+    LOG_PRINT_L0("Failed to get txid " << txid << " from db");
+    return false;
+  }
+  if (!cryptonote::parse_and_validate_tx_base_from_blob(bd, tx))
+  {
+    LOG_PRINT_L0("Bad tx: " << txid);
+    return false;
+  }
+  if (blob)
+    *blob = std::move(bd);
+  return true;
+}
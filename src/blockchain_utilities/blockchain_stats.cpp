@@ -35,6 +35,7 @@
 #include "cryptonote_core/cryptonote_core.h"
 #include "cryptonote_core/blockchain.h"
 #include "blockchain_db/blockchain_db.h"
+#include "blockchain_scan.h"
 #include "version.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
@@ -46,6 +47,23 @@ using namespace cryptonote;
 
 static bool stop_requested = false;
 
+struct tx_stats_t
+{
+  uint32_t ins;
+  uint32_t outs;
+  uint32_t rings;
+};
+
+struct block_stats_t
+{
+  uint64_t timestamp;
+  uint64_t size;
+  uint64_t coinbase_amount;
+  uint64_t tx_fee_amount;
+  difficulty_type diff;
+  std::vector<tx_stats_t> txes;
+};
+
 int main(int argc, char* argv[])
 {
   TRY_ENTRY();
@@ -229,16 +247,56 @@ plot 'stats.csv' index "DATA" using (timecolumn(1,"%Y-%m-%d")):4 with lines, ''
   uint32_t txhr[24] = {0};
   unsigned int i;
 
-  for (uint64_t h = block_start; h < block_stop; ++h)
+  // blocks and txes are read and parsed in parallel, the per day accounting below runs in height order
+  r = for_blocks_parallel<block_stats_t>(db, block_start, block_stop, stop_requested,
+    [&](uint64_t h, const cryptonote::blobdata &bd, const cryptonote::block &blk, block_stats_t &stats)
   {
-    cryptonote::blobdata bd = db->get_block_blob_from_height(h);
-    cryptonote::block blk;
-    if (!cryptonote::parse_and_validate_block_from_blob(bd, blk))
+    stats.timestamp = blk.timestamp;
+    stats.size = bd.size();
+    stats.tx_fee_amount = 0;
+    stats.txes.reserve(blk.tx_hashes.size());
+    cryptonote::blobdata txbd;
+    for (const auto& tx_id : blk.tx_hashes)
     {
-      LOG_PRINT_L0("Bad block from db");
-      return 1;
+      if (tx_id == crypto::null_hash)
+      {
+        throw std::runtime_error("Aborting: tx == null_hash");
+      }
+      if (!db->get_pruned_tx_blob(tx_id, txbd))
+      {
+        throw std::runtime_error("Aborting: tx not found");
+      }
+      transaction tx;
+      if (!parse_and_validate_tx_base_from_blob(txbd, tx))
+      {
+        LOG_PRINT_L0("Bad txn from db");
+        return false;
+      }
+      stats.size += txbd.size();
+      if (db->get_prunable_tx_blob(tx_id, txbd))
+        stats.size += txbd.size();
+      if (do_fees || do_emission) {
+        stats.tx_fee_amount += get_tx_fee(tx);
+      }
+      tx_stats_t tx_stats = {0, 0, 0};
+      tx_stats.ins = tx.vin.size();
+      tx_stats.outs = tx.vout.size();
+      if (do_ringsize) {
+        const cryptonote::txin_to_key& tx_in_to_key
+                       = boost::get<cryptonote::txin_to_key>(tx.vin[0]);
+        tx_stats.rings = tx_in_to_key.key_offsets.size();
+      }
+      stats.txes.push_back(tx_stats);
     }
-    time_t tt = blk.timestamp;
+    if (do_diff)
+      stats.diff = db->get_block_difficulty(h);
+    if (do_emission)
+      stats.coinbase_amount = get_outs_money_amount(blk.miner_tx);
+    return true;
+  },
+    [&](uint64_t h, const block_stats_t &stats)
+  {
+    time_t tt = stats.timestamp;
     char timebuf[64];
     epee::misc_utils::get_gmt_time(tt, currtm);
     if (!prevtm.tm_year)
@@ -295,36 +353,14 @@ plot 'stats.csv' index "DATA" using (timecolumn(1,"%Y-%m-%d")):4 with lines, ''
       std::cout << ENDL;
     }
 skip:
-    currsz += bd.size();
-    uint64_t coinbase_amount;
-    uint64_t tx_fee_amount = 0;
-    for (const auto& tx_id : blk.tx_hashes)
+    currsz += stats.size;
+    for (const tx_stats_t &tx_stats: stats.txes)
     {
-      if (tx_id == crypto::null_hash)
-      {
-        throw std::runtime_error("Aborting: tx == null_hash");
-      }
-      if (!db->get_pruned_tx_blob(tx_id, bd))
-      {
-        throw std::runtime_error("Aborting: tx not found");
-      }
-      transaction tx;
-      if (!parse_and_validate_tx_base_from_blob(bd, tx))
-      {
-        LOG_PRINT_L0("Bad txn from db");
-        return 1;
-      }
-      currsz += bd.size();
-      if (db->get_prunable_tx_blob(tx_id, bd))
-        currsz += bd.size();
       currtxs++;
-      if (do_fees || do_emission) {
-        tx_fee_amount += get_tx_fee(tx);
-      }
       if (do_hours)
         txhr[currtm.tm_hour]++;
       if (do_inputs) {
-        io = tx.vin.size();
+        io = tx_stats.ins;
         if (io < minins)
           minins = io;
         else if (io > maxins)
@@ -332,9 +368,7 @@ skip:
         totins += io;
       }
       if (do_ringsize) {
-        const cryptonote::txin_to_key& tx_in_to_key
-                       = boost::get<cryptonote::txin_to_key>(tx.vin[0]);
-        io = tx_in_to_key.key_offsets.size();
+        io = tx_stats.rings;
         if (io < minrings)
           minrings = io;
         else if (io > maxrings)
@@ -342,7 +376,7 @@ skip:
         totrings += io;
       }
       if (do_outputs) {
-        io = tx.vout.size();
+        io = tx_stats.outs;
         if (io < minouts)
           minouts = io;
         else if (io > maxouts)
@@ -352,7 +386,7 @@ skip:
       tottxs++;
     }
     if (do_diff) {
-      difficulty_type diff = db->get_block_difficulty(h);
+      const difficulty_type &diff = stats.diff;
       if (!mindiff || diff < mindiff)
         mindiff = diff;
       if (diff > maxdiff)
@@ -360,17 +394,16 @@ skip:
       totdiff += diff;
     }
     if (do_emission) {
-      coinbase_amount = get_outs_money_amount(blk.miner_tx);
-      emission += coinbase_amount - tx_fee_amount;
+      emission += stats.coinbase_amount - stats.tx_fee_amount;
     }
     if (do_fees) {
-      fees += tx_fee_amount;
+      fees += stats.tx_fee_amount;
     }
     currblks++;
-
-    if (stop_requested)
-      break;
-  }
+    return true;
+  });
+  if (!r)
+    return 1;
 
   core_storage->deinit();
   return 0;
@@ -35,6 +35,7 @@
 #include "cryptonote_core/cryptonote_core.h"
 #include "cryptonote_core/blockchain.h"
 #include "blockchain_db/blockchain_db.h"
+#include "blockchain_scan.h"
 #include "version.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
@@ -185,39 +186,59 @@ int main(int argc, char* argv[])
   std::unordered_map<uint64_t,uint64_t> indices;
 
   LOG_PRINT_L0("Reading blockchain from " << input);
-  core_storage->for_all_transactions([&](const crypto::hash &hash, const cryptonote::transaction &tx)->bool
-  {
-    const bool coinbase = tx.vin.size() == 1 && tx.vin[0].type() == typeid(txin_gen);
-    const uint64_t height = core_storage->get_db().get_tx_block_height(hash);
+  bool stop_requested = false;
+  tools::signal_handler::install([&stop_requested](int type) {
+    stop_requested = true;
+  });
 
-    // create new outputs
-    for (const auto &out: tx.vout)
+  // txes are parsed in parallel, but must be added in chain order for the output indices to match
+  r = for_blocks_parallel<std::vector<cryptonote::transaction>>(db, 0, db->height(), stop_requested,
+    [db](uint64_t height, const cryptonote::blobdata &bd, const cryptonote::block &b, std::vector<cryptonote::transaction> &txes)
+  {
+    txes.resize(1 + b.tx_hashes.size());
+    txes[0] = b.miner_tx;
+    for (size_t n = 0; n < b.tx_hashes.size(); ++n)
+      if (!get_pruned_transaction(db, b.tx_hashes[n], txes[n + 1]))
+        return false;
+    return true;
+  },
+    [&](uint64_t height, const std::vector<cryptonote::transaction> &txes)
+  {
+    for (const cryptonote::transaction &tx: txes)
     {
-      if (opt_rct_only && out.amount)
-        continue;
-      indices[out.amount]++;
-      output_data od(out.amount, indices[out.amount], coinbase, height);
-      auto itb = outputs.emplace(od, std::list<reference>());
-      itb.first->first.info(coinbase, height);
-    }
+      const bool coinbase = tx.vin.size() == 1 && tx.vin[0].type() == typeid(txin_gen);
 
-    for (const auto &in: tx.vin)
-    {
-      if (in.type() != typeid(txin_to_key))
-        continue;
-      const auto &txin = boost::get<txin_to_key>(in);
-      if (opt_rct_only && txin.amount != 0)
-        continue;
-
-      const std::vector<uint64_t> absolute = cryptonote::relative_output_offsets_to_absolute(txin.key_offsets);
-      for (size_t n = 0; n < txin.key_offsets.size(); ++n)
+      // create new outputs
+      for (const auto &out: tx.vout)
+      {
+        if (opt_rct_only && out.amount)
+          continue;
+        indices[out.amount]++;
+        output_data od(out.amount, indices[out.amount], coinbase, height);
+        auto itb = outputs.emplace(od, std::list<reference>());
+        itb.first->first.info(coinbase, height);
+      }
+
+      for (const auto &in: tx.vin)
       {
-        output_data od(txin.amount, absolute[n], coinbase, height);
-        outputs[od].push_back(reference(height, txin.key_offsets.size(), n));
+        if (in.type() != typeid(txin_to_key))
+          continue;
+        const auto &txin = boost::get<txin_to_key>(in);
+        if (opt_rct_only && txin.amount != 0)
+          continue;
+
+        const std::vector<uint64_t> absolute = cryptonote::relative_output_offsets_to_absolute(txin.key_offsets);
+        for (size_t n = 0; n < txin.key_offsets.size(); ++n)
+        {
+          output_data od(txin.amount, absolute[n], coinbase, height);
+          outputs[od].push_back(reference(height, txin.key_offsets.size(), n));
+        }
       }
     }
     return true;
-  }, true);
+  });
+  if (!r)
+    return 1;
 
   std::unordered_map<uint64_t, uint64_t> counts;
   size_t total = 0;
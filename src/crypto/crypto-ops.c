@@ -29,6 +29,7 @@
 // Parts of this file are originally copyright (c) 2012-2013 The Cryptonote developers
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "warnings.h"
@@ -66,6 +67,245 @@ uint64_t load_4(const unsigned char *in)
   return result;
 }
 
+#if defined(CRYPTO_OPS_FE51)
+
+/*
+Field arithmetic on five 64-bit limbs in radix 2^51, with 128-bit products
+(after curve25519-donna-c64). Every operation below leaves its limbs under
+2^51 + 2^13, so the ge_* formulas can chain them without tracking bounds.
+*/
+
+typedef unsigned __int128 fe_uint128;
+
+#define FE51_MASK ((((uint64_t) 1) << 51) - 1)
+
+static void fe_0(fe h) {
+  h[0] = 0;
+  h[1] = 0;
+  h[2] = 0;
+  h[3] = 0;
+  h[4] = 0;
+}
+
+static void fe_1(fe h) {
+  h[0] = 1;
+  h[1] = 0;
+  h[2] = 0;
+  h[3] = 0;
+  h[4] = 0;
+}
+
+static void fe_carry(fe h, uint64_t h0, uint64_t h1, uint64_t h2, uint64_t h3, uint64_t h4) {
+  h1 += h0 >> 51; h0 &= FE51_MASK;
+  h2 += h1 >> 51; h1 &= FE51_MASK;
+  h3 += h2 >> 51; h2 &= FE51_MASK;
+  h4 += h3 >> 51; h3 &= FE51_MASK;
+  h0 += 19 * (h4 >> 51); h4 &= FE51_MASK;
+  h[0] = h0;
+  h[1] = h1;
+  h[2] = h2;
+  h[3] = h3;
+  h[4] = h4;
+}
+
+/*
+h = f + g
+Can overlap h with f or g.
+*/
+
+void fe_add(fe h, const fe f, const fe g) {
+  fe_carry(h, f[0] + g[0], f[1] + g[1], f[2] + g[2], f[3] + g[3], f[4] + g[4]);
+}
+
+/*
+h = f - g, computed as f + 2p - g
+Can overlap h with f or g.
+*/
+
+static void fe_sub(fe h, const fe f, const fe g) {
+  fe_carry(h,
+    f[0] + 0xfffffffffffdaULL - g[0],
+    f[1] + 0xffffffffffffeULL - g[1],
+    f[2] + 0xffffffffffffeULL - g[2],
+    f[3] + 0xffffffffffffeULL - g[3],
+    f[4] + 0xffffffffffffeULL - g[4]);
+}
+
+static void fe_neg(fe h, const fe f) {
+  fe zero;
+  fe_0(zero);
+  fe_sub(h, zero, f);
+}
+
+/*
+Replace (f,g) with (g,g) if b == 1;
+replace (f,g) with (f,g) if b == 0.
+
+Preconditions: b in {0,1}.
+*/
+
+static void fe_cmov(fe f, const fe g, unsigned int b) {
+  uint64_t mask = (uint64_t) 0 - (uint64_t) b;
+  assert((((b - 1) & ~b) | ((b - 2) & ~(b - 1))) == (unsigned int) -1);
+  f[0] ^= (f[0] ^ g[0]) & mask;
+  f[1] ^= (f[1] ^ g[1]) & mask;
+  f[2] ^= (f[2] ^ g[2]) & mask;
+  f[3] ^= (f[3] ^ g[3]) & mask;
+  f[4] ^= (f[4] ^ g[4]) & mask;
+}
+
+static void fe_copy(fe h, const fe f) {
+  h[0] = f[0];
+  h[1] = f[1];
+  h[2] = f[2];
+  h[3] = f[3];
+  h[4] = f[4];
+}
+
+/*
+Loads the 255 low bits of s, or all 256 of them (reduced mod p) if top is set.
+*/
+
+static void fe_frombytes_bits(fe h, const unsigned char *s, int top) {
+  uint64_t w0 = load_4(s) | (load_4(s + 4) << 32);
+  uint64_t w1 = load_4(s + 8) | (load_4(s + 12) << 32);
+  uint64_t w2 = load_4(s + 16) | (load_4(s + 20) << 32);
+  uint64_t w3 = load_4(s + 24) | (load_4(s + 28) << 32);
+  h[0] = w0 & FE51_MASK;
+  h[1] = ((w0 >> 51) | (w1 << 13)) & FE51_MASK;
+  h[2] = ((w1 >> 38) | (w2 << 26)) & FE51_MASK;
+  h[3] = ((w2 >> 25) | (w3 << 39)) & FE51_MASK;
+  h[4] = w3 >> 12;
+  if (top) {
+    fe_carry(h, h[0], h[1], h[2], h[3], h[4]);
+  } else {
+    h[4] &= FE51_MASK;
+  }
+}
+
+/*
+h = f * g
+Can overlap h with f or g.
+*/
+
+static void fe_mul(fe h, const fe f, const fe g) {
+  uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  uint64_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+  uint64_t g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3, g4_19 = 19 * g4;
+  fe_uint128 t0, t1, t2, t3, t4;
+  uint64_t h0, h1, h2, h3, h4, c;
+
+  t0 = (fe_uint128) f0 * g0 + (fe_uint128) f1 * g4_19 + (fe_uint128) f2 * g3_19 + (fe_uint128) f3 * g2_19 + (fe_uint128) f4 * g1_19;
+  t1 = (fe_uint128) f0 * g1 + (fe_uint128) f1 * g0 + (fe_uint128) f2 * g4_19 + (fe_uint128) f3 * g3_19 + (fe_uint128) f4 * g2_19;
+  t2 = (fe_uint128) f0 * g2 + (fe_uint128) f1 * g1 + (fe_uint128) f2 * g0 + (fe_uint128) f3 * g4_19 + (fe_uint128) f4 * g3_19;
+  t3 = (fe_uint128) f0 * g3 + (fe_uint128) f1 * g2 + (fe_uint128) f2 * g1 + (fe_uint128) f3 * g0 + (fe_uint128) f4 * g4_19;
+  t4 = (fe_uint128) f0 * g4 + (fe_uint128) f1 * g3 + (fe_uint128) f2 * g2 + (fe_uint128) f3 * g1 + (fe_uint128) f4 * g0;
+
+  h0 = (uint64_t) t0 & FE51_MASK; c = (uint64_t) (t0 >> 51);
+  t1 += c; h1 = (uint64_t) t1 & FE51_MASK; c = (uint64_t) (t1 >> 51);
+  t2 += c; h2 = (uint64_t) t2 & FE51_MASK; c = (uint64_t) (t2 >> 51);
+  t3 += c; h3 = (uint64_t) t3 & FE51_MASK; c = (uint64_t) (t3 >> 51);
+  t4 += c; h4 = (uint64_t) t4 & FE51_MASK; c = (uint64_t) (t4 >> 51);
+  h0 += c * 19; h1 += h0 >> 51; h0 &= FE51_MASK;
+
+  h[0] = h0;
+  h[1] = h1;
+  h[2] = h2;
+  h[3] = h3;
+  h[4] = h4;
+}
+
+/*
+h = f * f, doubled if dbl is set
+Can overlap h with f.
+*/
+
+static void fe_sq_dbl(fe h, const fe f, int dbl) {
+  uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  uint64_t f0_2 = 2 * f0, f1_2 = 2 * f1;
+  uint64_t f2_38 = 38 * f2, f3_19 = 19 * f3, f4_19 = 19 * f4, f4_38 = 2 * f4_19;
+  fe_uint128 t0, t1, t2, t3, t4;
+  uint64_t h0, h1, h2, h3, h4, c;
+
+  t0 = (fe_uint128) f0 * f0 + (fe_uint128) f4_38 * f1 + (fe_uint128) f2_38 * f3;
+  t1 = (fe_uint128) f0_2 * f1 + (fe_uint128) f4_38 * f2 + (fe_uint128) f3_19 * f3;
+  t2 = (fe_uint128) f0_2 * f2 + (fe_uint128) f1 * f1 + (fe_uint128) f4_38 * f3;
+  t3 = (fe_uint128) f0_2 * f3 + (fe_uint128) f1_2 * f2 + (fe_uint128) f4_19 * f4;
+  t4 = (fe_uint128) f0_2 * f4 + (fe_uint128) f1_2 * f3 + (fe_uint128) f2 * f2;
+
+  if (dbl) {
+    t0 <<= 1;
+    t1 <<= 1;
+    t2 <<= 1;
+    t3 <<= 1;
+    t4 <<= 1;
+  }
+
+  h0 = (uint64_t) t0 & FE51_MASK; c = (uint64_t) (t0 >> 51);
+  t1 += c; h1 = (uint64_t) t1 & FE51_MASK; c = (uint64_t) (t1 >> 51);
+  t2 += c; h2 = (uint64_t) t2 & FE51_MASK; c = (uint64_t) (t2 >> 51);
+  t3 += c; h3 = (uint64_t) t3 & FE51_MASK; c = (uint64_t) (t3 >> 51);
+  t4 += c; h4 = (uint64_t) t4 & FE51_MASK; c = (uint64_t) (t4 >> 51);
+  h0 += c * 19; h1 += h0 >> 51; h0 &= FE51_MASK;
+
+  h[0] = h0;
+  h[1] = h1;
+  h[2] = h2;
+  h[3] = h3;
+  h[4] = h4;
+}
+
+static void fe_sq(fe h, const fe f) {
+  fe_sq_dbl(h, f, 0);
+}
+
+/*
+h = 2 * f * f
+Can overlap h with f.
+*/
+
+static void fe_sq2(fe h, const fe f) {
+  fe_sq_dbl(h, f, 1);
+}
+
+/*
+Writes the canonical (fully reduced) encoding of h.
+*/
+
+void fe_tobytes(unsigned char *s, const fe h) {
+  uint64_t t[5];
+  int i;
+
+  fe_carry(t, h[0], h[1], h[2], h[3], h[4]);
+  fe_carry(t, t[0], t[1], t[2], t[3], t[4]);
+
+  /* t is now below 2^255 + 19 * 2^13, carried; subtract p if t >= p */
+  t[0] += 19;
+  fe_carry(t, t[0], t[1], t[2], t[3], t[4]);
+
+  /* t + 19 is in [19, 2^255 - 1] and offset by 19; add 2^255 - 19 and drop the top bit */
+  t[0] += FE51_MASK + 1 - 19;
+  t[1] += FE51_MASK;
+  t[2] += FE51_MASK;
+  t[3] += FE51_MASK;
+  t[4] += FE51_MASK;
+  t[1] += t[0] >> 51; t[0] &= FE51_MASK;
+  t[2] += t[1] >> 51; t[1] &= FE51_MASK;
+  t[3] += t[2] >> 51; t[2] &= FE51_MASK;
+  t[4] += t[3] >> 51; t[3] &= FE51_MASK;
+  t[4] &= FE51_MASK;
+
+  t[0] |= t[1] << 51;
+  t[1] = (t[1] >> 13) | (t[2] << 38);
+  t[2] = (t[2] >> 26) | (t[3] << 25);
+  t[3] = (t[3] >> 39) | (t[4] << 12);
+  for (i = 0; i < 32; ++i) {
+    s[i] = (unsigned char) (t[i / 8] >> (8 * (i % 8)));
+  }
+}
+
+#else
+
 /* From fe_0.c */
 
 /*
@@ -254,6 +494,8 @@ static void fe_copy(fe h, const fe f) {
   h[9] = f9;
 }
 
+#endif
+
 /* From fe_invert.c */
 
 void fe_invert(fe out, const fe z) {
@@ -341,6 +583,8 @@ static int fe_isnonzero(const fe f) {
     s[27] | s[28] | s[29] | s[30] | s[31]) - 1) >> 8) + 1;
 }
 
+#if !defined(CRYPTO_OPS_FE51)
+
 /* From fe_mul.c */
 
 /*
@@ -1121,6 +1365,8 @@ void fe_tobytes(unsigned char *s, const fe h) {
   s[31] = h9 >> 18;
 }
 
+#endif
+
 /* From ge_add.c */
 
 void ge_add(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q) {
@@ -1284,6 +1530,51 @@ void ge_triple_scalarmult_base_vartime(ge_p2 *r, const unsigned char *a, const u
   }
 }
 
+/*
+r = a * H + b * B
+Same as ge_double_scalarmult_base_vartime with A = H, but both
+points use their fixed precomputed tables (ge_Hi and ge_Bi).
+*/
+
+void ge_double_scalarmult_base_vartime_H(ge_p2 *r, const unsigned char *a, const unsigned char *b) {
+  signed char aslide[256];
+  signed char bslide[256];
+  ge_p1p1 t;
+  ge_p3 u;
+  int i;
+
+  slide(aslide, a);
+  slide(bslide, b);
+
+  ge_p2_0(r);
+
+  for (i = 255; i >= 0; --i) {
+    if (aslide[i] || bslide[i]) break;
+  }
+
+  for (; i >= 0; --i) {
+    ge_p2_dbl(&t, r);
+
+    if (aslide[i] > 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_madd(&t, &u, &ge_Hi[aslide[i]/2]);
+    } else if (aslide[i] < 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_msub(&t, &u, &ge_Hi[(-aslide[i])/2]);
+    }
+
+    if (bslide[i] > 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_madd(&t, &u, &ge_Bi[bslide[i]/2]);
+    } else if (bslide[i] < 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_msub(&t, &u, &ge_Bi[(-bslide[i])/2]);
+    }
+
+    ge_p1p1_to_p2(r, &t);
+  }
+}
+
 void ge_double_scalarmult_base_vartime_p3(ge_p3 *r3, const unsigned char *a, const ge_p3 *A, const unsigned char *b) {
   signed char aslide[256];
   signed char bslide[256];
@@ -1337,6 +1628,15 @@ int ge_frombytes_vartime(ge_p3 *h, const unsigned char *s) {
   fe vxx;
   fe check;
 
+#if defined(CRYPTO_OPS_FE51)
+  fe_frombytes_bits(h->Y, s, 0);
+
+  /* Validate the number to be canonical */
+  if (h->Y[4] == FE51_MASK && h->Y[3] == FE51_MASK && h->Y[2] == FE51_MASK &&
+    h->Y[1] == FE51_MASK && h->Y[0] >= FE51_MASK - 18) {
+    return -1;
+  }
+#else
   /* From fe_frombytes.c */
 
   int64_t h0 = load_4(s);
@@ -1391,6 +1691,7 @@ int ge_frombytes_vartime(ge_p3 *h, const unsigned char *s) {
   h->Y[9] = h9;
 
   /* End fe_frombytes.c */
+#endif
 
   fe_1(h->Z);
   fe_sq(u, h->Y);
@@ -1575,6 +1876,40 @@ void ge_p3_tobytes(unsigned char *s, const ge_p3 *h) {
   s[31] ^= fe_isnegative(x) << 7;
 }
 
+/*
+Same as ge_p3_tobytes on each of the n points, 32 bytes each in s, but
+with a single inversion (Montgomery's trick). tmp holds n elements.
+*/
+
+void ge_p3_tobytes_batch(unsigned char *s, const ge_p3 *h, size_t n, fe *tmp) {
+  fe recip;
+  fe zinv;
+  fe x;
+  fe y;
+  size_t i;
+
+  if (n == 0) {
+    return;
+  }
+  fe_copy(tmp[0], h[0].Z);
+  for (i = 1; i < n; ++i) {
+    fe_mul(tmp[i], tmp[i - 1], h[i].Z);
+  }
+  fe_invert(recip, tmp[n - 1]);
+  for (i = n - 1; i > 0; --i) {
+    fe_mul(zinv, recip, tmp[i - 1]);
+    fe_mul(recip, recip, h[i].Z);
+    fe_mul(x, h[i].X, zinv);
+    fe_mul(y, h[i].Y, zinv);
+    fe_tobytes(s + 32 * i, y);
+    s[32 * i + 31] ^= fe_isnegative(x) << 7;
+  }
+  fe_mul(x, h[0].X, recip);
+  fe_mul(y, h[0].Y, recip);
+  fe_tobytes(s, y);
+  s[31] ^= fe_isnegative(x) << 7;
+}
+
 /* From ge_precomp_0.c */
 
 static void ge_precomp_0(ge_precomp *h) {
@@ -2311,6 +2646,9 @@ void ge_fromfe_frombytes_vartime(ge_p2 *r, const unsigned char *s) {
   fe u, v, w, x, y, z;
   unsigned char sign;
 
+#if defined(CRYPTO_OPS_FE51)
+  fe_frombytes_bits(u, s, 1);
+#else
   /* From fe_frombytes.c */
 
   int64_t h0 = load_4(s);
@@ -2358,6 +2696,7 @@ void ge_fromfe_frombytes_vartime(ge_p2 *r, const unsigned char *s) {
   u[9] = h9;
 
   /* End fe_frombytes.c */
+#endif
 
   fe_sq2(v, u); /* 2 * u^2 */
   fe_1(w);
@@ -3832,6 +4171,12 @@ int sc_isnonzero(const unsigned char *s) {
 
 int ge_p3_is_point_at_infinity(const ge_p3 *p) {
   // X = 0 and Y == Z
+#if defined(CRYPTO_OPS_FE51)
+  // the 51-bit limbs are not kept canonical, so compare the values
+  fe d;
+  fe_sub(d, p->Y, p->Z);
+  return !fe_isnonzero(p->X) && !fe_isnonzero(p->T) && !fe_isnonzero(d);
+#else
   int n;
   for (n = 0; n < 10; ++n)
   {
@@ -3841,4 +4186,5 @@ int ge_p3_is_point_at_infinity(const ge_p3 *p) {
       return 0;
   }
   return 1;
+#endif
 }
@@ -32,7 +32,15 @@
 
 /* From fe.h */
 
+/* Where the compiler has 64x64->128 bit products, use five 51-bit limbs
+   instead of ref10's ten 25.5-bit ones; the tables in crypto-ops-data.c
+   come in both forms. */
+#if defined(__SIZEOF_INT128__) && !defined(CRYPTO_OPS_NO_FE51)
+#define CRYPTO_OPS_FE51
+typedef uint64_t fe[5];
+#else
 typedef int32_t fe[10];
+#endif
 
 /* From ge.h */
 
@@ -112,6 +120,7 @@ void ge_p3_to_p2(ge_p2 *, const ge_p3 *);
 /* From ge_p3_tobytes.c */
 
 void ge_p3_tobytes(unsigned char *, const ge_p3 *);
+void ge_p3_tobytes_batch(unsigned char *, const ge_p3 *, size_t, fe *);
 
 /* From ge_scalarmult_base.c */
 
@@ -143,6 +152,8 @@ extern const fe fe_fffb3;
 extern const fe fe_fffb4;
 extern const ge_p3 ge_p3_identity;
 extern const ge_p3 ge_p3_H;
+extern const ge_precomp ge_Hi[8];
+void ge_double_scalarmult_base_vartime_H(ge_p2 *, const unsigned char *, const unsigned char *);
 void ge_fromfe_frombytes_vartime(ge_p2 *, const unsigned char *);
 void sc_0(unsigned char *);
 void sc_reduce32(unsigned char *);
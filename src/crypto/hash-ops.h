@@ -79,6 +79,9 @@ enum {
 };
 
 void cn_fast_hash(const void *data, size_t length, char *hash);
+/* hashes[i] = cn_fast_hash(data[i], length[i]) for count messages, hashed four
+   at a time where keccakf_x4 is vectorized; hashes must not overlap data */
+void cn_fast_hash_batch(const void *const *data, const size_t *length, size_t count, char (*hashes)[HASH_SIZE]);
 void cn_slow_hash(const void *data, size_t length, char *hash, int variant, int prehashed, uint64_t height);
 
 void hash_extra_blake(const void *data, size_t length, char *hash);
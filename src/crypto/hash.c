@@ -55,3 +55,83 @@ void cn_fast_hash(const void *data, size_t length, char *hash) {
   hash_process(&state, data, length);
   memcpy(hash, &state, HASH_SIZE);
 }
+
+static void absorb_x4(uint64_t st[25][4], int lane, const uint8_t *block) {
+  size_t i;
+  for (i = 0; i < HASH_DATA_AREA / 8; ++i) {
+    uint64_t w;
+    memcpy(&w, block + i * 8, 8);
+    st[i][lane] ^= swap64le(w);
+  }
+}
+
+void cn_fast_hash_batch(const void *const *data, const size_t *length, size_t count, char (*hashes)[HASH_SIZE]) {
+  uint64_t st[25][4];
+  const uint8_t *in[4];
+  size_t left[4], msg[4], next = 0, i;
+  int active[4], last[4], lane, busy;
+
+  if (count < 2 || !keccakf_x4_vectorized()) {
+    for (i = 0; i < count; ++i) {
+      cn_fast_hash(data[i], length[i], hashes[i]);
+    }
+    return;
+  }
+
+  // each lane takes the next message as soon as its current one is done
+  memset(st, 0, sizeof(st));
+  for (lane = 0; lane < 4; ++lane) {
+    active[lane] = next < count;
+    last[lane] = 0;
+    if (active[lane]) {
+      msg[lane] = next;
+      in[lane] = data[next];
+      left[lane] = length[next];
+      ++next;
+    }
+  }
+
+  do {
+    for (lane = 0; lane < 4; ++lane) {
+      if (!active[lane])
+        continue;
+      if (left[lane] >= HASH_DATA_AREA) {
+        absorb_x4(st, lane, in[lane]);
+        in[lane] += HASH_DATA_AREA;
+        left[lane] -= HASH_DATA_AREA;
+      } else {
+        uint8_t temp[HASH_DATA_AREA];
+        memcpy(temp, in[lane], left[lane]);
+        temp[left[lane]] = 1;
+        memset(temp + left[lane] + 1, 0, HASH_DATA_AREA - left[lane] - 1);
+        temp[HASH_DATA_AREA - 1] |= 0x80;
+        absorb_x4(st, lane, temp);
+        last[lane] = 1;
+      }
+    }
+
+    keccakf_x4(st);
+
+    busy = 0;
+    for (lane = 0; lane < 4; ++lane) {
+      if (active[lane] && last[lane]) {
+        for (i = 0; i < HASH_SIZE / 8; ++i) {
+          uint64_t w = swap64le(st[i][lane]);
+          memcpy(hashes[msg[lane]] + i * 8, &w, 8);
+        }
+        for (i = 0; i < 25; ++i) {
+          st[i][lane] = 0;
+        }
+        last[lane] = 0;
+        active[lane] = next < count;
+        if (active[lane]) {
+          msg[lane] = next;
+          in[lane] = data[next];
+          left[lane] = length[next];
+          ++next;
+        }
+      }
+      busy |= active[lane];
+    }
+  } while (busy);
+}
@@ -84,6 +84,146 @@ void keccakf(uint64_t st[25], int rounds)
     }
 }
 
+// four independent states side by side, st[i][n] being word i of state n
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+
+#include <immintrin.h>
+
+#define XOR(x, y) _mm256_xor_si256((x), (y))
+#define XOR5(v, w, x, y, z) XOR(XOR(XOR((v), (w)), XOR((x), (y))), (z))
+#define ANDNOT(x, y) _mm256_andnot_si256((x), (y))
+#define ROL(x, n) _mm256_or_si256(_mm256_slli_epi64((x), (n)), _mm256_srli_epi64((x), 64 - (n)))
+
+__attribute__((target("avx2")))
+static void keccakf_x4_avx2(uint64_t st[25][4])
+{
+    __m256i a[25], b[25], c0, c1, c2, c3, c4, d0, d1, d2, d3, d4;
+    int i, round;
+
+    for (i = 0; i < 25; i++)
+        a[i] = _mm256_loadu_si256((const __m256i *) st[i]);
+
+    for (round = 0; round < KECCAK_ROUNDS; round++) {
+    /* Theta */
+    c0 = XOR5(a[0], a[5], a[10], a[15], a[20]);
+    c1 = XOR5(a[1], a[6], a[11], a[16], a[21]);
+    c2 = XOR5(a[2], a[7], a[12], a[17], a[22]);
+    c3 = XOR5(a[3], a[8], a[13], a[18], a[23]);
+    c4 = XOR5(a[4], a[9], a[14], a[19], a[24]);
+    d0 = XOR(c4, ROL(c1, 1));
+    d1 = XOR(c0, ROL(c2, 1));
+    d2 = XOR(c1, ROL(c3, 1));
+    d3 = XOR(c2, ROL(c4, 1));
+    d4 = XOR(c3, ROL(c0, 1));
+
+    /* Rho Pi */
+    b[0] = XOR(a[0], d0);
+    b[10] = ROL(XOR(a[1], d1), 1);
+    b[20] = ROL(XOR(a[2], d2), 62);
+    b[5] = ROL(XOR(a[3], d3), 28);
+    b[15] = ROL(XOR(a[4], d4), 27);
+    b[16] = ROL(XOR(a[5], d0), 36);
+    b[1] = ROL(XOR(a[6], d1), 44);
+    b[11] = ROL(XOR(a[7], d2), 6);
+    b[21] = ROL(XOR(a[8], d3), 55);
+    b[6] = ROL(XOR(a[9], d4), 20);
+    b[7] = ROL(XOR(a[10], d0), 3);
+    b[17] = ROL(XOR(a[11], d1), 10);
+    b[2] = ROL(XOR(a[12], d2), 43);
+    b[12] = ROL(XOR(a[13], d3), 25);
+    b[22] = ROL(XOR(a[14], d4), 39);
+    b[23] = ROL(XOR(a[15], d0), 41);
+    b[8] = ROL(XOR(a[16], d1), 45);
+    b[18] = ROL(XOR(a[17], d2), 15);
+    b[3] = ROL(XOR(a[18], d3), 21);
+    b[13] = ROL(XOR(a[19], d4), 8);
+    b[14] = ROL(XOR(a[20], d0), 18);
+    b[24] = ROL(XOR(a[21], d1), 2);
+    b[9] = ROL(XOR(a[22], d2), 61);
+    b[19] = ROL(XOR(a[23], d3), 56);
+    b[4] = ROL(XOR(a[24], d4), 14);
+
+    /* Chi */
+    a[0] = XOR(b[0], ANDNOT(b[1], b[2]));
+    a[1] = XOR(b[1], ANDNOT(b[2], b[3]));
+    a[2] = XOR(b[2], ANDNOT(b[3], b[4]));
+    a[3] = XOR(b[3], ANDNOT(b[4], b[0]));
+    a[4] = XOR(b[4], ANDNOT(b[0], b[1]));
+    a[5] = XOR(b[5], ANDNOT(b[6], b[7]));
+    a[6] = XOR(b[6], ANDNOT(b[7], b[8]));
+    a[7] = XOR(b[7], ANDNOT(b[8], b[9]));
+    a[8] = XOR(b[8], ANDNOT(b[9], b[5]));
+    a[9] = XOR(b[9], ANDNOT(b[5], b[6]));
+    a[10] = XOR(b[10], ANDNOT(b[11], b[12]));
+    a[11] = XOR(b[11], ANDNOT(b[12], b[13]));
+    a[12] = XOR(b[12], ANDNOT(b[13], b[14]));
+    a[13] = XOR(b[13], ANDNOT(b[14], b[10]));
+    a[14] = XOR(b[14], ANDNOT(b[10], b[11]));
+    a[15] = XOR(b[15], ANDNOT(b[16], b[17]));
+    a[16] = XOR(b[16], ANDNOT(b[17], b[18]));
+    a[17] = XOR(b[17], ANDNOT(b[18], b[19]));
+    a[18] = XOR(b[18], ANDNOT(b[19], b[15]));
+    a[19] = XOR(b[19], ANDNOT(b[15], b[16]));
+    a[20] = XOR(b[20], ANDNOT(b[21], b[22]));
+    a[21] = XOR(b[21], ANDNOT(b[22], b[23]));
+    a[22] = XOR(b[22], ANDNOT(b[23], b[24]));
+    a[23] = XOR(b[23], ANDNOT(b[24], b[20]));
+    a[24] = XOR(b[24], ANDNOT(b[20], b[21]));
+
+    /* Iota */
+    a[0] = XOR(a[0], _mm256_set1_epi64x((long long) keccakf_rndc[round]));
+    }
+
+    for (i = 0; i < 25; i++)
+        _mm256_storeu_si256((__m256i *) st[i], a[i]);
+}
+
+#undef XOR
+#undef XOR5
+#undef ANDNOT
+#undef ROL
+
+int keccakf_x4_vectorized(void)
+{
+    static int supported = -1;
+    if (supported < 0) {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return supported;
+}
+
+#else
+
+int keccakf_x4_vectorized(void)
+{
+    return 0;
+}
+
+#endif
+
+void keccakf_x4(uint64_t st[25][4])
+{
+    uint64_t one[25];
+    int i, n;
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    if (keccakf_x4_vectorized()) {
+        keccakf_x4_avx2(st);
+        return;
+    }
+#endif
+
+    for (n = 0; n < 4; n++) {
+        for (i = 0; i < 25; i++)
+            one[i] = st[i][n];
+        keccakf(one, KECCAK_ROUNDS);
+        for (i = 0; i < 25; i++)
+            st[i][n] = one[i];
+    }
+}
+
 // compute a keccak hash (md) of given byte length from "in"
 typedef uint64_t state_t[25];
 
@@ -32,6 +32,11 @@ void keccak(const uint8_t *in, size_t inlen, uint8_t *md, int mdlen);
 // update the state
 void keccakf(uint64_t st[25], int norounds);
 
+// keccakf on four independent states at once, st[i][n] being word i of
+// state n; vectorized when keccakf_x4_vectorized() says so
+void keccakf_x4(uint64_t st[25][4]);
+int keccakf_x4_vectorized(void);
+
 void keccak1600(const uint8_t *in, size_t inlen, uint8_t *md);
 
 void keccak_init(KECCAK_CTX * ctx);
@@ -59,6 +59,18 @@ size_t tree_hash_cnt(size_t count) {
 	return pow >> 1;
 }
 
+/***
+* out[j] = hash of the pair in[2j], in[2j+1], for j < n
+*/
+static void tree_hash_pairs(const char *in, size_t n, char *out, const void **data, size_t *length) {
+  size_t i;
+  for (i = 0; i < n; ++i) {
+    data[i] = in + 2 * i * HASH_SIZE;
+    length[i] = 2 * HASH_SIZE;
+  }
+  cn_fast_hash_batch(data, length, n, (char (*)[HASH_SIZE]) out);
+}
+
 void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash) {
 // The blockchain block at height 202612 https://moneroblocks.info/block/202612
 // contained 514 transactions, that triggered bad calculation of variable "cnt" in the original version of this function
@@ -79,29 +91,32 @@ void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash) {
   } else if (count == 2) {
     cn_fast_hash(hashes, 2 * HASH_SIZE, root_hash);
   } else {
-    size_t i, j;
-
     size_t cnt = tree_hash_cnt( count );
+    size_t first = 2 * cnt - count;
 
-    char *ints = calloc(cnt, HASH_SIZE);  // zero out as extra protection for using uninitialized mem
-    assert(ints);
-
-    memcpy(ints, hashes, (2 * cnt - count) * HASH_SIZE);
+    // the pairs of a level are hashed as one batch, which can't work in place,
+    // so levels alternate between ints and tmp
+    char *buf = calloc(cnt + cnt / 2, HASH_SIZE);  // zero out as extra protection for using uninitialized mem
+    const void **data = malloc(cnt * sizeof(*data));
+    size_t *length = malloc(cnt * sizeof(*length));
+    assert(buf && data && length);
+    char *ints = buf, *tmp = buf + cnt * HASH_SIZE;
 
-    for (i = 2 * cnt - count, j = 2 * cnt - count; j < cnt; i += 2, ++j) {
-      cn_fast_hash(hashes[i], 64, ints + j * HASH_SIZE);
-    }
-    assert(i == count);
+    memcpy(ints, hashes, first * HASH_SIZE);
+    tree_hash_pairs(hashes[first], cnt - first, ints + first * HASH_SIZE, data, length);
 
     while (cnt > 2) {
       cnt >>= 1;
-      for (i = 0, j = 0; j < cnt; i += 2, ++j) {
-        cn_fast_hash(ints + i * HASH_SIZE, 64, ints + j * HASH_SIZE);
-      }
+      tree_hash_pairs(ints, cnt, tmp, data, length);
+      char *t = ints;
+      ints = tmp;
+      tmp = t;
     }
 
     cn_fast_hash(ints, 64, root_hash);
-    free(ints);
+    free(length);
+    free(data);
+    free(buf);
   }
 }
 
@@ -273,7 +273,7 @@ namespace cryptonote
     return is_v1_tx(blobdata_ref{tx_blob.data(), tx_blob.size()});
   }
   //---------------------------------------------------------------
-  bool generate_key_image_helper(const account_keys& ack, const std::unordered_map<crypto::public_key, subaddress_index>& subaddresses, const crypto::public_key& out_key, const crypto::public_key& tx_public_key, const std::vector<crypto::public_key>& additional_tx_public_keys, size_t real_output_index, keypair& in_ephemeral, crypto::key_image& ki, hw::device &hwdev)
+  bool generate_key_image_helper(const account_keys& ack, const subaddress_map& subaddresses, const crypto::public_key& out_key, const crypto::public_key& tx_public_key, const std::vector<crypto::public_key>& additional_tx_public_keys, size_t real_output_index, keypair& in_ephemeral, crypto::key_image& ki, hw::device &hwdev)
   {
     crypto::key_derivation recv_derivation = AUTO_VAL_INIT(recv_derivation);
     bool r = hwdev.generate_key_derivation(tx_public_key, ack.m_view_secret_key, recv_derivation);
@@ -904,22 +904,22 @@ namespace cryptonote
     return false;
   }
   //---------------------------------------------------------------
-  boost::optional<subaddress_receive_info> is_out_to_acc_precomp(const std::unordered_map<crypto::public_key, subaddress_index>& subaddresses, const crypto::public_key& out_key, const crypto::key_derivation& derivation, const std::vector<crypto::key_derivation>& additional_derivations, size_t output_index, hw::device &hwdev)
+  boost::optional<subaddress_receive_info> is_out_to_acc_precomp(const subaddress_map& subaddresses, const crypto::public_key& out_key, const crypto::key_derivation& derivation, const std::vector<crypto::key_derivation>& additional_derivations, size_t output_index, hw::device &hwdev)
   {
     // try the shared tx pubkey
     crypto::public_key subaddress_spendkey;
     hwdev.derive_subaddress_public_key(out_key, derivation, output_index, subaddress_spendkey);
-    auto found = subaddresses.find(subaddress_spendkey);
-    if (found != subaddresses.end())
-      return subaddress_receive_info{ found->second, derivation };
+    const subaddress_index* found = subaddresses.find(subaddress_spendkey);
+    if (found)
+      return subaddress_receive_info{ *found, derivation };
     // try additional tx pubkeys if available
     if (!additional_derivations.empty())
     {
       CHECK_AND_ASSERT_MES(output_index < additional_derivations.size(), boost::none, "wrong number of additional derivations");
       hwdev.derive_subaddress_public_key(out_key, additional_derivations[output_index], output_index, subaddress_spendkey);
       found = subaddresses.find(subaddress_spendkey);
-      if (found != subaddresses.end())
-        return subaddress_receive_info{ found->second, additional_derivations[output_index] };
+      if (found)
+        return subaddress_receive_info{ *found, additional_derivations[output_index] };
     }
     return boost::none;
   }
@@ -1224,9 +1224,13 @@ namespace cryptonote
   }
   //---------------------------------------------------------------
   blobdata get_block_hashing_blob(const block& b)
+  {
+    return get_block_hashing_blob(b, get_tx_tree_hash(b));
+  }
+  //---------------------------------------------------------------
+  blobdata get_block_hashing_blob(const block& b, const crypto::hash& tree_root_hash)
   {
     blobdata blob = t_serializable_object_to_blob(static_cast<block_header>(b));
-    crypto::hash tree_root_hash = get_tx_tree_hash(b);
     blob.append(reinterpret_cast<const char*>(&tree_root_hash), sizeof(tree_root_hash));
     blob.append(tools::get_varint_data(b.tx_hashes.size()+1));
     return blob;
@@ -1373,6 +1377,32 @@ namespace cryptonote
     return get_tx_tree_hash(txs_ids);
   }
   //---------------------------------------------------------------
+  std::vector<crypto::hash> get_miner_tx_tree_branch(const std::vector<crypto::hash>& tx_hashes)
+  {
+    // the miner tx is the first leaf, so its path is all zeroes and its
+    // siblings do not depend on it: a placeholder is enough to get them
+    std::vector<crypto::hash> leaves;
+    leaves.reserve(1 + tx_hashes.size());
+    leaves.push_back(null_hash);
+    leaves.insert(leaves.end(), tx_hashes.begin(), tx_hashes.end());
+
+    std::vector<crypto::hash> branch(sizeof(size_t) * 8);
+    size_t depth = 0;
+    uint32_t path = 0;
+    CHECK_AND_ASSERT_THROW_MES(crypto::tree_branch(reinterpret_cast<const char (*)[HASH_SIZE]>(leaves.data()), leaves.size(), leaves.front().data, reinterpret_cast<char (*)[HASH_SIZE]>(branch.data()), &depth, &path),
+        "Failed to calculate miner tx tree branch");
+    CHECK_AND_ASSERT_THROW_MES(path == 0 && depth <= branch.size(), "Unexpected miner tx tree branch");
+    branch.resize(depth);
+    return branch;
+  }
+  //---------------------------------------------------------------
+  crypto::hash get_tx_tree_hash(const crypto::hash& miner_tx_hash, const std::vector<crypto::hash>& miner_tx_branch)
+  {
+    crypto::hash h = null_hash;
+    crypto::tree_branch_hash(miner_tx_hash.data, reinterpret_cast<const char (*)[HASH_SIZE]>(miner_tx_branch.data()), miner_tx_branch.size(), 0, h.data);
+    return h;
+  }
+  //---------------------------------------------------------------
   bool is_valid_decomposed_amount(uint64_t amount)
   {
     const uint64_t *begin = valid_decomposed_outputs;
@@ -28,8 +28,12 @@
 
 #pragma once
 
+#include <vector>
+
 #include "crypto/hash.h"
 #include "cryptonote_basic/cryptonote_basic.h"
+#include "cryptonote_basic/difficulty.h"
+#include "serialization/difficulty_type.h"
 
 namespace cryptonote
 {
@@ -45,4 +49,35 @@ namespace cryptonote
     uint64_t weight;
     bool res; //!< Listeners must ignore `tx` when this is false.
   };
+
+  /*! Block template parts that do not depend on the miner address. Pools
+      build their own miner transaction from the reward parameters, and the
+      tree root from its hash and `miner_tx_branch` (see
+      `get_tx_tree_hash`), so one event serves every miner. */
+  struct miner_template_event
+  {
+    block_header header; //!< `nonce` is zero
+    uint64_t height;
+    difficulty_type difficulty;
+    crypto::hash seed_hash;
+    uint64_t median_weight;
+    uint64_t already_generated_coins;
+    uint64_t txs_weight;
+    uint64_t fee;
+    std::vector<crypto::hash> tx_hashes;
+    std::vector<crypto::hash> miner_tx_branch;
+
+    BEGIN_SERIALIZE_OBJECT()
+      FIELDS(header)
+      VARINT_FIELD(height)
+      FIELD(difficulty)
+      FIELD(seed_hash)
+      VARINT_FIELD(median_weight)
+      VARINT_FIELD(already_generated_coins)
+      VARINT_FIELD(txs_weight)
+      VARINT_FIELD(fee)
+      FIELD(tx_hashes)
+      FIELD(miner_tx_branch)
+    END_SERIALIZE()
+  };
 }
@@ -33,5 +33,6 @@ namespace cryptonote
   struct block;
   class transaction;
   struct txpool_event;
+  struct miner_template_event;
   struct tx_block_template_backlog_entry;
 }
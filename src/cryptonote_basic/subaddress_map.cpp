@@ -0,0 +1,198 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "subaddress_map.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "misc_log_ex.h"
+
+namespace cryptonote
+{
+  namespace
+  {
+    // Index of empty slots, not a subaddress the wallet can reach
+    constexpr const subaddress_index empty_index{
+      std::numeric_limits<std::uint32_t>::max(), std::numeric_limits<std::uint32_t>::max()
+    };
+
+    constexpr const std::size_t min_capacity = 64;
+
+    //! Load factor of at most 3/4, past that a missed lookup probes too many slots
+    constexpr std::size_t max_size(const std::size_t capacity) noexcept
+    {
+      return capacity - capacity / 4;
+    }
+  }
+
+  subaddress_map::subaddress_map() noexcept
+    : m_slots(), m_size(0), m_expanded()
+  {}
+
+  subaddress_map::subaddress_map(const std::unordered_map<crypto::public_key, subaddress_index>& source)
+    : subaddress_map()
+  {
+    reserve(source.size());
+    for (const auto& elem : source)
+      insert(elem.first, elem.second);
+    update_expanded();
+  }
+
+  bool subaddress_map::is_empty(const entry& slot) noexcept
+  {
+    return slot.index == empty_index;
+  }
+
+  std::size_t subaddress_map::home(const crypto::public_key& key) const noexcept
+  {
+    // spend keys are uniformly distributed, any of their bytes make a good hash
+    std::uint64_t hash;
+    std::memcpy(std::addressof(hash), key.data, sizeof(hash));
+    return std::size_t(hash) & (m_slots.size() - 1);
+  }
+
+  std::size_t subaddress_map::probe(const crypto::public_key& key) const noexcept
+  {
+    const std::size_t mask = m_slots.size() - 1;
+    for (std::size_t i = home(key); ; i = (i + 1) & mask)
+    {
+      const entry& slot = m_slots[i];
+      if (is_empty(slot) || slot.key == key)
+        return i;
+    }
+  }
+
+  const subaddress_index* subaddress_map::find(const crypto::public_key& key) const noexcept
+  {
+    if (m_slots.empty())
+      return nullptr;
+    const entry& slot = m_slots[probe(key)];
+    return is_empty(slot) ? nullptr : std::addressof(slot.index);
+  }
+
+  void subaddress_map::insert(const crypto::public_key& key, const subaddress_index& index)
+  {
+    CHECK_AND_ASSERT_THROW_MES(!(index == empty_index), "Subaddress index " << index << " is reserved");
+    if (max_size(m_slots.size()) <= m_size)
+      rehash(std::max(min_capacity, m_slots.size() * 2));
+
+    entry& slot = m_slots[probe(key)];
+    if (is_empty(slot))
+    {
+      slot.key = key;
+      ++m_size;
+    }
+    slot.index = index;
+
+    // only ever counts too low if keys come out of order, which costs a re-derivation at most
+    auto expanded = m_expanded.find(index.major);
+    if (expanded == m_expanded.end())
+    {
+      if (index.minor == 0)
+        m_expanded.emplace(index.major, 1);
+    }
+    else if (expanded->second == index.minor)
+      ++expanded->second;
+  }
+
+  void subaddress_map::insert(const std::uint32_t major, const std::uint32_t first, const std::vector<crypto::public_key>& keys)
+  {
+    CHECK_AND_ASSERT_THROW_MES(keys.size() <= std::numeric_limits<std::uint32_t>::max() - first, "Too many subaddress keys");
+    reserve(m_size + keys.size());
+    subaddress_index index{major, first};
+    for (const crypto::public_key& key : keys)
+    {
+      insert(key, index);
+      ++index.minor;
+    }
+  }
+
+  std::uint32_t subaddress_map::expanded(const std::uint32_t major) const noexcept
+  {
+    const auto expanded = m_expanded.find(major);
+    return expanded == m_expanded.end() ? 0 : expanded->second;
+  }
+
+  void subaddress_map::update_expanded()
+  {
+    // the leading run of an account cannot be longer than its entry count
+    std::unordered_map<std::uint32_t, std::uint32_t> counts;
+    for (const entry& slot : *this)
+      ++counts[slot.index.major];
+
+    std::unordered_map<std::uint32_t, std::vector<bool>> present;
+    for (const auto& count : counts)
+      present[count.first].resize(count.second);
+    for (const entry& slot : *this)
+    {
+      std::vector<bool>& bits = present[slot.index.major];
+      if (slot.index.minor < bits.size())
+        bits[slot.index.minor] = true;
+    }
+
+    m_expanded.clear();
+    for (const auto& bits : present)
+    {
+      std::uint32_t count = 0;
+      while (count < bits.second.size() && bits.second[count])
+        ++count;
+      if (count)
+        m_expanded.emplace(bits.first, count);
+    }
+  }
+
+  void subaddress_map::reserve(const std::size_t count)
+  {
+    std::size_t capacity = std::max(min_capacity, m_slots.size());
+    while (max_size(capacity) < count)
+      capacity *= 2;
+    if (capacity != m_slots.size())
+      rehash(capacity);
+  }
+
+  void subaddress_map::clear() noexcept
+  {
+    std::vector<entry>{}.swap(m_slots);
+    m_size = 0;
+    m_expanded.clear();
+  }
+
+  void subaddress_map::rehash(const std::size_t capacity)
+  {
+    std::vector<entry> old(capacity, entry{crypto::null_pkey, empty_index});
+    std::swap(old, m_slots);
+    for (const entry& slot : old)
+    {
+      if (!is_empty(slot))
+        m_slots[probe(slot.key)] = slot;
+    }
+  }
+}
@@ -0,0 +1,203 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "serialization/crypto.h"
+#include "serialization/pair.h"
+#include "serialization/serialization.h"
+#include "subaddress_index.h"
+
+namespace cryptonote
+{
+  /*! \brief Maps subaddress spend public keys to their index.
+
+      Open addressing with linear probing over one flat array, so an entry
+      costs a single slot instead of an allocated hash node, and a lookup
+      that misses - the common case when scanning - touches a few adjacent
+      slots. Keys are stored whole: the spend key tested for a received
+      output is picked by the sender, who could match a truncated key on
+      purpose. Entries can be replaced but not removed.
+
+      The map also remembers, per account, how many leading subaddresses it
+      holds (see `expanded`), so the wallet only derives keys past that. */
+  class subaddress_map
+  {
+  public:
+    struct entry
+    {
+      crypto::public_key key;
+      subaddress_index index;
+    };
+
+    //! Iterates over the occupied slots, in no particular order.
+    class const_iterator
+    {
+      const entry* m_slot;
+      const entry* m_end;
+
+      void skip_empty() noexcept
+      {
+        while (m_slot != m_end && is_empty(*m_slot))
+          ++m_slot;
+      }
+
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef entry value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef const entry* pointer;
+      typedef const entry& reference;
+
+      const_iterator(const entry* slot, const entry* end) noexcept
+        : m_slot(slot), m_end(end)
+      {
+        skip_empty();
+      }
+
+      reference operator*() const noexcept { return *m_slot; }
+      pointer operator->() const noexcept { return m_slot; }
+      const_iterator& operator++() noexcept
+      {
+        ++m_slot;
+        skip_empty();
+        return *this;
+      }
+      const_iterator operator++(int) noexcept
+      {
+        const_iterator out = *this;
+        ++(*this);
+        return out;
+      }
+      bool operator==(const const_iterator& rhs) const noexcept { return m_slot == rhs.m_slot; }
+      bool operator!=(const const_iterator& rhs) const noexcept { return m_slot != rhs.m_slot; }
+    };
+
+    subaddress_map() noexcept;
+
+    //! Implicit, so callers holding a `std::unordered_map` keep working.
+    subaddress_map(const std::unordered_map<crypto::public_key, subaddress_index>& source);
+
+    //! \return Index of `key`, or `nullptr` if it is not in the map.
+    const subaddress_index* find(const crypto::public_key& key) const noexcept;
+    std::size_t count(const crypto::public_key& key) const noexcept { return find(key) ? 1 : 0; }
+
+    //! Add `key`, or replace its index if it is already in the map.
+    void insert(const crypto::public_key& key, const subaddress_index& index);
+
+    //! Add `keys`, the spend keys of subaddresses `first` onwards of account `major`.
+    void insert(std::uint32_t major, std::uint32_t first, const std::vector<crypto::public_key>& keys);
+
+    //! \return Count `n` such that subaddresses `0` to `n - 1` of account `major` are in the map.
+    std::uint32_t expanded(std::uint32_t major) const noexcept;
+
+    void reserve(std::size_t count);
+    void clear() noexcept;
+    std::size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+
+    const_iterator begin() const noexcept { return {m_slots.data(), m_slots.data() + m_slots.size()}; }
+    const_iterator end() const noexcept { return {m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()}; }
+
+    //! Recompute `expanded` for every account, after entries were added in any order.
+    void update_expanded();
+
+  private:
+    static bool is_empty(const entry& slot) noexcept;
+    std::size_t home(const crypto::public_key& key) const noexcept;
+
+    //! \return Position of the slot holding `key`, or of the empty slot where it belongs.
+    std::size_t probe(const crypto::public_key& key) const noexcept;
+    void rehash(std::size_t capacity);
+
+    std::vector<entry> m_slots; //!< Size is zero or a power of two
+    std::size_t m_size;
+    std::unordered_map<std::uint32_t, std::uint32_t> m_expanded;
+  };
+}
+
+// Same format as `serializable_unordered_map`, so wallet caches stay readable by older versions
+template <template <bool> class Archive>
+bool do_serialize(Archive<false> &ar, cryptonote::subaddress_map &v)
+{
+  size_t cnt;
+  ar.begin_array(cnt);
+  if (!ar.good())
+    return false;
+  v.clear();
+
+  // very basic sanity check
+  if (ar.remaining_bytes() < cnt) {
+    ar.set_fail();
+    return false;
+  }
+
+  v.reserve(cnt);
+  for (size_t i = 0; i < cnt; i++) {
+    if (i > 0)
+      ar.delimit_array();
+    std::pair<crypto::public_key, cryptonote::subaddress_index> e;
+    if (!::do_serialize(ar, e))
+      return false;
+    v.insert(e.first, e.second);
+    if (!ar.good())
+      return false;
+  }
+  ar.end_array();
+  v.update_expanded();
+  return true;
+}
+
+template <template <bool> class Archive>
+bool do_serialize(Archive<true> &ar, cryptonote::subaddress_map &v)
+{
+  size_t cnt = v.size();
+  ar.begin_array(cnt);
+  for (auto i = v.begin(); i != v.end(); ++i)
+  {
+    if (!ar.good())
+      return false;
+    if (i != v.begin())
+      ar.delimit_array();
+    std::pair<crypto::public_key, cryptonote::subaddress_index> e{i->key, i->index};
+    if (!::do_serialize(ar, e))
+      return false;
+    if (!ar.good())
+      return false;
+  }
+  ar.end_array();
+  return true;
+}
@@ -0,0 +1,284 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "cryptonote_basic/transaction_view.h"
+
+#include "common/varint.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "ringct/rctTypes.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "cn"
+
+namespace cryptonote
+{
+  namespace
+  {
+    constexpr const std::uint8_t txin_gen_tag = 0xff;
+    constexpr const std::uint8_t txin_to_key_tag = 0x2;
+    constexpr const std::uint8_t txout_to_key_tag = 0x2;
+
+    //! Like `binary_archive`, but also fails on a varint cut short by the end of the blob
+    template<typename T>
+    bool read_varint(const std::uint8_t*& position, const std::uint8_t* end, T& value)
+    {
+      return 0 < tools::read_varint(position, end, value) && !(position[-1] & 0x80);
+    }
+
+    //! Reads a container size and applies the `do_serialize_container` sanity check
+    bool read_count(const std::uint8_t*& position, const std::uint8_t* end, std::size_t& count)
+    {
+      return read_varint(position, end, count) && count <= std::size_t(end - position);
+    }
+
+    bool skip(const std::uint8_t*& position, const std::uint8_t* end, std::size_t count, std::size_t bytes)
+    {
+      if (std::size_t(end - position) / bytes < count)
+        return false;
+      position += count * bytes;
+      return true;
+    }
+  }
+
+  transaction_view::transaction_view() noexcept
+    : m_blob(),
+      m_prefix_size(0),
+      m_unprunable_size(0),
+      m_version(0),
+      m_unlock_time(0),
+      m_inputs(),
+      m_outputs(),
+      m_extra(),
+      m_rct_type(rct::RCTTypeNull),
+      m_rct_fee(0),
+      m_pruned(false)
+  {}
+
+  bool transaction_view::parse_input(const std::uint8_t*& position, const std::uint8_t* const end)
+  {
+    if (position == end)
+      return false;
+
+    input in{};
+    switch (*position++)
+    {
+    case txin_gen_tag:
+      if (!read_varint(position, end, in.amount))
+        return false;
+      break;
+    case txin_to_key_tag:
+      if (!read_varint(position, end, in.amount) || !read_count(position, end, in.key_offsets_count))
+        return false;
+      in.key_offsets = position;
+      for (std::size_t i = 0; i < in.key_offsets_count; ++i)
+      {
+        std::uint64_t offset;
+        if (!read_varint(position, end, offset))
+          return false;
+      }
+      if (std::size_t(end - position) < sizeof(crypto::key_image))
+        return false;
+      in.key_image = reinterpret_cast<const crypto::key_image*>(position);
+      position += sizeof(crypto::key_image);
+      break;
+    default:
+      MERROR("Unsupported transaction input type " << unsigned(position[-1]));
+      return false;
+    }
+    m_inputs.push_back(in);
+    return true;
+  }
+
+  bool transaction_view::parse_output(const std::uint8_t*& position, const std::uint8_t* const end)
+  {
+    output out{};
+    if (!read_varint(position, end, out.amount) || position == end)
+      return false;
+    if (*position++ != txout_to_key_tag)
+    {
+      MERROR("Unsupported transaction output type " << unsigned(position[-1]));
+      return false;
+    }
+    if (std::size_t(end - position) < sizeof(crypto::public_key))
+      return false;
+    out.key = reinterpret_cast<const crypto::public_key*>(position);
+    position += sizeof(crypto::public_key);
+    m_outputs.push_back(out);
+    return true;
+  }
+
+  bool transaction_view::parse_rct_base(const std::uint8_t*& position, const std::uint8_t* const end)
+  {
+    // mirrors rctSig::serialize_rctsig_base
+    if (position == end)
+      return false;
+    m_rct_type = *position++;
+    if (m_rct_type == rct::RCTTypeNull)
+      return true;
+    if (m_rct_type != rct::RCTTypeFull && m_rct_type != rct::RCTTypeSimple && m_rct_type != rct::RCTTypeBulletproof && m_rct_type != rct::RCTTypeBulletproof2 && m_rct_type != rct::RCTTypeCLSAG)
+      return false;
+    if (!read_varint(position, end, m_rct_fee))
+      return false;
+    if (m_rct_type == rct::RCTTypeSimple && !skip(position, end, m_inputs.size(), sizeof(rct::key)))
+      return false;
+    const bool short_ecdh = m_rct_type == rct::RCTTypeBulletproof2 || m_rct_type == rct::RCTTypeCLSAG;
+    if (!skip(position, end, m_outputs.size(), short_ecdh ? sizeof(crypto::hash8) : sizeof(rct::ecdhTuple)))
+      return false;
+    return skip(position, end, m_outputs.size(), sizeof(rct::key)); // outPk masks
+  }
+
+  bool transaction_view::skip_signatures(const std::uint8_t*& position, const std::uint8_t* const end)
+  {
+    for (const input& in : m_inputs)
+    {
+      if (in.key_image && !skip(position, end, in.key_offsets_count, sizeof(crypto::signature)))
+        return false;
+    }
+    return true;
+  }
+
+  bool transaction_view::parse(const epee::span<const std::uint8_t> blob, const bool pruned)
+  {
+    m_blob = blob;
+    m_prefix_size = 0;
+    m_unprunable_size = 0;
+    m_inputs.clear();
+    m_outputs.clear();
+    m_extra = nullptr;
+    m_rct_type = rct::RCTTypeNull;
+    m_rct_fee = 0;
+    m_pruned = pruned;
+
+    const std::uint8_t* const begin = blob.begin();
+    const std::uint8_t* const end = blob.end();
+    const std::uint8_t* position = begin;
+
+    std::size_t count = 0;
+    if (!read_varint(position, end, m_version) || m_version == 0 || CURRENT_TRANSACTION_VERSION < m_version)
+      return false;
+    if (!read_varint(position, end, m_unlock_time))
+      return false;
+
+    if (!read_count(position, end, count))
+      return false;
+    m_inputs.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      if (!parse_input(position, end))
+        return false;
+    }
+
+    if (!read_count(position, end, count))
+      return false;
+    m_outputs.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      if (!parse_output(position, end))
+        return false;
+    }
+
+    if (!read_count(position, end, count))
+      return false;
+    m_extra = {position, count};
+    position += count;
+    m_prefix_size = position - begin;
+
+    if (m_version == 1)
+    {
+      if (!pruned && !skip_signatures(position, end))
+        return false;
+      m_unprunable_size = pruned ? m_prefix_size : position - begin;
+    }
+    else
+    {
+      if (!m_inputs.empty() && !parse_rct_base(position, end))
+        return false;
+      m_unprunable_size = position - begin;
+    }
+
+    // pruned blobs are read like `parse_and_validate_tx_base_from_blob`, which ignores the rest
+    if (pruned)
+    {
+      m_blob = {begin, m_unprunable_size};
+      return true;
+    }
+
+    if (m_version == 1)
+      return position == end;
+
+    // prunable ringct data has too many layouts to mirror here; `materialize` checks it
+    return m_rct_type != rct::RCTTypeNull || position == end;
+  }
+
+  crypto::hash transaction_view::get_prefix_hash() const
+  {
+    return crypto::cn_fast_hash(m_blob.data(), m_prefix_size);
+  }
+
+  crypto::hash transaction_view::get_hash() const
+  {
+    CHECK_AND_ASSERT_THROW_MES(!m_pruned, "Cannot calculate the hash of a pruned transaction");
+    if (m_version == 1)
+      return crypto::cn_fast_hash(m_blob.data(), m_blob.size());
+
+    crypto::hash hashes[3];
+    hashes[0] = get_prefix_hash();
+    hashes[1] = crypto::cn_fast_hash(base().data(), base().size());
+    if (m_rct_type == rct::RCTTypeNull)
+      hashes[2] = crypto::null_hash;
+    else
+      hashes[2] = crypto::cn_fast_hash(prunable().data(), prunable().size());
+    return crypto::cn_fast_hash(hashes, sizeof(hashes));
+  }
+
+  crypto::hash transaction_view::get_pruned_hash(const crypto::hash& prunable_hash) const
+  {
+    CHECK_AND_ASSERT_THROW_MES(m_version > 1, "Hash for pruned v1 tx cannot be calculated");
+
+    crypto::hash hashes[3];
+    hashes[0] = get_prefix_hash();
+    hashes[1] = crypto::cn_fast_hash(base().data(), base().size());
+    hashes[2] = m_rct_type == rct::RCTTypeNull ? crypto::null_hash : prunable_hash;
+    return crypto::cn_fast_hash(hashes, sizeof(hashes));
+  }
+
+  bool transaction_view::materialize(transaction& tx) const
+  {
+    const blobdata_ref blob{reinterpret_cast<const char*>(m_blob.data()), m_blob.size()};
+    if (m_pruned)
+      return parse_and_validate_tx_base_from_blob(blob, tx);
+    return parse_and_validate_tx_from_blob(blob, tx);
+  }
+
+  transaction_view& transaction_view::get_thread_view()
+  {
+    static thread_local transaction_view view;
+    return view;
+  }
+}
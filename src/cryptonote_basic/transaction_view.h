@@ -0,0 +1,131 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+#include "span.h"
+
+namespace cryptonote
+{
+  class transaction;
+
+  /*! \brief Read-only view of a serialized transaction.
+
+      `parse` walks the blob in place and records where each part is, so a
+      transaction can be hashed and looked up before (or instead of) being
+      deserialized into a `transaction`, whose inputs, outputs and ringct
+      data all live in separate heap allocations. Only the index arrays of
+      inputs and outputs are allocated, and they keep their capacity when
+      the view is parsed again, so a view reused by a thread (see
+      `get_thread_view`) stops allocating after a few transactions.
+
+      Accepts the input and output types that `check_tx_semantic` accepts
+      (plus `txin_gen` for miner transactions); anything else fails to
+      parse. The blob must outlive the view. */
+  class transaction_view
+  {
+  public:
+    struct input
+    {
+      std::uint64_t amount;               //!< Or height of a `txin_gen`
+      const std::uint8_t* key_offsets;    //!< Varints, nullptr for a `txin_gen`
+      std::size_t key_offsets_count;      //!< Ring size
+      const crypto::key_image* key_image; //!< Points into the blob, nullptr for a `txin_gen`
+    };
+
+    struct output
+    {
+      std::uint64_t amount;
+      const crypto::public_key* key; //!< Points into the blob
+    };
+
+    transaction_view() noexcept;
+
+    /*! Parse `blob`, which is a full transaction or, if `pruned`, only its
+        prefix and ringct base (as in a pruned `tx_blob_entry`).
+        \return False if `blob` is not a transaction this view understands. */
+    bool parse(epee::span<const std::uint8_t> blob, bool pruned = false);
+
+    bool is_pruned() const noexcept { return m_pruned; }
+    std::size_t version() const noexcept { return m_version; }
+    std::uint64_t unlock_time() const noexcept { return m_unlock_time; }
+    const std::vector<input>& inputs() const noexcept { return m_inputs; }
+    const std::vector<output>& outputs() const noexcept { return m_outputs; }
+    epee::span<const std::uint8_t> extra() const noexcept { return m_extra; }
+    std::uint8_t rct_type() const noexcept { return m_rct_type; }
+    std::uint64_t rct_fee() const noexcept { return m_rct_fee; }
+
+    //! \return Serialized prefix, as hashed by `get_transaction_prefix_hash`.
+    epee::span<const std::uint8_t> prefix() const noexcept { return {m_blob.data(), m_prefix_size}; }
+    //! \return Serialized ringct base (v2) or signatures (v1).
+    epee::span<const std::uint8_t> base() const noexcept { return {m_blob.data() + m_prefix_size, m_unprunable_size - m_prefix_size}; }
+    //! \return Serialized ringct prunable data, empty for v1 and pruned transactions.
+    epee::span<const std::uint8_t> prunable() const noexcept { return {m_blob.data() + m_unprunable_size, m_blob.size() - m_unprunable_size}; }
+
+    crypto::hash get_prefix_hash() const;
+
+    //! \return Same as `get_transaction_hash` on the deserialized transaction. Not for pruned views.
+    crypto::hash get_hash() const;
+
+    //! \return Same as `get_pruned_transaction_hash` on the deserialized transaction. v2 only.
+    crypto::hash get_pruned_hash(const crypto::hash& prunable_hash) const;
+
+    /*! Deserialize the blob into `tx`, like `parse_and_validate_tx_from_blob`
+        (or `parse_and_validate_tx_base_from_blob` for a pruned view). The
+        hash is not set, as the caller usually has it already. */
+    bool materialize(transaction& tx) const;
+
+    //! \return A view owned by the calling thread, to reuse its allocations.
+    static transaction_view& get_thread_view();
+
+  private:
+    bool parse_input(const std::uint8_t*& position, const std::uint8_t* end);
+    bool parse_output(const std::uint8_t*& position, const std::uint8_t* end);
+    bool parse_rct_base(const std::uint8_t*& position, const std::uint8_t* end);
+    bool skip_signatures(const std::uint8_t*& position, const std::uint8_t* end);
+
+    epee::span<const std::uint8_t> m_blob;
+    std::size_t m_prefix_size;
+    std::size_t m_unprunable_size;
+    std::size_t m_version;
+    std::uint64_t m_unlock_time;
+    std::vector<input> m_inputs;
+    std::vector<output> m_outputs;
+    epee::span<const std::uint8_t> m_extra;
+    std::uint8_t m_rct_type;
+    std::uint64_t m_rct_fee;
+    bool m_pruned;
+  };
+}
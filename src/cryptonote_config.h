@@ -126,6 +126,13 @@
 
 #define COMMAND_RPC_GET_BLOCKS_FAST_MAX_BLOCK_COUNT     1000
 #define COMMAND_RPC_GET_BLOCKS_FAST_MAX_TX_COUNT        20000
+#define COMMAND_RPC_GET_BLOCKS_FAST_CACHE_MIN_DEPTH     100 // blocks
+#define COMMAND_RPC_GET_BLOCKS_FAST_CACHE_SIZE          (256*1024*1024) // bytes
+
+#define FIND_BLOCKCHAIN_SUPPLEMENT_MAX_SIZE             (100*1024*1024) // 100 MB
+
+#define LIGHT_WALLET_SCAN_BATCH_SIZE                    100 // blocks per store
+#define LIGHT_WALLET_SCAN_REORG_DEPTH                   100 // recent block ids kept
 
 #define P2P_LOCAL_WHITE_PEERLIST_LIMIT                  1000
 #define P2P_LOCAL_GRAY_PEERLIST_LIMIT                   5000
@@ -194,6 +201,7 @@
 #define CRYPTONOTE_PRUNING_STRIPE_SIZE          4096 // the smaller, the smoother the increase
 #define CRYPTONOTE_PRUNING_LOG_STRIPES          3 // the higher, the more space saved
 #define CRYPTONOTE_PRUNING_TIP_BLOCKS           5500 // the smaller, the more space saved
+#define CRYPTONOTE_PRUNING_BACKGROUND_STEP_TXES 2048 // transactions gone through per step of a background pruning, one step per idle call
 
 #define RPC_CREDITS_PER_HASH_SCALE ((float)(1<<24))
 
@@ -40,6 +40,7 @@
 #include "blockchain.h"
 #include "blockchain_db/blockchain_db.h"
 #include "cryptonote_basic/cryptonote_boost_serialization.h"
+#include "cryptonote_basic/events.h"
 #include "cryptonote_config.h"
 #include "cryptonote_basic/miner.h"
 #include "hardforks/hardforks.h"
@@ -62,8 +63,6 @@
 #undef MONERO_DEFAULT_LOG_CATEGORY
 #define MONERO_DEFAULT_LOG_CATEGORY "blockchain"
 
-#define FIND_BLOCKCHAIN_SUPPLEMENT_MAX_SIZE (100*1024*1024) // 100 MB
-
 using namespace crypto;
 
 //#include "serialization/json_archive.h"
@@ -96,8 +95,11 @@ Blockchain::Blockchain(tx_memory_pool& tx_pool) :
   m_long_term_block_weights_cache_rolling_median(CRYPTONOTE_LONG_TERM_BLOCK_WEIGHT_WINDOW_SIZE),
   m_difficulty_for_next_block_top_hash(crypto::null_hash),
   m_difficulty_for_next_block(1),
+  m_btc_body_valid(false),
+  m_miner_template_prev_id(crypto::null_hash),
   m_btc_valid(false),
   m_batch_success(true),
+  m_syncing(true),
   m_prepare_height(0)
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
@@ -1547,52 +1549,24 @@ uint64_t Blockchain::get_current_cumulative_block_weight_median() const
   return m_current_block_cumul_weight_median;
 }
 //------------------------------------------------------------------
-//TODO: This function only needed minor modification to work with BlockchainDB,
-//      and *works*.  As such, to reduce the number of things that might break
-//      in moving to BlockchainDB, this function will remain otherwise
-//      unchanged for the time being.
-//
-// This function makes a new block for a miner to mine the hash for
-//
-// FIXME: this codebase references #if defined(DEBUG_CREATE_BLOCK_TEMPLATE)
-// in a lot of places.  That flag is not referenced in any of the code
-// nor any of the makefiles, howeve.  Need to look into whether or not it's
-// necessary at all.
-bool Blockchain::create_block_template(block& b, const crypto::hash *from_block, const account_public_address& miner_address, difficulty_type& diffic, uint64_t& height, uint64_t& expected_reward, const blobdata& ex_nonce, uint64_t &seed_height, crypto::hash &seed_hash)
+bool Blockchain::create_block_template_body(const crypto::hash *from_block, block_template_body &body)
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  size_t median_weight;
-  uint64_t already_generated_coins;
-  uint64_t pool_cookie;
-
+  block& b = body.bl;
+  difficulty_type& diffic = body.difficulty;
+  uint64_t& height = body.height;
+  uint64_t& expected_reward = body.expected_reward;
+  uint64_t& seed_height = body.seed_height;
+  crypto::hash& seed_hash = body.seed_hash;
+  size_t& median_weight = body.median_weight;
+  uint64_t& already_generated_coins = body.already_generated_coins;
+  size_t& txs_weight = body.txs_weight;
+  uint64_t& fee = body.fee;
+
+  b = boost::value_initialized<block>();
+  seed_height = 0;
   seed_hash = crypto::null_hash;
 
-  m_tx_pool.lock();
-  const auto unlock_guard = epee::misc_utils::create_scope_leave_handler([&]() { m_tx_pool.unlock(); });
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
-  if (m_btc_valid && !from_block) {
-    // The pool cookie is atomic. The lack of locking is OK, as if it changes
-    // just as we compare it, we'll just use a slightly old template, but
-    // this would be the case anyway if we'd lock, and the change happened
-    // just after the block template was created
-    if (!memcmp(&miner_address, &m_btc_address, sizeof(cryptonote::account_public_address)) && m_btc_nonce == ex_nonce
-      && m_btc_pool_cookie == m_tx_pool.cookie() && m_btc.prev_id == get_tail_id()) {
-      MDEBUG("Using cached template");
-      const uint64_t now = time(NULL);
-      if (m_btc.timestamp < now) // ensures it can't get below the median of the last few blocks
-        m_btc.timestamp = now;
-      b = m_btc;
-      diffic = m_btc_difficulty;
-      height = m_btc_height;
-      expected_reward = m_btc_expected_reward;
-      seed_height = m_btc_seed_height;
-      seed_hash = m_btc_seed_hash;
-      return true;
-    }
-    MDEBUG("Not using cached template: address " << (!memcmp(&miner_address, &m_btc_address, sizeof(cryptonote::account_public_address))) << ", nonce " << (m_btc_nonce == ex_nonce) << ", cookie " << (m_btc_pool_cookie == m_tx_pool.cookie()) << ", from_block " << (!!from_block));
-    invalidate_block_template_cache();
-  }
-
   if (from_block)
   {
     //build alternative subchain, front -> mainchain, back -> alternative head
@@ -1699,13 +1673,12 @@ bool Blockchain::create_block_template(block& b, const crypto::hash *from_block,
 
   CHECK_AND_ASSERT_MES(diffic, false, "difficulty overhead.");
 
-  size_t txs_weight;
-  uint64_t fee;
   if (!m_tx_pool.fill_block_template(b, median_weight, already_generated_coins, txs_weight, fee, expected_reward, b.major_version))
   {
     return false;
   }
-  pool_cookie = m_tx_pool.cookie();
+  body.pool_cookie = m_tx_pool.cookie();
+  body.miner_tx_branch = get_miner_tx_tree_branch(b.tx_hashes);
 #if defined(DEBUG_CREATE_BLOCK_TEMPLATE)
   size_t real_txs_weight = 0;
   uint64_t real_fee = 0;
@@ -1759,6 +1732,91 @@ bool Blockchain::create_block_template(block& b, const crypto::hash *from_block,
       ", fee " << fee);
 #endif
 
+  return true;
+}
+//------------------------------------------------------------------
+//TODO: This function only needed minor modification to work with BlockchainDB,
+//      and *works*.  As such, to reduce the number of things that might break
+//      in moving to BlockchainDB, this function will remain otherwise
+//      unchanged for the time being.
+//
+// This function makes a new block for a miner to mine the hash for
+//
+// FIXME: this codebase references #if defined(DEBUG_CREATE_BLOCK_TEMPLATE)
+// in a lot of places.  That flag is not referenced in any of the code
+// nor any of the makefiles, howeve.  Need to look into whether or not it's
+// necessary at all.
+bool Blockchain::create_block_template(block& b, const crypto::hash *from_block, const account_public_address& miner_address, difficulty_type& diffic, uint64_t& height, uint64_t& expected_reward, const blobdata& ex_nonce, uint64_t &seed_height, crypto::hash &seed_hash, crypto::hash *tree_root_hash)
+{
+  LOG_PRINT_L3("Blockchain::" << __func__);
+
+  m_tx_pool.lock();
+  const auto unlock_guard = epee::misc_utils::create_scope_leave_handler([&]() { m_tx_pool.unlock(); });
+  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  if (m_btc_valid && !from_block) {
+    // The pool cookie is atomic. The lack of locking is OK, as if it changes
+    // just as we compare it, we'll just use a slightly old template, but
+    // this would be the case anyway if we'd lock, and the change happened
+    // just after the block template was created
+    if (!memcmp(&miner_address, &m_btc_address, sizeof(cryptonote::account_public_address)) && m_btc_nonce == ex_nonce
+      && m_btc_pool_cookie == m_tx_pool.cookie() && m_btc.prev_id == get_tail_id()) {
+      MDEBUG("Using cached template");
+      const uint64_t now = time(NULL);
+      if (m_btc.timestamp < now) // ensures it can't get below the median of the last few blocks
+        m_btc.timestamp = now;
+      b = m_btc;
+      diffic = m_btc_difficulty;
+      height = m_btc_height;
+      expected_reward = m_btc_expected_reward;
+      seed_height = m_btc_seed_height;
+      seed_hash = m_btc_seed_hash;
+      if (tree_root_hash)
+        *tree_root_hash = m_btc_tree_root_hash;
+      return true;
+    }
+    MDEBUG("Not using cached template: address " << (!memcmp(&miner_address, &m_btc_address, sizeof(cryptonote::account_public_address))) << ", nonce " << (m_btc_nonce == ex_nonce) << ", cookie " << (m_btc_pool_cookie == m_tx_pool.cookie()) << ", from_block " << (!!from_block));
+    m_btc_valid = false; // the body may still be usable for this miner
+  }
+
+  // the transaction selection and tree hash only depend on the tip and the pool,
+  // so requests for other addresses or nonces only rebuild the miner tx
+  block_template_body fresh_body;
+  const block_template_body *body = &m_btc_body;
+  if (from_block || !m_btc_body_valid || m_btc_body.pool_cookie != m_tx_pool.cookie() || m_btc_body.bl.prev_id != get_tail_id())
+  {
+    if (!from_block)
+      m_btc_body_valid = false;
+    if (!create_block_template_body(from_block, fresh_body))
+      return false;
+    if (from_block)
+    {
+      body = &fresh_body;
+    }
+    else
+    {
+      m_btc_body = std::move(fresh_body);
+      m_btc_body_valid = true;
+    }
+  }
+  else
+  {
+    MDEBUG("Using cached template body");
+  }
+
+  b = body->bl;
+  const uint64_t now = time(NULL);
+  if (b.timestamp < now) // ensures it can't get below the median of the last few blocks
+    b.timestamp = now;
+  diffic = body->difficulty;
+  height = body->height;
+  expected_reward = body->expected_reward;
+  seed_height = body->seed_height;
+  seed_hash = body->seed_hash;
+  const size_t median_weight = body->median_weight;
+  const uint64_t already_generated_coins = body->already_generated_coins;
+  const size_t txs_weight = body->txs_weight;
+  const uint64_t fee = body->fee;
+
   /*
    two-phase miner transaction generation: we don't know exact block weight until we prepare block, but we don't know reward until we know
    block weight, so first miner transaction generated with fake amount of money, and with phase we know think we know expected block weight
@@ -1819,8 +1877,11 @@ bool Blockchain::create_block_template(block& b, const crypto::hash *from_block,
         ", cumulative weight " << cumulative_weight << " is now good");
 #endif
 
+    const crypto::hash tree_root = get_tx_tree_hash(get_transaction_hash(b.miner_tx), body->miner_tx_branch);
+    if (tree_root_hash)
+      *tree_root_hash = tree_root;
     if (!from_block)
-      cache_block_template(b, miner_address, ex_nonce, diffic, height, expected_reward, seed_height, seed_hash, pool_cookie);
+      cache_block_template(b, miner_address, ex_nonce, diffic, height, expected_reward, seed_height, seed_hash, body->pool_cookie, tree_root);
     return true;
   }
   LOG_ERROR("Failed to create_block_template with " << 10 << " tries");
@@ -2193,7 +2254,7 @@ bool Blockchain::get_blocks(uint64_t start_offset, size_t count, std::vector<std
   if(start_offset >= height)
     return false;
 
-  blocks.reserve(blocks.size() + height - start_offset);
+  blocks.reserve(blocks.size() + std::min<uint64_t>(count, height - start_offset));
   for(size_t i = start_offset; i < start_offset + count && i < height;i++)
   {
     blocks.push_back(std::make_pair(m_db->get_block_blob_from_height(i), block()));
@@ -4482,6 +4543,15 @@ bool Blockchain::check_blockchain_pruning()
   return m_db->check_pruning();
 }
 //------------------------------------------------------------------
+bool Blockchain::prune_blockchain_step(uint64_t max_txes, pruning_progress_t &progress, uint32_t pruning_seed)
+{
+  m_tx_pool.lock();
+  epee::misc_utils::auto_scope_leave_caller unlocker = epee::misc_utils::create_scope_leave_handler([&](){m_tx_pool.unlock();});
+  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+
+  return m_db->prune_blockchain_step(max_txes, progress, pruning_seed);
+}
+//------------------------------------------------------------------
 uint64_t Blockchain::get_next_long_term_block_weight(uint64_t block_weight) const
 {
   PERF_TIMER(get_next_long_term_block_weight);
@@ -5133,14 +5203,46 @@ bool Blockchain::prepare_handle_incoming_blocks(const std::vector<block_complete
             return false; \
         } while(0); \
 
-  // generate sorted tables for all amounts and absolute offsets
+  // parse all txes first, so their prefix hashes can be computed as one batch
   size_t tx_index = 0, block_index = 0;
+  {
+    std::vector<blobdata> prefix_blobs(total_txs);
+    for (const auto &entry : blocks_entry)
+    {
+      for (const auto &tx_blob : entry.txs)
+      {
+        if (tx_index >= txes.size())
+          SCAN_TABLE_QUIT("tx_index is out of sync");
+        transaction &tx = txes[tx_index].first;
+        if (!parse_and_validate_tx_base_from_blob(tx_blob.blob, tx))
+          SCAN_TABLE_QUIT("Could not parse tx from incoming blocks.");
+        if (!t_serializable_object_to_blob(static_cast<const transaction_prefix&>(tx), prefix_blobs[tx_index]))
+          SCAN_TABLE_QUIT("Could not serialize tx prefix from incoming blocks.");
+        ++tx_index;
+      }
+    }
+
+    std::vector<const void*> prefix_data(total_txs);
+    std::vector<size_t> prefix_sizes(total_txs);
+    std::vector<crypto::hash> prefix_hashes(total_txs);
+    for (size_t i = 0; i < total_txs; ++i)
+    {
+      prefix_data[i] = prefix_blobs[i].data();
+      prefix_sizes[i] = prefix_blobs[i].size();
+    }
+    crypto::cn_fast_hash_batch(prefix_data.data(), prefix_sizes.data(), total_txs, prefix_hashes.data());
+    for (size_t i = 0; i < total_txs; ++i)
+      txes[i].second = prefix_hashes[i];
+  }
+
+  // generate sorted tables for all amounts and absolute offsets
+  tx_index = 0;
   for (const auto &entry : blocks_entry)
   {
     if (m_cancel)
       return false;
 
-    for (const auto &tx_blob : entry.txs)
+    for (size_t n = 0; n < entry.txs.size(); ++n)
     {
       if (tx_index >= txes.size())
         SCAN_TABLE_QUIT("tx_index is out of sync");
@@ -5148,10 +5250,6 @@ bool Blockchain::prepare_handle_incoming_blocks(const std::vector<block_complete
       crypto::hash &tx_prefix_hash = txes[tx_index].second;
       ++tx_index;
 
-      if (!parse_and_validate_tx_base_from_blob(tx_blob.blob, tx))
-        SCAN_TABLE_QUIT("Could not parse tx from incoming blocks.");
-      cryptonote::get_transaction_prefix_hash(tx, tx_prefix_hash);
-
       auto its = m_scan_table.find(tx_prefix_hash);
       if (its != m_scan_table.end())
         SCAN_TABLE_QUIT("Duplicate tx found from incoming blocks.");
@@ -5376,6 +5474,15 @@ void Blockchain::add_miner_notify(MinerNotifyCallback&& notify)
   }
 }
 
+void Blockchain::add_miner_template_notify(MinerTemplateNotifyCallback&& notify, MinerTemplateWantedCallback&& wanted)
+{
+  if (notify && wanted)
+  {
+    CRITICAL_REGION_LOCAL(m_blockchain_lock);
+    m_miner_template_notifiers.emplace_back(std::move(notify), std::move(wanted));
+  }
+}
+
 void Blockchain::safesyncmode(const bool onoff)
 {
   /* all of this is no-op'd if the user set a specific
@@ -5611,9 +5718,10 @@ void Blockchain::invalidate_block_template_cache()
 {
   MDEBUG("Invalidating block template cache");
   m_btc_valid = false;
+  m_btc_body_valid = false;
 }
 
-void Blockchain::cache_block_template(const block &b, const cryptonote::account_public_address &address, const blobdata &nonce, const difficulty_type &diff, uint64_t height, uint64_t expected_reward, uint64_t seed_height, const crypto::hash &seed_hash, uint64_t pool_cookie)
+void Blockchain::cache_block_template(const block &b, const cryptonote::account_public_address &address, const blobdata &nonce, const difficulty_type &diff, uint64_t height, uint64_t expected_reward, uint64_t seed_height, const crypto::hash &seed_hash, uint64_t pool_cookie, const crypto::hash &tree_root_hash)
 {
   MDEBUG("Setting block template cache");
   m_btc = b;
@@ -5625,11 +5733,14 @@ void Blockchain::cache_block_template(const block &b, const cryptonote::account_
   m_btc_seed_hash = seed_hash;
   m_btc_seed_height = seed_height;
   m_btc_pool_cookie = pool_cookie;
+  m_btc_tree_root_hash = tree_root_hash;
   m_btc_valid = true;
 }
 
 void Blockchain::send_miner_notifications(const crypto::hash &prev_id, uint64_t already_generated_coins)
 {
+  send_miner_template(true);
+
   if (m_miner_notifiers.empty())
     return;
 
@@ -5655,6 +5766,67 @@ void Blockchain::send_miner_notifications(const crypto::hash &prev_id, uint64_t
   }
 }
 
+void Blockchain::send_miner_template_notifications()
+{
+  m_tx_pool.lock();
+  const auto unlock_guard = epee::misc_utils::create_scope_leave_handler([&]() { m_tx_pool.unlock(); });
+  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  send_miner_template(false);
+}
+
+void Blockchain::send_miner_template(bool force)
+{
+  if (m_miner_template_notifiers.empty() || m_syncing)
+    return;
+
+  // building the body costs as much as get_block_template, so only do it
+  // when someone is listening
+  bool wanted = false;
+  for (const auto& notifier : m_miner_template_notifiers)
+    wanted = wanted || notifier.second();
+  if (!wanted)
+    return;
+
+  // the body is shared with create_block_template, so pushing it also
+  // prepares the next get_block_template for any miner address
+  const crypto::hash tail_id = get_tail_id();
+  if (!m_btc_body_valid || m_btc_body.pool_cookie != m_tx_pool.cookie() || m_btc_body.bl.prev_id != tail_id)
+  {
+    m_btc_body_valid = false;
+    if (!create_block_template_body(NULL, m_btc_body))
+    {
+      MERROR("Failed to create block template body for miner template notifications");
+      return;
+    }
+    m_btc_body_valid = true;
+  }
+
+  const block &b = m_btc_body.bl;
+  if (!force && m_miner_template_prev_id == b.prev_id && m_miner_template_tx_hashes == b.tx_hashes)
+    return;
+  m_miner_template_prev_id = b.prev_id;
+  m_miner_template_tx_hashes = b.tx_hashes;
+
+  miner_template_event event{};
+  event.header = b;
+  event.header.nonce = 0;
+  const uint64_t now = time(NULL);
+  if (event.header.timestamp < now)
+    event.header.timestamp = now;
+  event.height = m_btc_body.height;
+  event.difficulty = m_btc_body.difficulty;
+  event.seed_hash = m_btc_body.seed_hash;
+  event.median_weight = m_btc_body.median_weight;
+  event.already_generated_coins = m_btc_body.already_generated_coins;
+  event.txs_weight = m_btc_body.txs_weight;
+  event.fee = m_btc_body.fee;
+  event.tx_hashes = b.tx_hashes;
+  event.miner_tx_branch = m_btc_body.miner_tx_branch;
+
+  for (const auto& notifier : m_miner_template_notifiers)
+    notifier.first(event);
+}
+
 namespace cryptonote {
 template bool Blockchain::get_transactions(const std::vector<crypto::hash>&, std::vector<transaction>&, std::vector<crypto::hash>&, bool) const;
 template bool Blockchain::get_split_transactions_blobs(const std::vector<crypto::hash>&, std::vector<std::tuple<crypto::hash, cryptonote::blobdata, crypto::hash, cryptonote::blobdata>>&, std::vector<crypto::hash>&) const;
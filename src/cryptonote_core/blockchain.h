@@ -92,6 +92,8 @@ namespace cryptonote
 
   typedef boost::function<void(uint64_t /* height */, epee::span<const block> /* blocks */)> BlockNotifyCallback;
   typedef boost::function<void(uint8_t /* major_version */, uint64_t /* height */, const crypto::hash& /* prev_id */, const crypto::hash& /* seed_hash */, difficulty_type /* diff */, uint64_t /* median_weight */, uint64_t /* already_generated_coins */, const std::vector<tx_block_template_backlog_entry>& /* tx_backlog */)> MinerNotifyCallback;
+  typedef boost::function<void(const miner_template_event& /* event */)> MinerTemplateNotifyCallback;
+  typedef boost::function<bool()> MinerTemplateWantedCallback;
 
   /************************************************************************/
   /*                                                                      */
@@ -367,11 +369,12 @@ namespace cryptonote
      * @param height return-by-reference tells the miner what height it's mining against
      * @param expected_reward return-by-reference the total reward awarded to the miner finding this block, including transaction fees
      * @param ex_nonce extra data to be added to the miner transaction's extra
+     * @param tree_root_hash optional return-by-reference transaction tree hash of the block, for its hashing blob
      *
      * @return true if block template filled in successfully, else false
      */
     bool create_block_template(block& b, const account_public_address& miner_address, difficulty_type& di, uint64_t& height, uint64_t& expected_reward, const blobdata& ex_nonce, uint64_t &seed_height, crypto::hash &seed_hash);
-    bool create_block_template(block& b, const crypto::hash *from_block, const account_public_address& miner_address, difficulty_type& di, uint64_t& height, uint64_t& expected_reward, const blobdata& ex_nonce, uint64_t &seed_height, crypto::hash &seed_hash);
+    bool create_block_template(block& b, const crypto::hash *from_block, const account_public_address& miner_address, difficulty_type& di, uint64_t& height, uint64_t& expected_reward, const blobdata& ex_nonce, uint64_t &seed_height, crypto::hash &seed_hash, crypto::hash *tree_root_hash = NULL);
 
     /**
      * @brief gets data required to create a block template and start mining on it
@@ -803,6 +806,35 @@ namespace cryptonote
      */
     void add_miner_notify(MinerNotifyCallback&& notify);
 
+    /**
+     * @brief sets a miner template notify object to call for every new
+     * block and for every txpool change that alters the template
+     *
+     * @param notify the notify object to call with the new template
+     * @param wanted returns whether anyone listens to `notify`, templates
+     * are only built when one of them does
+     */
+    void add_miner_template_notify(MinerTemplateNotifyCallback&& notify, MinerTemplateWantedCallback&& wanted);
+
+    /**
+     * @brief sets whether the node is catching up with the network
+     *
+     * Miner templates are not built while syncing, as they would be stale
+     * before anyone could mine on them.
+     *
+     * @param syncing true while the chain is behind the network
+     */
+    void set_syncing(bool syncing) { m_syncing = syncing; }
+
+    /**
+     * @brief sends the block template to miner template notifiers if the
+     * transactions in it changed since it was last sent
+     *
+     * Called periodically, as sending one for every txpool change would
+     * flood the pools with templates.
+     */
+    void send_miner_template_notifications();
+
     /**
      * @brief sets a reorg notify object to call for every reorg
      *
@@ -1030,6 +1062,8 @@ namespace cryptonote
     bool prune_blockchain(uint32_t pruning_seed = 0);
     bool update_blockchain_pruning();
     bool check_blockchain_pruning();
+    bool prune_blockchain_step(uint64_t max_txes, pruning_progress_t &progress, uint32_t pruning_seed = 0);
+    bool get_pruning_progress(pruning_progress_t &progress) const { return m_db->get_pruning_progress(progress); }
 
     void lock();
     void unlock();
@@ -1164,6 +1198,26 @@ namespace cryptonote
 
     std::atomic<bool> m_cancel;
 
+    // block template parts that only depend on the chain tip and the pool,
+    // shared by templates for all miner addresses and extra nonces
+    struct block_template_body
+    {
+      block bl; //!< without miner transaction
+      difficulty_type difficulty;
+      uint64_t height;
+      uint64_t expected_reward;
+      uint64_t seed_height;
+      crypto::hash seed_hash;
+      size_t median_weight;
+      uint64_t already_generated_coins;
+      size_t txs_weight;
+      uint64_t fee;
+      uint64_t pool_cookie;
+      std::vector<crypto::hash> miner_tx_branch; //!< tree hash siblings of the miner transaction
+    };
+    block_template_body m_btc_body;
+    bool m_btc_body_valid;
+
     // block template cache
     block m_btc;
     account_public_address m_btc_address;
@@ -1174,6 +1228,7 @@ namespace cryptonote
     uint64_t m_btc_expected_reward;
     crypto::hash m_btc_seed_hash;
     uint64_t m_btc_seed_height;
+    crypto::hash m_btc_tree_root_hash;
     bool m_btc_valid;
 
 
@@ -1185,6 +1240,10 @@ namespace cryptonote
 
     std::vector<BlockNotifyCallback> m_block_notifiers;
     std::vector<MinerNotifyCallback> m_miner_notifiers;
+    std::vector<std::pair<MinerTemplateNotifyCallback, MinerTemplateWantedCallback>> m_miner_template_notifiers;
+    crypto::hash m_miner_template_prev_id; //!< of the template last sent to `m_miner_template_notifiers`
+    std::vector<crypto::hash> m_miner_template_tx_hashes; //!< of the template last sent to `m_miner_template_notifiers`
+    std::atomic<bool> m_syncing; //!< no miner templates are built while set
     std::shared_ptr<tools::Notify> m_reorg_notify;
 
     // for prepare_handle_incoming_blocks
@@ -1553,6 +1612,16 @@ namespace cryptonote
      */
     bool expand_transaction_2(transaction &tx, const crypto::hash &tx_prefix_hash, const std::vector<std::vector<rct::ctkey>> &pubkeys) const;
 
+    /**
+     * @brief fills in the parts of a block template that do not depend on the miner
+     *
+     * @param from_block optional block hash to start mining from (main chain tip if NULL)
+     * @param body return-by-reference block template body
+     *
+     * @return true on success, else false
+     */
+    bool create_block_template_body(const crypto::hash *from_block, block_template_body &body);
+
     /**
      * @brief invalidates any cached block template
      */
@@ -1563,7 +1632,7 @@ namespace cryptonote
      *
      * At some point, may be used to push an update to miners
      */
-    void cache_block_template(const block &b, const cryptonote::account_public_address &address, const blobdata &nonce, const difficulty_type &diff, uint64_t height, uint64_t expected_reward, uint64_t seed_height, const crypto::hash &seed_hash, uint64_t pool_cookie);
+    void cache_block_template(const block &b, const cryptonote::account_public_address &address, const blobdata &nonce, const difficulty_type &diff, uint64_t height, uint64_t expected_reward, uint64_t seed_height, const crypto::hash &seed_hash, uint64_t pool_cookie, const crypto::hash &tree_root_hash);
 
     /**
      * @brief sends new block notifications to ZMQ `miner_data` subscribers
@@ -1572,5 +1641,14 @@ namespace cryptonote
      * @param already_generated_coins total coins mined by the network so far
      */
     void send_miner_notifications(const crypto::hash &prev_id, uint64_t already_generated_coins);
+
+    /**
+     * @brief sends the block template body to miner template notifiers
+     *
+     * The txpool and blockchain locks must be held.
+     *
+     * @param force send even if the transactions did not change
+     */
+    void send_miner_template(bool force);
   };
 }  // namespace cryptonote
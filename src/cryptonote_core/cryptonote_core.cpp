@@ -42,6 +42,7 @@ using namespace epee;
 #include "common/threadpool.h"
 #include "common/command_line.h"
 #include "cryptonote_basic/events.h"
+#include "cryptonote_basic/transaction_view.h"
 #include "warnings.h"
 #include "crypto/crypto.h"
 #include "cryptonote_config.h"
@@ -198,6 +199,11 @@ namespace cryptonote
   , "Prune blockchain"
   , false
   };
+  static const command_line::arg_descriptor<bool> arg_prune_blockchain_background  = {
+    "prune-blockchain-background"
+  , "Prune blockchain in place in the background while the daemon runs, instead of all at once on startup (implies --prune-blockchain)"
+  , false
+  };
   static const command_line::arg_descriptor<std::string> arg_reorg_notify = {
     "reorg-notify"
   , "Run a program for each reorg, '%s' will be replaced by the split height, "
@@ -239,7 +245,9 @@ namespace cryptonote
               m_disable_dns_checkpoints(true),
               m_update_download(0),
               m_nettype(UNDEFINED),
-              m_update_available(false)
+              m_update_available(false),
+              m_background_pruning(false),
+              m_background_pruning_percent(0)
   {
     m_checkpoints_updating.clear();
     set_cryptonote_protocol(pprotocol);
@@ -346,6 +354,7 @@ namespace cryptonote
     command_line::add_arg(desc, arg_max_txpool_weight);
     command_line::add_arg(desc, arg_block_notify);
     command_line::add_arg(desc, arg_prune_blockchain);
+    command_line::add_arg(desc, arg_prune_blockchain_background);
     command_line::add_arg(desc, arg_reorg_notify);
     command_line::add_arg(desc, arg_block_rate_notify);
     command_line::add_arg(desc, arg_keep_alt_blocks);
@@ -476,11 +485,13 @@ namespace cryptonote
 
     std::string db_sync_mode = command_line::get_arg(vm, cryptonote::arg_db_sync_mode);
     bool db_salvage = command_line::get_arg(vm, cryptonote::arg_db_salvage) != 0;
+    bool db_output_key_index = command_line::get_arg(vm, cryptonote::arg_db_output_key_index);
     bool fast_sync = command_line::get_arg(vm, arg_fast_block_sync) != 0;
     uint64_t blocks_threads = command_line::get_arg(vm, arg_prep_blocks_threads);
     std::string check_updates_string = command_line::get_arg(vm, arg_check_updates);
     size_t max_txpool_weight = command_line::get_arg(vm, arg_max_txpool_weight);
-    bool prune_blockchain = command_line::get_arg(vm, arg_prune_blockchain);
+    bool prune_background = command_line::get_arg(vm, arg_prune_blockchain_background);
+    bool prune_blockchain = command_line::get_arg(vm, arg_prune_blockchain) || prune_background;
     bool keep_alt_blocks = command_line::get_arg(vm, arg_keep_alt_blocks);
     bool keep_fakechain = command_line::get_arg(vm, arg_keep_fakechain);
 
@@ -610,6 +621,8 @@ namespace cryptonote
 
       if (db_salvage)
         db_flags |= DBF_SALVAGE;
+      if (db_output_key_index)
+        db_flags |= DBF_OUTPUT_KEY_INDEX;
 
       db->open(filename, db_flags);
       if(!db->m_open)
@@ -718,13 +731,27 @@ namespace cryptonote
     if (!keep_alt_blocks && !m_blockchain_storage.get_db().is_read_only())
       m_blockchain_storage.get_db().drop_alt_blocks();
 
-    if (prune_blockchain)
+    pruning_progress_t pruning_progress;
+    if (m_blockchain_storage.get_pruning_progress(pruning_progress) && !m_blockchain_storage.get_db().is_read_only())
+    {
+      MGINFO("Resuming background blockchain pruning at " << pruning_progress.txes_done << "/" << pruning_progress.txes_total << " transactions");
+      m_background_pruning = true;
+    }
+    else if (prune_blockchain)
     {
       // display a message if the blockchain is not pruned yet
       if (!m_blockchain_storage.get_blockchain_pruning_seed())
       {
-        MGINFO("Pruning blockchain...");
-        CHECK_AND_ASSERT_MES(m_blockchain_storage.prune_blockchain(), false, "Failed to prune blockchain");
+        if (prune_background)
+        {
+          MGINFO("Pruning blockchain in the background...");
+          CHECK_AND_ASSERT_MES(prune_blockchain_background(), false, "Failed to start pruning blockchain");
+        }
+        else
+        {
+          MGINFO("Pruning blockchain...");
+          CHECK_AND_ASSERT_MES(m_blockchain_storage.prune_blockchain(), false, "Failed to prune blockchain");
+        }
       }
       else
       {
@@ -780,7 +807,7 @@ namespace cryptonote
     return false;
   }
   //-----------------------------------------------------------------------------------------------
-  bool core::handle_incoming_tx_pre(const tx_blob_entry& tx_blob, tx_verification_context& tvc, cryptonote::transaction &tx, crypto::hash &tx_hash)
+  bool core::handle_incoming_tx_pre(const tx_blob_entry& tx_blob, tx_verification_context& tvc, crypto::hash &tx_hash)
   {
     tvc = {};
 
@@ -794,29 +821,16 @@ namespace cryptonote
 
     tx_hash = crypto::null_hash;
 
-    bool r;
-    if (tx_blob.prunable_hash == crypto::null_hash)
-    {
-      r = parse_tx_from_blob(tx, tx_hash, tx_blob.blob);
-    }
-    else
-    {
-      r = parse_and_validate_tx_base_from_blob(tx_blob.blob, tx);
-      if (r)
-      {
-        tx.set_prunable_hash(tx_blob.prunable_hash);
-        tx_hash = cryptonote::get_pruned_transaction_hash(tx, tx_blob.prunable_hash);
-        tx.set_hash(tx_hash);
-      }
-    }
-
-    if (!r)
+    // hash in place, the transaction is only deserialized if it is new (see handle_incoming_tx_post)
+    transaction_view& view = transaction_view::get_thread_view();
+    const bool pruned = tx_blob.prunable_hash != crypto::null_hash;
+    if (!view.parse(epee::strspan<std::uint8_t>(tx_blob.blob), pruned) || (pruned && view.version() < 2))
     {
       LOG_PRINT_L1("WRONG TRANSACTION BLOB, Failed to parse, rejected");
       tvc.m_verifivation_failed = true;
       return false;
     }
-    //std::cout << "!"<< tx.vin.size() << std::endl;
+    tx_hash = pruned ? view.get_pruned_hash(tx_blob.prunable_hash) : view.get_hash();
 
     bad_semantics_txes_lock.lock();
     for (int idx = 0; idx < 2; ++idx)
@@ -833,10 +847,10 @@ namespace cryptonote
 
     uint8_t version = m_blockchain_storage.get_current_hard_fork_version();
     const size_t max_tx_version = version == 1 ? 1 : 2;
-    if (tx.version == 0 || tx.version > max_tx_version)
+    if (view.version() == 0 || view.version() > max_tx_version)
     {
       // v2 is the latest one we know
-      MERROR_VER("Bad tx version (" << tx.version << ", max is " << max_tx_version << ")");
+      MERROR_VER("Bad tx version (" << view.version() << ", max is " << max_tx_version << ")");
       tvc.m_verifivation_failed = true;
       return false;
     }
@@ -844,8 +858,27 @@ namespace cryptonote
     return true;
   }
   //-----------------------------------------------------------------------------------------------
+  static bool materialize_tx(const tx_blob_entry& tx_blob, const crypto::hash &tx_hash, cryptonote::transaction &tx)
+  {
+    transaction_view& view = transaction_view::get_thread_view();
+    const bool pruned = tx_blob.prunable_hash != crypto::null_hash;
+    if (!view.parse(epee::strspan<std::uint8_t>(tx_blob.blob), pruned) || !view.materialize(tx))
+      return false;
+    if (pruned)
+      tx.set_prunable_hash(tx_blob.prunable_hash);
+    tx.set_hash(tx_hash);
+    return true;
+  }
+  //-----------------------------------------------------------------------------------------------
   bool core::handle_incoming_tx_post(const tx_blob_entry& tx_blob, tx_verification_context& tvc, cryptonote::transaction &tx, crypto::hash &tx_hash)
   {
+    if (!materialize_tx(tx_blob, tx_hash, tx))
+    {
+      LOG_PRINT_L1("WRONG TRANSACTION BLOB, Failed to parse, rejected");
+      tvc.m_verifivation_failed = true;
+      return false;
+    }
+
     if(!check_tx_syntax(tx))
     {
       LOG_PRINT_L1("WRONG TRANSACTION BLOB, Failed to check tx " << tx_hash << " syntax, rejected");
@@ -995,7 +1028,7 @@ namespace cryptonote
       tpool.submit(&waiter, [&, i, it] {
         try
         {
-          results[i].res = handle_incoming_tx_pre(*it, tvc[i], results[i].tx, results[i].hash);
+          results[i].res = handle_incoming_tx_pre(*it, tvc[i], results[i].hash);
         }
         catch (const std::exception &e)
         {
@@ -1060,10 +1093,25 @@ namespace cryptonote
         ok = false;
         continue;
       }
-      if (tx_relay == relay_method::block)
-        get_blockchain_storage().on_new_tx_from_block(results[i].tx);
       if (already_have[i])
+      {
+        // known transactions were only hashed, the block handler still needs them whole
+        if (tx_relay == relay_method::block)
+        {
+          if (!materialize_tx(tx_blobs[i], results[i].hash, results[i].tx))
+          {
+            MERROR_VER("Failed to parse known transaction " << results[i].hash);
+            tvc[i].m_verifivation_failed = true;
+            results[i].res = ok = false;
+            continue;
+          }
+          get_blockchain_storage().on_new_tx_from_block(results[i].tx);
+        }
+        results[i].res = false; // not a new pool transaction
         continue;
+      }
+      if (tx_relay == relay_method::block)
+        get_blockchain_storage().on_new_tx_from_block(results[i].tx);
 
       results[i].blob_size = it->blob.size();
       results[i].weight = results[i].tx.pruned ? get_pruned_transaction_weight(results[i].tx) : get_transaction_weight(results[i].tx, it->blob.size());
@@ -1401,9 +1449,9 @@ namespace cryptonote
     return m_blockchain_storage.create_block_template(b, adr, diffic, height, expected_reward, ex_nonce, seed_height, seed_hash);
   }
   //-----------------------------------------------------------------------------------------------
-  bool core::get_block_template(block& b, const crypto::hash *prev_block, const account_public_address& adr, difficulty_type& diffic, uint64_t& height, uint64_t& expected_reward, const blobdata& ex_nonce, uint64_t &seed_height, crypto::hash &seed_hash)
+  bool core::get_block_template(block& b, const crypto::hash *prev_block, const account_public_address& adr, difficulty_type& diffic, uint64_t& height, uint64_t& expected_reward, const blobdata& ex_nonce, uint64_t &seed_height, crypto::hash &seed_hash, crypto::hash *tree_root_hash)
   {
-    return m_blockchain_storage.create_block_template(b, prev_block, adr, diffic, height, expected_reward, ex_nonce, seed_height, seed_hash);
+    return m_blockchain_storage.create_block_template(b, prev_block, adr, diffic, height, expected_reward, ex_nonce, seed_height, seed_hash, tree_root_hash);
   }
   //-----------------------------------------------------------------------------------------------
   bool core::get_miner_data(uint8_t& major_version, uint64_t& height, crypto::hash& prev_id, crypto::hash& seed_hash, difficulty_type& difficulty, uint64_t& median_weight, uint64_t& already_generated_coins, std::vector<tx_block_template_backlog_entry>& tx_backlog)
@@ -1750,7 +1798,12 @@ namespace cryptonote
     m_check_disk_space_interval.do_call(boost::bind(&core::check_disk_space, this));
     m_block_rate_interval.do_call(boost::bind(&core::check_block_rate, this));
     m_blockchain_pruning_interval.do_call(boost::bind(&core::update_blockchain_pruning, this));
+    if (m_background_pruning)
+      background_pruning_step(); // one step per idle call, about once a second
     m_diff_recalc_interval.do_call(boost::bind(&core::recalculate_difficulties, this));
+    // templates pushed while catching up would be stale before they are mined on
+    m_blockchain_storage.set_syncing(!is_synchronized() || get_current_blockchain_height() < get_target_blockchain_height());
+    m_miner_template_interval.do_call(boost::bind(&core::send_miner_template_notifications, this));
     m_miner.on_idle();
     m_mempool.on_idle();
     return true;
@@ -1949,6 +2002,38 @@ namespace cryptonote
     return p;
   }
   //-----------------------------------------------------------------------------------------------
+  bool core::background_pruning_step()
+  {
+    pruning_progress_t progress;
+    bool done;
+    try
+    {
+      done = m_blockchain_storage.prune_blockchain_step(CRYPTONOTE_PRUNING_BACKGROUND_STEP_TXES, progress);
+    }
+    catch (const std::exception &e)
+    {
+      MERROR("Background blockchain pruning failed: " << e.what());
+      m_background_pruning = false;
+      return false;
+    }
+
+    const uint64_t free_mb = progress.free_pages * progress.page_size / 1024 / 1024;
+    if (done)
+    {
+      MGINFO_GREEN("Background blockchain pruning done, " << free_mb << " MB free in the database for reuse");
+      m_background_pruning = false;
+      return true;
+    }
+    MDEBUG("Background blockchain pruning step: " << progress.pruned_records << " records, " << progress.pruned_bytes << " bytes pruned");
+    const unsigned int percent = progress.txes_total ? progress.txes_done * 100 / progress.txes_total : 0;
+    if (m_background_pruning_percent.exchange(percent) != percent)
+    {
+      MGINFO("Background blockchain pruning: " << percent << "% (" << progress.txes_done << "/" << progress.txes_total <<
+          " transactions), " << free_mb << " MB free in the database for reuse");
+    }
+    return true;
+  }
+  //-----------------------------------------------------------------------------------------------
   bool core::check_block_rate()
   {
     if (m_offline || m_nettype == FAKECHAIN || m_target_blockchain_height > get_current_blockchain_height() || m_target_blockchain_height == 0)
@@ -1995,6 +2080,12 @@ namespace cryptonote
     return true;
   }
   //-----------------------------------------------------------------------------------------------
+  bool core::send_miner_template_notifications()
+  {
+    m_blockchain_storage.send_miner_template_notifications();
+    return true;
+  }
+  //-----------------------------------------------------------------------------------------------
   void core::flush_bad_txs_cache()
   {
     bad_semantics_txes_lock.lock();
@@ -2023,6 +2114,19 @@ namespace cryptonote
     return m_blockchain_storage.check_blockchain_pruning();
   }
   //-----------------------------------------------------------------------------------------------
+  bool core::prune_blockchain_background()
+  {
+    if (m_background_pruning.exchange(true))
+      return true;
+    // the first step sets the pruning seed, the rest is done from on_idle
+    return background_pruning_step();
+  }
+  //-----------------------------------------------------------------------------------------------
+  bool core::get_pruning_progress(pruning_progress_t &progress) const
+  {
+    return m_blockchain_storage.get_pruning_progress(progress);
+  }
+  //-----------------------------------------------------------------------------------------------
   void core::set_target_blockchain_height(uint64_t target_blockchain_height)
   {
     m_target_blockchain_height = target_blockchain_height;
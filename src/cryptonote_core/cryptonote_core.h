@@ -234,7 +234,7 @@ namespace cryptonote
       * @note see Blockchain::create_block_template
       */
      virtual bool get_block_template(block& b, const account_public_address& adr, difficulty_type& diffic, uint64_t& height, uint64_t& expected_reward, const blobdata& ex_nonce, uint64_t &seed_height, crypto::hash &seed_hash) override;
-     virtual bool get_block_template(block& b, const crypto::hash *prev_block, const account_public_address& adr, difficulty_type& diffic, uint64_t& height, uint64_t& expected_reward, const blobdata& ex_nonce, uint64_t &seed_height, crypto::hash &seed_hash);
+     virtual bool get_block_template(block& b, const crypto::hash *prev_block, const account_public_address& adr, difficulty_type& diffic, uint64_t& height, uint64_t& expected_reward, const blobdata& ex_nonce, uint64_t &seed_height, crypto::hash &seed_hash, crypto::hash *tree_root_hash = NULL);
 
      /**
       * @copydoc Blockchain::get_miner_data
@@ -862,6 +862,24 @@ namespace cryptonote
       */
      bool check_blockchain_pruning();
 
+     /**
+      * @brief starts pruning the blockchain in place, a few transactions at a time from the idle loop
+      *
+      * The daemon keeps running meanwhile, and pruning resumes after a restart.
+      *
+      * @return true on success, false otherwise
+      */
+     bool prune_blockchain_background();
+
+     /**
+      * @brief gets the state of a background blockchain pruning
+      *
+      * @param progress return-by-reference the pruning state
+      *
+      * @return true iff a background pruning is in progress
+      */
+     bool get_pruning_progress(pruning_progress_t &progress) const;
+
      /**
       * @brief checks whether a given block height is included in the precompiled block hash area
       *
@@ -977,7 +995,7 @@ namespace cryptonote
      bool check_tx_semantic(const transaction& tx, bool keeped_by_block) const;
      void set_semantics_failed(const crypto::hash &tx_hash);
 
-     bool handle_incoming_tx_pre(const tx_blob_entry& tx_blob, tx_verification_context& tvc, cryptonote::transaction &tx, crypto::hash &tx_hash);
+     bool handle_incoming_tx_pre(const tx_blob_entry& tx_blob, tx_verification_context& tvc, crypto::hash &tx_hash);
      bool handle_incoming_tx_post(const tx_blob_entry& tx_blob, tx_verification_context& tvc, cryptonote::transaction &tx, crypto::hash &tx_hash);
      struct tx_verification_batch_info { const cryptonote::transaction *tx; crypto::hash tx_hash; tx_verification_context &tvc; bool &result; };
      bool handle_incoming_tx_accumulated_batch(std::vector<tx_verification_batch_info> &tx_info, bool keeped_by_block);
@@ -1056,6 +1074,13 @@ namespace cryptonote
       */
      bool check_block_rate();
 
+     /**
+      * @brief runs one step of a background blockchain pruning
+      *
+      * @return true on success, false otherwise
+      */
+     bool background_pruning_step();
+
      /**
       * @brief recalculate difficulties after the last difficulty checklpoint to circumvent the annoying 'difficulty drift' bug
       *
@@ -1063,6 +1088,13 @@ namespace cryptonote
       */
      bool recalculate_difficulties();
 
+     /**
+      * @brief pushes the block template to miner template listeners if the txpool changed it
+      *
+      * @return true
+      */
+     bool send_miner_template_notifications();
+
      bool m_test_drop_download = true; //!< whether or not to drop incoming blocks (for testing)
 
      uint64_t m_test_drop_download_height = 0; //!< height under which to drop incoming blocks, if doing so
@@ -1088,6 +1120,7 @@ namespace cryptonote
      epee::math_helper::once_a_time_seconds<90, false> m_block_rate_interval; //!< interval for checking block rate
      epee::math_helper::once_a_time_seconds<60*60*5, true> m_blockchain_pruning_interval; //!< interval for incremental blockchain pruning
      epee::math_helper::once_a_time_seconds<60*60*24*7, false> m_diff_recalc_interval; //!< interval for recalculating difficulties
+     epee::math_helper::once_a_time_seconds<5, true> m_miner_template_interval; //!< interval for pushing block templates after txpool changes
 
      std::atomic<bool> m_starter_message_showed; //!< has the "daemon will sync now" message been shown?
 
@@ -1097,6 +1130,9 @@ namespace cryptonote
 
      std::atomic<bool> m_update_available;
 
+     std::atomic<bool> m_background_pruning; //!< is a background blockchain pruning in progress?
+     std::atomic<unsigned int> m_background_pruning_percent; //!< last background pruning progress logged, steps run from the RPC and idle threads
+
      std::string m_checkpoints_path; //!< path to json checkpoints file
      time_t m_last_dns_checkpoints_update; //!< time when dns checkpoints were last updated
      time_t m_last_json_checkpoints_update; //!< time when json checkpoints were last updated
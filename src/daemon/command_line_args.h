@@ -141,6 +141,17 @@ namespace daemon_args
   , "Disable ZMQ RPC server"
   };
 
+  const command_line::arg_descriptor<bool> arg_light_wallet_server = {
+    "light-wallet-server"
+  , "Scan blocks for registered view keys and serve the light wallet RPC endpoints on the unrestricted RPC"
+  };
+
+  const command_line::arg_descriptor<uint64_t> arg_light_wallet_max_accounts = {
+    "light-wallet-max-accounts"
+  , "Maximum number of accounts the light wallet server registers, 0 for no limit"
+  , 1000
+  };
+
 }  // namespace daemon_args
 
 #endif // DAEMON_COMMAND_LINE_ARGS_H
@@ -967,18 +967,19 @@ bool t_command_parser_executor::prune_blockchain(const std::vector<std::string>&
     return true;
   }
 
-  if (args.empty() || args[0] != "confirm")
+  if (args.empty() || (args[0] != "confirm" && args[0] != "background"))
   {
     std::cout << "Warning: pruning from within lozzaxd will not shrink the database file size." << std::endl;
     std::cout << "Instead, parts of the file will be marked as free, so the file will not grow" << std::endl;
     std::cout << "until that newly free space is used up. If you want a smaller file size now," << std::endl;
     std::cout << "exit lozzaxd and run lozzax-blockchain-prune (you will temporarily need more" << std::endl;
     std::cout << "disk space for the database conversion though). If you are OK with the database" << std::endl;
-    std::cout << "file keeping the same size, re-run this command with the \"confirm\" parameter." << std::endl;
+    std::cout << "file keeping the same size, re-run this command with the \"confirm\" parameter," << std::endl;
+    std::cout << "or with the \"background\" parameter to prune while lozzaxd keeps running." << std::endl;
     return true;
   }
 
-  return m_executor.prune_blockchain();
+  return m_executor.prune_blockchain(args[0] == "background");
 }
 
 bool t_command_parser_executor::check_blockchain_pruning(const std::vector<std::string>& args)
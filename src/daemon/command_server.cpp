@@ -315,8 +315,8 @@ t_command_server::t_command_server(
     m_command_lookup.set_handler(
       "prune_blockchain"
     , std::bind(&t_command_parser_executor::prune_blockchain, &m_parser, p::_1)
-    , "prune_blockchain [confirm]"
-    , "Prune the blockchain."
+    , "prune_blockchain [confirm|background]"
+    , "Prune the blockchain. With \"background\", prune it a few transactions at a time while the daemon keeps running, or show the progress of such a pruning."
     );
     m_command_lookup.set_handler(
       "check_blockchain_pruning"
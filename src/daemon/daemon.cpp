@@ -31,9 +31,11 @@
 #include <memory>
 #include <stdexcept>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/filesystem/path.hpp>
 #include "misc_log_ex.h"
 #include "daemon/daemon.h"
 #include "rpc/daemon_handler.h"
+#include "rpc/light_wallet_scanner.h"
 #include "rpc/zmq_pub.h"
 #include "rpc/zmq_server.h"
 
@@ -77,6 +79,7 @@ public:
   t_p2p p2p;
   std::vector<std::unique_ptr<t_rpc>> rpcs;
   std::unique_ptr<zmq_internals> zmq;
+  std::shared_ptr<cryptonote::light_wallet::scanner> light_wallet;
 
   t_internals(
       boost::program_options::variables_map const & vm
@@ -102,6 +105,16 @@ public:
       rpcs.emplace_back(new t_rpc{vm, core, p2p, true, restricted_rpc_port, "restricted", true});
     }
 
+    if (command_line::get_arg(vm, daemon_args::arg_light_wallet_server))
+    {
+      const boost::filesystem::path path = boost::filesystem::path{command_line::get_arg(vm, cryptonote::arg_data_dir)} / "light_wallet";
+      const uint64_t max_accounts = command_line::get_arg(vm, daemon_args::arg_light_wallet_max_accounts);
+      light_wallet = std::make_shared<cryptonote::light_wallet::scanner>(core.get(), path.string(), max_accounts);
+      core.get().get_blockchain_storage().add_block_notify(cryptonote::light_wallet::scanner::notify{light_wallet});
+      for (auto& rpc : rpcs)
+        rpc->get_server()->set_light_wallet(light_wallet);
+    }
+
     if (!command_line::get_arg(vm, daemon_args::arg_zmq_rpc_disabled))
     {
       zmq.reset(new zmq_internals{core, p2p});
@@ -121,6 +134,7 @@ public:
       {
         core.get().get_blockchain_storage().add_block_notify(cryptonote::listener::zmq_pub::chain_main{shared});
         core.get().get_blockchain_storage().add_miner_notify(cryptonote::listener::zmq_pub::miner_data{shared});
+        core.get().get_blockchain_storage().add_miner_template_notify(cryptonote::listener::zmq_pub::miner_template{shared}, cryptonote::listener::zmq_pub::miner_template_wanted{shared});
         core.get().set_txpool_listener(cryptonote::listener::zmq_pub::txpool_add{shared});
       }
     }
@@ -196,6 +210,9 @@ bool t_daemon::run(bool interactive)
     for(auto& rpc: mp_internals->rpcs)
       rpc->run();
 
+    if (mp_internals->light_wallet)
+      mp_internals->light_wallet->run();
+
     std::unique_ptr<daemonize::t_command_server> rpc_commands;
     if (interactive && mp_internals->rpcs.size())
     {
@@ -225,6 +242,9 @@ bool t_daemon::run(bool interactive)
 
     for(auto& rpc : mp_internals->rpcs)
       rpc->stop();
+
+    if (mp_internals->light_wallet)
+      mp_internals->light_wallet->stop();
     MGINFO("Node stopped.");
     return true;
   }
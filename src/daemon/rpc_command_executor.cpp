@@ -2337,7 +2337,7 @@ bool t_rpc_command_executor::pop_blocks(uint64_t num_blocks)
   return true;
 }
 
-bool t_rpc_command_executor::prune_blockchain()
+bool t_rpc_command_executor::prune_blockchain(bool background)
 {
     cryptonote::COMMAND_RPC_PRUNE_BLOCKCHAIN::request req;
     cryptonote::COMMAND_RPC_PRUNE_BLOCKCHAIN::response res;
@@ -2345,6 +2345,7 @@ bool t_rpc_command_executor::prune_blockchain()
     epee::json_rpc::error error_resp;
 
     req.check = false;
+    req.background = background;
 
     if (m_is_rpc)
     {
@@ -2362,6 +2363,12 @@ bool t_rpc_command_executor::prune_blockchain()
         }
     }
 
+    if (res.in_progress)
+    {
+      tools::success_msg_writer() << "Blockchain pruning in progress: " << res.txes_done << "/" << res.txes_total << " transactions, "
+          << res.free_bytes / 1024 / 1024 << " MB free in the database for reuse";
+      return true;
+    }
     tools::success_msg_writer() << "Blockchain pruned";
     return true;
 }
@@ -157,7 +157,7 @@ public:
 
   bool pop_blocks(uint64_t num_blocks);
 
-  bool prune_blockchain();
+  bool prune_blockchain(bool background = false);
 
   bool check_blockchain_pruning();
 
@@ -30,6 +30,9 @@
 
 
 
+#include <algorithm>
+#include <memory>
+
 #include "device_default.hpp"
 #include "int-util.h"
 #include "crypto/wallet/crypto.h"
@@ -143,38 +146,46 @@ namespace hw {
         std::vector<crypto::public_key>  device_default::get_subaddress_spend_public_keys(const cryptonote::account_keys &keys, uint32_t account, uint32_t begin, uint32_t end) {
             CHECK_AND_ASSERT_THROW_MES(begin <= end, "begin > end");
 
-            std::vector<crypto::public_key> pkeys;
-            pkeys.reserve(end - begin);
+            // D_i = B + m_i*G, converted to bytes a chunk at a time with a single inversion
+            static constexpr const uint32_t chunk_size = 256;
+            std::vector<crypto::public_key> pkeys(end - begin);
+            std::vector<ge_p3> points(std::min(end - begin, chunk_size));
+            std::unique_ptr<fe[]> scratch(new fe[points.size()]);
             cryptonote::subaddress_index index = {account, begin};
 
-            ge_p3 p3;
+            ge_p3 spend;
             ge_cached cached;
-            CHECK_AND_ASSERT_THROW_MES(ge_frombytes_vartime(&p3, (const unsigned char*)keys.m_account_address.m_spend_public_key.data) == 0,
+            CHECK_AND_ASSERT_THROW_MES(ge_frombytes_vartime(&spend, (const unsigned char*)keys.m_account_address.m_spend_public_key.data) == 0,
                 "ge_frombytes_vartime failed to convert spend public key");
-            ge_p3_to_cached(&cached, &p3);
+            ge_p3_to_cached(&cached, &spend);
 
-            for (uint32_t idx = begin; idx < end; ++idx)
+            for (uint32_t first = begin; first < end; )
             {
-                index.minor = idx;
-                if (index.is_zero())
+                const uint32_t count = std::min(end - first, chunk_size);
+                for (uint32_t i = 0; i < count; ++i)
                 {
-                    pkeys.push_back(keys.m_account_address.m_spend_public_key);
-                    continue;
+                    index.minor = first + i;
+                    if (index.is_zero())
+                    {
+                        points[i] = spend;
+                        continue;
+                    }
+                    crypto::secret_key m = get_subaddress_secret_key(keys.m_view_secret_key, index);
+
+                    // M = m*G
+                    ge_p3 M;
+                    ge_scalarmult_base(&M, (const unsigned char*)m.data);
+
+                    // D = B + M
+                    ge_p1p1 p1p1;
+                    ge_add(&p1p1, &M, &cached);
+                    ge_p1p1_to_p3(&points[i], &p1p1);
                 }
-                crypto::secret_key m = get_subaddress_secret_key(keys.m_view_secret_key, index);
-
-                // M = m*G
-                ge_scalarmult_base(&p3, (const unsigned char*)m.data);
-
-                // D = B + M
-                crypto::public_key D;
-                ge_p1p1 p1p1;
-                ge_add(&p1p1, &p3, &cached);
-                ge_p1p1_to_p3(&p3, &p1p1);
-                ge_p3_tobytes((unsigned char*)D.data, &p3);
-
-                pkeys.push_back(D);
+                ge_p3_tobytes_batch((unsigned char*)pkeys[first - begin].data, points.data(), count, scratch.get());
+                first += count;
             }
+            if (account == 0 && begin == 0 && end > 0)
+                pkeys[0] = keys.m_account_address.m_spend_public_key;
             return pkeys;
         }
 
@@ -38,6 +38,8 @@
 #include "net/error.h"
 #include "serialization/keyvalue_serialization.h"
 #include "storages/portable_storage.h"
+#include "storages/portable_storage_reader.h"
+#include "storages/portable_storage_writer.h"
 #include "string_tools_lexical.h"
 
 namespace net
@@ -122,7 +124,8 @@ namespace net
         return tor_address{host, porti};
     }
 
-    bool tor_address::_load(epee::serialization::portable_storage& src, epee::serialization::section* hparent)
+    template<typename T>
+    bool tor_address::load_from(T& src, typename T::hsection hparent)
     {
         tor_serialized in{};
         if (in._load(src, hparent) && in.host.size() < sizeof(host_) && (in.host == unknown_host || !host_check(in.host).has_error()))
@@ -138,12 +141,38 @@ namespace net
         return false;
     }
 
-    bool tor_address::store(epee::serialization::portable_storage& dest, epee::serialization::section* hparent) const
+    template<typename T>
+    bool tor_address::store_to(T& dest, typename T::hsection hparent) const
     {
         const tor_serialized out{std::string{host_}, port_};
         return out.store(dest, hparent);
     }
 
+    bool tor_address::_load(epee::serialization::portable_storage& src, epee::serialization::section* hparent)
+    {
+        return load_from(src, hparent);
+    }
+
+    bool tor_address::_load(epee::serialization::binary_reader& src, epee::serialization::section_view* hparent)
+    {
+        return load_from(src, hparent);
+    }
+
+    bool tor_address::store(epee::serialization::portable_storage& dest, epee::serialization::section* hparent) const
+    {
+        return store_to(dest, hparent);
+    }
+
+    bool tor_address::store(epee::serialization::binary_writer& dest, epee::serialization::stream_handle hparent) const
+    {
+        return store_to(dest, hparent);
+    }
+
+    bool tor_address::store(epee::serialization::json_writer& dest, epee::serialization::stream_handle hparent) const
+    {
+        return store_to(dest, hparent);
+    }
+
     tor_address::tor_address(const tor_address& rhs) noexcept
       : port_(rhs.port_)
     {
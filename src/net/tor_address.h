@@ -42,6 +42,11 @@ namespace serialization
 {
     class portable_storage;
     struct section;
+    class binary_reader;
+    struct section_view;
+    class binary_writer;
+    class json_writer;
+    struct stream_handle;
 }
 }
 
@@ -56,6 +61,12 @@ namespace net
         //! Keep in private, `host.size()` has no runtime check
         tor_address(boost::string_ref host, std::uint16_t port) noexcept;
 
+        template<typename T>
+        bool load_from(T& src, typename T::hsection hparent);
+
+        template<typename T>
+        bool store_to(T& dest, typename T::hsection hparent) const;
+
     public:
         //! \return Size of internal buffer for host.
         static constexpr std::size_t buffer_size() noexcept { return sizeof(host_); }
@@ -78,9 +89,12 @@ namespace net
 
         //! Load from epee p2p format, and \return false if not valid tor address
         bool _load(epee::serialization::portable_storage& src, epee::serialization::section* hparent);
+        bool _load(epee::serialization::binary_reader& src, epee::serialization::section_view* hparent);
 
         //! Store in epee p2p format
         bool store(epee::serialization::portable_storage& dest, epee::serialization::section* hparent) const;
+        bool store(epee::serialization::binary_writer& dest, epee::serialization::stream_handle hparent) const;
+        bool store(epee::serialization::json_writer& dest, epee::serialization::stream_handle hparent) const;
 
         // Moves and  copies are currently identical
 
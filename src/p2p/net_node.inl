@@ -1522,6 +1522,9 @@ namespace nodetool
 
     std::set<size_t> tried_peers;
 
+    // indices below are into this copy, which does not change while we pick
+    const std::shared_ptr<const peerlist_snapshot> peers = zone.m_peerlist.get_snapshot(use_white_list);
+
     size_t try_count = 0;
     size_t rand_count = 0;
     while(rand_count < (max_random_index+1)*3 &&  try_count < 10 && !zone.m_net_server.is_stop_signal_sent())
@@ -1559,20 +1562,6 @@ namespace nodetool
         });
       }
 
-      auto get_host_string = [](const epee::net_utils::network_address &address) {
-        if (address.get_type_id() == epee::net_utils::ipv6_network_address::get_type_id())
-        {
-          boost::asio::ip::address_v6 actual_ip = address.as<const epee::net_utils::ipv6_network_address>().ip();
-          if (actual_ip.is_v4_mapped())
-          {
-            boost::asio::ip::address_v4 v4ip = make_address_v4_from_v6(actual_ip);
-            uint32_t actual_ipv4;
-            memcpy(&actual_ipv4, v4ip.to_bytes().data(), sizeof(actual_ipv4));
-            return epee::net_utils::ipv4_network_address(actual_ipv4, 0).host_str();
-          }
-        }
-        return address.host_str();
-      };
       std::unordered_set<std::string> hosts_added;
       std::deque<size_t> filtered;
       const size_t limit = use_white_list ? 20 : std::numeric_limits<size_t>::max();
@@ -1580,47 +1569,29 @@ namespace nodetool
       {
         bool skip_duplicate_class_B = step == 0;
         size_t idx = 0, skipped = 0;
-        zone.m_peerlist.foreach (use_white_list, [&classB, &filtered, &idx, &skipped, skip_duplicate_class_B, limit, next_needed_pruning_stripe, &hosts_added, &get_host_string](const peerlist_entry &pe){
+        for (const peerlist_snapshot::entry &e: peers->peers)
+        {
           if (filtered.size() >= limit)
-            return false;
-          bool skip = false;
-          if (skip_duplicate_class_B && pe.adr.get_type_id() == epee::net_utils::ipv4_network_address::get_type_id())
-          {
-            const epee::net_utils::network_address na = pe.adr;
-            uint32_t actual_ip = na.as<const epee::net_utils::ipv4_network_address>().ip();
-            skip = classB.find(actual_ip & 0x0000ffff) != classB.end();
-          }
-          else if (skip_duplicate_class_B && pe.adr.get_type_id() == epee::net_utils::ipv6_network_address::get_type_id())
-          {
-            const epee::net_utils::network_address na = pe.adr;
-            const boost::asio::ip::address_v6 &actual_ip = na.as<const epee::net_utils::ipv6_network_address>().ip();
-            if (actual_ip.is_v4_mapped())
-            {
-              boost::asio::ip::address_v4 v4ip = make_address_v4_from_v6(actual_ip);
-              uint32_t actual_ipv4;
-              memcpy(&actual_ipv4, v4ip.to_bytes().data(), sizeof(actual_ipv4));
-              skip = classB.find(actual_ipv4 & ntohl(0xffff0000)) != classB.end();
-            }
-          }
+            break;
+          bool skip = skip_duplicate_class_B && e.class_b && classB.find(*e.class_b) != classB.end();
 
           // consider each host once, to avoid giving undue inflence to hosts running several nodes
           if (!skip)
           {
-            const auto i = hosts_added.find(get_host_string(pe.adr));
+            const auto i = hosts_added.find(e.host);
             if (i != hosts_added.end())
               skip = true;
           }
 
           if (skip)
             ++skipped;
-          else if (next_needed_pruning_stripe == 0 || pe.pruning_seed == 0)
+          else if (next_needed_pruning_stripe == 0 || e.peer.pruning_seed == 0)
             filtered.push_back(idx);
-          else if (next_needed_pruning_stripe == tools::get_pruning_stripe(pe.pruning_seed))
+          else if (next_needed_pruning_stripe == tools::get_pruning_stripe(e.peer.pruning_seed))
             filtered.push_front(idx);
           ++idx;
-          hosts_added.insert(get_host_string(pe.adr));
-          return true;
-        });
+          hosts_added.insert(e.host);
+        }
         if (skipped == 0 || !filtered.empty())
           break;
         if (skipped)
@@ -1642,8 +1613,8 @@ namespace nodetool
           m_used_stripe_peers[next_needed_pruning_stripe-1].pop_front();
           for (size_t i = 0; i < filtered.size(); ++i)
           {
-            peerlist_entry pe;
-            if (zone.m_peerlist.get_white_peer_by_index(pe, filtered[i]) && pe.adr == na)
+            const peerlist_entry &pe = peers->peers[filtered[i]].peer;
+            if (pe.adr == na)
             {
               MDEBUG("Reusing stripe " << next_needed_pruning_stripe << " peer " << pe.adr.str());
               random_index = i;
@@ -1657,16 +1628,13 @@ namespace nodetool
 
       CHECK_AND_ASSERT_MES(random_index < filtered.size(), false, "random_index < filtered.size() failed!!");
       random_index = filtered[random_index];
-      CHECK_AND_ASSERT_MES(random_index < (use_white_list ? zone.m_peerlist.get_white_peers_count() : zone.m_peerlist.get_gray_peers_count()),
-          false, "random_index < peers size failed!!");
+      CHECK_AND_ASSERT_MES(random_index < peers->peers.size(), false, "random_index < peers size failed!!");
 
       if(tried_peers.count(random_index))
         continue;
 
       tried_peers.insert(random_index);
-      peerlist_entry pe = AUTO_VAL_INIT(pe);
-      bool r = use_white_list ? zone.m_peerlist.get_white_peer_by_index(pe, random_index):zone.m_peerlist.get_gray_peer_by_index(pe, random_index);
-      CHECK_AND_ASSERT_MES(r, false, "Failed to get random peer from peerlist(white:" << use_white_list << ")");
+      const peerlist_entry pe = peers->peers[random_index].peer;
 
       ++try_count;
 
@@ -263,6 +263,8 @@ namespace nodetool
     if (!m_peers_white.empty() || !m_peers_gray.empty() || !m_peers_anchor.empty())
       return false;
 
+    white_changed();
+    gray_changed();
     add_peers(m_peers_white.get<by_addr>(), std::move(peers.white));
     add_peers(m_peers_gray.get<by_addr>(), std::move(peers.gray));
     add_peers(m_peers_anchor.get<by_addr>(), std::move(peers.anchor));
@@ -293,6 +295,42 @@ namespace nodetool
   {
     filter(use_white, [&pr](const peerlist_entry& pe){ return pe.adr.is_same_host(pr.adr); });
   }
+
+  std::shared_ptr<const peerlist_snapshot> peerlist_manager::get_snapshot(const bool white)
+  {
+    CRITICAL_REGION_LOCAL(m_peerlist_lock);
+    std::shared_ptr<const peerlist_snapshot>& snapshot = white ? m_white_snapshot : m_gray_snapshot;
+    if (snapshot)
+      return snapshot;
+
+    const peers_indexed::index<by_time>::type& by_time_index = white ? m_peers_white.get<by_time>() : m_peers_gray.get<by_time>();
+    auto out = std::make_shared<peerlist_snapshot>();
+    out->peers.reserve(by_time_index.size());
+    for (const peerlist_entry& pe: boost::adaptors::reverse(by_time_index))
+    {
+      out->peers.push_back({pe, {}, boost::none});
+      peerlist_snapshot::entry& e = out->peers.back();
+      if (pe.adr.get_type_id() == epee::net_utils::ipv4_network_address::get_type_id())
+      {
+        e.class_b = pe.adr.as<const epee::net_utils::ipv4_network_address>().ip() & 0x0000ffff;
+      }
+      else if (pe.adr.get_type_id() == epee::net_utils::ipv6_network_address::get_type_id())
+      {
+        const boost::asio::ip::address_v6 &ip = pe.adr.as<const epee::net_utils::ipv6_network_address>().ip();
+        if (ip.is_v4_mapped())
+        {
+          uint32_t ipv4;
+          memcpy(&ipv4, ip.to_bytes().data() + 12, sizeof(ipv4));
+          e.class_b = ipv4 & ntohl(0xffff0000);
+          e.host = epee::net_utils::ipv4_network_address(ipv4, 0).host_str();
+        }
+      }
+      if (e.host.empty())
+        e.host = pe.adr.host_str();
+    }
+    snapshot = std::move(out);
+    return snapshot;
+  }
 }
 
 BOOST_CLASS_VERSION(nodetool::peerlist_types, nodetool::CURRENT_PEERLIST_STORAGE_ARCHIVE_VER);
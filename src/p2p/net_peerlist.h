@@ -32,6 +32,7 @@
 
 #include <iosfwd>
 #include <list>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -93,6 +94,20 @@ namespace nodetool
     peerlist_types m_types;
   };
 
+  //! Read-only copy of the white or gray list, so peers can be picked without holding the peerlist lock.
+  struct peerlist_snapshot
+  {
+    struct entry
+    {
+      peerlist_entry peer;
+      std::string host; //!< IPv4-mapped IPv6 addresses are shown as IPv4
+      boost::optional<uint32_t> class_b; //!< /16 of an IPv4 (or IPv4-mapped) address, in the byte order of `ipv4_network_address::ip()`
+    };
+
+    //! Most recently seen first, so index `i` matches `get_white_peer_by_index` and `get_gray_peer_by_index`
+    std::vector<entry> peers;
+  };
+
   /************************************************************************/
   /*                                                                      */
   /************************************************************************/
@@ -121,6 +136,9 @@ namespace nodetool
     bool remove_from_peer_anchor(const epee::net_utils::network_address& addr);
     bool remove_from_peer_white(const peerlist_entry& pe);
     template<typename F> size_t filter(bool white, const F &f); // f returns true: drop, false: keep
+
+    //! \return Current white or gray list. Rebuilt on the first call after the list changed, and shared until the next change.
+    std::shared_ptr<const peerlist_snapshot> get_snapshot(bool white);
     
   private:
     struct by_time{};
@@ -184,6 +202,8 @@ namespace nodetool
   private: 
     void trim_white_peerlist();
     void trim_gray_peerlist();
+    void white_changed() { m_white_snapshot.reset(); }
+    void gray_changed() { m_gray_snapshot.reset(); }
 
     friend class boost::serialization::access;
     epee::critical_section m_peerlist_lock;
@@ -194,6 +214,8 @@ namespace nodetool
     peers_indexed m_peers_gray;
     peers_indexed m_peers_white;
     anchor_peers_indexed m_peers_anchor;
+    std::shared_ptr<const peerlist_snapshot> m_white_snapshot; // null when out of date
+    std::shared_ptr<const peerlist_snapshot> m_gray_snapshot;  // null when out of date
   };
   //--------------------------------------------------------------------------------------------------
   inline void peerlist_manager::trim_gray_peerlist()
@@ -202,6 +224,7 @@ namespace nodetool
     {
       peers_indexed::index<by_time>::type& sorted_index=m_peers_gray.get<by_time>();
       sorted_index.erase(sorted_index.begin());
+      gray_changed();
     }
   }
   //--------------------------------------------------------------------------------------------------
@@ -211,18 +234,25 @@ namespace nodetool
     {
       peers_indexed::index<by_time>::type& sorted_index=m_peers_white.get<by_time>();
       sorted_index.erase(sorted_index.begin());
+      white_changed();
     }
   }
   //--------------------------------------------------------------------------------------------------
   inline 
   bool peerlist_manager::merge_peerlist(const std::vector<peerlist_entry>& outer_bs, const std::function<bool(const peerlist_entry&)> &f)
   {
-    CRITICAL_REGION_LOCAL(m_peerlist_lock);
+    // the filter may take other locks, and does not need this one
+    std::vector<const peerlist_entry*> accepted;
+    accepted.reserve(outer_bs.size());
     for(const peerlist_entry& be:  outer_bs)
     {
-      if (!f || f(be))
-        append_with_peer_gray(be);
+      if ((!f || f(be)) && is_host_allowed(be.adr))
+        accepted.push_back(std::addressof(be));
     }
+
+    CRITICAL_REGION_LOCAL(m_peerlist_lock);
+    for(const peerlist_entry* be: accepted)
+      append_with_peer_gray(*be);
     // delete extra elements
     trim_gray_peerlist();    
     return true;
@@ -231,24 +261,22 @@ namespace nodetool
   inline
   bool peerlist_manager::get_white_peer_by_index(peerlist_entry& p, size_t i)
   {
-    CRITICAL_REGION_LOCAL(m_peerlist_lock);
-    if(i >= m_peers_white.size())
+    const std::shared_ptr<const peerlist_snapshot> peers = get_snapshot(true);
+    if(i >= peers->peers.size())
       return false;
 
-    peers_indexed::index<by_time>::type& by_time_index = m_peers_white.get<by_time>();
-    p = *epee::misc_utils::move_it_backward(--by_time_index.end(), i);    
+    p = peers->peers[i].peer;
     return true;
   }
   //--------------------------------------------------------------------------------------------------
   inline
     bool peerlist_manager::get_gray_peer_by_index(peerlist_entry& p, size_t i)
   {
-    CRITICAL_REGION_LOCAL(m_peerlist_lock);
-    if(i >= m_peers_gray.size())
+    const std::shared_ptr<const peerlist_snapshot> peers = get_snapshot(false);
+    if(i >= peers->peers.size())
       return false;
 
-    peers_indexed::index<by_time>::type& by_time_index = m_peers_gray.get<by_time>();
-    p = *epee::misc_utils::move_it_backward(--by_time_index.end(), i);    
+    p = peers->peers[i].peer;
     return true;
   }
   //--------------------------------------------------------------------------------------------------
@@ -349,6 +377,7 @@ namespace nodetool
       //put new record into white list
       evict_host_from_peerlist(true, ple);
       m_peers_white.insert(ple);
+      white_changed();
       trim_white_peerlist();
     }else
     {
@@ -361,12 +390,14 @@ namespace nodetool
       if (!trust_last_seen)
         new_ple.last_seen = by_addr_it_wt->last_seen; // do not overwrite the last seen timestamp, incoming peer lists are untrusted
       m_peers_white.replace(by_addr_it_wt, new_ple);
+      white_changed();
     }
     //remove from gray list, if need
     auto by_addr_it_gr = m_peers_gray.get<by_addr>().find(ple.adr);
     if(by_addr_it_gr != m_peers_gray.get<by_addr>().end())
     {
       m_peers_gray.erase(by_addr_it_gr);
+      gray_changed();
     }
     return true;
     CATCH_ENTRY_L0("peerlist_manager::append_with_peer_white()", false);
@@ -391,6 +422,7 @@ namespace nodetool
     {
       //put new record into white list
       m_peers_gray.insert(ple);
+      gray_changed();
       trim_gray_peerlist();    
     }else
     {
@@ -401,7 +433,13 @@ namespace nodetool
       if (by_addr_it_gr->rpc_port && ple.rpc_port == 0) // guard against older nodes not passing RPC port around
         new_ple.rpc_port = by_addr_it_gr->rpc_port;
       new_ple.last_seen = by_addr_it_gr->last_seen; // do not overwrite the last seen timestamp, incoming peer list are untrusted
-      m_peers_gray.replace(by_addr_it_gr, new_ple);
+      // peers keep sending the same entries, do not invalidate the snapshot for those
+      if (new_ple.id != by_addr_it_gr->id || new_ple.pruning_seed != by_addr_it_gr->pruning_seed ||
+          new_ple.rpc_port != by_addr_it_gr->rpc_port || new_ple.rpc_credits_per_hash != by_addr_it_gr->rpc_credits_per_hash)
+      {
+        m_peers_gray.replace(by_addr_it_gr, new_ple);
+        gray_changed();
+      }
     }
     return true;
     CATCH_ENTRY_L0("peerlist_manager::append_with_peer_gray()", false);
@@ -430,16 +468,13 @@ namespace nodetool
   {
     TRY_ENTRY();
 
-    CRITICAL_REGION_LOCAL(m_peerlist_lock);
+    const std::shared_ptr<const peerlist_snapshot> peers = get_snapshot(false);
 
-    if (m_peers_gray.empty()) {
+    if (peers->peers.empty()) {
       return false;
     }
 
-    size_t random_index = crypto::rand_idx(m_peers_gray.size());
-
-    peers_indexed::index<by_time>::type& by_time_index = m_peers_gray.get<by_time>();
-    pe = *epee::misc_utils::move_it_backward(--by_time_index.end(), random_index);
+    pe = peers->peers[crypto::rand_idx(peers->peers.size())].peer;
 
     return true;
 
@@ -457,6 +492,7 @@ namespace nodetool
 
     if (iterator != m_peers_white.get<by_addr>().end()) {
       m_peers_white.erase(iterator);
+      white_changed();
     }
 
     return true;
@@ -475,6 +511,7 @@ namespace nodetool
 
     if (iterator != m_peers_gray.get<by_addr>().end()) {
       m_peers_gray.erase(iterator);
+      gray_changed();
     }
 
     return true;
@@ -538,6 +575,11 @@ namespace nodetool
       else
         ++i;
     }
+    if (filtered)
+    {
+      white_changed();
+      gray_changed();
+    }
     CATCH_ENTRY_L0("peerlist_manager::filter()", filtered);
     return filtered;
   }
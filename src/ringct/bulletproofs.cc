@@ -30,11 +30,13 @@
 // Paper references are to https://eprint.iacr.org/2017/1066 (revision 1 July 2018)
 
 #include <stdlib.h>
+#include <type_traits>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/lock_guard.hpp>
 #include "misc_log_ex.h"
 #include "span.h"
 #include "common/perf_timer.h"
+#include "common/threadpool.h"
 #include "cryptonote_config.h"
 extern "C"
 {
@@ -72,11 +74,11 @@ static constexpr size_t maxN = 64;
 static constexpr size_t maxM = BULLETPROOF_MAX_OUTPUTS;
 static rct::key Hi[maxN*maxM], Gi[maxN*maxM];
 static ge_p3 Hi_p3[maxN*maxM], Gi_p3[maxN*maxM];
+static ge_cached Hi_cached[maxN*maxM], Gi_cached[maxN*maxM];
 static std::shared_ptr<straus_cached_data> straus_HiGi_cache;
 static std::shared_ptr<pippenger_cached_data> pippenger_HiGi_cache;
 static const rct::key TWO = { {0x02, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00  } };
 static const rct::key MINUS_ONE = { { 0xec, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10 } };
-static const rct::key MINUS_INV_EIGHT = { { 0x74, 0xa4, 0x19, 0x7a, 0xf0, 0x7d, 0x0b, 0xf7, 0x05, 0xc2, 0xda, 0x25, 0x2b, 0x5c, 0x0b, 0x0d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a } };
 static const rct::keyV oneN = vector_dup(rct::identity(), maxN);
 static const rct::keyV twoN = vector_powers(TWO, maxN);
 static const rct::key ip12 = inner_product(oneN, twoN);
@@ -125,6 +127,8 @@ static void init_exponents()
     CHECK_AND_ASSERT_THROW_MES(ge_frombytes_vartime(&Hi_p3[i], Hi[i].bytes) == 0, "ge_frombytes_vartime failed");
     Gi[i] = get_exponent(rct::H, i * 2 + 1);
     CHECK_AND_ASSERT_THROW_MES(ge_frombytes_vartime(&Gi_p3[i], Gi[i].bytes) == 0, "ge_frombytes_vartime failed");
+    ge_p3_to_cached(&Hi_cached[i], &Hi_p3[i]);
+    ge_p3_to_cached(&Gi_cached[i], &Gi_p3[i]);
 
     data.push_back({rct::zero(), Gi_p3[i]});
     data.push_back({rct::zero(), Hi_p3[i]});
@@ -135,9 +139,10 @@ static void init_exponents()
 
   MINFO("Hi/Gi cache size: " << (sizeof(Hi)+sizeof(Gi))/1024 << " kB");
   MINFO("Hi_p3/Gi_p3 cache size: " << (sizeof(Hi_p3)+sizeof(Gi_p3))/1024 << " kB");
+  MINFO("Hi_cached/Gi_cached cache size: " << (sizeof(Hi_cached)+sizeof(Gi_cached))/1024 << " kB");
   MINFO("Straus cache size: " << straus_get_cache_size(straus_HiGi_cache)/1024 << " kB");
   MINFO("Pippenger cache size: " << pippenger_get_cache_size(pippenger_HiGi_cache)/1024 << " kB");
-  size_t cache_size = (sizeof(Hi)+sizeof(Hi_p3))*2 + straus_get_cache_size(straus_HiGi_cache) + pippenger_get_cache_size(pippenger_HiGi_cache);
+  size_t cache_size = (sizeof(Hi)+sizeof(Hi_p3)+sizeof(Hi_cached))*2 + straus_get_cache_size(straus_HiGi_cache) + pippenger_get_cache_size(pippenger_HiGi_cache);
   MINFO("Total cache size: " << cache_size/1024 << "kB");
   init_done = true;
 }
@@ -158,8 +163,46 @@ static rct::key vector_exponent(const rct::keyV &a, const rct::keyV &b)
   return multiexp(multiexp_data, 2 * a.size());
 }
 
+/* Replace r with p if b is 1, keep it if b is 0, without branching on b */
+static void ge_p1p1_cmov(ge_p1p1 *r, const ge_p1p1 *p, unsigned int b)
+{
+  typedef std::remove_extent<fe>::type limb;
+  const limb mask = limb(0) - limb(b);
+  for (size_t i = 0; i < sizeof(fe) / sizeof(limb); ++i)
+  {
+    r->X[i] ^= (r->X[i] ^ p->X[i]) & mask;
+    r->Y[i] ^= (r->Y[i] ^ p->Y[i]) & mask;
+    r->Z[i] ^= (r->Z[i] ^ p->Z[i]) & mask;
+    r->T[i] ^= (r->T[i] ^ p->T[i]) & mask;
+  }
+}
+
+/* Given the bit vector aL, construct the vector commitment to aL/8 and aR/8.
+ * Each aL8 entry is 0 or 1/8 and each aR8 entry is 0 or -1/8, so this is
+ * (sum of Gi over set bits - sum of Hi over unset bits) / 8, which only
+ * needs point additions against the cached generators and one final scalarmult.
+ * The bits are secret: both sums are computed at each step and the result
+ * is selected in constant time */
+static rct::key bit_vector_exponent8(const rct::keyV &aL)
+{
+  CHECK_AND_ASSERT_THROW_MES(aL.size() <= maxN*maxM, "Incompatible sizes of aL and maxN");
+
+  ge_p3 acc = ge_p3_identity;
+  ge_p1p1 p1, p1_set;
+  for (size_t i = 0; i < aL.size(); ++i)
+  {
+    ge_sub(&p1, &acc, &Hi_cached[i]);
+    ge_add(&p1_set, &acc, &Gi_cached[i]);
+    ge_p1p1_cmov(&p1, &p1_set, aL[i].bytes[0] & 1);
+    ge_p1p1_to_p3(&acc, &p1);
+  }
+  rct::key res;
+  ge_p3_tobytes(res.bytes, &acc);
+  return rct::scalarmultKey(res, INV_EIGHT);
+}
+
 /* Compute a custom vector-scalar commitment */
-static rct::key cross_vector_exponent8(size_t size, const std::vector<ge_p3> &A, size_t Ao, const std::vector<ge_p3> &B, size_t Bo, const rct::keyV &a, size_t ao, const rct::keyV &b, size_t bo, const rct::keyV *scale, const ge_p3 *extra_point, const rct::key *extra_scalar)
+static rct::key cross_vector_exponent8(size_t size, const std::vector<ge_p3> &A, size_t Ao, const std::vector<ge_p3> &B, size_t Bo, const rct::keyV &a, size_t ao, const rct::keyV &b, size_t bo, const rct::keyV *scale, const ge_p3 *extra_point, const rct::key *extra_scalar, std::vector<MultiexpData> &multiexp_data)
 {
   CHECK_AND_ASSERT_THROW_MES(size + Ao <= A.size(), "Incompatible size for A");
   CHECK_AND_ASSERT_THROW_MES(size + Bo <= B.size(), "Incompatible size for B");
@@ -169,7 +212,7 @@ static rct::key cross_vector_exponent8(size_t size, const std::vector<ge_p3> &A,
   CHECK_AND_ASSERT_THROW_MES(!scale || size == scale->size() / 2, "Incompatible size for scale");
   CHECK_AND_ASSERT_THROW_MES(!!extra_point == !!extra_scalar, "only one of extra point/scalar present");
 
-  std::vector<MultiexpData> multiexp_data;
+  // multiexp_data is caller owned scratch, reused across the inner product rounds
   multiexp_data.resize(size*2 + (!!extra_point));
   for (size_t i = 0; i < size; ++i)
   {
@@ -268,12 +311,11 @@ static rct::keyV hadamard(const rct::keyV &a, const rct::keyV &b)
   return res;
 }
 
-/* folds a curvepoint array using a two way scaled Hadamard product */
-static void hadamard_fold(std::vector<ge_p3> &v, const rct::keyV *scale, const rct::key &a, const rct::key &b)
+/* folds a range of a curvepoint array using a two way scaled Hadamard product */
+static void hadamard_fold_range(std::vector<ge_p3> &v, const rct::keyV *scale, const rct::key &a, const rct::key &b, size_t start, size_t stop)
 {
-  CHECK_AND_ASSERT_THROW_MES((v.size() & 1) == 0, "Vector size should be even");
   const size_t sz = v.size() / 2;
-  for (size_t n = 0; n < sz; ++n)
+  for (size_t n = start; n < stop; ++n)
   {
     ge_dsmp c[2];
     ge_dsm_precomp(c[0], &v[n]);
@@ -283,7 +325,37 @@ static void hadamard_fold(std::vector<ge_p3> &v, const rct::keyV *scale, const r
     if (scale) sc_mul(sb.bytes, b.bytes, (*scale)[sz + n].bytes); else sb = b;
     ge_double_scalarmult_precomp_vartime2_p3(&v[n], sa.bytes, c[0], sb.bytes, c[1]);
   }
-  v.resize(sz);
+}
+
+/* folds a curvepoint array using a two way scaled Hadamard product, splitting
+ * the work across the threadpool (the waiter is waited on by the caller) */
+static void hadamard_fold(std::vector<ge_p3> &v, const rct::keyV *scale, const rct::key &a, const rct::key &b, tools::threadpool::waiter &waiter)
+{
+  static constexpr size_t min_chunk = 16;
+  CHECK_AND_ASSERT_THROW_MES((v.size() & 1) == 0, "Vector size should be even");
+  const size_t sz = v.size() / 2;
+  tools::threadpool &tpool = tools::threadpool::getInstance();
+  const size_t threads = std::max<size_t>(1, std::min<size_t>(tpool.get_max_concurrency(), sz / min_chunk));
+  const size_t chunk = (sz + threads - 1) / threads;
+  for (size_t start = 0; start < sz; start += chunk)
+  {
+    const size_t stop = std::min(sz, start + chunk);
+    tpool.submit(&waiter, [&v, scale, &a, &b, start, stop]() { hadamard_fold_range(v, scale, a, b, start, stop); }, true);
+  }
+}
+
+/* folds a scalar array in place: a[n] = a[n] * x + a[n + sz] * y */
+static void scalar_fold(rct::keyV &a, const rct::key &x, const rct::key &y)
+{
+  CHECK_AND_ASSERT_THROW_MES((a.size() & 1) == 0, "Vector size should be even");
+  const size_t sz = a.size() / 2;
+  rct::key tmp;
+  for (size_t n = 0; n < sz; ++n)
+  {
+    sc_mul(tmp.bytes, a[sz + n].bytes, y.bytes);
+    sc_muladd(a[n].bytes, a[n].bytes, x.bytes, tmp.bytes);
+  }
+  a.resize(sz);
 }
 
 /* Add two vectors */
@@ -509,8 +581,8 @@ Bulletproof bulletproof_PROVE(const rct::keyV &sv, const rct::keyV &gamma)
 
   rct::keyV V(sv.size());
   rct::keyV aL(MN), aR(MN);
-  rct::keyV aL8(MN), aR8(MN);
   rct::key tmp, tmp2;
+  tools::threadpool &tpool = tools::threadpool::getInstance();
 
   PERF_TIMER_START_BP(PROVE_v);
   for (size_t i = 0; i < sv.size(); ++i)
@@ -531,14 +603,12 @@ Bulletproof bulletproof_PROVE(const rct::keyV &sv, const rct::keyV &gamma)
       if (j < sv.size() && (sv[j][i/8] & (((uint64_t)1)<<(i%8))))
       {
         aL[j*N+i] = rct::identity();
-        aL8[j*N+i] = INV_EIGHT;
-        aR[j*N+i] = aR8[j*N+i] = rct::zero();
+        aR[j*N+i] = rct::zero();
       }
       else
       {
-        aL[j*N+i] = aL8[j*N+i] = rct::zero();
+        aL[j*N+i] = rct::zero();
         aR[j*N+i] = MINUS_ONE;
-        aR8[j*N+i] = MINUS_INV_EIGHT;
       }
     }
   }
@@ -568,19 +638,22 @@ try_again:
   rct::key hash_cache = rct::hash_to_scalar(V);
 
   PERF_TIMER_START_BP(PROVE_step1);
-  // PAPER LINES 43-44
+  // PAPER LINES 43-47
   rct::key alpha = rct::skGen();
-  rct::key ve = vector_exponent(aL8, aR8);
-  rct::key A;
-  sc_mul(tmp.bytes, alpha.bytes, INV_EIGHT.bytes);
-  rct::addKeys(A, ve, rct::scalarmultBase(tmp));
-
-  // PAPER LINES 45-47
   rct::keyV sL = rct::skvGen(MN), sR = rct::skvGen(MN);
   rct::key rho = rct::skGen();
-  ve = vector_exponent(sL, sR);
+  rct::key ve_aLaR, ve_sLsR;
+  {
+    tools::threadpool::waiter waiter(tpool);
+    tpool.submit(&waiter, [&]() { ve_aLaR = bit_vector_exponent8(aL); }, true);
+    ve_sLsR = vector_exponent(sL, sR);
+    CHECK_AND_ASSERT_THROW_MES(waiter.wait(), "Failed to compute vector commitments");
+  }
+  rct::key A;
+  sc_mul(tmp.bytes, alpha.bytes, INV_EIGHT.bytes);
+  rct::addKeys(A, ve_aLaR, rct::scalarmultBase(tmp));
   rct::key S;
-  rct::addKeys(S, ve, rct::scalarmultBase(rho));
+  rct::addKeys(S, ve_sLsR, rct::scalarmultBase(rho));
   S = rct::scalarmultKey(S, INV_EIGHT);
 
   // PAPER LINES 48-50
@@ -720,12 +793,17 @@ try_again:
   rct::keyV R(logMN);
   int round = 0;
   rct::keyV w(logMN); // this is the challenge x in the inner product protocol
+  std::vector<MultiexpData> multiexp_data_L, multiexp_data_R;
+  multiexp_data_L.reserve(MN + 1);
+  multiexp_data_R.reserve(MN + 1);
   PERF_TIMER_STOP_BP(PROVE_step3);
 
   PERF_TIMER_START_BP(PROVE_step4);
   const rct::keyV *scale = &yinvpow;
   while (nprime > 1)
   {
+    tools::threadpool::waiter waiter(tpool);
+
     // PAPER LINE 20
     nprime /= 2;
 
@@ -738,9 +816,10 @@ try_again:
     // PAPER LINES 23-24
     PERF_TIMER_START_BP(PROVE_LR);
     sc_mul(tmp.bytes, cL.bytes, x_ip.bytes);
-    L[round] = cross_vector_exponent8(nprime, Gprime, nprime, Hprime, 0, aprime, 0, bprime, nprime, scale, &ge_p3_H, &tmp);
-    sc_mul(tmp.bytes, cR.bytes, x_ip.bytes);
-    R[round] = cross_vector_exponent8(nprime, Gprime, 0, Hprime, nprime, aprime, nprime, bprime, 0, scale, &ge_p3_H, &tmp);
+    sc_mul(tmp2.bytes, cR.bytes, x_ip.bytes);
+    tpool.submit(&waiter, [&]() { L[round] = cross_vector_exponent8(nprime, Gprime, nprime, Hprime, 0, aprime, 0, bprime, nprime, scale, &ge_p3_H, &tmp, multiexp_data_L); }, true);
+    R[round] = cross_vector_exponent8(nprime, Gprime, 0, Hprime, nprime, aprime, nprime, bprime, 0, scale, &ge_p3_H, &tmp2, multiexp_data_R);
+    CHECK_AND_ASSERT_THROW_MES(waiter.wait(), "Failed to compute L/R");
     PERF_TIMER_STOP_BP(PROVE_LR);
 
     // PAPER LINES 25-27
@@ -757,17 +836,24 @@ try_again:
     if (nprime > 1)
     {
       PERF_TIMER_START_BP(PROVE_hadamard2);
-      hadamard_fold(Gprime, NULL, winv, w[round]);
-      hadamard_fold(Hprime, scale, w[round], winv);
-      PERF_TIMER_STOP_BP(PROVE_hadamard2);
+      hadamard_fold(Gprime, NULL, winv, w[round], waiter);
+      hadamard_fold(Hprime, scale, w[round], winv, waiter);
     }
 
     // PAPER LINES 33-34
     PERF_TIMER_START_BP(PROVE_prime);
-    aprime = vector_add(vector_scalar(slice(aprime, 0, nprime), w[round]), vector_scalar(slice(aprime, nprime, aprime.size()), winv));
-    bprime = vector_add(vector_scalar(slice(bprime, 0, nprime), winv), vector_scalar(slice(bprime, nprime, bprime.size()), w[round]));
+    scalar_fold(aprime, w[round], winv);
+    scalar_fold(bprime, winv, w[round]);
     PERF_TIMER_STOP_BP(PROVE_prime);
 
+    if (nprime > 1)
+    {
+      CHECK_AND_ASSERT_THROW_MES(waiter.wait(), "Failed to fold generators");
+      Gprime.resize(nprime);
+      Hprime.resize(nprime);
+      PERF_TIMER_STOP_BP(PROVE_hadamard2);
+    }
+
     scale = NULL;
     ++round;
   }
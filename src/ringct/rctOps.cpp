@@ -329,8 +329,11 @@ namespace rct {
             return it->commitment;
         }
         key am = d2h(amount);
-        key bH = scalarmultH(am);
-        return addKeys(G, bH);
+        ge_p2 R;
+        ge_double_scalarmult_base_vartime_H(&R, am.bytes, identity().bytes);
+        key res;
+        ge_tobytes(res.bytes, &R);
+        return res;
     }
 
     key commit(xmr_amount amount, const key &mask) {
@@ -394,6 +397,15 @@ namespace rct {
         return aP;
     }
 
+    //Computes aH where a is public, using the fixed H table
+    key scalarmultH_vartime(const key & a) {
+        ge_p2 R;
+        ge_double_scalarmult_base_vartime_H(&R, a.bytes, zero().bytes);
+        key aP;
+        ge_tobytes(aP.bytes, &R);
+        return aP;
+    }
+
     //Computes 8P
     key scalarmult8(const key & P) {
         ge_p3 p3;
@@ -477,6 +489,12 @@ namespace rct {
     //aGbB = aG + bB where a, b are scalars, G is the basepoint and B is a point
     void addKeys2(key &aGbB, const key &a, const key &b, const key & B) {
         ge_p2 rv;
+        if (B == H)
+        {
+            ge_double_scalarmult_base_vartime_H(&rv, b.bytes, a.bytes);
+            ge_tobytes(aGbB.bytes, &rv);
+            return;
+        }
         ge_p3 B2;
         CHECK_AND_ASSERT_THROW_MES_L1(ge_frombytes_vartime(&B2, B.bytes) == 0, "ge_frombytes_vartime failed at "+boost::lexical_cast<std::string>(__LINE__));
         ge_double_scalarmult_base_vartime(&rv, b.bytes, &B2, a.bytes);
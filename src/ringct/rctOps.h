@@ -122,6 +122,8 @@ namespace rct {
     key scalarmultKey(const key &P, const key &a);
     //Computes aH where H= toPoint(cn_fast_hash(G)), G the basepoint
     key scalarmultH(const key & a);
+    //Same, using the precomputed H table, in variable time: for public scalars only
+    key scalarmultH_vartime(const key & a);
     // multiplies a point by 8
     key scalarmult8(const key & P);
     void scalarmult8(ge_p3 &res, const key & P);
@@ -137,6 +139,7 @@ namespace rct {
     //aGB = aG + B where a is a scalar, G is the basepoint, and B is a point
     void addKeys1(key &aGB, const key &a, const key & B);
     //aGbB = aG + bB where a, b are scalars, G is the basepoint and B is a point
+    //(B == H uses the precomputed H table)
     void addKeys2(key &aGbB, const key &a, const key &b, const key &B);
     //Does some precomputation to make addKeys3 more efficient
     // input B a curve point and output a ge_dsmp which has precomputation applied
@@ -1043,7 +1043,7 @@ namespace rct {
         {
           rv.txnFee = 0;
         }
-        key txnFeeKey = scalarmultH(d2h(rv.txnFee));
+        key txnFeeKey = scalarmultH_vartime(d2h(rv.txnFee));
 
         rv.mixRing = mixRing;
         if (msout)
@@ -1220,6 +1220,16 @@ namespace rct {
             msout->c.resize(inamounts.size());
             msout->mu_p.resize(rv.type == RCTTypeCLSAG ? inamounts.size() : 0);
         }
+        if (rv.type == RCTTypeCLSAG && !kLRki && !msout && inamounts.size() > 1 && hwdev.get_type() == hw::device::SOFTWARE)
+        {
+            // software signing keeps no state between inputs, so sign them concurrently
+            tools::threadpool& tpool = tools::threadpool::getInstance();
+            tools::threadpool::waiter waiter(tpool);
+            for (size_t n = 0; n < inamounts.size(); ++n)
+                tpool.submit(&waiter, [&, n] { rv.p.CLSAGs[n] = proveRctCLSAGSimple(full_message, rv.mixRing[n], inSk[n], a[n], pseudoOuts[n], NULL, NULL, NULL, index[n], hwdev); });
+            CHECK_AND_ASSERT_THROW_MES(waiter.wait(), "Failed to generate CLSAG signatures");
+            return rv;
+        }
         for (i = 0 ; i < inamounts.size(); i++)
         {
             if (rv.type == RCTTypeCLSAG)
@@ -1294,7 +1304,7 @@ namespace rct {
 
           if (!semantics) {
             //compute txn fee
-            key txnFeeKey = scalarmultH(d2h(rv.txnFee));
+            key txnFeeKey = scalarmultH_vartime(d2h(rv.txnFee));
             bool mgVerd = verRctMG(rv.p.MGs[0], rv.mixRing, rv.outPk, txnFeeKey, get_pre_mlsag_hash(rv, hw::get_device("default")));
             DP("mg sig verified?");
             DP(mgVerd);
@@ -1379,7 +1389,7 @@ namespace rct {
           }
           key sumOutpks = addKeys(masks);
           DP(sumOutpks);
-          const key txnFeeKey = scalarmultH(d2h(rv.txnFee));
+          const key txnFeeKey = scalarmultH_vartime(d2h(rv.txnFee));
           addKeys(sumOutpks, txnFeeKey, sumOutpks);
 
           key sumPseudoOuts = addKeys(pseudoOuts);
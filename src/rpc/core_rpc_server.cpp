@@ -48,6 +48,7 @@ using namespace epee;
 #include "cryptonote_basic/merge_mining.h"
 #include "cryptonote_core/tx_sanity_check.h"
 #include "misc_language.h"
+#include "net/http_request_parser.h"
 #include "net/parse.h"
 #include "storages/http_abstract_invoke.h"
 #include "crypto/hash.h"
@@ -55,6 +56,7 @@ using namespace epee;
 #include "rpc/rpc_handler.h"
 #include "rpc/rpc_payment_costs.h"
 #include "rpc/rpc_payment_signature.h"
+#include "rpc/scan_record.h"
 #include "core_rpc_server_error_codes.h"
 #include "p2p/net_node.h"
 #include "version.h"
@@ -73,6 +75,7 @@ using namespace epee;
 #define RESTRICTED_BLOCK_HEADER_RANGE 1000
 #define RESTRICTED_TRANSACTIONS_COUNT 100
 #define RESTRICTED_SPENT_KEY_IMAGES_COUNT 5000
+#define RESTRICTED_OUTPUT_KEYS_COUNT 5000
 #define RESTRICTED_BLOCK_COUNT 1000
 
 #define RPC_TRACKER(rpc) \
@@ -143,6 +146,27 @@ namespace
   {
     store_128(difficulty, sdiff, swdiff, stop64);
   }
+
+  bool is_light_wallet_output_unlocked(const cryptonote::light_wallet::output &out, uint64_t chain_height)
+  {
+    if (out.height + CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE > chain_height)
+      return false;
+    if (out.unlock_time < CRYPTONOTE_MAX_BLOCK_NUMBER)
+      return chain_height - 1 + CRYPTONOTE_LOCKED_TX_ALLOWED_DELTA_BLOCKS >= out.unlock_time;
+    return (uint64_t)time(NULL) + CRYPTONOTE_LOCKED_TX_ALLOWED_DELTA_SECONDS_V2 >= out.unlock_time;
+  }
+
+  template<typename T>
+  T make_light_wallet_spent_output(const cryptonote::light_wallet::spend &s)
+  {
+    T out;
+    out.amount = s.amount;
+    out.key_image = epee::string_tools::pod_to_hex(s.key_image);
+    out.tx_pub_key = epee::string_tools::pod_to_hex(s.tx_pub_key);
+    out.out_index = s.out_index;
+    out.mixin = s.mixin;
+    return out;
+  }
 }
 
 namespace cryptonote
@@ -173,6 +197,7 @@ namespace cryptonote
     , m_was_bootstrap_ever_used(false)
     , disable_rpc_ban(false)
     , m_rpc_payment_allow_free_loopback(false)
+    , m_get_blocks_cache(COMMAND_RPC_GET_BLOCKS_FAST_CACHE_SIZE)
   {}
   //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::set_bootstrap_daemon(
@@ -611,62 +636,133 @@ namespace cryptonote
       }
     }
 
-    std::vector<std::pair<std::pair<cryptonote::blobdata, crypto::hash>, std::vector<std::pair<crypto::hash, cryptonote::blobdata> > > > bs;
-    if(!m_core.find_blockchain_supplement(req.start_height, req.block_ids, bs, res.current_height, res.start_height, req.prune, !req.no_miner_tx, max_blocks, COMMAND_RPC_GET_BLOCKS_FAST_MAX_TX_COUNT))
+    const uint8_t cache_flags = get_blocks_cache::make_flags(req.prune, req.no_miner_tx, req.compact);
+    std::vector<std::shared_ptr<const get_blocks_cache::entry>> entries;
+
+    // blocks deep enough to be cached are served without the database, up to
+    // the first one missing from the cache
+    uint64_t start_height = req.start_height;
+    const uint64_t current_height = m_core.get_current_blockchain_height();
+    if (req.start_height > 0 ? req.start_height < current_height : m_core.get_blockchain_storage().find_blockchain_supplement(req.block_ids, start_height))
     {
-      res.status = "Failed";
-      add_host_fail(ctx);
-      return true;
+      size_t size = 0, ntxes = 0;
+      for (uint64_t height = start_height; height + COMMAND_RPC_GET_BLOCKS_FAST_CACHE_MIN_DEPTH <= current_height && entries.size() < max_blocks; ++height)
+      {
+        std::shared_ptr<const get_blocks_cache::entry> e = m_get_blocks_cache.get(height, cache_flags);
+        if (!e || e->block_id != m_core.get_block_id_by_height(height))
+          break;
+        if (!entries.empty() && (ntxes + e->tx_count > COMMAND_RPC_GET_BLOCKS_FAST_MAX_TX_COUNT || (size >= FIND_BLOCKCHAIN_SUPPLEMENT_MAX_SIZE && entries.size() >= 3)))
+          break;
+        size += e->size;
+        ntxes += e->tx_count;
+        entries.push_back(std::move(e));
+      }
     }
 
-    CHECK_PAYMENT_SAME_TS(req, res, bs.size() * COST_PER_BLOCK);
+    if (!entries.empty())
+    {
+      res.start_height = start_height;
+      res.current_height = current_height;
+    }
+    else
+    {
+      // scan records never need the prunable data, so don't load it
+      std::vector<std::pair<std::pair<cryptonote::blobdata, crypto::hash>, std::vector<std::pair<crypto::hash, cryptonote::blobdata> > > > bs;
+      if(!m_core.find_blockchain_supplement(req.start_height, req.block_ids, bs, res.current_height, res.start_height, req.prune || req.compact, !req.no_miner_tx, max_blocks, COMMAND_RPC_GET_BLOCKS_FAST_MAX_TX_COUNT))
+      {
+        res.status = "Failed";
+        add_host_fail(ctx);
+        return true;
+      }
 
-    size_t size = 0, ntxes = 0;
-    res.blocks.reserve(bs.size());
-    res.output_indices.reserve(bs.size());
-    for(auto& bd: bs)
-    {
-      res.blocks.resize(res.blocks.size()+1);
-      res.blocks.back().pruned = req.prune;
-      res.blocks.back().block = bd.first.first;
-      size += bd.first.first.size();
-      res.output_indices.push_back(COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices());
-      ntxes += bd.second.size();
-      res.output_indices.back().indices.reserve(1 + bd.second.size());
-      if (req.no_miner_tx)
-        res.output_indices.back().indices.push_back(COMMAND_RPC_GET_BLOCKS_FAST::tx_output_indices());
-      res.blocks.back().txs.reserve(bd.second.size());
-      for (std::vector<std::pair<crypto::hash, cryptonote::blobdata>>::iterator i = bd.second.begin(); i != bd.second.end(); ++i)
-      {
-        res.blocks.back().txs.push_back({std::move(i->second), crypto::null_hash});
-        i->second.clear();
-        i->second.shrink_to_fit();
-        size += res.blocks.back().txs.back().blob.size();
-      }
-
-      const size_t n_txes_to_lookup = bd.second.size() + (req.no_miner_tx ? 0 : 1);
-      if (n_txes_to_lookup > 0)
-      {
-        std::vector<std::vector<uint64_t>> indices;
-        bool r = m_core.get_tx_outputs_gindexs(req.no_miner_tx ? bd.second.front().first : bd.first.second, n_txes_to_lookup, indices);
-        if (!r)
-        {
-          res.status = "Failed";
-          return true;
-        }
-        if (indices.size() != n_txes_to_lookup || res.output_indices.back().indices.size() != (req.no_miner_tx ? 1 : 0))
+      entries.reserve(bs.size());
+      for (size_t i = 0; i < bs.size(); ++i)
+      {
+        std::shared_ptr<get_blocks_cache::entry> e = std::make_shared<get_blocks_cache::entry>();
+        if (!make_get_blocks_entry(req, bs[i], *e))
         {
           res.status = "Failed";
           return true;
         }
-        for (size_t i = 0; i < indices.size(); ++i)
-          res.output_indices.back().indices.push_back({std::move(indices[i])});
+        const uint64_t height = res.start_height + i;
+        if (height + COMMAND_RPC_GET_BLOCKS_FAST_CACHE_MIN_DEPTH <= res.current_height)
+          m_get_blocks_cache.add(height, cache_flags, e);
+        entries.push_back(std::move(e));
       }
     }
 
-    MDEBUG("on_get_blocks: " << bs.size() << " blocks, " << ntxes << " txes, size " << size);
+    CHECK_PAYMENT_SAME_TS(req, res, entries.size() * COST_PER_BLOCK);
+
+    size_t size = 0, ntxes = 0;
+    if (req.compact)
+      res.scan_records.reserve(entries.size());
+    else
+      res.blocks.reserve(entries.size());
+    res.output_indices.reserve(entries.size());
+    for (const std::shared_ptr<const get_blocks_cache::entry> &e: entries)
+    {
+      if (req.compact)
+        res.scan_records.push_back(e->scan_record);
+      else
+        res.blocks.push_back(e->block);
+      res.output_indices.push_back(e->output_indices);
+      size += e->size;
+      ntxes += e->tx_count;
+    }
+
+    MDEBUG("on_get_blocks: " << entries.size() << " blocks, " << ntxes << " txes, size " << size << (req.compact ? " (compact)" : ""));
     res.status = CORE_RPC_STATUS_OK;
     return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::make_get_blocks_entry(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, std::pair<std::pair<cryptonote::blobdata, crypto::hash>, std::vector<std::pair<crypto::hash, cryptonote::blobdata>>> &bd, get_blocks_cache::entry &e)
+  {
+    block b;
+    if (!parse_and_validate_block_from_blob(bd.first.first, b))
+      return false;
+    e.block_id = get_block_hash(b);
+    e.tx_count = bd.second.size();
+    e.size = bd.first.first.size();
+    for (const auto &tx_entry: bd.second)
+      e.size += tx_entry.second.size();
+
+    if (req.compact)
+    {
+      // bd.first.second is the miner tx hash, set when the miner tx was requested
+      if (!rpc::make_scan_record(b, e.block_id, bd.first.second, bd.second, req.no_miner_tx, e.scan_record))
+        return false;
+      // what the record holds, rather than the blobs it was built from
+      e.size = sizeof(e.scan_record) + rpc::get_scan_record_size(e.scan_record);
+    }
+    else
+    {
+      e.block.pruned = req.prune;
+      e.block.block = std::move(bd.first.first);
+      e.block.txs.reserve(bd.second.size());
+      for (auto &tx_entry: bd.second)
+        e.block.txs.push_back({std::move(tx_entry.second), crypto::null_hash});
+    }
+
+    e.output_indices.indices.reserve(1 + bd.second.size());
+    if (req.no_miner_tx)
+      e.output_indices.indices.push_back(COMMAND_RPC_GET_BLOCKS_FAST::tx_output_indices());
+
+    const size_t n_txes_to_lookup = bd.second.size() + (req.no_miner_tx ? 0 : 1);
+    if (n_txes_to_lookup > 0)
+    {
+      std::vector<std::vector<uint64_t>> indices;
+      bool r = m_core.get_tx_outputs_gindexs(req.no_miner_tx ? bd.second.front().first : bd.first.second, n_txes_to_lookup, indices);
+      if (!r)
+        return false;
+      if (indices.size() != n_txes_to_lookup || e.output_indices.indices.size() != (req.no_miner_tx ? 1 : 0))
+        return false;
+      for (size_t i = 0; i < indices.size(); ++i)
+      {
+        e.size += indices[i].size() * sizeof(uint64_t);
+        e.output_indices.indices.push_back({std::move(indices[i])});
+      }
+    }
+    return true;
   }
     bool core_rpc_server::on_get_alt_blocks_hashes(const COMMAND_RPC_GET_ALT_BLOCKS_HASHES::request& req, COMMAND_RPC_GET_ALT_BLOCKS_HASHES::response& res, const connection_context *ctx)
     {
@@ -1189,6 +1285,61 @@ namespace cryptonote
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::on_get_output_key_indices(const COMMAND_RPC_GET_OUTPUT_KEY_INDICES::request& req, COMMAND_RPC_GET_OUTPUT_KEY_INDICES::response& res, const connection_context *ctx)
+  {
+    RPC_TRACKER(get_output_key_indices);
+    bool ok;
+    if (use_bootstrap_daemon_if_necessary<COMMAND_RPC_GET_OUTPUT_KEY_INDICES>(invoke_http_mode::JON, "/get_output_key_indices", req, res, ok))
+      return ok;
+
+    const bool restricted = m_restricted && ctx;
+    if (restricted && req.output_keys.size() > RESTRICTED_OUTPUT_KEYS_COUNT)
+    {
+      res.status = "Too many output keys queried in restricted mode";
+      return true;
+    }
+
+    CHECK_PAYMENT_MIN1(req, res, req.output_keys.size() * COST_PER_OUTPUT_KEY, false);
+
+    std::vector<crypto::public_key> keys;
+    keys.reserve(req.output_keys.size());
+    for (const auto &key_hex_str: req.output_keys)
+    {
+      crypto::public_key key;
+      if (!epee::string_tools::hex_to_pod(key_hex_str, key))
+      {
+        res.status = "Failed to parse hex representation of output key";
+        return true;
+      }
+      keys.push_back(key);
+    }
+
+    std::vector<std::vector<cryptonote::output_key_index_t>> indices;
+    try
+    {
+      if (!m_core.get_blockchain_storage().get_db().get_output_key_indices(keys, indices))
+      {
+        res.status = "Output key index not available, restart the daemon with --db-output-key-index";
+        return true;
+      }
+    }
+    catch (const std::exception &e)
+    {
+      res.status = std::string("Failed to look up output keys: ") + e.what();
+      return true;
+    }
+
+    res.output_keys.resize(indices.size());
+    for (size_t n = 0; n < indices.size(); ++n)
+    {
+      for (const auto &oi: indices[n])
+        res.output_keys[n].outputs.push_back({oi.amount, oi.amount_index, epee::string_tools::pod_to_hex(oi.tx_hash), oi.local_index});
+    }
+
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::on_send_raw_tx(const COMMAND_RPC_SEND_RAW_TX::request& req, COMMAND_RPC_SEND_RAW_TX::response& res, const connection_context *ctx)
   {
     RPC_TRACKER(send_raw_tx);
@@ -1727,17 +1878,17 @@ namespace cryptonote
     return 0;
   }
   //------------------------------------------------------------------------------------------------------------------------------
-  bool core_rpc_server::get_block_template(const account_public_address &address, const crypto::hash *prev_block, const cryptonote::blobdata &extra_nonce, size_t &reserved_offset, cryptonote::difficulty_type  &difficulty, uint64_t &height, uint64_t &expected_reward, block &b, uint64_t &seed_height, crypto::hash &seed_hash, crypto::hash &next_seed_hash, epee::json_rpc::error &error_resp)
+  bool core_rpc_server::get_block_template(const account_public_address &address, const crypto::hash *prev_block, const cryptonote::blobdata &extra_nonce, size_t &reserved_offset, cryptonote::difficulty_type  &difficulty, uint64_t &height, uint64_t &expected_reward, block &b, cryptonote::blobdata &block_blob, crypto::hash &tree_root_hash, uint64_t &seed_height, crypto::hash &seed_hash, crypto::hash &next_seed_hash, epee::json_rpc::error &error_resp)
   {
     b = boost::value_initialized<cryptonote::block>();
-    if(!m_core.get_block_template(b, prev_block, address, difficulty, height, expected_reward, extra_nonce, seed_height, seed_hash))
+    if(!m_core.get_block_template(b, prev_block, address, difficulty, height, expected_reward, extra_nonce, seed_height, seed_hash, &tree_root_hash))
     {
       error_resp.code = CORE_RPC_ERROR_CODE_INTERNAL_ERROR;
       error_resp.message = "Internal error: failed to create block template";
       LOG_ERROR("Failed to create block template");
       return false;
     }
-    blobdata block_blob = t_serializable_object_to_blob(b);
+    block_blob = t_serializable_object_to_blob(b);
     crypto::public_key tx_pub_key = cryptonote::get_tx_pub_key_from_extra(b.miner_tx);
     if(tx_pub_key == crypto::null_pkey)
     {
@@ -1854,8 +2005,9 @@ namespace cryptonote
         return false;
       }
     }
-    crypto::hash seed_hash, next_seed_hash;
-    if (!get_block_template(info.address, req.prev_block.empty() ? NULL : &prev_block, blob_reserve, reserved_offset, wdiff, res.height, res.expected_reward, b, res.seed_height, seed_hash, next_seed_hash, error_resp))
+    crypto::hash seed_hash, next_seed_hash, tree_root_hash;
+    blobdata block_blob;
+    if (!get_block_template(info.address, req.prev_block.empty() ? NULL : &prev_block, blob_reserve, reserved_offset, wdiff, res.height, res.expected_reward, b, block_blob, tree_root_hash, res.seed_height, seed_hash, next_seed_hash, error_resp))
       return false;
     if (b.major_version >= RX_BLOCK_VERSION)
     {
@@ -1866,8 +2018,7 @@ namespace cryptonote
 
     res.reserved_offset = reserved_offset;
     store_difficulty(wdiff, res.difficulty, res.wide_difficulty, res.difficulty_top64);
-    blobdata block_blob = t_serializable_object_to_blob(b);
-    blobdata hashing_blob = get_block_hashing_blob(b);
+    blobdata hashing_blob = get_block_hashing_blob(b, tree_root_hash);
     res.prev_hash = string_tools::pod_to_hex(b.prev_id);
     res.blocktemplate_blob = string_tools::buff_to_hex_nodelimer(block_blob);
     res.blockhashing_blob =  string_tools::buff_to_hex_nodelimer(hashing_blob);
@@ -2094,11 +2245,44 @@ namespace cryptonote
       error_resp.message = "Wrong block blob";
       return false;
     }
-    
+
+    crypto::hash block_id;
+    if (!submit_block(blockblob, block_id, error_resp))
+      return false;
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::on_submitblock_bin(const COMMAND_RPC_SUBMITBLOCK_BIN::request& req, COMMAND_RPC_SUBMITBLOCK_BIN::response& res, const connection_context *ctx)
+  {
+    RPC_TRACKER(submitblock_bin);
+    {
+      boost::shared_lock<boost::shared_mutex> lock(m_bootstrap_daemon_mutex);
+      if (m_should_use_bootstrap_daemon)
+      {
+        res.status = "This command is unsupported for bootstrap daemon";
+        return true;
+      }
+    }
+    CHECK_CORE_READY();
+
+    // same checks as submit_block, minus the hex decoding
+    epee::json_rpc::error error_resp;
+    if (!submit_block(req.block_blob, res.block_id, error_resp))
+    {
+      res.status = error_resp.message;
+      return true;
+    }
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::submit_block(const cryptonote::blobdata &blockblob, crypto::hash &block_id, epee::json_rpc::error &error_resp)
+  {
     // Fixing of high orphan issue for most pools
     // Thanks Boolberry!
     block b;
-    if(!parse_and_validate_block_from_blob(blockblob, b))
+    if(!parse_and_validate_block_from_blob(blockblob, b, block_id))
     {
       error_resp.code = CORE_RPC_ERROR_CODE_WRONG_BLOCKBLOB;
       error_resp.message = "Wrong block blob";
@@ -2121,7 +2305,6 @@ namespace cryptonote
       error_resp.message = "Block not accepted";
       return false;
     }
-    res.status = CORE_RPC_STATUS_OK;
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
@@ -3096,6 +3279,207 @@ namespace cryptonote
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::get_light_wallet_account(const std::string &address, const std::string &view_key, light_wallet::account &account, uint64_t &scanned_height, std::string &reason)
+  {
+    address_parse_info info;
+    if (!get_account_address_from_str(info, nettype(), address) || info.is_subaddress)
+    {
+      reason = "Invalid address";
+      return false;
+    }
+    crypto::secret_key key;
+    if (!epee::string_tools::hex_to_pod(view_key, key) || !m_light_wallet->get_account(info.address, key, account, scanned_height))
+    {
+      reason = "Invalid view key or unknown account";
+      return false;
+    }
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::on_light_wallet_login(const tools::COMMAND_RPC_LOGIN::request& req, tools::COMMAND_RPC_LOGIN::response& res, const connection_context *ctx)
+  {
+    RPC_TRACKER(light_wallet_login);
+
+    res.new_address = false;
+    address_parse_info info;
+    if (!get_account_address_from_str(info, nettype(), req.address) || info.is_subaddress)
+    {
+      res.status = "error";
+      res.reason = "Invalid address";
+      return true;
+    }
+    crypto::secret_key view_key;
+    bool full = false;
+    if (!epee::string_tools::hex_to_pod(req.view_key, view_key) || !m_light_wallet->login(info.address, view_key, req.create_account, res.new_address, full))
+    {
+      res.status = "error";
+      res.reason = full ? "Account limit reached" : "Invalid view key or unknown account";
+      return true;
+    }
+    res.status = "success";
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::on_get_address_info(const tools::COMMAND_RPC_GET_ADDRESS_INFO::request& req, tools::COMMAND_RPC_GET_ADDRESS_INFO::response& res, const connection_context *ctx)
+  {
+    RPC_TRACKER(get_address_info);
+
+    light_wallet::account account;
+    uint64_t scanned_height = 0;
+    std::string reason;
+    if (!get_light_wallet_account(req.address, req.view_key, account, scanned_height, reason))
+    {
+      MDEBUG("get_address_info: " << reason);
+      return false; // the response has no status
+    }
+
+    const uint64_t chain_height = m_core.get_current_blockchain_height();
+    res.locked_funds = 0;
+    res.total_received = 0;
+    res.total_sent = 0;
+    for (const light_wallet::output &out: account.outputs)
+    {
+      res.total_received += out.amount;
+      if (!is_light_wallet_output_unlocked(out, chain_height))
+        res.locked_funds += out.amount;
+    }
+    for (const light_wallet::spend &s: account.spends)
+    {
+      res.total_sent += s.amount;
+      res.spent_outputs.push_back(make_light_wallet_spent_output<tools::COMMAND_RPC_GET_ADDRESS_INFO::spent_output>(s));
+    }
+    res.scanned_height = scanned_height ? scanned_height - 1 : 0;
+    res.scanned_block_height = res.scanned_height;
+    res.start_height = account.start_height;
+    res.blockchain_height = chain_height - 1;
+    res.transaction_height = res.blockchain_height;
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::on_get_address_txs(const tools::COMMAND_RPC_GET_ADDRESS_TXS::request& req, tools::COMMAND_RPC_GET_ADDRESS_TXS::response& res, const connection_context *ctx)
+  {
+    RPC_TRACKER(get_address_txs);
+
+    light_wallet::account account;
+    uint64_t scanned_height = 0;
+    if (!get_light_wallet_account(req.address, req.view_key, account, scanned_height, res.status))
+      return true;
+
+    const uint64_t chain_height = m_core.get_current_blockchain_height();
+    std::unordered_map<crypto::hash, size_t> positions;
+    const auto get_tx = [&](const crypto::hash &tx_hash, uint64_t height, uint64_t timestamp, uint64_t unlock_time, uint32_t mixin) -> tools::COMMAND_RPC_GET_ADDRESS_TXS::transaction&
+    {
+      const auto inserted = positions.emplace(tx_hash, res.transactions.size());
+      if (inserted.second)
+      {
+        res.transactions.emplace_back();
+        tools::COMMAND_RPC_GET_ADDRESS_TXS::transaction &tx = res.transactions.back();
+        tx.hash = epee::string_tools::pod_to_hex(tx_hash);
+        tx.timestamp = timestamp;
+        tx.total_received = 0;
+        tx.total_sent = 0;
+        tx.unlock_time = unlock_time;
+        tx.height = height;
+        tx.payment_id = epee::string_tools::pod_to_hex(crypto::null_hash);
+        tx.coinbase = false;
+        tx.mempool = false;
+        tx.mixin = mixin;
+      }
+      return res.transactions[inserted.first->second];
+    };
+
+    res.total_received = 0;
+    res.total_received_unlocked = 0;
+    for (const light_wallet::output &out: account.outputs)
+    {
+      tools::COMMAND_RPC_GET_ADDRESS_TXS::transaction &tx = get_tx(out.tx_hash, out.height, out.timestamp, out.unlock_time, out.mixin);
+      tx.total_received += out.amount;
+      tx.coinbase = out.coinbase;
+      if (out.payment_id != crypto::null_hash)
+        tx.payment_id = epee::string_tools::pod_to_hex(out.payment_id);
+      res.total_received += out.amount;
+      if (is_light_wallet_output_unlocked(out, chain_height))
+        res.total_received_unlocked += out.amount;
+    }
+    for (const light_wallet::spend &s: account.spends)
+    {
+      tools::COMMAND_RPC_GET_ADDRESS_TXS::transaction &tx = get_tx(s.tx_hash, s.height, s.timestamp, s.unlock_time, s.mixin);
+      tx.total_sent += s.amount;
+      tx.spent_outputs.push_back(make_light_wallet_spent_output<tools::COMMAND_RPC_GET_ADDRESS_TXS::spent_output>(s));
+    }
+
+    std::stable_sort(res.transactions.begin(), res.transactions.end(), [](const tools::COMMAND_RPC_GET_ADDRESS_TXS::transaction &a, const tools::COMMAND_RPC_GET_ADDRESS_TXS::transaction &b) { return a.height < b.height; });
+    for (size_t i = 0; i < res.transactions.size(); ++i)
+      res.transactions[i].id = i;
+
+    res.scanned_height = scanned_height ? scanned_height - 1 : 0;
+    res.scanned_block_height = res.scanned_height;
+    res.blockchain_height = chain_height - 1;
+    res.status = "success";
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::on_get_unspent_outs(const tools::COMMAND_RPC_GET_UNSPENT_OUTS::request& req, tools::COMMAND_RPC_GET_UNSPENT_OUTS::response& res, const connection_context *ctx)
+  {
+    RPC_TRACKER(get_unspent_outs);
+
+    light_wallet::account account;
+    uint64_t scanned_height = 0;
+    if (!get_light_wallet_account(req.address, req.view_key, account, scanned_height, res.reason))
+    {
+      res.status = "error";
+      return true;
+    }
+
+    uint64_t min_amount = 0, dust_threshold = 0;
+    if ((!req.amount.empty() && !epee::string_tools::get_xtype_from_string(min_amount, req.amount)) ||
+        (!req.dust_threshold.empty() && !epee::string_tools::get_xtype_from_string(dust_threshold, req.dust_threshold)))
+    {
+      res.status = "error";
+      res.reason = "Invalid amount";
+      return true;
+    }
+
+    // key images of the inputs that may spend each output, by tx key and output index
+    std::unordered_map<crypto::public_key, std::vector<std::pair<uint32_t, std::string>>> key_images;
+    for (const light_wallet::spend &s: account.spends)
+      key_images[s.tx_pub_key].emplace_back(s.out_index, epee::string_tools::pod_to_hex(s.key_image));
+
+    res.amount = 0;
+    for (const light_wallet::output &out: account.outputs)
+    {
+      if (out.amount < min_amount || (!req.use_dust && !out.rct && out.amount < dust_threshold))
+        continue;
+
+      tools::COMMAND_RPC_GET_UNSPENT_OUTS::output o;
+      o.amount = out.amount;
+      o.public_key = epee::string_tools::pod_to_hex(out.key);
+      o.index = out.index;
+      o.global_index = out.global_index;
+      if (out.rct)
+        o.rct = epee::string_tools::pod_to_hex(out.commitment) + epee::string_tools::pod_to_hex(out.encrypted_mask) + epee::string_tools::pod_to_hex(out.encrypted_amount);
+      o.tx_hash = epee::string_tools::pod_to_hex(out.tx_hash);
+      o.tx_pub_key = epee::string_tools::pod_to_hex(out.tx_pub_key);
+      o.tx_prefix_hash = epee::string_tools::pod_to_hex(out.tx_prefix_hash);
+      const auto spends = key_images.find(out.tx_pub_key);
+      if (spends != key_images.end())
+      {
+        for (const auto &s: spends->second)
+          if (s.first == out.index)
+            o.spend_key_images.push_back(s.second);
+      }
+      o.timestamp = out.timestamp;
+      o.height = out.height;
+      res.outputs.push_back(std::move(o));
+      res.amount += out.amount;
+    }
+
+    // wallet2 uses a grace of 10 blocks for its estimate too
+    res.per_kb_fee = m_core.get_blockchain_storage().get_dynamic_base_fee_estimate(10) * 1024;
+    res.status = "success";
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::on_relay_tx(const COMMAND_RPC_RELAY_TX::request& req, COMMAND_RPC_RELAY_TX::response& res, epee::json_rpc::error& error_resp, const connection_context *ctx)
   {
     RPC_TRACKER(relay_tx);
@@ -3301,7 +3685,7 @@ namespace cryptonote
 
     try
     {
-      if (!(req.check ? m_core.check_blockchain_pruning() : m_core.prune_blockchain()))
+      if (!(req.check ? m_core.check_blockchain_pruning() : req.background ? m_core.prune_blockchain_background() : m_core.prune_blockchain()))
       {
         error_resp.code = CORE_RPC_ERROR_CODE_INTERNAL_ERROR;
         error_resp.message = req.check ? "Failed to check blockchain pruning" : "Failed to prune blockchain";
@@ -3309,6 +3693,11 @@ namespace cryptonote
       }
       res.pruning_seed = m_core.get_blockchain_pruning_seed();
       res.pruned = res.pruning_seed != 0;
+      pruning_progress_t progress;
+      res.in_progress = m_core.get_pruning_progress(progress);
+      res.txes_done = progress.txes_done;
+      res.txes_total = progress.txes_total;
+      res.free_bytes = progress.free_pages * progress.page_size;
     }
     catch (const std::exception &e)
     {
@@ -3358,7 +3747,9 @@ namespace cryptonote
       cryptonote::difficulty_type difficulty;
       uint64_t height, expected_reward;
       size_t reserved_offset;
-      if (!get_block_template(m_rpc_payment->get_payment_address(), NULL, extra_nonce, reserved_offset, difficulty, height, expected_reward, b, seed_height, seed_hash, next_seed_hash, error_resp))
+      cryptonote::blobdata block_blob;
+      crypto::hash tree_root_hash;
+      if (!get_block_template(m_rpc_payment->get_payment_address(), NULL, extra_nonce, reserved_offset, difficulty, height, expected_reward, b, block_blob, tree_root_hash, seed_height, seed_hash, next_seed_hash, error_resp))
         return false;
       return true;
     }, hashing_blob, res.seed_height, seed_hash, top_hash, res.diff, res.credits_per_hash_found, res.credits, res.cookie))
@@ -3494,6 +3885,7 @@ namespace cryptonote
     if (req.clear)
     {
       RPCTracker::clear();
+      epee::net_utils::http::clear_request_parser_stats();
       res.status = CORE_RPC_STATUS_OK;
       return true;
     }
@@ -3508,6 +3900,14 @@ namespace cryptonote
       res.data.back().credits = d.second.credits;
     }
 
+    // time spent parsing HTTP requests, before any RPC handler runs
+    const epee::net_utils::http::request_parser_stats parser_stats = epee::net_utils::http::get_request_parser_stats();
+    res.data.resize(res.data.size() + 1);
+    res.data.back().rpc = "http:parse";
+    res.data.back().count = parser_stats.count;
+    res.data.back().time = parser_stats.time;
+    res.data.back().credits = 0;
+
     res.status = CORE_RPC_STATUS_OK;
     return true;
   }
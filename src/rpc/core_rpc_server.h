@@ -39,10 +39,13 @@
 #include "net/http_server_impl_base.h"
 #include "net/http_client.h"
 #include "core_rpc_server_commands_defs.h"
+#include "get_blocks_cache.h"
+#include "light_wallet_scanner.h"
 #include "cryptonote_core/cryptonote_core.h"
 #include "p2p/net_node.h"
 #include "cryptonote_protocol/cryptonote_protocol_handler.h"
 #include "rpc_payment.h"
+#include "wallet/wallet_light_rpc.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
 #define MONERO_DEFAULT_LOG_CATEGORY "daemon.rpc"
@@ -96,6 +99,9 @@ namespace cryptonote
       );
     network_type nettype() const { return m_core.get_nettype(); }
 
+    //! Serve the light wallet endpoints from `scanner`. Call before `run()`.
+    void set_light_wallet(std::shared_ptr<light_wallet::scanner> scanner) { m_light_wallet = std::move(scanner); }
+
     CHAIN_HTTP_TO_MAP2(connection_context); //forward http requests to uri map
 
     BEGIN_URI_MAP2()
@@ -109,10 +115,12 @@ namespace cryptonote
       MAP_URI_AUTO_BIN2("/gethashes.bin", on_get_hashes, COMMAND_RPC_GET_HASHES_FAST)
       MAP_URI_AUTO_BIN2("/get_o_indexes.bin", on_get_indexes, COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES)      
       MAP_URI_AUTO_BIN2("/get_outs.bin", on_get_outs_bin, COMMAND_RPC_GET_OUTPUTS_BIN)
+      MAP_URI_AUTO_BIN2("/submit_block.bin", on_submitblock_bin, COMMAND_RPC_SUBMITBLOCK_BIN)
       MAP_URI_AUTO_JON2("/get_transactions", on_get_transactions, COMMAND_RPC_GET_TRANSACTIONS)
       MAP_URI_AUTO_JON2("/gettransactions", on_get_transactions, COMMAND_RPC_GET_TRANSACTIONS)
       MAP_URI_AUTO_JON2("/get_alt_blocks_hashes", on_get_alt_blocks_hashes, COMMAND_RPC_GET_ALT_BLOCKS_HASHES)
       MAP_URI_AUTO_JON2("/is_key_image_spent", on_is_key_image_spent, COMMAND_RPC_IS_KEY_IMAGE_SPENT)
+      MAP_URI_AUTO_JON2("/get_output_key_indices", on_get_output_key_indices, COMMAND_RPC_GET_OUTPUT_KEY_INDICES)
       MAP_URI_AUTO_JON2("/send_raw_transaction", on_send_raw_tx, COMMAND_RPC_SEND_RAW_TX)
       MAP_URI_AUTO_JON2("/sendrawtransaction", on_send_raw_tx, COMMAND_RPC_SEND_RAW_TX)
       MAP_URI_AUTO_JON2_IF("/start_mining", on_start_mining, COMMAND_RPC_START_MINING, !m_restricted)
@@ -141,6 +149,10 @@ namespace cryptonote
       MAP_URI_AUTO_JON2_IF("/update", on_update, COMMAND_RPC_UPDATE, !m_restricted)
       MAP_URI_AUTO_BIN2("/get_output_distribution.bin", on_get_output_distribution_bin, COMMAND_RPC_GET_OUTPUT_DISTRIBUTION)
       MAP_URI_AUTO_JON2_IF("/pop_blocks", on_pop_blocks, COMMAND_RPC_POP_BLOCKS, !m_restricted)
+      MAP_URI_AUTO_JON2_IF("/login", on_light_wallet_login, tools::COMMAND_RPC_LOGIN, m_light_wallet && !m_restricted)
+      MAP_URI_AUTO_JON2_IF("/get_address_info", on_get_address_info, tools::COMMAND_RPC_GET_ADDRESS_INFO, m_light_wallet && !m_restricted)
+      MAP_URI_AUTO_JON2_IF("/get_address_txs", on_get_address_txs, tools::COMMAND_RPC_GET_ADDRESS_TXS, m_light_wallet && !m_restricted)
+      MAP_URI_AUTO_JON2_IF("/get_unspent_outs", on_get_unspent_outs, tools::COMMAND_RPC_GET_UNSPENT_OUTS, m_light_wallet && !m_restricted)
       BEGIN_JSON_RPC_MAP("/json_rpc")
         MAP_JON_RPC("get_block_count",           on_getblockcount,              COMMAND_RPC_GETBLOCKCOUNT)
         MAP_JON_RPC("getblockcount",             on_getblockcount,              COMMAND_RPC_GETBLOCKCOUNT)
@@ -198,12 +210,14 @@ namespace cryptonote
     bool on_get_hashes(const COMMAND_RPC_GET_HASHES_FAST::request& req, COMMAND_RPC_GET_HASHES_FAST::response& res, const connection_context *ctx = NULL);
     bool on_get_transactions(const COMMAND_RPC_GET_TRANSACTIONS::request& req, COMMAND_RPC_GET_TRANSACTIONS::response& res, const connection_context *ctx = NULL);
     bool on_is_key_image_spent(const COMMAND_RPC_IS_KEY_IMAGE_SPENT::request& req, COMMAND_RPC_IS_KEY_IMAGE_SPENT::response& res, const connection_context *ctx = NULL);
+    bool on_get_output_key_indices(const COMMAND_RPC_GET_OUTPUT_KEY_INDICES::request& req, COMMAND_RPC_GET_OUTPUT_KEY_INDICES::response& res, const connection_context *ctx = NULL);
     bool on_get_indexes(const COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::request& req, COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::response& res, const connection_context *ctx = NULL);
     bool on_send_raw_tx(const COMMAND_RPC_SEND_RAW_TX::request& req, COMMAND_RPC_SEND_RAW_TX::response& res, const connection_context *ctx = NULL);
     bool on_start_mining(const COMMAND_RPC_START_MINING::request& req, COMMAND_RPC_START_MINING::response& res, const connection_context *ctx = NULL);
     bool on_stop_mining(const COMMAND_RPC_STOP_MINING::request& req, COMMAND_RPC_STOP_MINING::response& res, const connection_context *ctx = NULL);
     bool on_mining_status(const COMMAND_RPC_MINING_STATUS::request& req, COMMAND_RPC_MINING_STATUS::response& res, const connection_context *ctx = NULL);
     bool on_get_outs_bin(const COMMAND_RPC_GET_OUTPUTS_BIN::request& req, COMMAND_RPC_GET_OUTPUTS_BIN::response& res, const connection_context *ctx = NULL);
+    bool on_submitblock_bin(const COMMAND_RPC_SUBMITBLOCK_BIN::request& req, COMMAND_RPC_SUBMITBLOCK_BIN::response& res, const connection_context *ctx = NULL);
     bool on_get_outs(const COMMAND_RPC_GET_OUTPUTS::request& req, COMMAND_RPC_GET_OUTPUTS::response& res, const connection_context *ctx = NULL);
     bool on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RPC_GET_INFO::response& res, const connection_context *ctx = NULL);
     bool on_get_net_stats(const COMMAND_RPC_GET_NET_STATS::request& req, COMMAND_RPC_GET_NET_STATS::response& res, const connection_context *ctx = NULL);
@@ -226,6 +240,10 @@ namespace cryptonote
     bool on_update(const COMMAND_RPC_UPDATE::request& req, COMMAND_RPC_UPDATE::response& res, const connection_context *ctx = NULL);
     bool on_get_output_distribution_bin(const COMMAND_RPC_GET_OUTPUT_DISTRIBUTION::request& req, COMMAND_RPC_GET_OUTPUT_DISTRIBUTION::response& res, const connection_context *ctx = NULL);
     bool on_pop_blocks(const COMMAND_RPC_POP_BLOCKS::request& req, COMMAND_RPC_POP_BLOCKS::response& res, const connection_context *ctx = NULL);
+    bool on_light_wallet_login(const tools::COMMAND_RPC_LOGIN::request& req, tools::COMMAND_RPC_LOGIN::response& res, const connection_context *ctx = NULL);
+    bool on_get_address_info(const tools::COMMAND_RPC_GET_ADDRESS_INFO::request& req, tools::COMMAND_RPC_GET_ADDRESS_INFO::response& res, const connection_context *ctx = NULL);
+    bool on_get_address_txs(const tools::COMMAND_RPC_GET_ADDRESS_TXS::request& req, tools::COMMAND_RPC_GET_ADDRESS_TXS::response& res, const connection_context *ctx = NULL);
+    bool on_get_unspent_outs(const tools::COMMAND_RPC_GET_UNSPENT_OUTS::request& req, tools::COMMAND_RPC_GET_UNSPENT_OUTS::response& res, const connection_context *ctx = NULL);
     
     //json_rpc
     bool on_getblockcount(const COMMAND_RPC_GETBLOCKCOUNT::request& req, COMMAND_RPC_GETBLOCKCOUNT::response& res, const connection_context *ctx = NULL);
@@ -287,7 +305,10 @@ private:
     enum invoke_http_mode { JON, BIN, JON_RPC };
     template <typename COMMAND_TYPE>
     bool use_bootstrap_daemon_if_necessary(const invoke_http_mode &mode, const std::string &command_name, const typename COMMAND_TYPE::request& req, typename COMMAND_TYPE::response& res, bool &r);
-    bool get_block_template(const account_public_address &address, const crypto::hash *prev_block, const cryptonote::blobdata &extra_nonce, size_t &reserved_offset, cryptonote::difficulty_type &difficulty, uint64_t &height, uint64_t &expected_reward, block &b, uint64_t &seed_height, crypto::hash &seed_hash, crypto::hash &next_seed_hash, epee::json_rpc::error &error_resp);
+    bool get_block_template(const account_public_address &address, const crypto::hash *prev_block, const cryptonote::blobdata &extra_nonce, size_t &reserved_offset, cryptonote::difficulty_type &difficulty, uint64_t &height, uint64_t &expected_reward, block &b, cryptonote::blobdata &block_blob, crypto::hash &tree_root_hash, uint64_t &seed_height, crypto::hash &seed_hash, crypto::hash &next_seed_hash, epee::json_rpc::error &error_resp);
+    bool make_get_blocks_entry(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, std::pair<std::pair<cryptonote::blobdata, crypto::hash>, std::vector<std::pair<crypto::hash, cryptonote::blobdata>>> &bd, get_blocks_cache::entry &e);
+    bool submit_block(const cryptonote::blobdata &block_blob, crypto::hash &block_id, epee::json_rpc::error &error_resp);
+    bool get_light_wallet_account(const std::string &address, const std::string &view_key, light_wallet::account &account, uint64_t &scanned_height, std::string &reason);
     bool check_payment(const std::string &client, uint64_t payment, const std::string &rpc, bool same_ts, std::string &message, uint64_t &credits, std::string &top_hash);
     
     core& m_core;
@@ -304,6 +325,8 @@ private:
     std::unique_ptr<rpc_payment> m_rpc_payment;
     bool disable_rpc_ban;
     bool m_rpc_payment_allow_free_loopback;
+    get_blocks_cache m_get_blocks_cache;
+    std::shared_ptr<light_wallet::scanner> m_light_wallet;
   };
 }
 
@@ -88,7 +88,7 @@ namespace cryptonote
 // advance which version they will stop working with
 // Don't go over 32767 for any of these
 #define CORE_RPC_VERSION_MAJOR 3
-#define CORE_RPC_VERSION_MINOR 9
+#define CORE_RPC_VERSION_MINOR 13
 #define MAKE_CORE_RPC_VERSION(major,minor) (((major)<<16)|(minor))
 #define CORE_RPC_VERSION MAKE_CORE_RPC_VERSION(CORE_RPC_VERSION_MAJOR, CORE_RPC_VERSION_MINOR)
 
@@ -168,15 +168,73 @@ namespace cryptonote
       uint64_t    start_height;
       bool        prune;
       bool        no_miner_tx;
+      bool        compact; //!< return `scan_records` instead of `blocks`
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE_PARENT(rpc_access_request_base)
         KV_SERIALIZE_CONTAINER_POD_AS_BLOB(block_ids)
         KV_SERIALIZE(start_height)
         KV_SERIALIZE(prune)
         KV_SERIALIZE_OPT(no_miner_tx, false)
+        KV_SERIALIZE_OPT(compact, false)
+      END_KV_SERIALIZE_MAP()
+    };
+    typedef epee::misc_utils::struct_init<request_t> request;
+
+    /*! What a wallet needs to scan one block, in columns. The per tx columns
+        have one entry per transaction, the miner tx first unless
+        `no_miner_tx` was requested. The other columns are the concatenation
+        of the entries of each transaction, in the same order:
+          - `additional_pub_keys`: `additional_pub_key_counts` entries
+          - `key_images`: `input_counts` entries, from `txin_to_key` inputs
+          - `output_keys` and `amounts`: `output_counts` entries, the amount
+            is 0 for ringct outputs
+          - `commitments`: one per output of ringct transactions
+          - `encrypted_amounts`: one per output with a compact ecdh tuple
+            (`RCTTypeBulletproof2` and later)
+          - `legacy_ecdh_info`: mask and amount for each output of older
+            ringct types
+        Daemon side only, from RPC version 3.11: wallet2 still requests full
+        blocks, since it keeps the fee, payment id and ring offsets of its
+        transactions, which a record does not carry. See
+        `rpc/scan_record.h`. */
+    struct block_scan_record
+    {
+      crypto::hash block_id;
+      uint64_t timestamp;
+      std::vector<crypto::hash> tx_hashes;
+      std::vector<uint64_t> unlock_times;
+      std::vector<uint8_t> rct_types;
+      std::vector<crypto::public_key> tx_pub_keys; //!< `null_pkey` when missing
+      std::vector<uint64_t> additional_pub_key_counts;
+      std::vector<uint64_t> input_counts;
+      std::vector<uint64_t> output_counts;
+      std::vector<crypto::public_key> additional_pub_keys;
+      std::vector<crypto::key_image> key_images;
+      std::vector<crypto::public_key> output_keys;
+      std::vector<uint64_t> amounts;
+      std::vector<rct::key> commitments;
+      std::vector<crypto::hash8> encrypted_amounts;
+      std::vector<rct::key> legacy_ecdh_info;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE_VAL_POD_AS_BLOB(block_id)
+        KV_SERIALIZE(timestamp)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(tx_hashes)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(unlock_times)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(rct_types)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(tx_pub_keys)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(additional_pub_key_counts)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(input_counts)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(output_counts)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(additional_pub_keys)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(key_images)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(output_keys)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(amounts)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(commitments)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(encrypted_amounts)
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(legacy_ecdh_info)
       END_KV_SERIALIZE_MAP()
     };
-    typedef epee::misc_utils::struct_init<request_t> request;
 
     struct tx_output_indices
     {
@@ -202,6 +260,7 @@ namespace cryptonote
       uint64_t    start_height;
       uint64_t    current_height;
       std::vector<block_output_indices> output_indices;
+      std::vector<block_scan_record> scan_records;
 
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE_PARENT(rpc_access_response_base)
@@ -209,6 +268,7 @@ namespace cryptonote
         KV_SERIALIZE(start_height)
         KV_SERIALIZE(current_height)
         KV_SERIALIZE(output_indices)
+        KV_SERIALIZE(scan_records)
       END_KV_SERIALIZE_MAP()
     };
     typedef epee::misc_utils::struct_init<response_t> response;
@@ -436,6 +496,56 @@ namespace cryptonote
     typedef epee::misc_utils::struct_init<response_t> response;
   };
 
+  //-----------------------------------------------
+  struct COMMAND_RPC_GET_OUTPUT_KEY_INDICES
+  {
+    struct request_t: public rpc_access_request_base
+    {
+      std::vector<std::string> output_keys;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE_PARENT(rpc_access_request_base)
+        KV_SERIALIZE(output_keys)
+      END_KV_SERIALIZE_MAP()
+    };
+    typedef epee::misc_utils::struct_init<request_t> request;
+
+    struct output_index
+    {
+      uint64_t amount;
+      uint64_t index;
+      std::string txid;
+      uint64_t local_index;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE(amount)
+        KV_SERIALIZE(index)
+        KV_SERIALIZE(txid)
+        KV_SERIALIZE(local_index)
+      END_KV_SERIALIZE_MAP()
+    };
+
+    struct key_outputs
+    {
+      std::vector<output_index> outputs;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE(outputs)
+      END_KV_SERIALIZE_MAP()
+    };
+
+    struct response_t: public rpc_access_response_base
+    {
+      std::vector<key_outputs> output_keys;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE_PARENT(rpc_access_response_base)
+        KV_SERIALIZE(output_keys)
+      END_KV_SERIALIZE_MAP()
+    };
+    typedef epee::misc_utils::struct_init<response_t> response;
+  };
+
   //-----------------------------------------------
   struct COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES
   {
@@ -1071,6 +1181,31 @@ namespace cryptonote
     typedef epee::misc_utils::struct_init<response_t> response;
   };
 
+  struct COMMAND_RPC_SUBMITBLOCK_BIN
+  {
+    struct request_t: public rpc_request_base
+    {
+      std::string block_blob; //!< raw block, not hex encoded
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE_PARENT(rpc_request_base)
+        KV_SERIALIZE(block_blob)
+      END_KV_SERIALIZE_MAP()
+    };
+    typedef epee::misc_utils::struct_init<request_t> request;
+
+    struct response_t: public rpc_response_base
+    {
+      crypto::hash block_id;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE_PARENT(rpc_response_base)
+        KV_SERIALIZE_VAL_POD_AS_BLOB(block_id)
+      END_KV_SERIALIZE_MAP()
+    };
+    typedef epee::misc_utils::struct_init<response_t> response;
+  };
+
   struct COMMAND_RPC_GENERATEBLOCKS
   {
     struct request_t: public rpc_request_base
@@ -2672,10 +2807,12 @@ namespace cryptonote
     struct request_t: public rpc_request_base
     {
       bool check;
+      bool background;
 
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE_PARENT(rpc_request_base)
         KV_SERIALIZE_OPT(check, false)
+        KV_SERIALIZE_OPT(background, false)
       END_KV_SERIALIZE_MAP()
     };
     typedef epee::misc_utils::struct_init<request_t> request;
@@ -2684,11 +2821,19 @@ namespace cryptonote
     {
       bool pruned;
       uint32_t pruning_seed;
+      bool in_progress;
+      uint64_t txes_done;
+      uint64_t txes_total;
+      uint64_t free_bytes;
 
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE_PARENT(rpc_response_base)
         KV_SERIALIZE(pruned)
         KV_SERIALIZE(pruning_seed)
+        KV_SERIALIZE(in_progress)
+        KV_SERIALIZE(txes_done)
+        KV_SERIALIZE(txes_total)
+        KV_SERIALIZE(free_bytes)
       END_KV_SERIALIZE_MAP()
     };
     typedef epee::misc_utils::struct_init<response_t> response;
@@ -0,0 +1,84 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "get_blocks_cache.h"
+
+#include <boost/thread/locks.hpp>
+
+namespace cryptonote
+{
+  get_blocks_cache::get_blocks_cache(const size_t max_size)
+    : m_max_size(max_size), m_size(0)
+  {
+  }
+
+  std::shared_ptr<const get_blocks_cache::entry> get_blocks_cache::get(const uint64_t height, const uint8_t flags)
+  {
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    const auto it = m_entries.find({height, flags});
+    if (it == m_entries.end())
+      return nullptr;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->second;
+  }
+
+  void get_blocks_cache::add(const uint64_t height, const uint8_t flags, std::shared_ptr<const entry> e)
+  {
+    if (!e || e->size > m_max_size)
+      return;
+
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    const key k{height, flags};
+    const auto it = m_entries.find(k);
+    if (it != m_entries.end())
+      remove(it);
+
+    m_size += e->size;
+    m_lru.emplace_front(k, std::move(e));
+    m_entries.emplace(k, m_lru.begin());
+
+    while (m_size > m_max_size)
+      remove(m_entries.find(m_lru.back().first));
+  }
+
+  void get_blocks_cache::clear()
+  {
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    m_entries.clear();
+    m_lru.clear();
+    m_size = 0;
+  }
+
+  void get_blocks_cache::remove(const std::unordered_map<key, lru_list::iterator, key_hash>::iterator it)
+  {
+    m_size -= it->second->second->size;
+    m_lru.erase(it->second);
+    m_entries.erase(it);
+  }
+}
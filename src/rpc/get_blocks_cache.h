@@ -0,0 +1,105 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include "crypto/hash.h"
+#include "rpc/core_rpc_server_commands_defs.h"
+
+namespace cryptonote
+{
+  /*! \brief LRU of `get_blocks.bin` response entries, one per block.
+
+      Only blocks deeper than `COMMAND_RPC_GET_BLOCKS_FAST_CACHE_MIN_DEPTH`
+      are added. Entries keep the id of their block, and callers must check
+      it against the chain before use, so a deep reorg only costs a cache
+      miss. Thread-safe. */
+  class get_blocks_cache
+  {
+  public:
+    //! Response parts for one block, built with the request flags of its key
+    struct entry
+    {
+      crypto::hash block_id;
+      block_complete_entry block; //!< empty for compact requests
+      COMMAND_RPC_GET_BLOCKS_FAST::block_scan_record scan_record; //!< only for compact requests
+      COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices output_indices;
+      size_t tx_count; //!< not counting the miner tx
+      size_t size; //!< bytes of blobs or scan record columns
+    };
+
+    enum flags : uint8_t
+    {
+      flag_prune = 1,
+      flag_no_miner_tx = 2,
+      flag_compact = 4
+    };
+
+    static uint8_t make_flags(bool prune, bool no_miner_tx, bool compact) noexcept
+    {
+      return (prune ? flag_prune : 0) | (no_miner_tx ? flag_no_miner_tx : 0) | (compact ? flag_compact : 0);
+    }
+
+    //! \param max_size bytes of entries kept, 0 disables the cache
+    explicit get_blocks_cache(size_t max_size);
+
+    //! \return Entry for `height` built with `flags`, or null.
+    std::shared_ptr<const entry> get(uint64_t height, uint8_t flags);
+
+    //! Add or replace the entry for `height` built with `flags`.
+    void add(uint64_t height, uint8_t flags, std::shared_ptr<const entry> e);
+
+    void clear();
+
+  private:
+    typedef std::pair<uint64_t, uint8_t> key;
+
+    struct key_hash
+    {
+      size_t operator()(const key &k) const noexcept { return std::hash<uint64_t>()(k.first * 8 + k.second); }
+    };
+
+    typedef std::list<std::pair<key, std::shared_ptr<const entry>>> lru_list;
+
+    void remove(std::unordered_map<key, lru_list::iterator, key_hash>::iterator it);
+
+    boost::mutex m_lock;
+    const size_t m_max_size;
+    size_t m_size;
+    lru_list m_lru; //!< most recently used first
+    std::unordered_map<key, lru_list::iterator, key_hash> m_entries;
+  };
+}
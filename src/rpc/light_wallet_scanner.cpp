@@ -0,0 +1,552 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "light_wallet_scanner.h"
+
+#include <algorithm>
+#include <boost/thread/locks.hpp>
+#include <cstring>
+
+#include "common/threadpool.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_config.h"
+#include "cryptonote_core/cryptonote_core.h"
+#include "device/device.hpp"
+#include "ringct/rctOps.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "daemon.rpc.light_wallet"
+
+namespace cryptonote
+{
+namespace light_wallet
+{
+  namespace
+  {
+    struct scan_result
+    {
+      std::vector<output> outputs;
+      std::vector<spend> spends;
+    };
+
+    bool is_output_to(const crypto::key_derivation& derivation, const std::size_t index, const crypto::public_key& spend_key, const crypto::public_key& output_key)
+    {
+      crypto::public_key expected;
+      return crypto::derive_public_key(derivation, index, spend_key, expected) && expected == output_key;
+    }
+
+    //! Fill the amount fields of `out`. \return False if the commitment does not open.
+    bool decode_amount(const scan_tx& stx, const std::size_t index, const crypto::key_derivation& derivation, output& out)
+    {
+      out.amount = stx.tx.vout[index].amount;
+      out.rct = stx.tx.version >= 2;
+      out.commitment = rct::zero();
+      out.encrypted_mask = rct::zero();
+      out.encrypted_amount = rct::zero();
+      if (!out.rct)
+        return true;
+      if (stx.coinbase)
+      {
+        out.commitment = rct::zeroCommit(out.amount);
+        out.encrypted_mask = rct::identity();
+        return true;
+      }
+
+      const rct::rctSig& rv = stx.tx.rct_signatures;
+      if (index >= rv.ecdhInfo.size() || index >= rv.outPk.size())
+        return false;
+
+      crypto::secret_key scalar;
+      crypto::derivation_to_scalar(derivation, index, scalar);
+      const rct::key shared = rct::sk2rct(scalar);
+      rct::ecdhTuple ecdh = rv.ecdhInfo[index];
+      rct::ecdhDecode(ecdh, shared, rv.type == rct::RCTTypeBulletproof2 || rv.type == rct::RCTTypeCLSAG);
+
+      out.amount = rct::h2d(ecdh.amount);
+      out.commitment = rv.outPk[index].mask;
+      if (!(rct::commit(out.amount, ecdh.mask) == out.commitment))
+        return false;
+      sc_add(out.encrypted_mask.bytes, ecdh.mask.bytes, rct::hash_to_scalar(shared).bytes);
+      out.encrypted_amount = rv.ecdhInfo[index].amount;
+      return true;
+    }
+
+    bool load_block(core& core, const block& b, const uint64_t height, scan_block& out)
+    {
+      out.height = height;
+      out.timestamp = b.timestamp;
+      out.txs.clear();
+
+      std::vector<blobdata> blobs;
+      std::vector<crypto::hash> missed;
+      if (!core.get_transactions(b.tx_hashes, blobs, missed, true) || !missed.empty() || blobs.size() != b.tx_hashes.size())
+        return false;
+
+      const crypto::hash miner_tx_hash = get_transaction_hash(b.miner_tx);
+      std::vector<std::vector<uint64_t>> indices;
+      if (!core.get_tx_outputs_gindexs(miner_tx_hash, b.tx_hashes.size() + 1, indices) || indices.size() != b.tx_hashes.size() + 1)
+        return false;
+
+      out.txs.resize(b.tx_hashes.size() + 1);
+      if (!make_scan_tx(b.miner_tx, miner_tx_hash, std::move(indices[0]), true, out.txs[0]))
+        return false;
+      for (std::size_t i = 0; i < blobs.size(); ++i)
+      {
+        transaction tx;
+        if (!parse_and_validate_tx_base_from_blob(blobs[i], tx))
+          return false;
+        if (!make_scan_tx(std::move(tx), b.tx_hashes[i], std::move(indices[i + 1]), false, out.txs[i + 1]))
+          return false;
+      }
+      return true;
+    }
+
+    void add_output(output_lookup& lookup, account& acc, output out)
+    {
+      lookup[{out.indexed_amount(), out.global_index}] = acc.outputs.size();
+      acc.outputs.push_back(std::move(out));
+    }
+  }
+
+  bool make_scan_tx(transaction tx, const crypto::hash& hash, std::vector<uint64_t> global_indices, const bool coinbase, scan_tx& out)
+  {
+    if (global_indices.size() != tx.vout.size())
+      return false;
+
+    out.hash = hash;
+    out.prefix_hash = get_transaction_prefix_hash(tx);
+    out.coinbase = coinbase;
+    out.mixin = 0;
+    out.payment_id = crypto::null_hash;
+    out.short_payment_id = crypto::null_hash8;
+    out.additional_pub_keys.clear();
+    out.rings.clear();
+
+    // a partially parsed extra is still scanned, like wallet2 does
+    std::vector<tx_extra_field> fields;
+    parse_tx_extra(tx.extra, fields);
+
+    tx_extra_pub_key pub_key;
+    out.pub_key = find_tx_extra_field_by_type(fields, pub_key) ? pub_key.pub_key : crypto::null_pkey;
+
+    tx_extra_additional_pub_keys additional;
+    if (find_tx_extra_field_by_type(fields, additional) && additional.data.size() == tx.vout.size())
+      out.additional_pub_keys = std::move(additional.data);
+
+    tx_extra_nonce nonce;
+    if (find_tx_extra_field_by_type(fields, nonce))
+    {
+      if (!get_encrypted_payment_id_from_tx_extra_nonce(nonce.nonce, out.short_payment_id))
+      {
+        out.short_payment_id = crypto::null_hash8;
+        if (!get_payment_id_from_tx_extra_nonce(nonce.nonce, out.payment_id))
+          out.payment_id = crypto::null_hash;
+      }
+    }
+
+    for (const txin_v& in : tx.vin)
+    {
+      const txin_to_key* const key_in = boost::get<txin_to_key>(std::addressof(in));
+      if (!key_in || key_in->key_offsets.empty())
+        continue;
+      if (out.rings.empty())
+        out.mixin = key_in->key_offsets.size() - 1;
+      out.rings.push_back(relative_output_offsets_to_absolute(key_in->key_offsets));
+    }
+
+    out.tx = std::move(tx);
+    out.global_indices = std::move(global_indices);
+    return true;
+  }
+
+  void scan(const scan_block& block, const account& acc, const output_lookup& lookup, std::vector<output>& outputs, std::vector<spend>& spends)
+  {
+    hw::device& hwdev = hw::get_device("default");
+    for (const scan_tx& stx : block.txs)
+    {
+      std::size_t ring = 0;
+      for (const txin_v& in : stx.tx.vin)
+      {
+        const txin_to_key* const key_in = boost::get<txin_to_key>(std::addressof(in));
+        if (!key_in || key_in->key_offsets.empty())
+          continue;
+        for (const uint64_t index : stx.rings[ring])
+        {
+          const auto found = lookup.find({key_in->amount, index});
+          if (found == lookup.end())
+            continue;
+          const output& source = acc.outputs[found->second];
+          spends.push_back({stx.hash, key_in->k_image, source.tx_pub_key, source.amount, block.height, block.timestamp, stx.tx.unlock_time, source.index, stx.mixin});
+        }
+        ++ring;
+      }
+
+      crypto::key_derivation derivation;
+      const bool main_derivation = crypto::generate_key_derivation(stx.pub_key, acc.view_key, derivation);
+      for (std::size_t i = 0; i < stx.tx.vout.size(); ++i)
+      {
+        const txout_to_key* const target = boost::get<txout_to_key>(std::addressof(stx.tx.vout[i].target));
+        if (!target)
+          continue;
+
+        output out{};
+        crypto::key_derivation additional_derivation;
+        const crypto::key_derivation* used = nullptr;
+        if (main_derivation && is_output_to(derivation, i, acc.address.m_spend_public_key, target->key))
+        {
+          used = std::addressof(derivation);
+          out.tx_pub_key = stx.pub_key;
+        }
+        else if (!stx.additional_pub_keys.empty() &&
+          crypto::generate_key_derivation(stx.additional_pub_keys[i], acc.view_key, additional_derivation) &&
+          is_output_to(additional_derivation, i, acc.address.m_spend_public_key, target->key))
+        {
+          used = std::addressof(additional_derivation);
+          out.tx_pub_key = stx.additional_pub_keys[i];
+        }
+        if (!used)
+          continue;
+
+        if (!decode_amount(stx, i, *used, out))
+        {
+          MWARNING("Output " << i << " of tx " << stx.hash << " has a commitment that does not open, ignoring it");
+          continue;
+        }
+
+        out.tx_hash = stx.hash;
+        out.tx_prefix_hash = stx.prefix_hash;
+        out.key = target->key;
+        out.payment_id = stx.payment_id;
+        if (stx.short_payment_id != crypto::null_hash8)
+        {
+          crypto::hash8 payment_id = stx.short_payment_id;
+          if (hwdev.decrypt_payment_id(payment_id, stx.pub_key, acc.view_key))
+          {
+            out.payment_id = crypto::null_hash;
+            std::memcpy(out.payment_id.data, payment_id.data, sizeof(payment_id.data));
+          }
+        }
+        out.global_index = stx.global_indices[i];
+        out.height = block.height;
+        out.timestamp = block.timestamp;
+        out.unlock_time = stx.tx.unlock_time;
+        out.index = i;
+        out.mixin = stx.mixin;
+        out.coinbase = stx.coinbase;
+        outputs.push_back(std::move(out));
+      }
+    }
+  }
+
+  void scanner::notify::operator()(uint64_t, epee::span<const block>) const
+  {
+    const std::shared_ptr<scanner> self = self_.lock();
+    if (self)
+      self->wake();
+  }
+
+  scanner::scanner(core& core, const std::string& path, const std::size_t max_accounts)
+    : m_core(core), m_storage(path), m_max_accounts(max_accounts), m_stop(false), m_woken(false), m_state{}
+  {
+    std::vector<account> accounts;
+    MONERO_UNWRAP(m_storage.load(accounts, m_state));
+    for (account& acc : accounts)
+    {
+      std::unique_ptr<account_state> state{new account_state{}};
+      state->active = true;
+      state->data.address = acc.address;
+      state->data.view_key = acc.view_key;
+      state->data.start_height = acc.start_height;
+      state->data.spends = std::move(acc.spends);
+      for (output& out : acc.outputs)
+        add_output(state->lookup, state->data, std::move(out));
+      m_accounts.emplace(state->data.address, std::move(state));
+    }
+    MINFO("Loaded " << m_accounts.size() << " light wallet accounts, scanned up to height " << m_state.height);
+  }
+
+  scanner::~scanner()
+  {
+    stop();
+  }
+
+  void scanner::run()
+  {
+    m_thread = boost::thread{[this] { scan_loop(); }};
+  }
+
+  void scanner::stop()
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(m_lock);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable())
+      m_thread.join();
+  }
+
+  void scanner::wake()
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(m_lock);
+      m_woken = true;
+    }
+    m_wake.notify_all();
+  }
+
+  bool scanner::login(const account_public_address& address, const crypto::secret_key& view_key, const bool create, bool& created, bool& full)
+  {
+    created = false;
+    full = false;
+    crypto::public_key view_public_key;
+    if (!crypto::secret_key_to_public_key(view_key, view_public_key) || view_public_key != address.m_view_public_key)
+      return false;
+
+    {
+      boost::lock_guard<boost::mutex> lock(m_lock);
+      if (m_accounts.count(address))
+        return true;
+      if (!create)
+        return false;
+      if (m_max_accounts && m_accounts.size() >= m_max_accounts)
+      {
+        full = true;
+        return false;
+      }
+
+      // stored once the scanner picks it up, a lost registration is redone by the next login
+      std::unique_ptr<account_state> state{new account_state{}};
+      state->active = false;
+      state->data.address = address;
+      state->data.view_key = view_key;
+      state->data.start_height = 0;
+      m_accounts.emplace(address, std::move(state));
+      created = true;
+    }
+    MINFO("Registered light wallet account " << address.m_spend_public_key);
+    wake();
+    return true;
+  }
+
+  bool scanner::get_account(const account_public_address& address, const crypto::secret_key& view_key, account& out, uint64_t& scanned_height) const
+  {
+    crypto::public_key view_public_key;
+    if (!crypto::secret_key_to_public_key(view_key, view_public_key) || view_public_key != address.m_view_public_key)
+      return false;
+
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    const auto found = m_accounts.find(address);
+    if (found == m_accounts.end())
+      return false;
+    out = found->second->data;
+    if (!found->second->active)
+      out.start_height = m_state.height;
+    scanned_height = m_state.height;
+    return true;
+  }
+
+  void scanner::scan_loop()
+  {
+    MINFO("Light wallet scanner started");
+    for (;;)
+    {
+      bool more = false;
+      try
+      {
+        more = update();
+      }
+      catch (const std::exception& e)
+      {
+        MERROR("Light wallet scan failed: " << e.what());
+      }
+
+      boost::unique_lock<boost::mutex> lock(m_lock);
+      if (!more)
+        m_wake.wait_for(lock, boost::chrono::seconds(10), [this] { return m_stop || m_woken; });
+      if (m_stop)
+        break;
+      m_woken = false;
+    }
+    MINFO("Light wallet scanner stopped");
+  }
+
+  bool scanner::update()
+  {
+    // only this thread changes `m_state` and the account data, so reading
+    // them without `m_lock` is fine; calls into the core must not hold
+    // `m_lock` since block notifications take it with the chain locked
+    const uint64_t chain_height = m_core.get_current_blockchain_height();
+
+    uint64_t height = m_state.height;
+    for (auto id = m_state.recent_ids.rbegin(); id != m_state.recent_ids.rend(); ++id, --height)
+    {
+      if (m_core.get_block_id_by_height(height - 1) == *id)
+        break;
+    }
+    if (height != m_state.height)
+    {
+      if (m_state.height - height == m_state.recent_ids.size())
+        MWARNING("Light wallet scanner found a reorg deeper than " << m_state.recent_ids.size() << " blocks, results before height " << height << " may be stale");
+      MINFO("Light wallet scanner rolling back from height " << m_state.height << " to " << height);
+      boost::lock_guard<boost::mutex> lock(m_lock);
+      rollback(height);
+    }
+
+    std::vector<account_state*> active;
+    {
+      boost::lock_guard<boost::mutex> lock(m_lock);
+      active.reserve(m_accounts.size());
+      for (auto& entry : m_accounts)
+      {
+        account_state& state = *entry.second;
+        if (!state.active)
+        {
+          state.active = true;
+          state.data.start_height = m_state.height;
+          m_dirty.insert(std::addressof(state.data));
+        }
+        active.push_back(std::addressof(state));
+      }
+    }
+
+    if (m_state.height >= chain_height)
+    {
+      if (!m_dirty.empty())
+        store();
+      return false;
+    }
+
+    if (active.empty())
+    {
+      // nothing to scan for, skip ahead
+      const crypto::hash top_id = m_core.get_block_id_by_height(chain_height - 1);
+      {
+        boost::lock_guard<boost::mutex> lock(m_lock);
+        m_state.height = chain_height;
+        m_state.recent_ids.assign(1, top_id);
+      }
+      store();
+      return false;
+    }
+
+    std::vector<std::pair<blobdata, block>> blocks;
+    if (!m_core.get_blocks(m_state.height, LIGHT_WALLET_SCAN_BATCH_SIZE, blocks))
+      return false;
+
+    tools::threadpool& tpool = tools::threadpool::getInstance();
+    const std::size_t threads = std::max(1u, tpool.get_max_concurrency());
+    const std::size_t chunk = (active.size() + threads - 1) / threads;
+    std::vector<scan_result> results;
+    scan_block sblock;
+    for (const auto& entry : blocks)
+    {
+      const block& b = entry.second;
+      if (!m_state.recent_ids.empty() && b.prev_id != m_state.recent_ids.back())
+        break; // reorg while reading, rolled back on the next update
+      if (!load_block(m_core, b, m_state.height, sblock))
+      {
+        MERROR("Failed to load block " << m_state.height << " for light wallet scanning");
+        break;
+      }
+
+      results.assign(active.size(), scan_result{});
+      tools::threadpool::waiter waiter(tpool);
+      for (std::size_t start = 0; start < active.size(); start += chunk)
+      {
+        const std::size_t end = std::min(start + chunk, active.size());
+        tpool.submit(&waiter, [&active, &results, &sblock, start, end] {
+          for (std::size_t i = start; i < end; ++i)
+            scan(sblock, active[i]->data, active[i]->lookup, results[i].outputs, results[i].spends);
+        }, true);
+      }
+      if (!waiter.wait())
+        throw std::runtime_error{"light wallet scan job failed"};
+
+      boost::lock_guard<boost::mutex> lock(m_lock);
+      for (std::size_t i = 0; i < active.size(); ++i)
+      {
+        if (results[i].outputs.empty() && results[i].spends.empty())
+          continue;
+        account_state& state = *active[i];
+        for (output& out : results[i].outputs)
+          add_output(state.lookup, state.data, std::move(out));
+        for (spend& s : results[i].spends)
+          state.data.spends.push_back(std::move(s));
+        m_dirty.insert(std::addressof(state.data));
+      }
+      ++m_state.height;
+      m_state.recent_ids.push_back(get_block_hash(b));
+      if (m_state.recent_ids.size() > LIGHT_WALLET_SCAN_REORG_DEPTH)
+        m_state.recent_ids.erase(m_state.recent_ids.begin());
+    }
+
+    store();
+    return m_state.height < chain_height;
+  }
+
+  void scanner::rollback(const uint64_t height)
+  {
+    const auto from_height = [height](const uint64_t h) { return h >= height; };
+    for (auto& entry : m_accounts)
+    {
+      account_state& state = *entry.second;
+      if (!state.active)
+        continue;
+
+      account& acc = state.data;
+      const auto first_output = std::find_if(acc.outputs.begin(), acc.outputs.end(), [&](const output& o) { return from_height(o.height); });
+      const auto first_spend = std::find_if(acc.spends.begin(), acc.spends.end(), [&](const spend& s) { return from_height(s.height); });
+      if (first_output == acc.outputs.end() && first_spend == acc.spends.end() && acc.start_height <= height)
+        continue;
+
+      for (auto out = first_output; out != acc.outputs.end(); ++out)
+        state.lookup.erase({out->indexed_amount(), out->global_index});
+      acc.outputs.erase(first_output, acc.outputs.end());
+      acc.spends.erase(first_spend, acc.spends.end());
+      acc.start_height = std::min(acc.start_height, height);
+      m_dirty.insert(std::addressof(acc));
+    }
+
+    m_state.recent_ids.resize(m_state.recent_ids.size() - std::min<uint64_t>(m_state.height - height, m_state.recent_ids.size()));
+    m_state.height = height;
+  }
+
+  void scanner::store()
+  {
+    const std::vector<const account*> accounts{m_dirty.begin(), m_dirty.end()};
+    const expect<void> stored = m_storage.store(accounts, std::addressof(m_state));
+    if (!stored)
+    {
+      MERROR("Failed to store light wallet accounts: " << stored.error().message());
+      return;
+    }
+    m_dirty.clear();
+  }
+}
+}
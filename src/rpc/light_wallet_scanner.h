@@ -0,0 +1,161 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "cryptonote_basic/cryptonote_basic.h"
+#include "light_wallet_storage.h"
+#include "span.h"
+
+namespace cryptonote
+{
+  class core;
+
+namespace light_wallet
+{
+  //! A tx of a block, parsed once and shared by all accounts.
+  struct scan_tx
+  {
+    transaction tx;
+    crypto::hash hash;
+    crypto::hash prefix_hash;
+    crypto::public_key pub_key;
+    std::vector<crypto::public_key> additional_pub_keys; //!< Only if there is one per output
+    std::vector<uint64_t> global_indices;
+    std::vector<std::vector<uint64_t>> rings; //!< Absolute output indices of each key input
+    crypto::hash payment_id;   //!< Unencrypted id or `null_hash`
+    crypto::hash8 short_payment_id; //!< Encrypted id or `null_hash8`
+    uint32_t mixin;
+    bool coinbase;
+  };
+
+  struct scan_block
+  {
+    uint64_t height;
+    uint64_t timestamp;
+    std::vector<scan_tx> txs; //!< The miner tx first
+  };
+
+  //! Positions of account outputs in `account::outputs` by (indexed amount, global index).
+  typedef std::map<std::pair<uint64_t, uint64_t>, std::size_t> output_lookup;
+
+  //! \return `tx` parsed for scanning, or false if it is malformed.
+  bool make_scan_tx(transaction tx, const crypto::hash& hash, std::vector<uint64_t> global_indices, bool coinbase, scan_tx& out);
+
+  /*! Appends to `outputs` the outputs of `block` received by the main
+      address of `acc`, and to `spends` the key inputs whose ring uses one
+      of the outputs in `lookup`. Only reads `acc`. */
+  void scan(const scan_block& block, const account& acc, const output_lookup& lookup, std::vector<output>& outputs, std::vector<spend>& spends);
+
+  /*! \brief Scans new blocks for registered view keys in the daemon.
+
+      Blocks are read once from the core and each tx is parsed once; the
+      per-account work (key derivations) is spread over the thread pool.
+      Results are stored through `storage` after every batch of blocks, and
+      reorgs are rolled back using the ids of the recently scanned blocks.
+      Accounts start at the height the scanner reached when they were
+      registered. Thread-safe. */
+  class scanner
+  {
+  public:
+    //! Wakes the scanner, for `Blockchain::add_block_notify`.
+    struct notify
+    {
+      std::weak_ptr<scanner> self_;
+
+      void operator()(uint64_t height, epee::span<const block> blocks) const;
+    };
+
+    /*! \param max_accounts registrations are refused past this many accounts, 0 for no limit
+        \throw std::exception if the store at `path` cannot be opened or read */
+    scanner(core& core, const std::string& path, std::size_t max_accounts = 0);
+    ~scanner();
+
+    //! Start the scan thread.
+    void run();
+
+    //! Stop and join the scan thread.
+    void stop();
+
+    void wake();
+
+    /*! Check `view_key` against `address` and register it if `create`.
+        \param full set if the account would be new but the limit is reached
+        \return False if the view key does not match, or the account does not
+            exist and `create` is false or `full` is set. */
+    bool login(const account_public_address& address, const crypto::secret_key& view_key, bool create, bool& created, bool& full);
+
+    /*! Copy the account of `address` if `view_key` matches.
+        \param scanned_height set to the next block to be scanned
+        \return False if there is no such account. */
+    bool get_account(const account_public_address& address, const crypto::secret_key& view_key, account& out, uint64_t& scanned_height) const;
+
+  private:
+    struct account_state
+    {
+      account data;
+      output_lookup lookup;
+      bool active; //!< False until the scanner picks the account up
+    };
+
+    void scan_loop();
+
+    //! Scan the next batch of blocks. \return True if more blocks are waiting.
+    bool update();
+
+    //! Drop scan results from blocks at `height` and above. Requires `m_lock`.
+    void rollback(uint64_t height);
+
+    //! Write the changed accounts and the scan state, kept for a retry on failure.
+    void store();
+
+    core& m_core;
+    storage m_storage;
+    const std::size_t m_max_accounts;
+    mutable boost::mutex m_lock;
+    boost::condition_variable m_wake;
+    bool m_stop;
+    bool m_woken;
+    scan_state m_state;
+    std::unordered_map<account_public_address, std::unique_ptr<account_state>> m_accounts;
+    std::unordered_set<const account*> m_dirty; //!< Only used by the scan thread
+    boost::thread m_thread;
+  };
+}
+}
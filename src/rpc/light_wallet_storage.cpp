@@ -0,0 +1,145 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "light_wallet_storage.h"
+
+#include <boost/filesystem/operations.hpp>
+
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "lmdb/error.h"
+#include "lmdb/table.h"
+#include "lmdb/util.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "daemon.rpc.light_wallet"
+
+namespace cryptonote
+{
+namespace light_wallet
+{
+  namespace
+  {
+    constexpr const lmdb::table accounts_table{"light_wallet_accounts", MDB_CREATE, nullptr, nullptr};
+    constexpr const lmdb::table state_table{"light_wallet_state", MDB_CREATE, nullptr, nullptr};
+    constexpr const char state_key[] = "state";
+
+    MONERO_CURSOR(accounts_cursor);
+
+    lmdb::environment open_environment(const std::string& path)
+    {
+      boost::filesystem::create_directories(path);
+      return MONERO_UNWRAP(lmdb::open_environment(path.c_str(), 2));
+    }
+
+    template<typename T>
+    expect<void> put_object(MDB_txn& txn, MDB_dbi dbi, MDB_val key, const T& object)
+    {
+      blobdata blob;
+      MONERO_PRECOND(t_serializable_object_to_blob(object, blob));
+      MDB_val value{blob.size(), const_cast<char*>(blob.data())};
+      MONERO_LMDB_CHECK(mdb_put(&txn, dbi, &key, &value, 0));
+      return success();
+    }
+
+    template<typename T>
+    expect<void> get_object(MDB_val value, T& object)
+    {
+      if (!t_serializable_object_from_blob(object, blobdata{static_cast<const char*>(value.mv_data), value.mv_size}))
+        return {lmdb::error(MDB_CORRUPTED)};
+      return success();
+    }
+  }
+
+  storage::storage(const std::string& path)
+    : m_db(open_environment(path))
+  {
+    MONERO_UNWRAP(m_db.try_write([](MDB_txn& txn) -> expect<void>
+    {
+      for (const lmdb::table* table : {&accounts_table, &state_table})
+      {
+        const expect<MDB_dbi> dbi = table->open(txn);
+        if (!dbi)
+          return dbi.error();
+      }
+      return success();
+    }));
+  }
+
+  expect<void> storage::load(std::vector<account>& accounts, scan_state& state)
+  {
+    accounts.clear();
+    state = scan_state{};
+    state.height = 0;
+
+    expect<lmdb::read_txn> txn = m_db.create_read_txn();
+    if (!txn)
+      return txn.error();
+
+    MDB_dbi dbi = 0;
+    MONERO_LMDB_CHECK(mdb_dbi_open(txn->get(), state_table.name, 0, &dbi));
+    MDB_val key{sizeof(state_key), const_cast<char*>(state_key)};
+    MDB_val value{};
+    const int err = mdb_get(txn->get(), dbi, &key, &value);
+    if (err && err != MDB_NOTFOUND)
+      return {lmdb::error(err)};
+    if (!err)
+      MONERO_CHECK(get_object(value, state));
+
+    MONERO_LMDB_CHECK(mdb_dbi_open(txn->get(), accounts_table.name, 0, &dbi));
+    expect<accounts_cursor> cur = lmdb::open_cursor<close_accounts_cursor>(**txn, dbi);
+    if (!cur)
+      return cur.error();
+    for (int next = mdb_cursor_get(cur->get(), &key, &value, MDB_FIRST); next != MDB_NOTFOUND; next = mdb_cursor_get(cur->get(), &key, &value, MDB_NEXT))
+    {
+      if (next)
+        return {lmdb::error(next)};
+      accounts.emplace_back();
+      MONERO_CHECK(get_object(value, accounts.back()));
+    }
+    return success();
+  }
+
+  expect<void> storage::store(const std::vector<const account*>& accounts, const scan_state* const state)
+  {
+    return m_db.try_write([&accounts, state](MDB_txn& txn) -> expect<void>
+    {
+      MDB_dbi dbi = 0;
+      MONERO_LMDB_CHECK(mdb_dbi_open(&txn, accounts_table.name, 0, &dbi));
+      for (const account* acc : accounts)
+        MONERO_CHECK(put_object(txn, dbi, lmdb::to_val(acc->address), *acc));
+
+      if (state)
+      {
+        MONERO_LMDB_CHECK(mdb_dbi_open(&txn, state_table.name, 0, &dbi));
+        MONERO_CHECK(put_object(txn, dbi, MDB_val{sizeof(state_key), const_cast<char*>(state_key)}, *state));
+      }
+      return success();
+    });
+  }
+}
+}
@@ -0,0 +1,171 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/expect.h"
+#include "cryptonote_basic/cryptonote_basic.h"
+#include "lmdb/database.h"
+#include "ringct/rctTypes.h"
+#include "serialization/crypto.h"
+#include "serialization/containers.h"
+
+namespace cryptonote
+{
+namespace light_wallet
+{
+  //! An output received by the main address of an account.
+  struct output
+  {
+    crypto::hash tx_hash;
+    crypto::hash tx_prefix_hash;
+    crypto::public_key tx_pub_key; //!< The tx key the output key was derived from
+    crypto::public_key key;
+    rct::key commitment;
+    rct::key encrypted_mask;   //!< Mask encrypted the pre-Bulletproof2 way, which light wallets decrypt
+    rct::key encrypted_amount; //!< As found in the tx ecdh info
+    crypto::hash payment_id;   //!< Decrypted short ids use the first 8 bytes, `null_hash` if none
+    uint64_t amount;
+    uint64_t global_index;
+    uint64_t height;
+    uint64_t timestamp;
+    uint64_t unlock_time;
+    uint32_t index;            //!< Within the tx
+    uint32_t mixin;            //!< Ring size of the tx inputs minus one
+    bool coinbase;
+    bool rct;                  //!< Indexed with amount 0
+
+    uint64_t indexed_amount() const noexcept { return rct ? 0 : amount; }
+
+    BEGIN_SERIALIZE_OBJECT()
+      FIELD(tx_hash)
+      FIELD(tx_prefix_hash)
+      FIELD(tx_pub_key)
+      FIELD(key)
+      FIELD(commitment)
+      FIELD(encrypted_mask)
+      FIELD(encrypted_amount)
+      FIELD(payment_id)
+      VARINT_FIELD(amount)
+      VARINT_FIELD(global_index)
+      VARINT_FIELD(height)
+      VARINT_FIELD(timestamp)
+      VARINT_FIELD(unlock_time)
+      VARINT_FIELD(index)
+      VARINT_FIELD(mixin)
+      FIELD(coinbase)
+      FIELD(rct)
+    END_SERIALIZE()
+  };
+
+  /*! A tx input whose ring contains an output of an account. Without the
+      spend key only the light wallet can tell whether the key image is its
+      own or the output was used as a decoy. */
+  struct spend
+  {
+    crypto::hash tx_hash;
+    crypto::key_image key_image;
+    crypto::public_key tx_pub_key; //!< Of the referenced output
+    uint64_t amount;               //!< Of the referenced output
+    uint64_t height;
+    uint64_t timestamp;
+    uint64_t unlock_time;
+    uint32_t out_index;            //!< Of the referenced output
+    uint32_t mixin;
+
+    BEGIN_SERIALIZE_OBJECT()
+      FIELD(tx_hash)
+      FIELD(key_image)
+      FIELD(tx_pub_key)
+      VARINT_FIELD(amount)
+      VARINT_FIELD(height)
+      VARINT_FIELD(timestamp)
+      VARINT_FIELD(unlock_time)
+      VARINT_FIELD(out_index)
+      VARINT_FIELD(mixin)
+    END_SERIALIZE()
+  };
+
+  struct account
+  {
+    account_public_address address;
+    crypto::secret_key view_key;
+    uint64_t start_height; //!< First block scanned for the account
+    std::vector<output> outputs; //!< In chain order
+    std::vector<spend> spends;   //!< In chain order
+
+    BEGIN_SERIALIZE_OBJECT()
+      VERSION_FIELD(0)
+      FIELD(address)
+      FIELD(view_key)
+      VARINT_FIELD(start_height)
+      FIELD(outputs)
+      FIELD(spends)
+    END_SERIALIZE()
+  };
+
+  //! Progress of the scanner, shared by all accounts.
+  struct scan_state
+  {
+    uint64_t height; //!< Next block to scan
+    std::vector<crypto::hash> recent_ids; //!< Ids of the last scanned blocks, oldest first, to detect reorgs
+
+    BEGIN_SERIALIZE_OBJECT()
+      VERSION_FIELD(0)
+      VARINT_FIELD(height)
+      FIELD(recent_ids)
+    END_SERIALIZE()
+  };
+
+  /*! \brief LMDB store of light wallet accounts and scan progress.
+
+      Each account is one record keyed by its address, rewritten whenever
+      the scanner finds something for it. Not thread-safe for writers; the
+      scanner serializes all writes. */
+  class storage
+  {
+  public:
+    //! Opens or creates the environment in directory `path`. \throw std::system_error on failure
+    explicit storage(const std::string& path);
+
+    //! \return All accounts and the scan state, `height == 0` for a new store.
+    expect<void> load(std::vector<account>& accounts, scan_state& state);
+
+    //! Write `accounts` and, if given, `state` in one transaction.
+    expect<void> store(const std::vector<const account*>& accounts, const scan_state* state);
+
+  private:
+    lmdb::database m_db;
+  };
+}
+}
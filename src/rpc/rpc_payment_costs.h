@@ -34,6 +34,7 @@
 #define COST_PER_OUTPUT_INDEXES 1
 #define COST_PER_TX 0.5
 #define COST_PER_KEY_IMAGE 0.01
+#define COST_PER_OUTPUT_KEY 0.01
 #define COST_PER_POOL_HASH 0.01
 #define COST_PER_TX_POOL_STATS 0.2
 #define COST_PER_BLOCK_HEADER 0.1
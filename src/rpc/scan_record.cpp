@@ -0,0 +1,129 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "scan_record.h"
+
+#include <cstring>
+
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "ringct/rctTypes.h"
+
+namespace cryptonote
+{
+namespace rpc
+{
+  bool add_to_scan_record(const transaction& tx, const crypto::hash& tx_hash, block_scan_record& record)
+  {
+    const uint8_t rct_type = tx.version >= 2 ? tx.rct_signatures.type : (uint8_t)rct::RCTTypeNull;
+    if (rct_type != rct::RCTTypeNull && (tx.rct_signatures.outPk.size() != tx.vout.size() || tx.rct_signatures.ecdhInfo.size() != tx.vout.size()))
+      return false;
+
+    record.tx_hashes.push_back(tx_hash);
+    record.unlock_times.push_back(tx.unlock_time);
+    record.rct_types.push_back(rct_type);
+    record.tx_pub_keys.push_back(get_tx_pub_key_from_extra(tx));
+
+    const std::vector<crypto::public_key> additional_pub_keys = get_additional_tx_pub_keys_from_extra(tx);
+    record.additional_pub_key_counts.push_back(additional_pub_keys.size());
+    record.additional_pub_keys.insert(record.additional_pub_keys.end(), additional_pub_keys.begin(), additional_pub_keys.end());
+
+    uint64_t inputs = 0;
+    for (const txin_v& in: tx.vin)
+    {
+      if (in.type() != typeid(txin_to_key))
+        continue;
+      record.key_images.push_back(boost::get<txin_to_key>(in).k_image);
+      ++inputs;
+    }
+    record.input_counts.push_back(inputs);
+
+    record.output_counts.push_back(tx.vout.size());
+    for (std::size_t i = 0; i < tx.vout.size(); ++i)
+    {
+      const tx_out& out = tx.vout[i];
+      if (out.target.type() != typeid(txout_to_key))
+        return false;
+      record.output_keys.push_back(boost::get<txout_to_key>(out.target).key);
+      record.amounts.push_back(out.amount);
+      if (rct_type == rct::RCTTypeNull)
+        continue;
+
+      record.commitments.push_back(tx.rct_signatures.outPk[i].mask);
+      const rct::ecdhTuple& ecdh = tx.rct_signatures.ecdhInfo[i];
+      if (rct_type == rct::RCTTypeBulletproof2 || rct_type == rct::RCTTypeCLSAG)
+      {
+        crypto::hash8 amount;
+        std::memcpy(&amount, ecdh.amount.bytes, sizeof(amount));
+        record.encrypted_amounts.push_back(amount);
+      }
+      else
+      {
+        record.legacy_ecdh_info.push_back(ecdh.mask);
+        record.legacy_ecdh_info.push_back(ecdh.amount);
+      }
+    }
+    return true;
+  }
+
+  bool make_scan_record(const block& b, const crypto::hash& block_id, const crypto::hash& miner_tx_hash, const std::vector<std::pair<crypto::hash, blobdata>>& txs, const bool no_miner_tx, block_scan_record& record)
+  {
+    record.block_id = block_id;
+    record.timestamp = b.timestamp;
+
+    const std::size_t ntxes = txs.size() + (no_miner_tx ? 0 : 1);
+    record.tx_hashes.reserve(ntxes);
+    record.unlock_times.reserve(ntxes);
+    record.rct_types.reserve(ntxes);
+    record.tx_pub_keys.reserve(ntxes);
+    record.additional_pub_key_counts.reserve(ntxes);
+    record.input_counts.reserve(ntxes);
+    record.output_counts.reserve(ntxes);
+
+    if (!no_miner_tx && !add_to_scan_record(b.miner_tx, miner_tx_hash, record))
+      return false;
+    for (const auto& tx_entry: txs)
+    {
+      transaction tx;
+      if (!parse_and_validate_tx_base_from_blob(tx_entry.second, tx) || !add_to_scan_record(tx, tx_entry.first, record))
+        return false;
+    }
+    return true;
+  }
+
+  std::size_t get_scan_record_size(const block_scan_record& record)
+  {
+    return record.tx_hashes.size() * sizeof(crypto::hash) + record.unlock_times.size() * sizeof(uint64_t) +
+      record.rct_types.size() + record.tx_pub_keys.size() * sizeof(crypto::public_key) +
+      (record.additional_pub_key_counts.size() + record.input_counts.size() + record.output_counts.size()) * sizeof(uint64_t) +
+      record.additional_pub_keys.size() * sizeof(crypto::public_key) + record.key_images.size() * sizeof(crypto::key_image) +
+      record.output_keys.size() * sizeof(crypto::public_key) + record.amounts.size() * sizeof(uint64_t) +
+      record.commitments.size() * sizeof(rct::key) + record.encrypted_amounts.size() * sizeof(crypto::hash8) +
+      record.legacy_ecdh_info.size() * sizeof(rct::key);
+  }
+}  // namespace rpc
+}  // namespace cryptonote
@@ -0,0 +1,57 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "crypto/hash.h"
+#include "cryptonote_basic/blobdatatype.h"
+#include "cryptonote_basic/cryptonote_basic.h"
+#include "rpc/core_rpc_server_commands_defs.h"
+
+namespace cryptonote
+{
+namespace rpc
+{
+  typedef COMMAND_RPC_GET_BLOCKS_FAST::block_scan_record block_scan_record;
+
+  //! Append the columns of `tx` to `record`. \return False if `tx` has outputs a scan record cannot hold.
+  bool add_to_scan_record(const transaction& tx, const crypto::hash& tx_hash, block_scan_record& record);
+
+  /*! Fill `record` for block `b`, from the blobs of its non miner
+      transactions. The miner tx comes first unless `no_miner_tx`.
+      \return False if a transaction cannot be parsed or held by a record. */
+  bool make_scan_record(const block& b, const crypto::hash& block_id, const crypto::hash& miner_tx_hash, const std::vector<std::pair<crypto::hash, blobdata>>& txs, bool no_miner_tx, block_scan_record& record);
+
+  //! \return Size of the column data in `record`, in bytes.
+  std::size_t get_scan_record_size(const block_scan_record& record);
+}  // namespace rpc
+}  // namespace cryptonote
@@ -61,6 +61,7 @@ namespace
   using chain_writer =  void(epee::byte_stream&, std::uint64_t, epee::span<const cryptonote::block>);
   using miner_writer =  void(epee::byte_stream&, uint8_t, uint64_t, const crypto::hash&, const crypto::hash&, cryptonote::difficulty_type, uint64_t, uint64_t, const std::vector<cryptonote::tx_block_template_backlog_entry>&);
   using txpool_writer = void(epee::byte_stream&, epee::span<const cryptonote::txpool_event>);
+  using template_writer = void(epee::byte_stream&, const cryptonote::miner_template_event&);
 
   template<typename F>
   struct context
@@ -202,6 +203,13 @@ namespace
     json_pub(buf, miner_data{major_version, height, prev_id, seed_hash, diff, median_weight, already_generated_coins, tx_backlog});
   }
 
+  //! \return `name:...` where `...` is the binary serialization of `event`.
+  void bin_miner_template(epee::byte_stream& buf, const cryptonote::miner_template_event& event)
+  {
+    const cryptonote::blobdata blob = cryptonote::t_serializable_object_to_blob(event);
+    buf.write(blob.data(), blob.size());
+  }
+
   // boost::adaptors are in place "views" - no copy/move takes place
   // moving transactions (via sort, etc.), is expensive!
 
@@ -236,6 +244,11 @@ namespace
     {u8"json-full-miner_data", json_miner_data},
   }};
 
+  constexpr const std::array<context<template_writer>, 1> template_contexts =
+  {{
+    {u8"bin-full-miner_template", bin_miner_template},
+  }};
+
   constexpr const std::array<context<txpool_writer>, 2> txpool_contexts =
   {{
     {u8"json-full-txpool_add", json_full_txpool},
@@ -360,6 +373,7 @@ zmq_pub::zmq_pub(void* context)
   : relay_(),
     chain_subs_{{0}},
     miner_subs_{{0}},
+    template_subs_{{0}},
     txpool_subs_{{0}},
     sync_()
 {
@@ -368,6 +382,7 @@ zmq_pub::zmq_pub(void* context)
 
   verify_sorted(chain_contexts, "chain_contexts");
   verify_sorted(miner_contexts, "miner_contexts");
+  verify_sorted(template_contexts, "template_contexts");
   verify_sorted(txpool_contexts, "txpool_contexts");
 
   relay_.reset(zmq_socket(context, ZMQ_PAIR));
@@ -389,12 +404,13 @@ bool zmq_pub::sub_request(boost::string_ref message)
 
     const auto chain_range = get_range(chain_contexts, message);
     const auto miner_range = get_range(miner_contexts, message);
+    const auto template_range = get_range(template_contexts, message);
     const auto txpool_range = get_range(txpool_contexts, message);
 
-    if (!chain_range.empty() || !miner_range.empty() || !txpool_range.empty())
+    if (!chain_range.empty() || !miner_range.empty() || !template_range.empty() || !txpool_range.empty())
     {
       MDEBUG("Client " << (tag ? "subscribed" : "unsubscribed") << " to " <<
-             chain_range.size() << " chain topic(s), " << miner_range.size() << " miner topic(s) and " << txpool_range.size() << " txpool topic(s)");
+             chain_range.size() << " chain topic(s), " << (miner_range.size() + template_range.size()) << " miner topic(s) and " << txpool_range.size() << " txpool topic(s)");
 
       const boost::lock_guard<boost::mutex> lock{sync_};
       switch (tag)
@@ -402,11 +418,13 @@ bool zmq_pub::sub_request(boost::string_ref message)
       case 0:
         remove_subscriptions(chain_subs_, chain_range, chain_contexts.begin());
         remove_subscriptions(miner_subs_, miner_range, miner_contexts.begin());
+        remove_subscriptions(template_subs_, template_range, template_contexts.begin());
         remove_subscriptions(txpool_subs_, txpool_range, txpool_contexts.begin());
         return true;
       case 1:
         add_subscriptions(chain_subs_, chain_range, chain_contexts.begin());
         add_subscriptions(miner_subs_, miner_range, miner_contexts.begin());
+        add_subscriptions(template_subs_, template_range, template_contexts.begin());
         add_subscriptions(txpool_subs_, txpool_range, txpool_contexts.begin());
         return true;
       default:
@@ -498,6 +516,36 @@ std::size_t zmq_pub::send_miner_data(uint8_t major_version, uint64_t height, con
   return 0;
 }
 
+std::size_t zmq_pub::send_miner_template(const miner_template_event& event)
+{
+  boost::unique_lock<boost::mutex> guard{sync_};
+
+  const auto subs_copy = template_subs_;
+  guard.unlock();
+
+  for (const std::size_t sub : subs_copy)
+  {
+    if (sub)
+    {
+        auto messages = make_pubs(subs_copy, template_contexts, event);
+        guard.lock();
+        return send_messages(relay_.get(), messages);
+    }
+  }
+  return 0;
+}
+
+bool zmq_pub::has_miner_template_subscribers()
+{
+  const boost::lock_guard<boost::mutex> lock{sync_};
+  for (const std::size_t sub : template_subs_)
+  {
+    if (sub)
+      return true;
+  }
+  return false;
+}
+
 std::size_t zmq_pub::send_txpool_add(std::vector<txpool_event> txes)
 {
   if (txes.empty())
@@ -537,6 +585,21 @@ void zmq_pub::miner_data::operator()(uint8_t major_version, uint64_t height, con
     MERROR("Unable to send ZMQ/Pub - ZMQ server destroyed");
 }
 
+void zmq_pub::miner_template::operator()(const miner_template_event& event) const
+{
+  const std::shared_ptr<zmq_pub> self = self_.lock();
+  if (self)
+    self->send_miner_template(event);
+  else
+    MERROR("Unable to send ZMQ/Pub - ZMQ server destroyed");
+}
+
+bool zmq_pub::miner_template_wanted::operator()() const
+{
+  const std::shared_ptr<zmq_pub> self = self_.lock();
+  return self && self->has_miner_template_subscribers();
+}
+
 void zmq_pub::txpool_add::operator()(std::vector<cryptonote::txpool_event> txes) const
 {
   const std::shared_ptr<zmq_pub> self = self_.lock();
@@ -61,6 +61,7 @@ class zmq_pub
     std::deque<std::vector<txpool_event>> txes_;
     std::array<std::size_t, 2> chain_subs_;
     std::array<std::size_t, 1> miner_subs_;
+    std::array<std::size_t, 1> template_subs_;
     std::array<std::size_t, 2> txpool_subs_;
     boost::mutex sync_; //!< Synchronizes counts in `*_subs_` arrays.
 
@@ -95,6 +96,15 @@ class zmq_pub
         \return Number of ZMQ messages sent to relay. */
     std::size_t send_miner_data(uint8_t major_version, uint64_t height, const crypto::hash& prev_id, const crypto::hash& seed_hash, difficulty_type diff, uint64_t median_weight, uint64_t already_generated_coins, const std::vector<tx_block_template_backlog_entry>& tx_backlog);
 
+    /*! Send a `ZMQ_PUB` notification for a new block template body.
+        Thread-safe.
+        \return Number of ZMQ messages sent to relay. */
+    std::size_t send_miner_template(const miner_template_event& event);
+
+    /*! Thread-safe.
+        \return True if a client is subscribed to a miner template topic. */
+    bool has_miner_template_subscribers();
+
     /*! Send a `ZMQ_PUB` notification for new tx(es) being added to the local
         pool. Thread-safe.
         \return Number of ZMQ messages sent to relay. */
@@ -114,6 +124,20 @@ class zmq_pub
       void operator()(uint8_t major_version, uint64_t height, const crypto::hash& prev_id, const crypto::hash& seed_hash, difficulty_type diff, uint64_t median_weight, uint64_t already_generated_coins, const std::vector<tx_block_template_backlog_entry>& tx_backlog) const;
     };
 
+    //! Callable for `send_miner_template` with weak ownership to `zmq_pub` object.
+    struct miner_template
+    {
+      std::weak_ptr<zmq_pub> self_;
+      void operator()(const miner_template_event& event) const;
+    };
+
+    //! Callable for `has_miner_template_subscribers` with weak ownership to `zmq_pub` object.
+    struct miner_template_wanted
+    {
+      std::weak_ptr<zmq_pub> self_;
+      bool operator()() const;
+    };
+
     //! Callable for `send_txpool_add` with weak ownership to `zmq_pub` object.
     struct txpool_add
     {
@@ -116,6 +116,8 @@ boost::optional<std::string> NodeRPCProxy::get_info()
 {
   if (m_offline)
     return boost::optional<std::string>("offline");
+  // held across the cache check too, the wallet may query this from several tx construction threads
+  const boost::lock_guard<boost::recursive_mutex> lock{m_daemon_rpc_mutex};
   const time_t now = time(NULL);
   if (now >= m_get_info_time + 30) // re-cache every 30 seconds
   {
@@ -123,7 +125,6 @@ boost::optional<std::string> NodeRPCProxy::get_info()
     cryptonote::COMMAND_RPC_GET_INFO::response resp_t = AUTO_VAL_INIT(resp_t);
 
     {
-      const boost::lock_guard<boost::recursive_mutex> lock{m_daemon_rpc_mutex};
       uint64_t pre_call_credits = m_rpc_payment_state.credits;
       req_t.client = cryptonote::make_rpc_payment_signature(m_client_id_secret_key);
       bool r = net_utils::invoke_http_json_rpc("/json_rpc", "get_info", req_t, resp_t, m_http_client, rpc_timeout);
@@ -143,6 +144,7 @@ boost::optional<std::string> NodeRPCProxy::get_info()
 
 boost::optional<std::string> NodeRPCProxy::get_height(uint64_t &height)
 {
+  const boost::lock_guard<boost::recursive_mutex> lock{m_daemon_rpc_mutex};
   const time_t now = time(NULL);
   if (now < m_height_time + 30) // re-cache every 30 seconds
   {
@@ -188,6 +190,7 @@ boost::optional<std::string> NodeRPCProxy::get_earliest_height(uint8_t version,
 {
   if (m_offline)
     return boost::optional<std::string>("offline");
+  const boost::lock_guard<boost::recursive_mutex> lock{m_daemon_rpc_mutex};
   if (m_earliest_height[version] == 0)
   {
     cryptonote::COMMAND_RPC_HARD_FORK_INFO::request req_t = AUTO_VAL_INIT(req_t);
@@ -195,7 +198,6 @@ boost::optional<std::string> NodeRPCProxy::get_earliest_height(uint8_t version,
     req_t.version = version;
 
     {
-      const boost::lock_guard<boost::recursive_mutex> lock{m_daemon_rpc_mutex};
       uint64_t pre_call_credits = m_rpc_payment_state.credits;
       req_t.client = cryptonote::make_rpc_payment_signature(m_client_id_secret_key);
       bool r = net_utils::invoke_http_json_rpc("/json_rpc", "hard_fork_info", req_t, resp_t, m_http_client, rpc_timeout);
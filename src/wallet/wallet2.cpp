@@ -121,6 +121,7 @@ using namespace cryptonote;
 
 #define SUBADDRESS_LOOKAHEAD_MAJOR 50
 #define SUBADDRESS_LOOKAHEAD_MINOR 200
+#define SUBADDRESS_PARALLEL_EXPANSION_MIN 4096 // below that, one thread derives the keys
 
 #define KEY_IMAGE_EXPORT_FILE_MAGIC "Lozzax key image export\003"
 
@@ -134,6 +135,8 @@ using namespace cryptonote;
 #define SEGREGATION_FORK_VICINITY 1500 /* blocks */
 
 #define FIRST_REFRESH_GRANULARITY     1024
+#define RESCAN_STORE_INTERVAL_BLOCKS  20000 // a hard rescan stores its progress that often
+#define RESCAN_SPENT_CHUNK_SIZE       1000
 
 #define GAMMA_SHAPE 19.28
 #define GAMMA_SCALE (1/1.61)
@@ -1171,6 +1174,7 @@ wallet2::wallet2(network_type nettype, uint64_t kdf_rounds, bool unattended, std
   m_multisig_rescan_k(NULL),
   m_upper_transaction_weight_limit(0),
   m_run(true),
+  m_store_rescan_progress(false),
   m_callback(0),
   m_trusted_daemon(false),
   m_nettype(nettype),
@@ -1224,6 +1228,7 @@ wallet2::wallet2(network_type nettype, uint64_t kdf_rounds, bool unattended, std
   m_light_wallet_unlocked_balance(0),
   m_original_keys_available(false),
   m_message_store(http_client_factory->create()),
+  m_http_pool(std::move(http_client_factory)),
   m_key_device_type(hw::device::device_type::SOFTWARE),
   m_ring_history_saved(false),
   m_ringdb(),
@@ -1361,7 +1366,9 @@ bool wallet2::set_daemon(std::string daemon_address, boost::optional<epee::net_u
 
   const std::string address = get_daemon_address();
   MINFO("setting daemon to " << address);
-  bool ret =  m_http_client->set_server(address, get_daemon_login(), std::move(ssl_options));
+  bool ret =  m_http_client->set_server(address, get_daemon_login(), ssl_options);
+  if (ret)
+    ret = m_http_pool.set_server(address, get_daemon_login(), std::move(ssl_options));
   if (ret)
   {
     CRITICAL_REGION_LOCAL(default_daemon_address_lock);
@@ -1372,7 +1379,7 @@ bool wallet2::set_daemon(std::string daemon_address, boost::optional<epee::net_u
 //----------------------------------------------------------------------------------------------------
 bool wallet2::set_proxy(const std::string &address)
 {
-  return m_http_client->set_proxy(address);
+  return m_http_client->set_proxy(address) && m_http_pool.set_proxy(address);
 }
 //----------------------------------------------------------------------------------------------------
 bool wallet2::init(std::string daemon_address, boost::optional<epee::net_utils::http::login> daemon_login, const std::string &proxy_address, uint64_t upper_transaction_weight_limit, bool trusted_daemon, epee::net_utils::ssl_options_t ssl_options)
@@ -1529,10 +1536,10 @@ cryptonote::account_public_address wallet2::get_subaddress(const cryptonote::sub
 //----------------------------------------------------------------------------------------------------
 boost::optional<cryptonote::subaddress_index> wallet2::get_subaddress_index(const cryptonote::account_public_address& address) const
 {
-  auto index = m_subaddresses.find(address.m_spend_public_key);
-  if (index == m_subaddresses.end())
+  const cryptonote::subaddress_index* index = m_subaddresses.find(address.m_spend_public_key);
+  if (!index)
     return boost::none;
-  return index->second;
+  return *index;
 }
 //----------------------------------------------------------------------------------------------------
 crypto::public_key wallet2::get_subaddress_spend_public_key(const cryptonote::subaddress_index& index) const
@@ -1581,22 +1588,12 @@ bool wallet2::should_expand(const cryptonote::subaddress_index &index) const
 //----------------------------------------------------------------------------------------------------
 void wallet2::expand_subaddresses(const cryptonote::subaddress_index& index)
 {
-  hw::device &hwdev = m_account.get_device();
   if (m_subaddress_labels.size() <= index.major)
   {
     // add new accounts
-    cryptonote::subaddress_index index2;
     const uint32_t major_end = get_subaddress_clamped_sum(index.major, m_subaddress_lookahead_major);
-    for (index2.major = m_subaddress_labels.size(); index2.major < major_end; ++index2.major)
-    {
-      const uint32_t end = get_subaddress_clamped_sum((index2.major == index.major ? index.minor : 0), m_subaddress_lookahead_minor);
-      const std::vector<crypto::public_key> pkeys = hwdev.get_subaddress_spend_public_keys(m_account.get_keys(), index2.major, 0, end);
-      for (index2.minor = 0; index2.minor < end; ++index2.minor)
-      {
-         const crypto::public_key &D = pkeys[index2.minor];
-         m_subaddresses[D] = index2;
-      }
-    }
+    for (uint32_t major = m_subaddress_labels.size(); major < major_end; ++major)
+      expand_subaddress_keys(major, get_subaddress_clamped_sum((major == index.major ? index.minor : 0), m_subaddress_lookahead_minor));
     m_subaddress_labels.resize(index.major + 1, {"Untitled account"});
     m_subaddress_labels[index.major].resize(index.minor + 1);
     get_account_tags();
@@ -1604,23 +1601,48 @@ void wallet2::expand_subaddresses(const cryptonote::subaddress_index& index)
   else if (m_subaddress_labels[index.major].size() <= index.minor)
   {
     // add new subaddresses
-    const uint32_t end = get_subaddress_clamped_sum(index.minor, m_subaddress_lookahead_minor);
-    const uint32_t begin = m_subaddress_labels[index.major].size();
-    cryptonote::subaddress_index index2 = {index.major, begin};
-    const std::vector<crypto::public_key> pkeys = hwdev.get_subaddress_spend_public_keys(m_account.get_keys(), index2.major, index2.minor, end);
-    for (; index2.minor < end; ++index2.minor)
-    {
-       const crypto::public_key &D = pkeys[index2.minor - begin];
-       m_subaddresses[D] = index2;
-    }
+    expand_subaddress_keys(index.major, get_subaddress_clamped_sum(index.minor, m_subaddress_lookahead_minor));
     m_subaddress_labels[index.major].resize(index.minor + 1);
   }
 }
 //----------------------------------------------------------------------------------------------------
+void wallet2::expand_subaddress_keys(uint32_t major, uint32_t end)
+{
+  // the lookahead window of earlier calls is already there, only derive past it
+  const uint32_t begin = m_subaddresses.expanded(major);
+  if (begin >= end)
+    return;
+
+  hw::device &hwdev = m_account.get_device();
+  tools::threadpool& tpool = tools::threadpool::getInstance();
+  const uint32_t threads = tpool.get_max_concurrency();
+  if (hwdev.get_type() != hw::device::SOFTWARE || threads < 2 || end - begin < SUBADDRESS_PARALLEL_EXPANSION_MIN)
+  {
+    m_subaddresses.insert(major, begin, hwdev.get_subaddress_spend_public_keys(m_account.get_keys(), major, begin, end));
+    return;
+  }
+
+  // a large lookahead is split over the thread pool, in chunks that are added in order
+  const uint32_t chunk = (end - begin + threads - 1) / threads;
+  std::vector<std::vector<crypto::public_key>> pkeys(threads);
+  tools::threadpool::waiter waiter(tpool);
+  for (uint32_t i = 0; i < threads; ++i)
+  {
+    const uint32_t first = begin + std::min(end - begin, i * chunk);
+    const uint32_t last = begin + std::min(end - begin, (i + 1) * chunk);
+    tpool.submit(&waiter, [this, &hwdev, &pkeys, i, major, first, last](){
+      pkeys[i] = hwdev.get_subaddress_spend_public_keys(m_account.get_keys(), major, first, last);
+    }, true);
+  }
+  THROW_WALLET_EXCEPTION_IF(!waiter.wait(), error::wallet_internal_error, "Exception in thread pool");
+  for (uint32_t i = 0; i < threads; ++i)
+    m_subaddresses.insert(major, begin + std::min(end - begin, i * chunk), pkeys[i]);
+}
+//----------------------------------------------------------------------------------------------------
 void wallet2::create_one_off_subaddress(const cryptonote::subaddress_index& index)
 {
   const crypto::public_key pkey = get_subaddress_spend_public_key(index);
-  m_subaddresses[pkey] = index;
+  m_subaddresses.insert(pkey, index);
 }
 //----------------------------------------------------------------------------------------------------
 std::string wallet2::get_subaddress_label(const cryptonote::subaddress_index& index) const
@@ -1917,6 +1939,11 @@ void wallet2::scan_output(const cryptonote::transaction &tx, bool miner_tx, cons
 }
 //----------------------------------------------------------------------------------------------------
 void wallet2::cache_tx_data(const cryptonote::transaction& tx, const crypto::hash &txid, tx_cache_data &tx_cache_data) const
+{
+  cache_tx_data(tx, txid, m_refresh_type, tx_cache_data);
+}
+//----------------------------------------------------------------------------------------------------
+void wallet2::cache_tx_data(const cryptonote::transaction& tx, const crypto::hash &txid, RefreshType refresh_type, tx_cache_data &tx_cache_data)
 {
   if(!parse_tx_extra(tx.extra, tx_cache_data.tx_extra_fields))
   {
@@ -1928,9 +1955,9 @@ void wallet2::cache_tx_data(const cryptonote::transaction& tx, const crypto::has
 
   // Don't try to extract tx public key if tx has no ouputs
   const bool is_miner = tx.vin.size() == 1 && tx.vin[0].type() == typeid(cryptonote::txin_gen);
-  if (!is_miner || m_refresh_type != RefreshType::RefreshNoCoinbase)
+  if (!is_miner || refresh_type != RefreshType::RefreshNoCoinbase)
   {
-    const size_t rec_size = (is_miner && m_refresh_type == RefreshType::RefreshOptimizeCoinbase && tx.version < 2) ? 1 : tx.vout.size();
+    const size_t rec_size = (is_miner && refresh_type == RefreshType::RefreshOptimizeCoinbase && tx.version < 2) ? 1 : tx.vout.size();
     if (!tx.vout.empty())
     {
       // if tx.vout is not empty, we loop through all tx pubkeys
@@ -2696,7 +2723,32 @@ void wallet2::parse_block_round(const cryptonote::blobdata &blob, cryptonote::bl
   error = !cryptonote::parse_and_validate_block_from_blob(blob, bl, bl_id);
 }
 //----------------------------------------------------------------------------------------------------
-void wallet2::pull_blocks(uint64_t start_height, uint64_t &blocks_start_height, const std::list<crypto::hash> &short_chain_history, std::vector<cryptonote::block_complete_entry> &blocks, std::vector<cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices> &o_indices, uint64_t &current_height)
+wallet2::daemon_client::daemon_client(wallet2 &wallet):
+  m_wallet(wallet),
+  m_lock(wallet.m_daemon_rpc_mutex),
+  m_lease(),
+  m_pre_call_credits(wallet.m_rpc_payment_state.credits)
+{
+  // without credits, check_rpc_cost has no balance to compare with
+  if (m_pre_call_credits == 0)
+  {
+    m_lease = wallet.m_http_pool.acquire();
+    m_lock.unlock();
+  }
+}
+//----------------------------------------------------------------------------------------------------
+epee::net_utils::http::abstract_http_client &wallet2::daemon_client::operator*() const
+{
+  return m_lease ? *m_lease : *m_wallet.m_http_client;
+}
+//----------------------------------------------------------------------------------------------------
+void wallet2::daemon_client::check_rpc_cost(const char *call, uint64_t post_call_credits, double expected_cost)
+{
+  const boost::lock_guard<boost::recursive_mutex> lock{m_wallet.m_daemon_rpc_mutex};
+  m_wallet.check_rpc_cost(call, post_call_credits, m_pre_call_credits, expected_cost);
+}
+//----------------------------------------------------------------------------------------------------
+void wallet2::pull_blocks(uint64_t start_height, uint64_t &blocks_start_height, const std::list<crypto::hash> &short_chain_history, std::vector<cryptonote::block_complete_entry> &blocks, std::vector<cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices> &o_indices, uint64_t &current_height, bool no_miner_tx)
 {
   cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::request req = AUTO_VAL_INIT(req);
   cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::response res = AUTO_VAL_INIT(res);
@@ -2706,18 +2758,17 @@ void wallet2::pull_blocks(uint64_t start_height, uint64_t &blocks_start_height,
 
   req.prune = true;
   req.start_height = start_height;
-  req.no_miner_tx = m_refresh_type == RefreshNoCoinbase;
+  req.no_miner_tx = no_miner_tx;
 
   {
-    const boost::lock_guard<boost::recursive_mutex> lock{m_daemon_rpc_mutex};
-    uint64_t pre_call_credits = m_rpc_payment_state.credits;
+    daemon_client client{*this};
     req.client = get_client_signature();
-    bool r = net_utils::invoke_http_bin("/getblocks.bin", req, res, *m_http_client, rpc_timeout);
+    bool r = net_utils::invoke_http_bin("/getblocks.bin", req, res, *client, rpc_timeout);
     THROW_ON_RPC_RESPONSE_ERROR(r, {}, res, "getblocks.bin", error::get_blocks_error, get_rpc_status(res.status));
     THROW_WALLET_EXCEPTION_IF(res.blocks.size() != res.output_indices.size(), error::wallet_internal_error,
         "mismatched blocks (" + boost::lexical_cast<std::string>(res.blocks.size()) + ") and output_indices (" +
         boost::lexical_cast<std::string>(res.output_indices.size()) + ") sizes from daemon");
-    check_rpc_cost("/getblocks.bin", res.credits, pre_call_credits, 1 + res.blocks.size() * COST_PER_BLOCK);
+    client.check_rpc_cost("/getblocks.bin", res.credits, 1 + res.blocks.size() * COST_PER_BLOCK);
   }
 
   blocks_start_height = res.start_height;
@@ -2738,19 +2789,18 @@ void wallet2::pull_hashes(uint64_t start_height, uint64_t &blocks_start_height,
   req.start_height = start_height;
 
   {
-    const boost::lock_guard<boost::recursive_mutex> lock{m_daemon_rpc_mutex};
+    daemon_client client{*this};
     req.client = get_client_signature();
-    uint64_t pre_call_credits = m_rpc_payment_state.credits;
-    bool r = net_utils::invoke_http_bin("/gethashes.bin", req, res, *m_http_client, rpc_timeout);
+    bool r = net_utils::invoke_http_bin("/gethashes.bin", req, res, *client, rpc_timeout);
     THROW_ON_RPC_RESPONSE_ERROR(r, {}, res, "gethashes.bin", error::get_hashes_error, get_rpc_status(res.status));
-    check_rpc_cost("/gethashes.bin", res.credits, pre_call_credits, 1 + res.m_block_ids.size() * COST_PER_BLOCK_HASH);
+    client.check_rpc_cost("/gethashes.bin", res.credits, 1 + res.m_block_ids.size() * COST_PER_BLOCK_HASH);
   }
 
   blocks_start_height = res.start_height;
   hashes = std::move(res.m_block_ids);
 }
 //----------------------------------------------------------------------------------------------------
-void wallet2::process_parsed_blocks(uint64_t start_height, const std::vector<cryptonote::block_complete_entry> &blocks, const std::vector<parsed_block> &parsed_blocks, uint64_t& blocks_added, std::map<std::pair<uint64_t, uint64_t>, size_t> *output_tracker_cache)
+void wallet2::process_parsed_blocks(uint64_t start_height, const std::vector<cryptonote::block_complete_entry> &blocks, const std::vector<parsed_block> &parsed_blocks, uint64_t& blocks_added, std::map<std::pair<uint64_t, uint64_t>, size_t> *output_tracker_cache, const std::vector<tx_cache_data> *shared_tx_cache_data)
 {
   size_t current_index = start_height;
   blocks_added = 0;
@@ -2766,6 +2816,7 @@ void wallet2::process_parsed_blocks(uint64_t start_height, const std::vector<cry
   for (size_t i = 0; i < blocks.size(); ++i)
     num_txes += 1 + parsed_blocks[i].txes.size();
   tx_cache_data.resize(num_txes);
+  THROW_WALLET_EXCEPTION_IF(shared_tx_cache_data && shared_tx_cache_data->size() != num_txes, error::wallet_internal_error, "Mismatched shared tx cache data size");
   size_t txidx = 0;
   for (size_t i = 0; i < blocks.size(); ++i)
   {
@@ -2776,6 +2827,22 @@ void wallet2::process_parsed_blocks(uint64_t start_height, const std::vector<cry
       txidx += 1 + parsed_blocks[i].block.tx_hashes.size();
       continue;
     }
+    if (shared_tx_cache_data)
+    {
+      // cached for RefreshFull, only the miner tx depends on the refresh type
+      const cryptonote::transaction &miner_tx = parsed_blocks[i].block.miner_tx;
+      if (m_refresh_type != RefreshNoCoinbase)
+      {
+        tx_cache_data[txidx] = (*shared_tx_cache_data)[txidx];
+        if (m_refresh_type == RefreshOptimizeCoinbase && miner_tx.version < 2 && !miner_tx.vout.empty())
+          for (auto &iod: tx_cache_data[txidx].primary)
+            iod.received.resize(1);
+      }
+      ++txidx;
+      for (size_t idx = 0; idx < parsed_blocks[i].txes.size(); ++idx, ++txidx)
+        tx_cache_data[txidx] = (*shared_tx_cache_data)[txidx];
+      continue;
+    }
     if (m_refresh_type != RefreshNoCoinbase)
       tpool.submit(&waiter, [&, i, txidx](){ cache_tx_data(parsed_blocks[i].block.miner_tx, get_transaction_hash(parsed_blocks[i].block.miner_tx), tx_cache_data[txidx]); });
     ++txidx;
@@ -2909,7 +2976,7 @@ void wallet2::refresh(bool trusted_daemon, uint64_t start_height, uint64_t & blo
   refresh(trusted_daemon, start_height, blocks_fetched, received_money);
 }
 //----------------------------------------------------------------------------------------------------
-void wallet2::pull_and_parse_next_blocks(uint64_t start_height, uint64_t &blocks_start_height, std::list<crypto::hash> &short_chain_history, const std::vector<cryptonote::block_complete_entry> &prev_blocks, const std::vector<parsed_block> &prev_parsed_blocks, std::vector<cryptonote::block_complete_entry> &blocks, std::vector<parsed_block> &parsed_blocks, bool &last, bool &error, std::exception_ptr &exception)
+void wallet2::pull_and_parse_next_blocks(uint64_t start_height, uint64_t &blocks_start_height, std::list<crypto::hash> &short_chain_history, const std::vector<cryptonote::block_complete_entry> &prev_blocks, const std::vector<parsed_block> &prev_parsed_blocks, std::vector<cryptonote::block_complete_entry> &blocks, std::vector<parsed_block> &parsed_blocks, bool &last, bool &error, std::exception_ptr &exception, bool no_miner_tx)
 {
   error = false;
   last = false;
@@ -2931,7 +2998,7 @@ void wallet2::pull_and_parse_next_blocks(uint64_t start_height, uint64_t &blocks
     // pull the new blocks
     std::vector<cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices> o_indices;
     uint64_t current_height;
-    pull_blocks(start_height, blocks_start_height, short_chain_history, blocks, o_indices, current_height);
+    pull_blocks(start_height, blocks_start_height, short_chain_history, blocks, o_indices, current_height, no_miner_tx);
     THROW_WALLET_EXCEPTION_IF(blocks.size() != o_indices.size(), error::wallet_internal_error, "Mismatched sizes of blocks and o_indices");
 
     tools::threadpool& tpool = tools::threadpool::getInstance();
@@ -3019,12 +3086,11 @@ void wallet2::update_pool_state(std::vector<std::tuple<cryptonote::transaction,
   cryptonote::COMMAND_RPC_GET_TRANSACTION_POOL_HASHES_BIN::response res;
 
   {
-    const boost::lock_guard<boost::recursive_mutex> lock{m_daemon_rpc_mutex};
-    uint64_t pre_call_credits = m_rpc_payment_state.credits;
+    daemon_client client{*this};
     req.client = get_client_signature();
-    bool r = epee::net_utils::invoke_http_json("/get_transaction_pool_hashes.bin", req, res, *m_http_client, rpc_timeout);
+    bool r = epee::net_utils::invoke_http_json("/get_transaction_pool_hashes.bin", req, res, *client, rpc_timeout);
     THROW_ON_RPC_RESPONSE_ERROR(r, {}, res, "get_transaction_pool_hashes.bin", error::get_tx_pool_error);
-    check_rpc_cost("/get_transaction_pool_hashes.bin", res.credits, pre_call_credits, 1 + res.tx_hashes.size() * COST_PER_POOL_HASH);
+    client.check_rpc_cost("/get_transaction_pool_hashes.bin", res.credits, 1 + res.tx_hashes.size() * COST_PER_POOL_HASH);
   }
   MTRACE("update_pool_state got pool");
 
@@ -3134,8 +3200,8 @@ void wallet2::update_pool_state(std::vector<std::tuple<cryptonote::transaction,
           const unconfirmed_transfer_details& utd = i.second;
           for (const auto& dst : utd.m_dests)
           {
-            auto subaddr_index = m_subaddresses.find(dst.addr.m_spend_public_key);
-            if (subaddr_index != m_subaddresses.end() && subaddr_index->second.major != utd.m_subaddr_account)
+            const cryptonote::subaddress_index* subaddr_index = m_subaddresses.find(dst.addr.m_spend_public_key);
+            if (subaddr_index && subaddr_index->major != utd.m_subaddr_account)
             {
               found = false;
               break;
@@ -3169,12 +3235,11 @@ void wallet2::update_pool_state(std::vector<std::tuple<cryptonote::transaction,
 
     bool r;
     {
-      const boost::lock_guard<boost::recursive_mutex> lock{m_daemon_rpc_mutex};
-      uint64_t pre_call_credits = m_rpc_payment_state.credits;
+      daemon_client client{*this};
       req.client = get_client_signature();
-      r = epee::net_utils::invoke_http_json("/gettransactions", req, res, *m_http_client, rpc_timeout);
+      r = epee::net_utils::invoke_http_json("/gettransactions", req, res, *client, rpc_timeout);
       if (r && res.status == CORE_RPC_STATUS_OK)
-        check_rpc_cost("/gettransactions", res.credits, pre_call_credits, res.txs.size() * COST_PER_TX);
+        client.check_rpc_cost("/gettransactions", res.credits, res.txs.size() * COST_PER_TX);
     }
 
     MDEBUG("Got " << r << " and " << res.status);
@@ -3450,11 +3515,14 @@ void wallet2::refresh(bool trusted_daemon, uint64_t start_height, uint64_t & blo
   // get updated pool state first, but do not process those txes just yet,
   // since that might cause a password prompt, which would introduce a data
   // leak allowing a passive adversary with traffic analysis capability to
-  // infer when we get an incoming output
+  // infer when we get an incoming output. This is done while the first set
+  // of blocks is being pulled, on a connection of its own
   std::vector<std::tuple<cryptonote::transaction, crypto::hash, bool>> process_pool_txs;
-  update_pool_state(process_pool_txs, true);
+  bool pool_state_updated = false;
+  std::exception_ptr pool_state_exception;
 
   bool first = true, last = false;
+  uint64_t stored_blocks = 0;
   while(m_run.load(std::memory_order_relaxed))
   {
     uint64_t next_blocks_start_height;
@@ -3477,7 +3545,14 @@ void wallet2::refresh(bool trusted_daemon, uint64_t start_height, uint64_t & blo
         break;
       }
       if (!last)
-        tpool.submit(&waiter, [&]{pull_and_parse_next_blocks(start_height, next_blocks_start_height, short_chain_history, blocks, parsed_blocks, next_blocks, next_parsed_blocks, last, error, exception);});
+        tpool.submit(&waiter, [&]{pull_and_parse_next_blocks(start_height, next_blocks_start_height, short_chain_history, blocks, parsed_blocks, next_blocks, next_parsed_blocks, last, error, exception, m_refresh_type == RefreshNoCoinbase);});
+
+      if (!pool_state_updated)
+      {
+        pool_state_updated = true;
+        try { update_pool_state(process_pool_txs, true); }
+        catch (...) { pool_state_exception = std::current_exception(); }
+      }
 
       if (!first)
       {
@@ -3516,6 +3591,8 @@ void wallet2::refresh(bool trusted_daemon, uint64_t start_height, uint64_t & blo
         blocks_fetched += added_blocks;
       }
       THROW_WALLET_EXCEPTION_IF(!waiter.wait(), error::wallet_internal_error, "Exception in thread pool");
+      if (pool_state_exception)
+        break;
 
       // handle error from async fetching thread
       if (error)
@@ -3535,6 +3612,15 @@ void wallet2::refresh(bool trusted_daemon, uint64_t start_height, uint64_t & blo
 
       first = false;
 
+      // a hard rescan starts from an empty cache, store it now and then so
+      // that an interrupted rescan carries on from there when reopened
+      if (m_store_rescan_progress && blocks_fetched >= stored_blocks + RESCAN_STORE_INTERVAL_BLOCKS)
+      {
+        MINFO("Storing rescan progress at height " << m_blockchain.size());
+        store();
+        stored_blocks = blocks_fetched;
+      }
+
       if (!next_blocks.empty())
       {
         const uint64_t expected_start_height = std::max(static_cast<uint64_t>(m_blockchain.size()), uint64_t(1)) - 1;
@@ -3593,6 +3679,8 @@ void wallet2::refresh(bool trusted_daemon, uint64_t start_height, uint64_t & blo
       }
     }
   }
+  if (pool_state_exception)
+    std::rethrow_exception(pool_state_exception);
   if(last_tx_hash_id != (m_transfers.size() ? m_transfers.back().m_txid : null_hash))
     received_money = true;
 
@@ -3608,6 +3696,8 @@ void wallet2::refresh(bool trusted_daemon, uint64_t start_height, uint64_t & blo
   }
 
   m_first_refresh_done = true;
+  if (refreshed)
+    m_store_rescan_progress = false;
 
   LOG_PRINT_L1("Refresh done, blocks received: " << blocks_fetched << ", balance (all accounts): " << print_money(balance_all(false)) << ", unlocked: " << print_money(unlocked_balance_all(false)));
 }
@@ -3626,6 +3716,185 @@ bool wallet2::refresh(bool trusted_daemon, uint64_t & blocks_fetched, bool& rece
   return ok;
 }
 //----------------------------------------------------------------------------------------------------
+void wallet2::refresh_wallets(const std::vector<wallet2*>& wallets, bool trusted_daemon, std::vector<uint64_t>& blocks_fetched)
+{
+  blocks_fetched.assign(wallets.size(), 0);
+
+  std::vector<size_t> shared, single;
+  for (size_t n = 0; n < wallets.size(); ++n)
+  {
+    wallet2 &w = *wallets[n];
+    if (w.m_offline || w.m_light_wallet)
+    {
+      single.push_back(n);
+      continue;
+    }
+    w.m_run.store(true, std::memory_order_relaxed);
+    try
+    {
+      // below the restore height only hashes are needed, and those are cheap
+      if (w.m_refresh_from_block_height > w.m_blockchain.size())
+      {
+        std::list<crypto::hash> short_chain_history;
+        uint64_t blocks_start_height;
+        w.get_short_chain_history(short_chain_history, (w.m_first_refresh_done || trusted_daemon) ? 1 : FIRST_REFRESH_GRANULARITY);
+        w.fast_refresh(w.m_refresh_from_block_height, blocks_start_height, short_chain_history);
+      }
+      shared.push_back(n);
+    }
+    catch (const std::exception &e)
+    {
+      MWARNING("Failed to fast refresh a wallet, refreshing it on its own: " << e.what());
+      single.push_back(n);
+    }
+  }
+
+  tools::threadpool& tpool = tools::threadpool::getInstance();
+  tools::threadpool::waiter waiter(tpool);
+  std::vector<std::shared_ptr<std::map<std::pair<uint64_t, uint64_t>, size_t>>> output_tracker_caches(wallets.size());
+  std::vector<size_t> done;
+  while (!shared.empty())
+  {
+    // pull for the wallet furthest behind, the others skip the blocks they already have
+    const size_t leader = *std::min_element(shared.begin(), shared.end(), [&](size_t a, size_t b) {
+      return wallets[a]->m_blockchain.size() < wallets[b]->m_blockchain.size();
+    });
+    wallet2 &lw = *wallets[leader];
+    const bool no_miner_tx = std::all_of(shared.begin(), shared.end(), [&](size_t n) {
+      return wallets[n]->m_refresh_type == RefreshNoCoinbase;
+    });
+
+    std::list<crypto::hash> short_chain_history;
+    lw.get_short_chain_history(short_chain_history, (lw.m_first_refresh_done || trusted_daemon) ? 1 : FIRST_REFRESH_GRANULARITY);
+    uint64_t blocks_start_height = 0;
+    std::vector<cryptonote::block_complete_entry> blocks;
+    std::vector<parsed_block> parsed_blocks;
+    bool last = false, error = false;
+    std::exception_ptr exception;
+    lw.pull_and_parse_next_blocks(0, blocks_start_height, short_chain_history, {}, {}, blocks, parsed_blocks, last, error, exception, no_miner_tx);
+    if (error)
+    {
+      MWARNING("Failed to pull blocks for the shared refresh, refreshing wallets on their own");
+      single.insert(single.end(), shared.begin(), shared.end());
+      break;
+    }
+    if (blocks.empty())
+    {
+      done.insert(done.end(), shared.begin(), shared.end());
+      break;
+    }
+
+    // the tx extra is parsed once for all wallets, derivations stay per wallet
+    size_t num_txes = 0;
+    for (const parsed_block &pb: parsed_blocks)
+      num_txes += 1 + pb.txes.size();
+    std::vector<tx_cache_data> tx_cache_data(num_txes);
+    size_t txidx = 0;
+    for (size_t i = 0; i < parsed_blocks.size(); ++i)
+    {
+      tpool.submit(&waiter, [&, i, txidx](){ cache_tx_data(parsed_blocks[i].block.miner_tx, get_transaction_hash(parsed_blocks[i].block.miner_tx), RefreshFull, tx_cache_data[txidx]); });
+      ++txidx;
+      for (size_t idx = 0; idx < parsed_blocks[i].txes.size() && idx < parsed_blocks[i].block.tx_hashes.size(); ++idx, ++txidx)
+        tpool.submit(&waiter, [&, i, idx, txidx](){ cache_tx_data(parsed_blocks[i].txes[idx], parsed_blocks[i].block.tx_hashes[idx], RefreshFull, tx_cache_data[txidx]); });
+    }
+    THROW_WALLET_EXCEPTION_IF(!waiter.wait(), error::wallet_internal_error, "Exception in thread pool");
+
+    const uint64_t blocks_end_height = blocks_start_height + blocks.size();
+    bool progress = false;
+    std::vector<size_t> next_shared;
+    for (const size_t n: shared)
+    {
+      wallet2 &w = *wallets[n];
+      if (!w.m_run.load(std::memory_order_relaxed))
+        continue;
+      if (!w.m_blockchain.is_in_bounds(blocks_start_height))
+      {
+        single.push_back(n);
+        continue;
+      }
+
+      const uint64_t size = w.m_blockchain.size();
+      uint64_t split = std::min(size, blocks_end_height);
+      for (uint64_t h = blocks_start_height; h < split; ++h)
+      {
+        if (parsed_blocks[h - blocks_start_height].hash != w.m_blockchain[h])
+        {
+          split = h;
+          break;
+        }
+      }
+      if (split >= blocks_end_height)
+      {
+        // ahead of this batch and on the same chain
+        next_shared.push_back(n);
+        continue;
+      }
+      if (size - split > w.m_max_reorg_depth)
+      {
+        // a regular refresh reports the reorg depth error
+        single.push_back(n);
+        continue;
+      }
+
+      try
+      {
+        if (w.m_track_uses && !output_tracker_caches[n] && blocks.size() >= 10)
+          output_tracker_caches[n] = w.create_output_tracker_cache();
+        uint64_t added_blocks = 0;
+        w.process_parsed_blocks(blocks_start_height, blocks, parsed_blocks, added_blocks, output_tracker_caches[n].get(), &tx_cache_data);
+        w.m_encrypt_keys_after_refresh.reset();
+        blocks_fetched[n] += added_blocks;
+        progress = progress || added_blocks > 0;
+        next_shared.push_back(n);
+      }
+      catch (const std::exception &e)
+      {
+        w.m_encrypt_keys_after_refresh.reset();
+        MWARNING("Shared refresh failed for a wallet, refreshing it on its own: " << e.what());
+        single.push_back(n);
+      }
+    }
+    shared = std::move(next_shared);
+
+    if (last)
+    {
+      // the rest is at the tip already
+      done.insert(done.end(), shared.begin(), shared.end());
+      break;
+    }
+    if (!progress)
+    {
+      single.insert(single.end(), shared.begin(), shared.end());
+      break;
+    }
+  }
+
+  for (const size_t n: done)
+  {
+    wallet2 &w = *wallets[n];
+    w.m_node_rpc_proxy.set_height(w.m_blockchain.size());
+    try
+    {
+      std::vector<std::tuple<cryptonote::transaction, crypto::hash, bool>> process_pool_txs;
+      w.update_pool_state(process_pool_txs, true);
+      if (!process_pool_txs.empty())
+        w.process_pool_state(process_pool_txs);
+    }
+    catch (...)
+    {
+      LOG_PRINT_L1("Failed to check pending transactions");
+    }
+    w.m_first_refresh_done = true;
+  }
+
+  for (const size_t n: single)
+  {
+    uint64_t fetched = 0;
+    wallets[n]->refresh(trusted_daemon, 0, fetched);
+    blocks_fetched[n] += fetched;
+  }
+}
+//----------------------------------------------------------------------------------------------------
 bool wallet2::get_rct_distribution(uint64_t &start_height, std::vector<uint64_t> &distribution)
 {
   uint32_t rpc_version;
@@ -5656,11 +5925,13 @@ void wallet2::set_offline(bool offline)
   m_offline = offline;
   m_node_rpc_proxy.set_offline(offline);
   m_http_client->set_auto_connect(!offline);
+  m_http_pool.set_auto_connect(!offline);
   if (offline)
   {
     boost::lock_guard<boost::recursive_mutex> lock(m_daemon_rpc_mutex);
     if(m_http_client->is_connected())
       m_http_client->disconnect();
+    m_http_pool.disconnect();
   }
 }
 //----------------------------------------------------------------------------------------------------
@@ -6274,54 +6545,94 @@ void wallet2::get_unconfirmed_payments(std::list<std::pair<crypto::hash,wallet2:
 void wallet2::rescan_spent()
 {
   // This is RPC call that can take a long time if there are many outputs,
-  // so we call it several times, in stripes, so we don't time out spuriously
-  std::vector<int> spent_status;
-  spent_status.reserve(m_transfers.size());
-  const size_t chunk_size = 1000;
-  for (size_t start_offset = 0; start_offset < m_transfers.size(); start_offset += chunk_size)
+  // so we call it several times, in stripes, so we don't time out spuriously.
+  // A window of stripes is in flight at once, and applied before the next
+  // one is requested, so memory does not grow with the number of outputs
+  struct stripe
   {
-    const size_t n_outputs = std::min<size_t>(chunk_size, m_transfers.size() - start_offset);
-    MDEBUG("Calling is_key_image_spent on " << start_offset << " - " << (start_offset + n_outputs - 1) << ", out of " << m_transfers.size());
-    COMMAND_RPC_IS_KEY_IMAGE_SPENT::request req = AUTO_VAL_INIT(req);
-    COMMAND_RPC_IS_KEY_IMAGE_SPENT::response daemon_resp = AUTO_VAL_INIT(daemon_resp);
-    for (size_t n = start_offset; n < start_offset + n_outputs; ++n)
-      req.key_images.push_back(string_tools::pod_to_hex(m_transfers[n].m_key_image));
+    std::vector<size_t> transfers;
+    COMMAND_RPC_IS_KEY_IMAGE_SPENT::response daemon_resp;
+    std::exception_ptr exception;
+  };
 
+  tools::threadpool& tpool = tools::threadpool::getInstance();
+  std::vector<stripe> stripes(std::max(1u, tpool.get_max_concurrency()));
+  size_t next = 0;
+  while (next < m_transfers.size())
+  {
+    size_t n_stripes = 0;
+    for (; n_stripes < stripes.size() && next < m_transfers.size(); ++n_stripes)
     {
-      const boost::lock_guard<boost::recursive_mutex> lock{m_daemon_rpc_mutex};
-      uint64_t pre_call_credits = m_rpc_payment_state.credits;
-      req.client = get_client_signature();
-      bool r = epee::net_utils::invoke_http_json("/is_key_image_spent", req, daemon_resp, *m_http_client, rpc_timeout);
-      THROW_ON_RPC_RESPONSE_ERROR(r, {}, daemon_resp, "is_key_image_spent", error::is_key_image_spent_error, get_rpc_status(daemon_resp.status));
-      THROW_WALLET_EXCEPTION_IF(daemon_resp.spent_status.size() != n_outputs, error::wallet_internal_error,
-        "daemon returned wrong response for is_key_image_spent, wrong amounts count = " +
-        std::to_string(daemon_resp.spent_status.size()) + ", expected " +  std::to_string(n_outputs));
-      check_rpc_cost("/is_key_image_spent", daemon_resp.credits, pre_call_credits, n_outputs * COST_PER_KEY_IMAGE);
+      stripe &s = stripes[n_stripes];
+      s.transfers.clear();
+      s.exception = NULL;
+      for (; next < m_transfers.size() && s.transfers.size() < RESCAN_SPENT_CHUNK_SIZE; ++next)
+      {
+        // a view wallet may not know about key images
+        const transfer_details& td = m_transfers[next];
+        if (td.m_key_image_known && !td.m_key_image_partial)
+          s.transfers.push_back(next);
+      }
+      if (s.transfers.empty())
+        break;
     }
 
-    std::copy(daemon_resp.spent_status.begin(), daemon_resp.spent_status.end(), std::back_inserter(spent_status));
-  }
+    tools::threadpool::waiter waiter(tpool);
+    for (size_t i = 0; i < n_stripes; ++i)
+    {
+      tpool.submit(&waiter, [this, &stripes, i](){
+        stripe &s = stripes[i];
+        try
+        {
+          const size_t n_outputs = s.transfers.size();
+          MDEBUG("Calling is_key_image_spent on " << n_outputs << " outputs from " << s.transfers.front() << ", out of " << m_transfers.size());
+          COMMAND_RPC_IS_KEY_IMAGE_SPENT::request req = AUTO_VAL_INIT(req);
+          s.daemon_resp = AUTO_VAL_INIT(s.daemon_resp);
+          for (size_t n: s.transfers)
+            req.key_images.push_back(string_tools::pod_to_hex(m_transfers[n].m_key_image));
+
+          daemon_client client{*this};
+          req.client = get_client_signature();
+          bool r = epee::net_utils::invoke_http_json("/is_key_image_spent", req, s.daemon_resp, *client, rpc_timeout);
+          THROW_ON_RPC_RESPONSE_ERROR(r, {}, s.daemon_resp, "is_key_image_spent", error::is_key_image_spent_error, get_rpc_status(s.daemon_resp.status));
+          THROW_WALLET_EXCEPTION_IF(s.daemon_resp.spent_status.size() != n_outputs, error::wallet_internal_error,
+            "daemon returned wrong response for is_key_image_spent, wrong amounts count = " +
+            std::to_string(s.daemon_resp.spent_status.size()) + ", expected " +  std::to_string(n_outputs));
+          client.check_rpc_cost("/is_key_image_spent", s.daemon_resp.credits, n_outputs * COST_PER_KEY_IMAGE);
+        }
+        catch (...)
+        {
+          s.exception = std::current_exception();
+        }
+      });
+    }
+    THROW_WALLET_EXCEPTION_IF(!waiter.wait(), error::wallet_internal_error, "Exception in thread pool");
 
-  // update spent status
-  for (size_t i = 0; i < m_transfers.size(); ++i)
-  {
-    transfer_details& td = m_transfers[i];
-    // a view wallet may not know about key images
-    if (!td.m_key_image_known || td.m_key_image_partial)
-      continue;
-    if (td.m_spent != (spent_status[i] != COMMAND_RPC_IS_KEY_IMAGE_SPENT::UNSPENT))
+    // update spent status
+    for (size_t i = 0; i < n_stripes; ++i)
     {
-      if (td.m_spent)
-      {
-        LOG_PRINT_L0("Marking output " << i << "(" << td.m_key_image << ") as unspent, it was marked as spent");
-        set_unspent(i);
-        td.m_spent_height = 0;
-      }
-      else
+      const stripe &s = stripes[i];
+      if (s.exception)
+        std::rethrow_exception(s.exception);
+      for (size_t n = 0; n < s.transfers.size(); ++n)
       {
-        LOG_PRINT_L0("Marking output " << i << "(" << td.m_key_image << ") as spent, it was marked as unspent");
-        set_spent(i, td.m_spent_height);
-        // unknown height, if this gets reorged, it might still be missed
+        const size_t idx = s.transfers[n];
+        transfer_details& td = m_transfers[idx];
+        if (td.m_spent != (s.daemon_resp.spent_status[n] != COMMAND_RPC_IS_KEY_IMAGE_SPENT::UNSPENT))
+        {
+          if (td.m_spent)
+          {
+            LOG_PRINT_L0("Marking output " << idx << "(" << td.m_key_image << ") as unspent, it was marked as spent");
+            set_unspent(idx);
+            td.m_spent_height = 0;
+          }
+          else
+          {
+            LOG_PRINT_L0("Marking output " << idx << "(" << td.m_key_image << ") as spent, it was marked as unspent");
+            set_spent(idx, td.m_spent_height);
+            // unknown height, if this gets reorged, it might still be missed
+          }
+        }
       }
     }
   }
@@ -6337,6 +6648,7 @@ void wallet2::rescan_blockchain(bool hard, bool refresh, bool keep_key_images)
   {
     clear();
     setup_new_blockchain();
+    m_store_rescan_progress = !m_wallet_file.empty();
   }
   else
   {
@@ -8638,15 +8950,14 @@ void wallet2::get_outs(std::vector<std::vector<tools::wallet2::get_outs_entry>>
       for (size_t i = 0; i < std::min<size_t>(req.outputs.size() - offset, chunk_size); ++i)
         chunk_req.outputs.push_back(req.outputs[offset + i]);
 
-      const boost::lock_guard<boost::recursive_mutex> lock{m_daemon_rpc_mutex};
-      uint64_t pre_call_credits = m_rpc_payment_state.credits;
+      daemon_client client{*this};
       chunk_req.client = get_client_signature();
-      bool r = epee::net_utils::invoke_http_bin("/get_outs.bin", chunk_req, chunk_daemon_resp, *m_http_client, rpc_timeout);
+      bool r = epee::net_utils::invoke_http_bin("/get_outs.bin", chunk_req, chunk_daemon_resp, *client, rpc_timeout);
       THROW_ON_RPC_RESPONSE_ERROR(r, {}, chunk_daemon_resp, "get_outs.bin", error::get_outs_error, get_rpc_status(chunk_daemon_resp.status));
       THROW_WALLET_EXCEPTION_IF(chunk_daemon_resp.outs.size() != chunk_req.outputs.size(), error::wallet_internal_error,
         "daemon returned wrong response for get_outs.bin, wrong amounts count = " +
         std::to_string(chunk_daemon_resp.outs.size()) + ", expected " +  std::to_string(chunk_req.outputs.size()));
-      check_rpc_cost("/get_outs.bin", chunk_daemon_resp.credits, pre_call_credits, chunk_daemon_resp.outs.size() * COST_PER_OUT);
+      client.check_rpc_cost("/get_outs.bin", chunk_daemon_resp.credits, chunk_daemon_resp.outs.size() * COST_PER_OUT);
 
       offset += chunk_size;
       for (size_t i = 0; i < chunk_daemon_resp.outs.size(); ++i)
@@ -9237,6 +9548,43 @@ void wallet2::transfer_selected_rct(std::vector<cryptonote::tx_destination_entry
   LOG_PRINT_L2("transfer_selected_rct done");
 }
 
+void wallet2::construct_final_txes(size_t num_txes, bool independent, const std::function<void(size_t)> &construct)
+{
+  // Once inputs, destinations, fees and rings are fixed, each tx can be signed and
+  // range proven on its own. Hardware devices and multisig carry state from one tx
+  // to the next, so those are always built in order.
+  const bool parallel = independent && num_txes > 1 && !m_multisig &&
+      m_account.get_device().get_type() == hw::device::SOFTWARE &&
+      tools::threadpool::getInstance().get_max_concurrency() > 1;
+  if (!parallel)
+  {
+    for (size_t n = 0; n < num_txes; ++n)
+      construct(n);
+    return;
+  }
+
+  // warm up the daemon backed values transfer_selected_rct reads, so workers hit the cache
+  get_upper_transaction_weight_limit();
+  use_fork_rules(HF_VERSION_CLSAG, -10);
+  use_fork_rules(HF_VERSION_SMALLER_BP, -10);
+
+  tools::threadpool& tpool = tools::threadpool::getInstance();
+  tools::threadpool::waiter waiter(tpool);
+  std::vector<std::exception_ptr> errors(num_txes);
+  for (size_t n = 0; n < num_txes; ++n)
+  {
+    tpool.submit(&waiter, [&, n]() {
+      try { construct(n); }
+      catch (...) { errors[n] = std::current_exception(); }
+    });
+  }
+  THROW_WALLET_EXCEPTION_IF(!waiter.wait(), error::wallet_internal_error, "Exception in thread pool");
+  // rethrow the first failure as is, so callers see the same error as a sequential build
+  for (const std::exception_ptr &e: errors)
+    if (e)
+      std::rethrow_exception(e);
+}
+
 std::vector<size_t> wallet2::pick_preferred_rct_inputs(uint64_t needed_money, uint32_t subaddr_account, const std::set<uint32_t> &subaddr_indices)
 {
   std::vector<size_t> picks;
@@ -10387,9 +10735,10 @@ skip_tx:
     " total fee, " << print_money(accumulated_change) << " total change");
 
   hwdev.set_mode(hw::device::TRANSACTION_CREATE_REAL);
-  for (std::vector<TX>::iterator i = txes.begin(); i != txes.end(); ++i)
+  const bool rings_fetched = std::all_of(txes.begin(), txes.end(), [](const TX &tx) { return !tx.outs.empty(); });
+  construct_final_txes(txes.size(), use_rct && rings_fetched, [&](size_t n)
   {
-    TX &tx = *i;
+    TX &tx = txes[n];
     cryptonote::transaction test_tx;
     pending_tx test_ptx;
     if (use_rct) {
@@ -10420,7 +10769,7 @@ skip_tx:
     tx.tx = test_tx;
     tx.ptx = test_ptx;
     tx.weight = get_transaction_weight(test_tx, txBlob.size());
-  }
+  });
 
   std::vector<wallet2::pending_tx> ptx_vector;
   for (std::vector<TX>::iterator i = txes.begin(); i != txes.end(); ++i)
@@ -10473,7 +10822,7 @@ bool wallet2::sanity_check(const std::vector<wallet2::pending_tx> &ptx_vector, s
   {
     if (ptx.change_dts.amount == 0)
       continue;
-    THROW_WALLET_EXCEPTION_IF(m_subaddresses.find(ptx.change_dts.addr.m_spend_public_key) == m_subaddresses.end(),
+    THROW_WALLET_EXCEPTION_IF(!m_subaddresses.find(ptx.change_dts.addr.m_spend_public_key),
          error::wallet_internal_error, "Change address is not ours");
     required[ptx.change_dts.addr].first += ptx.change_dts.amount;
     required[ptx.change_dts.addr].second = ptx.change_dts.is_subaddress;
@@ -10775,9 +11124,10 @@ std::vector<wallet2::pending_tx> wallet2::create_transactions_from(const crypton
     " total fee, " << print_money(accumulated_change) << " total change");
  
   hwdev.set_mode(hw::device::TRANSACTION_CREATE_REAL);
-  for (std::vector<TX>::iterator i = txes.begin(); i != txes.end(); ++i)
+  const bool rings_fetched = std::all_of(txes.begin(), txes.end(), [](const TX &tx) { return !tx.outs.empty(); });
+  construct_final_txes(txes.size(), use_rct && rings_fetched, [&](size_t n)
   {
-    TX &tx = *i;
+    TX &tx = txes[n];
     cryptonote::transaction test_tx;
     pending_tx test_ptx;
     if (use_rct) {
@@ -10791,7 +11141,7 @@ std::vector<wallet2::pending_tx> wallet2::create_transactions_from(const crypton
     tx.tx = test_tx;
     tx.ptx = test_ptx;
     tx.weight = get_transaction_weight(test_tx, txBlob.size());
-  }
+  });
 
   std::vector<wallet2::pending_tx> ptx_vector;
   for (std::vector<TX>::iterator i = txes.begin(); i != txes.end(); ++i)
@@ -14306,12 +14656,12 @@ void wallet2::finish_rescan_bc_keep_key_images(uint64_t transfer_height, const c
 //----------------------------------------------------------------------------------------------------
 uint64_t wallet2::get_bytes_sent() const
 {
-  return m_http_client->get_bytes_sent();
+  return m_http_client->get_bytes_sent() + m_http_pool.get_bytes_sent();
 }
 //----------------------------------------------------------------------------------------------------
 uint64_t wallet2::get_bytes_received() const
 {
-  return m_http_client->get_bytes_received();
+  return m_http_client->get_bytes_received() + m_http_pool.get_bytes_received();
 }
 //----------------------------------------------------------------------------------------------------
 std::vector<cryptonote::public_node> wallet2::get_public_nodes(bool white_only)
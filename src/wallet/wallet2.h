@@ -49,9 +49,11 @@
 #include "cryptonote_basic/account_boost_serialization.h"
 #include "cryptonote_basic/cryptonote_basic_impl.h"
 #include "net/http.h"
+#include "net/http_client_pool.h"
 #include "storages/http_abstract_invoke.h"
 #include "rpc/core_rpc_server_commands_defs.h"
 #include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_basic/subaddress_map.h"
 #include "cryptonote_core/cryptonote_tx_utils.h"
 #include "common/unordered_containers_boost_serialization.h"
 #include "common/util.h"
@@ -929,6 +931,16 @@ private:
     void refresh(bool trusted_daemon, uint64_t start_height, uint64_t & blocks_fetched, bool& received_money, bool check_pool = true);
     bool refresh(bool trusted_daemon, uint64_t & blocks_fetched, bool& received_money, bool& ok);
 
+    /*!
+     * \brief Refreshes several wallets connected to the same daemon in one
+     *        pass: each batch of blocks is pulled, parsed and has its tx
+     *        extra cached once, then every wallet scans it with its own keys.
+     *        Wallets the shared pass cannot follow (reorgs deeper than their
+     *        limit, errors) get a regular refresh afterwards, which may throw.
+     * \param blocks_fetched Set to the blocks added to each wallet
+     */
+    static void refresh_wallets(const std::vector<wallet2*>& wallets, bool trusted_daemon, std::vector<uint64_t>& blocks_fetched);
+
     void set_refresh_type(RefreshType refresh_type) { m_refresh_type = refresh_type; }
     RefreshType get_refresh_type() const { return m_refresh_type; }
 
@@ -1104,7 +1116,9 @@ private:
       a & m_scanned_pool_txs[1];
       if (ver < 20)
         return;
-      a & m_subaddresses.parent();
+      std::unordered_map<crypto::public_key, cryptonote::subaddress_index> subaddresses;
+      a & subaddresses;
+      m_subaddresses = subaddresses;
       std::unordered_map<cryptonote::subaddress_index, crypto::public_key> dummy_subaddresses_inv;
       a & dummy_subaddresses_inv;
       a & m_subaddress_labels;
@@ -1587,11 +1601,11 @@ private:
     void get_short_chain_history(std::list<crypto::hash>& ids, uint64_t granularity = 1) const;
     bool clear();
     void clear_soft(bool keep_key_images=false);
-    void pull_blocks(uint64_t start_height, uint64_t& blocks_start_height, const std::list<crypto::hash> &short_chain_history, std::vector<cryptonote::block_complete_entry> &blocks, std::vector<cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices> &o_indices, uint64_t &current_height);
+    void pull_blocks(uint64_t start_height, uint64_t& blocks_start_height, const std::list<crypto::hash> &short_chain_history, std::vector<cryptonote::block_complete_entry> &blocks, std::vector<cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices> &o_indices, uint64_t &current_height, bool no_miner_tx);
     void pull_hashes(uint64_t start_height, uint64_t& blocks_start_height, const std::list<crypto::hash> &short_chain_history, std::vector<crypto::hash> &hashes);
     void fast_refresh(uint64_t stop_height, uint64_t &blocks_start_height, std::list<crypto::hash> &short_chain_history, bool force = false);
-    void pull_and_parse_next_blocks(uint64_t start_height, uint64_t &blocks_start_height, std::list<crypto::hash> &short_chain_history, const std::vector<cryptonote::block_complete_entry> &prev_blocks, const std::vector<parsed_block> &prev_parsed_blocks, std::vector<cryptonote::block_complete_entry> &blocks, std::vector<parsed_block> &parsed_blocks, bool &last, bool &error, std::exception_ptr &exception);
-    void process_parsed_blocks(uint64_t start_height, const std::vector<cryptonote::block_complete_entry> &blocks, const std::vector<parsed_block> &parsed_blocks, uint64_t& blocks_added, std::map<std::pair<uint64_t, uint64_t>, size_t> *output_tracker_cache = NULL);
+    void pull_and_parse_next_blocks(uint64_t start_height, uint64_t &blocks_start_height, std::list<crypto::hash> &short_chain_history, const std::vector<cryptonote::block_complete_entry> &prev_blocks, const std::vector<parsed_block> &prev_parsed_blocks, std::vector<cryptonote::block_complete_entry> &blocks, std::vector<parsed_block> &parsed_blocks, bool &last, bool &error, std::exception_ptr &exception, bool no_miner_tx);
+    void process_parsed_blocks(uint64_t start_height, const std::vector<cryptonote::block_complete_entry> &blocks, const std::vector<parsed_block> &parsed_blocks, uint64_t& blocks_added, std::map<std::pair<uint64_t, uint64_t>, size_t> *output_tracker_cache = NULL, const std::vector<tx_cache_data> *shared_tx_cache_data = NULL);
     uint64_t select_transfers(uint64_t needed_money, std::vector<size_t> unused_transfers_indices, std::vector<size_t>& selected_transfers) const;
     bool prepare_file_names(const std::string& file_path);
     void process_unconfirmed(const crypto::hash &txid, const cryptonote::transaction& tx, uint64_t height);
@@ -1611,6 +1625,7 @@ private:
     uint64_t get_dynamic_base_fee_estimate();
     float get_output_relatedness(const transfer_details &td0, const transfer_details &td1) const;
     std::vector<size_t> pick_preferred_rct_inputs(uint64_t needed_money, uint32_t subaddr_account, const std::set<uint32_t> &subaddr_indices);
+    void construct_final_txes(size_t num_txes, bool independent, const std::function<void(size_t)> &construct);
     void set_spent(size_t idx, uint64_t height);
     void set_unspent(size_t idx);
     bool is_spent(const transfer_details &td, bool strict = true) const;
@@ -1649,7 +1664,10 @@ private:
       std::unordered_set<crypto::public_key> &pkeys) const;
 
     void cache_tx_data(const cryptonote::transaction& tx, const crypto::hash &txid, tx_cache_data &tx_cache_data) const;
+    static void cache_tx_data(const cryptonote::transaction& tx, const crypto::hash &txid, RefreshType refresh_type, tx_cache_data &tx_cache_data);
     std::shared_ptr<std::map<std::pair<uint64_t, uint64_t>, size_t>> create_output_tracker_cache() const;
+    //! Add the spend keys of subaddresses of account `major` up to `end`, excluded.
+    void expand_subaddress_keys(uint32_t major, uint32_t end);
 
     void init_type(hw::device::device_type device_type);
     void setup_new_blockchain();
@@ -1668,6 +1686,25 @@ private:
     std::string get_client_signature() const;
     void check_rpc_cost(const char *call, uint64_t post_call_credits, uint64_t pre_credits, double expected_cost);
 
+    /*! Daemon connection for one request. Bulk requests use this instead of
+        `m_http_client`, so they can overlap with each other and with the
+        requests made from other threads. When the daemon charges for RPC,
+        credits are checked against the balance before the call, so requests
+        go one at a time through `m_http_client` instead. */
+    class daemon_client
+    {
+    public:
+      explicit daemon_client(wallet2 &wallet);
+      epee::net_utils::http::abstract_http_client &operator*() const;
+      void check_rpc_cost(const char *call, uint64_t post_call_credits, double expected_cost);
+
+    private:
+      wallet2 &m_wallet;
+      boost::unique_lock<boost::recursive_mutex> m_lock;
+      epee::net_utils::http::client_pool::lease m_lease;
+      uint64_t m_pre_call_credits;
+    };
+
     bool should_expand(const cryptonote::subaddress_index &index) const;
     bool spends_one_of_ours(const cryptonote::transaction &tx) const;
 
@@ -1691,7 +1728,7 @@ private:
     serializable_unordered_map<crypto::key_image, size_t> m_key_images;
     serializable_unordered_map<crypto::public_key, size_t> m_pub_keys;
     cryptonote::account_public_address m_account_public_address;
-    serializable_unordered_map<crypto::public_key, cryptonote::subaddress_index> m_subaddresses;
+    cryptonote::subaddress_map m_subaddresses;
     std::vector<std::vector<std::string>> m_subaddress_labels;
     serializable_unordered_map<crypto::hash, std::string> m_tx_notes;
     serializable_unordered_map<std::string, std::string> m_attributes;
@@ -1703,6 +1740,7 @@ private:
     serializable_unordered_map<crypto::public_key, crypto::key_image> m_cold_key_images;
 
     std::atomic<bool> m_run;
+    bool m_store_rescan_progress; //!< Set by a hard rescan until a refresh completes
 
     boost::recursive_mutex m_daemon_rpc_mutex;
 
@@ -1793,6 +1831,7 @@ private:
     std::unique_ptr<tools::file_locker> m_keys_file_locker;
     
     mms::message_store m_message_store;
+    epee::net_utils::http::client_pool m_http_pool; // extra daemon connections, see daemon_client
     bool m_original_keys_available;
     cryptonote::account_public_address m_original_address;
     crypto::secret_key m_original_view_secret_key;
@@ -330,6 +330,53 @@ namespace tools
       return false;
   }
   //------------------------------------------------------------------------------------------------------------------------------
+  std::unique_ptr<wallet2> wallet_rpc_server::open_wallet_file(const std::string &filename, const std::string &password, epee::json_rpc::error& er)
+  {
+    namespace po = boost::program_options;
+    po::variables_map vm2;
+    const char *ptr = strchr(filename.c_str(), '/');
+#ifdef _WIN32
+    if (!ptr)
+      ptr = strchr(filename.c_str(), '\\');
+    if (!ptr)
+      ptr = strchr(filename.c_str(), ':');
+#endif
+    if (ptr)
+    {
+      er.code = WALLET_RPC_ERROR_CODE_UNKNOWN_ERROR;
+      er.message = "Invalid filename";
+      return nullptr;
+    }
+    std::string wallet_file = m_wallet_dir + "/" + filename;
+    {
+      po::options_description desc("dummy");
+      const command_line::arg_descriptor<std::string, true> arg_password = {"password", "password"};
+      const char *argv[4];
+      int argc = 3;
+      argv[0] = "wallet-rpc";
+      argv[1] = "--password";
+      argv[2] = password.c_str();
+      argv[3] = NULL;
+      vm2 = *m_vm;
+      command_line::add_arg(desc, arg_password);
+      po::store(po::parse_command_line(argc, argv, desc), vm2);
+    }
+    std::unique_ptr<tools::wallet2> wal = nullptr;
+    try {
+      wal = tools::wallet2::make_from_file(vm2, true, wallet_file, nullptr).first;
+    }
+    catch (const std::exception& e)
+    {
+      handle_rpc_exception(std::current_exception(), er, WALLET_RPC_ERROR_CODE_UNKNOWN_ERROR);
+    }
+    if (!wal)
+    {
+      er.code = WALLET_RPC_ERROR_CODE_UNKNOWN_ERROR;
+      er.message = "Failed to open wallet";
+    }
+    return wal;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
   void wallet_rpc_server::fill_transfer_entry(tools::wallet_rpc::transfer_entry &entry, const crypto::hash &txid, const crypto::hash &payment_id, const tools::wallet2::payment_details &pd)
   {
     entry.txid = string_tools::pod_to_hex(pd.m_tx_hash);
@@ -3110,6 +3157,81 @@ namespace tools
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
+  bool wallet_rpc_server::on_refresh_wallets(const wallet_rpc::COMMAND_RPC_REFRESH_WALLETS::request& req, wallet_rpc::COMMAND_RPC_REFRESH_WALLETS::response& res, epee::json_rpc::error& er, const connection_context *ctx)
+  {
+    if (m_wallet_dir.empty())
+    {
+      er.code = WALLET_RPC_ERROR_CODE_NO_WALLET_DIR;
+      er.message = "No wallet dir configured";
+      return false;
+    }
+    if (m_restricted)
+    {
+      er.code = WALLET_RPC_ERROR_CODE_DENIED;
+      er.message = "Command unavailable in restricted mode.";
+      return false;
+    }
+
+    // all wallets stay loaded for the shared pass, callers pick the batch size
+    const std::string current_file = m_wallet ? m_wallet->get_wallet_file() : std::string();
+    std::vector<std::unique_ptr<wallet2>> opened;
+    std::vector<wallet2*> wallets;
+    std::vector<size_t> results;
+    res.wallets.resize(req.wallets.size());
+    for (size_t n = 0; n < req.wallets.size(); ++n)
+    {
+      res.wallets[n].filename = req.wallets[n].filename;
+      if (m_wallet && m_wallet_dir + "/" + req.wallets[n].filename == current_file)
+      {
+        wallets.push_back(m_wallet);
+        results.push_back(n);
+        continue;
+      }
+      epee::json_rpc::error open_error;
+      std::unique_ptr<wallet2> wal = open_wallet_file(req.wallets[n].filename, req.wallets[n].password, open_error);
+      if (!wal)
+      {
+        res.wallets[n].error = open_error.message;
+        continue;
+      }
+      wallets.push_back(wal.get());
+      results.push_back(n);
+      opened.push_back(std::move(wal));
+    }
+    if (wallets.empty())
+      return true;
+
+    std::vector<uint64_t> blocks_fetched;
+    try
+    {
+      wallet2::refresh_wallets(wallets, wallets.front()->is_trusted_daemon(), blocks_fetched);
+    }
+    catch (const std::exception& e)
+    {
+      handle_rpc_exception(std::current_exception(), er, WALLET_RPC_ERROR_CODE_UNKNOWN_ERROR);
+      return false;
+    }
+
+    for (size_t i = 0; i < wallets.size(); ++i)
+    {
+      wallet_rpc::COMMAND_RPC_REFRESH_WALLETS::wallet_result &result = res.wallets[results[i]];
+      result.blocks_fetched = blocks_fetched[i];
+      result.balance = wallets[i]->balance_all(false);
+      result.unlocked_balance = wallets[i]->unlocked_balance_all(false);
+      if (!req.autosave)
+        continue;
+      try
+      {
+        wallets[i]->store();
+      }
+      catch (const std::exception& e)
+      {
+        result.error = std::string("Failed to store wallet: ") + e.what();
+      }
+    }
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
   bool wallet_rpc_server::on_auto_refresh(const wallet_rpc::COMMAND_RPC_AUTO_REFRESH::request& req, wallet_rpc::COMMAND_RPC_AUTO_REFRESH::response& res, epee::json_rpc::error& er, const connection_context *ctx)
   {
     if (m_restricted)
@@ -3348,21 +3470,6 @@ namespace tools
       return false;
     }
 
-    namespace po = boost::program_options;
-    po::variables_map vm2;
-    const char *ptr = strchr(req.filename.c_str(), '/');
-#ifdef _WIN32
-    if (!ptr)
-      ptr = strchr(req.filename.c_str(), '\\');
-    if (!ptr)
-      ptr = strchr(req.filename.c_str(), ':');
-#endif
-    if (ptr)
-    {
-      er.code = WALLET_RPC_ERROR_CODE_UNKNOWN_ERROR;
-      er.message = "Invalid filename";
-      return false;
-    }
     if (m_wallet && req.autosave_current)
     {
       try
@@ -3375,34 +3482,9 @@ namespace tools
         return false;
       }
     }
-    std::string wallet_file = m_wallet_dir + "/" + req.filename;
-    {
-      po::options_description desc("dummy");
-      const command_line::arg_descriptor<std::string, true> arg_password = {"password", "password"};
-      const char *argv[4];
-      int argc = 3;
-      argv[0] = "wallet-rpc";
-      argv[1] = "--password";
-      argv[2] = req.password.c_str();
-      argv[3] = NULL;
-      vm2 = *m_vm;
-      command_line::add_arg(desc, arg_password);
-      po::store(po::parse_command_line(argc, argv, desc), vm2);
-    }
-    std::unique_ptr<tools::wallet2> wal = nullptr;
-    try {
-      wal = tools::wallet2::make_from_file(vm2, true, wallet_file, nullptr).first;
-    }
-    catch (const std::exception& e)
-    {
-      handle_rpc_exception(std::current_exception(), er, WALLET_RPC_ERROR_CODE_UNKNOWN_ERROR);
-    }
+    std::unique_ptr<tools::wallet2> wal = open_wallet_file(req.filename, req.password, er);
     if (!wal)
-    {
-      er.code = WALLET_RPC_ERROR_CODE_UNKNOWN_ERROR;
-      er.message = "Failed to open wallet";
       return false;
-    }
 
     if (m_wallet)
       delete m_wallet;
@@ -38,6 +38,7 @@ Test the following RPCs:
     - generateblocks
     - misc block retrieval
     - pop_blocks
+    - get_output_key_indices
     - [TODO: many tests still need to be written]
 
 """
@@ -198,6 +199,15 @@ class BlockchainTest():
                     assert not out.unlocked
                     assert out.height == i
                     assert out.txid == txids[i]
+                res_keys = daemon.get_output_key_indices([out.key for out in res_out.outs])
+                assert len(res_keys.output_keys) == len(tx.output_indices)
+                for n in range(len(tx.output_indices)):
+                    outputs = res_keys.output_keys[n].outputs
+                    assert len(outputs) == 1
+                    assert outputs[0].amount == 0
+                    assert outputs[0].index == tx.output_indices[n]
+                    assert outputs[0].txid == txids[i]
+                    assert outputs[0].local_index == n
 
         for i in range(height + nblocks - 1):
             res_sum = daemon.get_coinbase_tx_sum(i, 1)
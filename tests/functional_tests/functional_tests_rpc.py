@@ -49,7 +49,7 @@ DIFFICULTY = 10
 
 lozzaxd_base = [builddir + "/bin/lozzaxd", "--regtest", "--fixed-difficulty", str(DIFFICULTY), "--no-igd", "--p2p-bind-port", "lozzaxd_p2p_port", "--rpc-bind-port", "lozzaxd_rpc_port", "--zmq-rpc-bind-port", "lozzaxd_zmq_port", "--non-interactive", "--disable-dns-checkpoints", "--check-updates", "disabled", "--rpc-ssl", "disabled", "--data-dir", "lozzaxd_data_dir", "--log-level", "1"]
 lozzaxd_extra = [
-  ["--offline"],
+  ["--offline", "--db-output-key-index"],
   ["--rpc-payment-address", "44SKxxLQw929wRF6BA9paQ1EWFshNnKhXM3qz6Mo3JGDE2YG3xyzVutMStEicxbQGRfrYvAAYxH6Fe8rnD56EaNwUiqhcwR", "--rpc-payment-difficulty", str(DIFFICULTY), "--rpc-payment-credits", "5000", "--offline"],
   ["--add-exclusive-node", "127.0.0.1:18283"],
   ["--add-exclusive-node", "127.0.0.1:18282"],
@@ -53,6 +53,7 @@ class WalletTest():
       self.languages()
       self.change_password()
       self.store()
+      self.refresh_wallets()
 
     def remove_file(self, name):
         WALLET_DIRECTORY = os.environ['WALLET_DIRECTORY']
@@ -386,6 +387,52 @@ class WalletTest():
         wallet.close_wallet()
         self.remove_wallet_files('test1')
 
+    def refresh_wallets(self):
+        print('Testing refresh_wallets')
+        wallet = Wallet()
+        daemon = Daemon()
+
+        # close the wallet if any, will throw if none is loaded
+        try: wallet.close_wallet()
+        except: pass
+
+        seeds = [
+            'velvet lymph giddy number token physics poetry unquoted nibs useful sabotage limits benches lifestyle eden nitrogen anvil fewest avoid batch vials washing fences goat unquoted',
+            'peeled mixture ionic radar utopia puddle buying illness nuns gadget river spout cavernous bounced paradise drunk looking cottage jump tequila melting went winter adjust spout',
+        ]
+        for i in range(len(seeds)):
+            self.remove_wallet_files('test' + str(i + 1))
+            wallet.restore_deterministic_wallet(seed = seeds[i], filename = 'test' + str(i + 1))
+            wallet.close_wallet()
+
+        daemon.generateblocks('42ey1afDFnn4886T7196doS9GPMzexD9gXpsZJDwVjeRVdFCSoHnv7KPbBeGpzJBzHRCAs9UxqeoyFQMYbqSWYTfJJQAWDm', 5)
+
+        res = wallet.refresh_wallets([{'filename': 'test1', 'password': ''}, {'filename': 'test2', 'password': ''}, {'filename': 'foo/bar', 'password': ''}])
+        assert len(res.wallets) == 3
+        assert res.wallets[0].filename == 'test1'
+        assert res.wallets[0].error == ''
+        assert res.wallets[0].blocks_fetched == 5
+        assert res.wallets[0].balance > 0
+        assert res.wallets[0].unlocked_balance == 0
+        assert res.wallets[1].filename == 'test2'
+        assert res.wallets[1].error == ''
+        assert res.wallets[1].blocks_fetched == 5
+        assert res.wallets[1].balance == 0
+        assert res.wallets[2].error != ''
+
+        # the refreshed state was stored
+        wallet.open_wallet('test1', password = '')
+        res2 = wallet.get_balance()
+        assert res2.balance == res.wallets[0].balance
+        res2 = wallet.refresh()
+        assert res2.blocks_fetched == 0
+        wallet.close_wallet()
+
+        for i in range(len(seeds)):
+            self.remove_wallet_files('test' + str(i + 1))
+        self.reset()
+
+
 
 if __name__ == '__main__':
     WalletTest().run_test()
@@ -68,7 +68,7 @@ namespace
     {
     }
 
-    virtual int invoke(int command, const epee::span<const uint8_t> in_buff, epee::byte_stream& buff_out, test_levin_connection_context& context)
+    virtual int invoke(int command, const epee::byte_slice& in_buff, epee::byte_stream& buff_out, test_levin_connection_context& context)
     {
       m_invoke_counter.inc();
       boost::unique_lock<boost::mutex> lock(m_mutex);
@@ -78,7 +78,7 @@ namespace
       return m_return_code;
     }
 
-    virtual int notify(int command, const epee::span<const uint8_t> in_buff, test_levin_connection_context& context)
+    virtual int notify(int command, const epee::byte_slice& in_buff, test_levin_connection_context& context)
     {
       m_notify_counter.inc();
       boost::unique_lock<boost::mutex> lock(m_mutex);
@@ -67,7 +67,7 @@ namespace net_load_tests
     {
     }
 
-    virtual int invoke(int command, const epee::span<const uint8_t> in_buff, epee::byte_stream& buff_out, test_connection_context& context)
+    virtual int invoke(int command, const epee::byte_slice& in_buff, epee::byte_stream& buff_out, test_connection_context& context)
     {
       //m_invoke_counter.inc();
       //std::unique_lock<std::mutex> lock(m_mutex);
@@ -78,7 +78,7 @@ namespace net_load_tests
       return LEVIN_OK;
     }
 
-    virtual int notify(int command, const epee::span<const uint8_t> in_buff, test_connection_context& context)
+    virtual int notify(int command, const epee::byte_slice& in_buff, test_connection_context& context)
     {
       //m_notify_counter.inc();
       //std::unique_lock<std::mutex> lock(m_mutex);
@@ -1200,8 +1200,9 @@ void gen_trezor_base::test_get_tx(
   {
     wlt->expand_subaddresses({10, 20});
 
-    const subaddresses_t & cur_sub = wallet_accessor_test::get_subaddresses(wlt);
-    all_subs.insert(cur_sub.begin(), cur_sub.end());
+    const cryptonote::subaddress_map & cur_sub = wallet_accessor_test::get_subaddresses(wlt);
+    for (const auto & elem : cur_sub)
+      all_subs.emplace(elem.key, elem.index);
   }
 
   for(size_t txid = 0; txid < ptxs.size(); ++txid)
@@ -1435,7 +1436,7 @@ tsx_builder * tsx_builder::construct_pending_tx(tools::wallet2::pending_tx &ptx,
   CHECK_AND_ASSERT_THROW_MES(m_from, "Wallet not provided");
 
   cryptonote::transaction tx;
-  subaddresses_t & subaddresses = wallet_accessor_test::get_subaddresses(m_from);
+  const cryptonote::subaddress_map & subaddresses = wallet_accessor_test::get_subaddresses(m_from);
   crypto::secret_key tx_key;
   std::vector<crypto::secret_key> additional_tx_keys;
   std::vector<tx_destination_entry> destinations_copy = m_destinations;
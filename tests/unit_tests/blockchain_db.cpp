@@ -341,4 +341,124 @@ TYPED_TEST(BlockchainDBTest, RetrieveBlockData)
   ASSERT_HASH_EQ(get_block_hash(this->m_blocks[1].first), hashes[1]);
 }
 
+TYPED_TEST(BlockchainDBTest, OutputKeyIndex)
+{
+  boost::filesystem::path tempPath = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  std::string dirPath = tempPath.string();
+
+  this->set_prefix(dirPath);
+
+  // without the flag, the index is not built and lookups are refused
+  ASSERT_NO_THROW(this->m_db->open(dirPath));
+  this->get_filenames();
+  this->init_hard_fork();
+
+  std::vector<crypto::public_key> keys;
+  std::vector<std::vector<output_key_index_t>> indices;
+  {
+    db_wtxn_guard guard(this->m_db);
+    ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[0], t_sizes[0], t_sizes[0], t_diffs[0], t_coins[0], this->m_txs[0]));
+    ASSERT_FALSE(this->m_db->get_output_key_indices(keys, indices));
+  }
+  ASSERT_NO_THROW(this->m_db->close());
+
+  // with the flag, existing outputs are indexed on open, and new ones as they are added
+  ASSERT_NO_THROW(this->m_db->open(dirPath, DBF_OUTPUT_KEY_INDEX));
+  {
+    db_wtxn_guard guard(this->m_db);
+    ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[1], t_sizes[1], t_sizes[1], t_diffs[1], t_coins[1], this->m_txs[1]));
+  }
+
+  std::vector<tx_out_index> expected;
+  auto add_outputs = [&](const transaction &tx)
+  {
+    for (size_t n = 0; n < tx.vout.size(); ++n)
+    {
+      keys.push_back(boost::get<txout_to_key>(tx.vout[n].target).key);
+      expected.emplace_back(get_transaction_hash(tx), n);
+    }
+  };
+  for (size_t i = 0; i < this->m_blocks.size(); ++i)
+  {
+    add_outputs(this->m_blocks[i].first.miner_tx);
+    for (const auto &tx: this->m_txs[i])
+      add_outputs(tx.first);
+  }
+  const size_t block0_outputs = this->m_blocks[0].first.miner_tx.vout.size() + this->m_txs[0][0].first.vout.size();
+  keys.push_back(crypto::null_pkey);
+
+  ASSERT_TRUE(this->m_db->get_output_key_indices(keys, indices));
+  ASSERT_EQ(keys.size(), indices.size());
+  for (size_t i = 0; i < expected.size(); ++i)
+  {
+    ASSERT_EQ(1, indices[i].size());
+    ASSERT_HASH_EQ(expected[i].first, indices[i][0].tx_hash);
+    ASSERT_EQ(expected[i].second, indices[i][0].local_index);
+    const output_data_t od = this->m_db->get_output_key(indices[i][0].amount, indices[i][0].amount_index);
+    ASSERT_HASH_EQ(keys[i], od.pubkey);
+  }
+  ASSERT_TRUE(indices.back().empty());
+
+  // popping a block takes its outputs out of the index
+  block blk;
+  std::vector<transaction> txs;
+  ASSERT_NO_THROW(this->m_db->pop_block(blk, txs));
+  ASSERT_TRUE(this->m_db->get_output_key_indices(keys, indices));
+  for (size_t i = 0; i < expected.size(); ++i)
+    ASSERT_EQ(i < block0_outputs ? 1 : 0, indices[i].size());
+}
+
+TYPED_TEST(BlockchainDBTest, IncrementalPruning)
+{
+  boost::filesystem::path tempPath = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  std::string dirPath = tempPath.string();
+
+  this->set_prefix(dirPath);
+
+  ASSERT_NO_THROW(this->m_db->open(dirPath));
+  this->get_filenames();
+  this->init_hard_fork();
+
+  for (size_t i = 0; i < this->m_blocks.size(); ++i)
+  {
+    db_wtxn_guard guard(this->m_db);
+    ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[i], t_sizes[i], t_sizes[i], t_diffs[i], t_coins[i], this->m_txs[i]));
+  }
+
+  pruning_progress_t progress;
+  ASSERT_FALSE(this->m_db->get_pruning_progress(progress));
+  ASSERT_EQ(0, progress.txes_done);
+  ASSERT_EQ(0, this->m_db->get_blockchain_pruning_seed());
+  const uint64_t n_txes = progress.txes_total;
+  ASSERT_LT(1, n_txes);
+
+  // the first step sets the pruning seed
+  ASSERT_FALSE(this->m_db->prune_blockchain_step(1, progress));
+  const uint32_t pruning_seed = this->m_db->get_blockchain_pruning_seed();
+  ASSERT_NE(0, pruning_seed);
+  ASSERT_EQ(1, progress.txes_done);
+  ASSERT_EQ(n_txes, progress.txes_total);
+
+  // and progress survives a restart
+  ASSERT_NO_THROW(this->m_db->close());
+  ASSERT_NO_THROW(this->m_db->open(dirPath));
+  ASSERT_TRUE(this->m_db->get_pruning_progress(progress));
+  ASSERT_EQ(1, progress.txes_done);
+
+  uint64_t steps = 1;
+  do
+  {
+    ++steps;
+  } while (!this->m_db->prune_blockchain_step(1, progress));
+  ASSERT_EQ(n_txes, steps);
+  ASSERT_EQ(n_txes, progress.txes_done);
+  ASSERT_FALSE(this->m_db->get_pruning_progress(progress));
+  ASSERT_EQ(n_txes, progress.txes_done);
+  ASSERT_EQ(pruning_seed, this->m_db->get_blockchain_pruning_seed());
+
+  // nothing left to do
+  ASSERT_TRUE(this->m_db->prune_blockchain_step(1, progress));
+  ASSERT_TRUE(this->m_db->check_pruning());
+}
+
 }  // anonymous namespace
@@ -33,8 +33,14 @@
 #include <string>
 
 #include "cryptonote_basic/cryptonote_basic_impl.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
 #include "cryptonote_basic/merge_mining.h"
 
+extern "C"
+{
+#include "crypto/crypto-ops.h"
+}
+
 namespace
 {
   static constexpr const std::uint8_t source[] = {
@@ -312,3 +318,82 @@ TEST(Crypto, tree_branch)
     }
   }
 }
+
+TEST(Crypto, miner_tx_tree_branch)
+{
+  std::vector<crypto::hash> leaves;
+  for (size_t count = 1; count < 40; ++count)
+  {
+    crypto::hash leaf;
+    std::memset(leaf.data, int(count), sizeof(leaf.data));
+    leaves.push_back(leaf);
+
+    const std::vector<crypto::hash> tx_hashes{leaves.begin() + 1, leaves.end()};
+    const std::vector<crypto::hash> branch = cryptonote::get_miner_tx_tree_branch(tx_hashes);
+    EXPECT_EQ(cryptonote::get_tx_tree_hash(leaves), cryptonote::get_tx_tree_hash(leaves[0], branch)) << "count " << count;
+
+    // the branch does not depend on the miner tx
+    crypto::hash other;
+    std::memset(other.data, 0xff, sizeof(other.data));
+    std::vector<crypto::hash> other_leaves = leaves;
+    other_leaves[0] = other;
+    EXPECT_EQ(cryptonote::get_tx_tree_hash(other_leaves), cryptonote::get_tx_tree_hash(other, branch)) << "count " << count;
+  }
+}
+
+TEST(Crypto, ge_frombytes_vartime_edges)
+{
+  // y >= p is rejected whatever the sign bit
+  for (unsigned int k = 0; k < 19; ++k)
+  {
+    unsigned char s[32];
+    memset(s, 0xff, 32);
+    s[0] = 0xed + k;
+    s[31] = 0x7f;
+    ge_p3 p3;
+    ASSERT_NE(ge_frombytes_vartime(&p3, s), 0);
+    s[31] |= 0x80;
+    ASSERT_NE(ge_frombytes_vartime(&p3, s), 0);
+  }
+
+  // identity, and x = 0 with the sign bit set
+  unsigned char s[32] = {1};
+  ge_p3 p3;
+  ASSERT_EQ(ge_frombytes_vartime(&p3, s), 0);
+  ASSERT_TRUE(ge_p3_is_point_at_infinity(&p3));
+  s[31] = 0x80;
+  ASSERT_NE(ge_frombytes_vartime(&p3, s), 0);
+
+  // encodings roundtrip
+  for (int n = 0; n < 64; ++n)
+  {
+    crypto::public_key pkey, pkey2;
+    crypto::secret_key skey;
+    crypto::generate_keys(pkey, skey);
+    ASSERT_EQ(ge_frombytes_vartime(&p3, (const unsigned char*)pkey.data), 0);
+    ASSERT_FALSE(ge_p3_is_point_at_infinity(&p3));
+    ge_p3_tobytes((unsigned char*)pkey2.data, &p3);
+    ASSERT_EQ(pkey, pkey2);
+  }
+}
+
+TEST(Crypto, cn_fast_hash_batch)
+{
+  std::vector<char> buffer(4096);
+  for (size_t n = 0; n < buffer.size(); ++n)
+    buffer[n] = n * 7 + 1;
+
+  // lengths around the 136 byte keccak block, in uneven lanes
+  static const size_t lengths[] = {0, 1, 64, 135, 136, 137, 271, 272, 273, 1000, 4000, 31, 32, 0, 2048};
+  static const size_t N = sizeof(lengths) / sizeof(lengths[0]);
+  for (size_t count = 0; count <= N; ++count)
+  {
+    std::vector<const void*> data(count);
+    std::vector<crypto::hash> hashes(count);
+    for (size_t n = 0; n < count; ++n)
+      data[n] = buffer.data() + n;
+    crypto::cn_fast_hash_batch(data.data(), lengths, count, hashes.data());
+    for (size_t n = 0; n < count; ++n)
+      ASSERT_EQ(hashes[n], crypto::cn_fast_hash(data[n], lengths[n]));
+  }
+}
@@ -38,6 +38,7 @@
 #include "string_tools.h"
 #include "net/abstract_tcp_server2.h"
 #include "net/levin_protocol_handler_async.h"
+#include "net/network_throttle-detail.hpp"
 
 namespace
 {
@@ -151,8 +152,8 @@ TEST(test_epee_connection, test_lifetime)
       delay(delay),
       on_connection_close_f(on_connection_close_f)
     {}
-    virtual int invoke(int, const epee::span<const uint8_t>, epee::byte_stream&, context_t&) override { epee::misc_utils::sleep_no_w(delay); return {}; }
-    virtual int notify(int, const epee::span<const uint8_t>, context_t&) override { return {}; }
+    virtual int invoke(int, const epee::byte_slice&, epee::byte_stream&, context_t&) override { epee::misc_utils::sleep_no_w(delay); return {}; }
+    virtual int notify(int, const epee::byte_slice&, context_t&) override { return {}; }
     virtual void callback(context_t&) override {}
     virtual void on_connection_new(context_t&) override {}
     virtual void on_connection_close(context_t&) override {
@@ -462,3 +463,119 @@ TEST(test_epee_connection, test_lifetime)
   server.timed_wait_server_stop(5 * 1000);
   server.deinit_server();
 }
+
+TEST(test_epee_connection, queued_messages_arrive_in_order)
+{
+  struct context_t: epee::net_utils::connection_context_base {
+    static constexpr size_t get_max_bytes(int) noexcept { return -1; }
+    static constexpr int handshake_command() noexcept { return 1001; }
+    static constexpr bool handshake_complete() noexcept { return true; }
+  };
+
+  struct received_t {
+    boost::mutex lock;
+    boost::condition_variable cond;
+    std::vector<uint32_t> sequence;
+    size_t bytes = 0;
+  };
+
+  struct command_handler_t: epee::levin::levin_commands_handler<context_t> {
+    received_t* received;
+    explicit command_handler_t(received_t* received = nullptr): received(received) {}
+    virtual int invoke(int, const epee::byte_slice&, epee::byte_stream&, context_t&) override { return {}; }
+    virtual int notify(int, const epee::byte_slice& in, context_t&) override {
+      if (!received || in.size() < sizeof(uint32_t))
+        return {};
+      uint32_t index;
+      memcpy(&index, in.data(), sizeof(index));
+      boost::unique_lock<boost::mutex> lock(received->lock);
+      received->sequence.push_back(index);
+      received->bytes += in.size();
+      received->cond.notify_all();
+      return {};
+    }
+    virtual void callback(context_t&) override {}
+    virtual void on_connection_new(context_t&) override {}
+    virtual void on_connection_close(context_t&) override {}
+    virtual ~command_handler_t() override {}
+    static void destroy(epee::levin::levin_commands_handler<context_t>* ptr) { delete ptr; }
+  };
+
+  using handler_t = epee::levin::async_protocol_handler<context_t>;
+  using connection_t = epee::net_utils::connection<handler_t>;
+  using shared_state_t = typename connection_t::shared_state;
+  using server_t = epee::net_utils::boosted_tcp_server<handler_t>;
+
+  const uint64_t rate_up_limit = epee::net_utils::connection_basic::get_rate_up_limit();
+  const uint64_t rate_down_limit = epee::net_utils::connection_basic::get_rate_down_limit();
+  epee::net_utils::connection_basic::set_rate_up_limit(1024 * 1024);
+  epee::net_utils::connection_basic::set_rate_down_limit(1024 * 1024);
+  const auto restore_limits = epee::misc_utils::create_scope_leave_handler([rate_up_limit, rate_down_limit]{
+    epee::net_utils::connection_basic::set_rate_up_limit(rate_up_limit);
+    epee::net_utils::connection_basic::set_rate_down_limit(rate_down_limit);
+  });
+
+  received_t received;
+  boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address::from_string("127.0.0.1"), 5263);
+  server_t server(epee::net_utils::e_connection_type_P2P);
+  ASSERT_TRUE(server.init_server(endpoint.port(), endpoint.address().to_string(), 0, "", false, true, epee::net_utils::ssl_support_t::e_ssl_support_disabled));
+  server.get_config_shared()->set_handler(new command_handler_t(&received), &command_handler_t::destroy);
+  ASSERT_TRUE(server.run_server(2, false));
+
+  boost::asio::io_service io_service;
+  std::unique_ptr<boost::asio::io_service::work> work(new boost::asio::io_service::work(io_service));
+  std::thread worker([&io_service]{ io_service.run(); });
+
+  auto shared_state = std::make_shared<shared_state_t>();
+  shared_state->set_handler(new command_handler_t, &command_handler_t::destroy);
+  boost::shared_ptr<connection_t> conn(new connection_t(io_service, shared_state, {}, {}));
+  conn->socket().connect(endpoint);
+  EXPECT_TRUE(conn->start(false, false));
+  context_t context;
+  conn->get_context(context);
+
+  // small notifications pile up behind the big, chunked one and are written together
+  constexpr uint32_t count = 500;
+  size_t expected_bytes = 0;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    epee::levin::message_writer message{i == 1 ? 200 * 1024 : 32};
+    message.buffer.write(reinterpret_cast<const char*>(&i), sizeof(i));
+    message.buffer.put_n(0, i == 1 ? 200 * 1024 : 28);
+    expected_bytes += message.payload_size();
+    EXPECT_EQ(1, shared_state->send(message.finalize_notify(1002), context.m_connection_id));
+  }
+
+  {
+    boost::unique_lock<boost::mutex> lock(received.lock);
+    received.cond.wait_for(lock, boost::chrono::seconds(10), [&received]{ return received.sequence.size() == count; });
+    EXPECT_EQ(count, received.sequence.size());
+    EXPECT_EQ(expected_bytes, received.bytes);
+    for (uint32_t i = 0; i < received.sequence.size(); ++i)
+      EXPECT_EQ(i, received.sequence[i]);
+  }
+
+  shared_state->close(context.m_connection_id);
+  conn.reset();
+  work.reset();
+  worker.join();
+  server.send_stop_signal();
+  server.timed_wait_server_stop(5 * 1000);
+  server.deinit_server();
+}
+
+TEST(network_throttle, token_bucket)
+{
+  epee::net_utils::network_throttle throttle("test", "test");
+  throttle.set_target_speed(1); // 1024 bytes per second, also the burst size
+
+  EXPECT_EQ(0, throttle.reserve(512));
+  EXPECT_EQ(0, throttle.reserve(512));
+
+  // the bucket is empty, reservations queue up behind each other
+  EXPECT_NEAR(1.0, throttle.reserve(1024), 0.1);
+  EXPECT_NEAR(2.0, throttle.reserve(1024), 0.1);
+
+  throttle.set_target_speed(0);
+  EXPECT_EQ(0, throttle.reserve(1024 * 1024));
+}
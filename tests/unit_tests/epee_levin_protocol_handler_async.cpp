@@ -59,7 +59,7 @@ namespace
     {
     }
 
-    virtual int invoke(int command, const epee::span<const uint8_t> in_buff, epee::byte_stream& buff_out, test_levin_connection_context& context)
+    virtual int invoke(int command, const epee::byte_slice& in_buff, epee::byte_stream& buff_out, test_levin_connection_context& context)
     {
       m_invoke_counter.inc();
       boost::unique_lock<boost::mutex> lock(m_mutex);
@@ -69,12 +69,13 @@ namespace
       return m_return_code;
     }
 
-    virtual int notify(int command, const epee::span<const uint8_t> in_buff, test_levin_connection_context& context)
+    virtual int notify(int command, const epee::byte_slice& in_buff, test_levin_connection_context& context)
     {
       m_notify_counter.inc();
       boost::unique_lock<boost::mutex> lock(m_mutex);
       m_last_command = command;
       m_last_in_buf = std::string((const char*)in_buff.data(), in_buff.size());
+      m_last_in_slice = in_buff.clone();
       return m_return_code;
     }
 
@@ -109,6 +110,7 @@ namespace
 
     int last_command() const { return m_last_command; }
     const std::string& last_in_buf() const { return m_last_in_buf; }
+    const epee::byte_slice& last_in_slice() const { return m_last_in_slice; }
 
   private:
     unit_test::call_counter m_invoke_counter;
@@ -124,6 +126,7 @@ namespace
 
     int m_last_command;
     std::string m_last_in_buf;
+    epee::byte_slice m_last_in_slice;
   };
 
   class test_connection : public epee::net_utils::i_service_endpoint
@@ -527,6 +530,100 @@ TEST_F(positive_test_connection_to_levin_protocol_handler_calls, handler_process
 }
 
 
+TEST_F(positive_test_connection_to_levin_protocol_handler_calls, handler_assembles_large_fragmented_notify_in_place)
+{
+  // Setup
+  const int expected_command = 4673261;
+  const int expected_fragmented_command = 46732;
+  const std::size_t fragment_size = 64 * 1024;
+
+  epee::levin::message_writer message{};
+  message.buffer.put_n('e', 256);
+  const epee::byte_slice notify = message.finalize_notify(expected_command);
+
+  epee::levin::message_writer in_fragmented_data;
+  for (std::size_t i = 0; i < 4 * 1024 * 1024; ++i)
+    in_fragmented_data.buffer.put(char(i % 251));
+  const std::string expected_data{
+    reinterpret_cast<const char*>(in_fragmented_data.buffer.data()) + sizeof(epee::levin::bucket_head2),
+    in_fragmented_data.buffer.size() - sizeof(epee::levin::bucket_head2)
+  };
+
+  epee::byte_slice fragmented = epee::levin::make_fragmented_notify(fragment_size, expected_fragmented_command, std::move(in_fragmented_data));
+  ASSERT_EQ(0u, fragmented.size() % fragment_size);
+  ASSERT_LT(64u, fragmented.size() / fragment_size);
+
+  // the header of the whole message opens the body of the first fragment
+  const std::string expected_head{reinterpret_cast<const char*>(fragmented.data()) + sizeof(epee::levin::bucket_head2), sizeof(epee::levin::bucket_head2)};
+
+  test_connection_ptr conn = create_connection();
+
+  // uneven chunks, so fragments and headers are split across reads
+  const std::uint8_t* reassembly = nullptr;
+  while (!fragmented.empty())
+  {
+    ASSERT_EQ(0u, m_commands_handler.notify_counter());
+    epee::byte_slice next = fragmented.take_slice(1000);
+    ASSERT_TRUE(conn->m_protocol_handler.handle_recv(next.data(), next.size()));
+
+    // the buffer is sized once from the header, so fragments never move it
+    if (!reassembly && sizeof(epee::levin::bucket_head2) <= conn->m_protocol_handler.m_fragment_buffer.size())
+      reassembly = conn->m_protocol_handler.m_fragment_buffer.data();
+    else if (!fragmented.empty())
+      ASSERT_EQ(reassembly, conn->m_protocol_handler.m_fragment_buffer.data());
+  }
+
+  ASSERT_EQ(1u, m_commands_handler.notify_counter());
+  ASSERT_EQ(expected_fragmented_command, m_commands_handler.last_command());
+
+  // the handler sees the reassembly buffer itself, past the inner header
+  const epee::byte_slice in_slice = m_commands_handler.last_in_slice().clone();
+  ASSERT_NE(nullptr, reassembly);
+  ASSERT_EQ(reassembly + sizeof(epee::levin::bucket_head2), in_slice.data());
+  ASSERT_EQ(expected_head, std::string(reinterpret_cast<const char*>(in_slice.data()) - sizeof(epee::levin::bucket_head2), sizeof(epee::levin::bucket_head2)));
+  ASSERT_LE(expected_data.size(), in_slice.size());
+  ASSERT_TRUE(expected_data == std::string(reinterpret_cast<const char*>(in_slice.data()), expected_data.size()));
+  ASSERT_EQ(std::string(in_slice.size() - expected_data.size(), '\0'), std::string(reinterpret_cast<const char*>(in_slice.data()) + expected_data.size(), in_slice.size() - expected_data.size())); // padding
+
+  // a kept view is not reused by later messages
+  ASSERT_TRUE(conn->m_protocol_handler.handle_recv(notify.data(), notify.size()));
+  ASSERT_EQ(2u, m_commands_handler.notify_counter());
+  ASSERT_EQ(expected_command, m_commands_handler.last_command());
+  ASSERT_TRUE(expected_data == std::string(reinterpret_cast<const char*>(in_slice.data()), expected_data.size()));
+  ASSERT_EQ(0u, conn->send_counter());
+}
+
+TEST_F(positive_test_connection_to_levin_protocol_handler_calls, handler_receives_large_notify_in_place)
+{
+  // Setup
+  const int expected_command = 4673261;
+  const std::string in_data(2 * 1024 * 1024, 'e');
+
+  epee::levin::message_writer message{};
+  message.buffer.write(epee::to_span(in_data));
+  epee::byte_slice notify = message.finalize_notify(expected_command);
+
+  test_connection_ptr conn = create_connection();
+
+  epee::byte_slice first = notify.take_slice(sizeof(epee::levin::bucket_head2) + 1000);
+  ASSERT_TRUE(conn->m_protocol_handler.handle_recv(first.data(), first.size()));
+  const std::uint8_t* const body = conn->m_protocol_handler.m_message_buffer.data();
+  ASSERT_NE(nullptr, body);
+
+  while (!notify.empty())
+  {
+    ASSERT_EQ(0u, m_commands_handler.notify_counter());
+    epee::byte_slice next = notify.take_slice(4096);
+    ASSERT_TRUE(conn->m_protocol_handler.handle_recv(next.data(), next.size()));
+  }
+
+  ASSERT_EQ(1u, m_commands_handler.notify_counter());
+  ASSERT_EQ(expected_command, m_commands_handler.last_command());
+  ASSERT_EQ(body, m_commands_handler.last_in_slice().data());
+  ASSERT_TRUE(in_data == m_commands_handler.last_in_buf());
+}
+
+
 TEST_F(test_levin_protocol_handler__hanle_recv_with_invalid_data, handles_big_packet_1)
 {
   std::string buf("yyyyyy");
@@ -26,12 +26,84 @@
 // STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
 #include <cstdint>
 #include <gtest/gtest.h>
+#include <list>
+#include <string>
+#include <vector>
 
+#include "byte_slice.h"
+#include "serialization/keyvalue_serialization.h"
 #include "storages/portable_storage.h"
+#include "storages/portable_storage_reader.h"
+#include "storages/portable_storage_template_helper.h"
 #include "span.h"
 
+namespace
+{
+  // fields are in name order, so the DOM writes them in the same order
+  struct stream_child
+  {
+    std::string blob;
+    std::uint32_t value;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(blob)
+      KV_SERIALIZE(value)
+    END_KV_SERIALIZE_MAP()
+
+    bool operator==(const stream_child& rhs) const { return blob == rhs.blob && value == rhs.value; }
+  };
+
+  struct stream_parent
+  {
+    std::list<stream_child> children;
+    bool flag;
+    std::vector<std::uint64_t> numbers;
+    double ratio;
+    stream_child single;
+    std::int8_t small;
+    std::vector<std::string> text;
+
+    BEGIN_KV_SERIALIZE_MAP()
+      KV_SERIALIZE(children)
+      KV_SERIALIZE(flag)
+      KV_SERIALIZE(numbers)
+      KV_SERIALIZE(ratio)
+      KV_SERIALIZE(single)
+      KV_SERIALIZE(small)
+      KV_SERIALIZE(text)
+    END_KV_SERIALIZE_MAP()
+  };
+
+  stream_parent make_stream_parent()
+  {
+    stream_parent out{};
+    for (std::uint32_t i = 0; i < 100; ++i)
+      out.children.push_back({std::string(i, 'x'), i});
+    out.flag = true;
+    for (std::uint64_t i = 0; i < 20000; ++i)
+      out.numbers.push_back(i * 0x100000001);
+    out.ratio = 0.25;
+    out.small = -3;
+    out.single = {"a\"/\n\tb", 7};
+    out.text = {"one", "", "three"};
+    return out;
+  }
+
+  void expect_same(const stream_parent& lhs, const stream_parent& rhs)
+  {
+    EXPECT_TRUE(lhs.children == rhs.children);
+    EXPECT_EQ(lhs.flag, rhs.flag);
+    EXPECT_TRUE(lhs.numbers == rhs.numbers);
+    EXPECT_EQ(lhs.ratio, rhs.ratio);
+    EXPECT_TRUE(lhs.single == rhs.single);
+    EXPECT_EQ(lhs.small, rhs.small);
+    EXPECT_TRUE(lhs.text == rhs.text);
+  }
+}
+
 TEST(epee_binary, two_keys)
 {
   static constexpr const std::uint8_t data[] = {
@@ -53,3 +125,115 @@ TEST(epee_binary, duplicate_key)
   epee::serialization::portable_storage storage{};
   EXPECT_FALSE(storage.load_from_binary(data));
 }
+
+TEST(epee_binary, reader_two_keys)
+{
+  static constexpr const std::uint8_t data[] = {
+    0x01, 0x11, 0x01, 0x1, 0x01, 0x01, 0x02, 0x1, 0x1, 0x08, 0x01, 'a',
+    0x0B, 0x00, 0x01, 'b', 0x0B, 0x00
+  };
+
+  epee::serialization::binary_reader reader{};
+  EXPECT_TRUE(reader.load_from_binary(data));
+}
+
+TEST(epee_binary, reader_duplicate_key)
+{
+  static constexpr const std::uint8_t data[] = {
+    0x01, 0x11, 0x01, 0x1, 0x01, 0x01, 0x02, 0x1, 0x1, 0x08, 0x01, 'a',
+    0x0B, 0x00, 0x01, 'a', 0x0B, 0x00
+  };
+
+  epee::serialization::binary_reader reader{};
+  EXPECT_FALSE(reader.load_from_binary(data));
+}
+
+TEST(epee_binary, reader_truncated)
+{
+  const stream_parent source = make_stream_parent();
+  epee::byte_slice binary;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(source, binary));
+
+  epee::serialization::binary_reader reader{};
+  EXPECT_FALSE(reader.load_from_binary({binary.data(), binary.size() - 1}));
+  EXPECT_FALSE(reader.load_from_binary({binary.data(), 9}));
+}
+
+TEST(epee_binary, reader_limits)
+{
+  const stream_parent source = make_stream_parent();
+  epee::byte_slice binary;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(source, binary));
+
+  epee::serialization::portable_storage::limits_t limits{1000, 1000, 104};
+  epee::serialization::binary_reader reader{};
+  EXPECT_TRUE(reader.load_from_binary({binary.data(), binary.size()}, &limits));
+
+  limits.n_strings = 103;
+  EXPECT_FALSE(reader.load_from_binary({binary.data(), binary.size()}, &limits));
+
+  limits = {100, 1000, 1000};
+  EXPECT_FALSE(reader.load_from_binary({binary.data(), binary.size()}, &limits));
+}
+
+TEST(epee_binary, stream_round_trip)
+{
+  const stream_parent source = make_stream_parent();
+  epee::byte_slice binary;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(source, binary));
+
+  stream_parent streamed{};
+  ASSERT_TRUE(epee::serialization::load_t_from_binary(streamed, {binary.data(), binary.size()}));
+  expect_same(source, streamed);
+
+  epee::serialization::portable_storage storage{};
+  ASSERT_TRUE(storage.load_from_binary({binary.data(), binary.size()}));
+  stream_parent loaded{};
+  ASSERT_TRUE(loaded.load(storage));
+  expect_same(source, loaded);
+
+  /* the DOM writes counts with the smallest width, the stream always with 4
+     bytes: root, single, text and the 100 children take 1 byte in the DOM,
+     the children array 2 and numbers 4 */
+  epee::byte_stream expected;
+  ASSERT_TRUE(storage.store_to_binary(expected));
+  EXPECT_EQ(expected.size() + 3 * 103 + 2, binary.size());
+  stream_parent reloaded{};
+  ASSERT_TRUE(epee::serialization::load_t_from_binary(reloaded, {expected.data(), expected.size()}));
+  expect_same(source, reloaded);
+}
+
+TEST(epee_binary, stream_fixed_width_counts)
+{
+  stream_child source{"ab", 1};
+  epee::byte_slice binary;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(source, binary));
+
+  // root section count right after the header, as a 4 byte varint
+  ASSERT_LE(13u, binary.size());
+  EXPECT_EQ((2u << 2) | PORTABLE_RAW_SIZE_MARK_DWORD, binary.data()[9]);
+  EXPECT_EQ(0u, binary.data()[10]);
+  EXPECT_EQ(0u, binary.data()[11]);
+  EXPECT_EQ(0u, binary.data()[12]);
+
+  stream_child loaded{};
+  ASSERT_TRUE(epee::serialization::load_t_from_binary(loaded, {binary.data(), binary.size()}));
+  EXPECT_TRUE(source == loaded);
+}
+
+TEST(epee_json, stream_matches_dom)
+{
+  const stream_parent source = make_stream_parent();
+  epee::serialization::portable_storage storage{};
+  source.store(storage);
+
+  for (bool newlines : {true, false})
+  {
+    std::string expected;
+    ASSERT_TRUE(storage.dump_as_json(expected, 0, newlines));
+
+    std::string streamed = "leftover";
+    ASSERT_TRUE(epee::serialization::store_t_to_json(source, streamed, 0, newlines));
+    EXPECT_EQ(expected, streamed);
+  }
+}
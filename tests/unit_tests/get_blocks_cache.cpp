@@ -0,0 +1,109 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <gtest/gtest.h>
+
+#include "rpc/get_blocks_cache.h"
+
+namespace
+{
+  std::shared_ptr<const cryptonote::get_blocks_cache::entry> make_entry(const size_t size, const char id)
+  {
+    auto e = std::make_shared<cryptonote::get_blocks_cache::entry>();
+    e->block_id = crypto::null_hash;
+    e->block_id.data[0] = id;
+    e->tx_count = 0;
+    e->size = size;
+    return e;
+  }
+}
+
+TEST(get_blocks_cache, flags)
+{
+  using cache = cryptonote::get_blocks_cache;
+  EXPECT_EQ(0, cache::make_flags(false, false, false));
+  EXPECT_EQ(cache::flag_prune | cache::flag_compact, cache::make_flags(true, false, true));
+  EXPECT_NE(cache::make_flags(true, false, false), cache::make_flags(false, true, false));
+}
+
+TEST(get_blocks_cache, get)
+{
+  cryptonote::get_blocks_cache cache{1000};
+  EXPECT_EQ(nullptr, cache.get(10, 0));
+
+  cache.add(10, 0, make_entry(100, 1));
+  cache.add(10, 1, make_entry(100, 2));
+  ASSERT_NE(nullptr, cache.get(10, 0));
+  EXPECT_EQ(1, cache.get(10, 0)->block_id.data[0]);
+  ASSERT_NE(nullptr, cache.get(10, 1));
+  EXPECT_EQ(2, cache.get(10, 1)->block_id.data[0]);
+  EXPECT_EQ(nullptr, cache.get(11, 0));
+
+  cache.add(10, 0, make_entry(100, 3));
+  ASSERT_NE(nullptr, cache.get(10, 0));
+  EXPECT_EQ(3, cache.get(10, 0)->block_id.data[0]);
+
+  cache.clear();
+  EXPECT_EQ(nullptr, cache.get(10, 0));
+  EXPECT_EQ(nullptr, cache.get(10, 1));
+}
+
+TEST(get_blocks_cache, evict)
+{
+  cryptonote::get_blocks_cache cache{300};
+  cache.add(1, 0, make_entry(100, 1));
+  cache.add(2, 0, make_entry(100, 2));
+  cache.add(3, 0, make_entry(100, 3));
+
+  // using 1 makes 2 the least recently used
+  EXPECT_NE(nullptr, cache.get(1, 0));
+  cache.add(4, 0, make_entry(100, 4));
+  EXPECT_NE(nullptr, cache.get(1, 0));
+  EXPECT_EQ(nullptr, cache.get(2, 0));
+  EXPECT_NE(nullptr, cache.get(3, 0));
+  EXPECT_NE(nullptr, cache.get(4, 0));
+
+  // too large to ever fit
+  cache.add(5, 0, make_entry(301, 5));
+  EXPECT_EQ(nullptr, cache.get(5, 0));
+  EXPECT_NE(nullptr, cache.get(4, 0));
+
+  cache.add(6, 0, make_entry(250, 6));
+  EXPECT_NE(nullptr, cache.get(6, 0));
+  EXPECT_EQ(nullptr, cache.get(1, 0));
+  EXPECT_EQ(nullptr, cache.get(3, 0));
+  EXPECT_EQ(nullptr, cache.get(4, 0));
+}
+
+TEST(get_blocks_cache, disabled)
+{
+  cryptonote::get_blocks_cache cache{0};
+  cache.add(1, 0, make_entry(1, 1));
+  EXPECT_EQ(nullptr, cache.get(1, 0));
+}
@@ -28,6 +28,8 @@
 
 #include "gtest/gtest.h"
 #include "net/http_auth.h"
+#include "net/http_client_pool.h"
+#include "net/http_request_parser.h"
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -743,3 +745,173 @@ TEST(HTTP, Add_Field)
 
   EXPECT_STREQ("leading textfoo: bar\r\nbar: foo\r\nmoarbars: moarfoo\r\n", str.c_str());
 }
+
+TEST(HTTP_Request_Parser, ByteAtATime)
+{
+  const std::string request =
+    "\r\nget /json_rpc?a=b HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n"
+    "connection :close\r\n"
+    "X-Custom: value with spaces\n"
+    "\r\n";
+
+  http::request_parser parser{};
+  http::http_request_info info{};
+  for (std::size_t i = 0; i < request.size() - 1; ++i)
+  {
+    epee::span<const char> in{request.data() + i, 1};
+    ASSERT_EQ(http::request_parser::status::incomplete, parser.parse(in, info));
+    EXPECT_TRUE(in.empty());
+  }
+  epee::span<const char> in{&request.back(), 1};
+  ASSERT_EQ(http::request_parser::status::complete, parser.parse(in, info));
+
+  EXPECT_EQ(http::http_method_get, info.m_http_method);
+  EXPECT_EQ("get", info.m_http_method_str);
+  EXPECT_EQ("/json_rpc?a=b", info.m_URI);
+  EXPECT_EQ("/json_rpc", info.m_uri_content.m_path);
+  EXPECT_EQ("get /json_rpc?a=b HTTP/1.1\r\n", info.m_full_request_str);
+  EXPECT_EQ(1, info.m_http_ver_hi);
+  EXPECT_EQ(1, info.m_http_ver_lo);
+  EXPECT_EQ("127.0.0.1", info.m_header_info.m_host);
+  EXPECT_EQ("close", info.m_header_info.m_connection);
+  ASSERT_EQ(1u, info.m_header_info.m_etc_fields.size());
+  EXPECT_EQ("X-Custom", info.m_header_info.m_etc_fields.front().first);
+  EXPECT_EQ("value with spaces", info.m_header_info.m_etc_fields.front().second);
+  EXPECT_EQ(info.m_request_head.size(), info.m_full_request_buf_size);
+  EXPECT_TRUE(info.m_body.empty());
+}
+
+TEST(HTTP_Request_Parser, Pipelined)
+{
+  const std::string requests =
+    "POST /get_info HTTP/1.1\r\nContent-Length: 4\r\n\r\nbody"
+    "PUT /other HTTP/1.0\r\nContent-Length: 5\r\n\r\nab";
+
+  http::request_parser parser{};
+  http::http_request_info info{};
+  epee::span<const char> in{requests.data(), requests.size()};
+  ASSERT_EQ(http::request_parser::status::complete, parser.parse(in, info));
+  EXPECT_EQ(http::http_method_post, info.m_http_method);
+  EXPECT_EQ("/get_info", info.m_URI);
+  EXPECT_EQ("body", info.m_body);
+  EXPECT_FALSE(in.empty());
+
+  parser.reset();
+  info.clear();
+  ASSERT_EQ(http::request_parser::status::incomplete, parser.parse(in, info));
+  EXPECT_TRUE(in.empty());
+
+  const std::string rest = "cde";
+  in = {rest.data(), rest.size()};
+  ASSERT_EQ(http::request_parser::status::complete, parser.parse(in, info));
+  EXPECT_EQ(http::http_method_put, info.m_http_method);
+  EXPECT_EQ(1, info.m_http_ver_hi);
+  EXPECT_EQ(0, info.m_http_ver_lo);
+  EXPECT_EQ("abcde", info.m_body);
+  EXPECT_TRUE(in.empty());
+}
+
+TEST(HTTP_Request_Parser, Invalid)
+{
+  const auto parse = [] (const std::string& request)
+  {
+    http::request_parser parser{};
+    http::http_request_info info{};
+    epee::span<const char> in{request.data(), request.size()};
+    return parser.parse(in, info);
+  };
+
+  EXPECT_EQ(http::request_parser::status::error, parse("FETCH / HTTP/1.1\r\n"));
+  EXPECT_EQ(http::request_parser::status::error, parse("GET  / HTTP/1.1\r\n"));
+  EXPECT_EQ(http::request_parser::status::error, parse("GET / HTTP/1\r\n"));
+  EXPECT_EQ(http::request_parser::status::error, parse("GET / FTP/1.1\r\n"));
+  EXPECT_EQ(http::request_parser::status::error, parse("GET / HTTP/1.1\r\nContent-Length: x\r\n\r\n"));
+  EXPECT_EQ(http::request_parser::status::error, parse(std::string(HTTP_MAX_STARTING_NEWLINES + 1, '\n') + "GET / HTTP/1.1\r\n"));
+  EXPECT_EQ(http::request_parser::status::error, parse("GET /" + std::string(HTTP_MAX_URI_LEN, 'a')));
+  EXPECT_EQ(http::request_parser::status::incomplete, parse("GET /" + std::string(HTTP_MAX_URI_LEN / 2, 'a')));
+  EXPECT_EQ(http::request_parser::status::error, parse("GET / HTTP/1.1\r\nX: " + std::string(HTTP_MAX_HEADER_LEN, 'a')));
+}
+
+namespace
+{
+  struct fake_client final : http::abstract_http_client
+  {
+    std::string host;
+    std::string proxy;
+    std::uint64_t sent = 0;
+
+    virtual bool set_proxy(const std::string& address) override { proxy = address; return true; }
+    virtual void set_server(std::string host_, std::string, boost::optional<http::login>, epee::net_utils::ssl_options_t) override { host = std::move(host_); }
+    virtual void set_auto_connect(bool) override {}
+    virtual bool connect(std::chrono::milliseconds) override { return true; }
+    virtual bool disconnect() override { return true; }
+    virtual bool is_connected(bool* = NULL) override { return true; }
+    virtual bool invoke(const boost::string_ref, const boost::string_ref, const boost::string_ref body, std::chrono::milliseconds, const http::http_response_info** = NULL, const http::fields_list& = http::fields_list()) override
+    {
+      sent += body.size();
+      return true;
+    }
+    virtual bool invoke_get(const boost::string_ref uri, std::chrono::milliseconds timeout, const std::string& body = std::string(), const http::http_response_info** = NULL, const http::fields_list& = http::fields_list()) override
+    {
+      return invoke(uri, "GET", body, timeout);
+    }
+    virtual bool invoke_post(const boost::string_ref uri, const std::string& body, std::chrono::milliseconds timeout, const http::http_response_info** = NULL, const http::fields_list& = http::fields_list()) override
+    {
+      return invoke(uri, "POST", body, timeout);
+    }
+    virtual uint64_t get_bytes_sent() const override { return sent; }
+    virtual uint64_t get_bytes_received() const override { return 0; }
+  };
+
+  struct fake_client_factory final : http::http_client_factory
+  {
+    std::size_t& created;
+    explicit fake_client_factory(std::size_t& created) : created(created) {}
+    virtual std::unique_ptr<http::abstract_http_client> create() override
+    {
+      ++created;
+      return std::unique_ptr<http::abstract_http_client>{new fake_client{}};
+    }
+  };
+}
+
+TEST(HTTP_Client_Pool, Reuse)
+{
+  std::size_t created = 0;
+  http::client_pool pool{std::unique_ptr<http::http_client_factory>{new fake_client_factory{created}}, 1};
+  ASSERT_TRUE(pool.set_server("http://node.example:18081", boost::none));
+  ASSERT_TRUE(pool.set_proxy("127.0.0.1:9050"));
+
+  http::abstract_http_client* kept_client = nullptr;
+  {
+    http::client_pool::lease first = pool.acquire();
+    http::client_pool::lease second = pool.acquire();
+    ASSERT_TRUE(bool(first));
+    ASSERT_TRUE(bool(second));
+    EXPECT_NE(std::addressof(*first), std::addressof(*second));
+    EXPECT_EQ("node.example", static_cast<fake_client&>(*first).host);
+    EXPECT_EQ("127.0.0.1:9050", static_cast<fake_client&>(*first).proxy);
+    EXPECT_TRUE(first->invoke_post("/getblocks.bin", "1234", std::chrono::seconds(1)));
+    EXPECT_TRUE(second->invoke_post("/get_outs.bin", "12", std::chrono::seconds(1)));
+    kept_client = std::addressof(*second); // returned first
+  }
+  EXPECT_EQ(2u, created);
+  EXPECT_EQ(6u, pool.get_bytes_sent());
+
+  {
+    // only one connection is kept, and it is reused
+    http::client_pool::lease again = pool.acquire();
+    EXPECT_EQ(2u, created);
+    EXPECT_EQ(kept_client, std::addressof(*again));
+    EXPECT_TRUE(again->invoke_post("/getblocks.bin", "1", std::chrono::seconds(1)));
+
+    // new settings apply to new clients only, the leased one is dropped on return
+    ASSERT_TRUE(pool.set_server("http://other.example:18081", boost::none));
+  }
+  EXPECT_EQ(7u, pool.get_bytes_sent());
+
+  http::client_pool::lease last = pool.acquire();
+  EXPECT_EQ(3u, created);
+  EXPECT_EQ("other.example", static_cast<fake_client&>(*last).host);
+}
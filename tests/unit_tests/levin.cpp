@@ -245,7 +245,7 @@ namespace
             return out;
         }
 
-        virtual int invoke(int command, const epee::span<const uint8_t> in_buff, epee::byte_stream& buff_out, cryptonote::levin::detail::p2p_context& context) override final
+        virtual int invoke(int command, const epee::byte_slice& in_buff, epee::byte_stream& buff_out, cryptonote::levin::detail::p2p_context& context) override final
         {
             buff_out.clear();
             invoked_.push_back(
@@ -254,7 +254,7 @@ namespace
             return 1;
         }
 
-        virtual int notify(int command, const epee::span<const uint8_t> in_buff, cryptonote::levin::detail::p2p_context& context) override final
+        virtual int notify(int command, const epee::byte_slice& in_buff, cryptonote::levin::detail::p2p_context& context) override final
         {
             notified_.push_back(
                 {context.m_connection_id, command, std::string{reinterpret_cast<const char*>(in_buff.data()), in_buff.size()}}
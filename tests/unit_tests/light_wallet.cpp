@@ -0,0 +1,273 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <boost/filesystem/operations.hpp>
+#include <cstring>
+#include <gtest/gtest.h>
+
+#include "crypto/crypto.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "device/device.hpp"
+#include "ringct/rctOps.h"
+#include "rpc/light_wallet_scanner.h"
+#include "rpc/light_wallet_storage.h"
+
+namespace
+{
+  cryptonote::light_wallet::account make_account()
+  {
+    cryptonote::light_wallet::account acc{};
+    crypto::secret_key spend_key;
+    crypto::generate_keys(acc.address.m_spend_public_key, spend_key);
+    crypto::generate_keys(acc.address.m_view_public_key, acc.view_key);
+    return acc;
+  }
+
+  //! A tx with its public key set, outputs are added with `pay`.
+  struct test_tx
+  {
+    cryptonote::transaction tx;
+    crypto::public_key pub_key;
+    crypto::secret_key sec_key;
+
+    explicit test_tx(const std::size_t version)
+    {
+      tx.version = version;
+      if (version >= 2)
+        tx.rct_signatures.type = rct::RCTTypeCLSAG;
+      crypto::generate_keys(pub_key, sec_key);
+      cryptonote::add_tx_pub_key_to_extra(tx, pub_key);
+    }
+
+    //! \return The shared secret of the new output
+    rct::key pay(const cryptonote::light_wallet::account& to, const uint64_t amount)
+    {
+      crypto::key_derivation derivation;
+      EXPECT_TRUE(crypto::generate_key_derivation(to.address.m_view_public_key, sec_key, derivation));
+
+      const std::size_t index = tx.vout.size();
+      crypto::public_key key;
+      EXPECT_TRUE(crypto::derive_public_key(derivation, index, to.address.m_spend_public_key, key));
+
+      crypto::secret_key scalar;
+      crypto::derivation_to_scalar(derivation, index, scalar);
+      const rct::key shared = rct::sk2rct(scalar);
+
+      tx.vout.push_back({tx.version >= 2 ? 0 : amount, cryptonote::txout_to_key{key}});
+      if (tx.version >= 2)
+      {
+        rct::ecdhTuple ecdh{rct::genCommitmentMask(shared), rct::d2h(amount)};
+        tx.rct_signatures.outPk.push_back({rct::pk2rct(key), rct::commit(amount, ecdh.mask)});
+        rct::ecdhEncode(ecdh, shared, true);
+        tx.rct_signatures.ecdhInfo.push_back(ecdh);
+      }
+      return shared;
+    }
+  };
+
+  cryptonote::light_wallet::scan_block make_block(const uint64_t height, const std::vector<cryptonote::transaction>& txs)
+  {
+    cryptonote::light_wallet::scan_block block{height, 1000 + height, {}};
+    uint64_t global_index = 100;
+    for (const cryptonote::transaction& tx : txs)
+    {
+      std::vector<uint64_t> global_indices;
+      for (std::size_t i = 0; i < tx.vout.size(); ++i)
+        global_indices.push_back(global_index++);
+
+      block.txs.emplace_back();
+      EXPECT_TRUE(cryptonote::light_wallet::make_scan_tx(tx, crypto::rand<crypto::hash>(), std::move(global_indices), false, block.txs.back()));
+    }
+    return block;
+  }
+}
+
+TEST(light_wallet, scan_clear_outputs)
+{
+  const cryptonote::light_wallet::account alice = make_account();
+  const cryptonote::light_wallet::account bob = make_account();
+
+  test_tx tx{1};
+  tx.pay(alice, 5);
+  tx.pay(bob, 7);
+  tx.pay(alice, 9);
+  const cryptonote::light_wallet::scan_block block = make_block(10, {tx.tx});
+
+  std::vector<cryptonote::light_wallet::output> outputs;
+  std::vector<cryptonote::light_wallet::spend> spends;
+  cryptonote::light_wallet::scan(block, alice, {}, outputs, spends);
+  EXPECT_TRUE(spends.empty());
+  ASSERT_EQ(2u, outputs.size());
+  EXPECT_EQ(5u, outputs[0].amount);
+  EXPECT_EQ(0u, outputs[0].index);
+  EXPECT_EQ(100u, outputs[0].global_index);
+  EXPECT_EQ(9u, outputs[1].amount);
+  EXPECT_EQ(2u, outputs[1].index);
+  EXPECT_EQ(102u, outputs[1].global_index);
+  for (const cryptonote::light_wallet::output& out : outputs)
+  {
+    EXPECT_FALSE(out.rct);
+    EXPECT_EQ(out.amount, out.indexed_amount());
+    EXPECT_EQ(tx.pub_key, out.tx_pub_key);
+    EXPECT_EQ(block.txs[0].hash, out.tx_hash);
+    EXPECT_EQ(10u, out.height);
+    EXPECT_EQ(1010u, out.timestamp);
+  }
+
+  outputs.clear();
+  cryptonote::light_wallet::scan(block, bob, {}, outputs, spends);
+  ASSERT_EQ(1u, outputs.size());
+  EXPECT_EQ(7u, outputs[0].amount);
+  EXPECT_EQ(1u, outputs[0].index);
+}
+
+TEST(light_wallet, scan_ringct_outputs)
+{
+  const cryptonote::light_wallet::account alice = make_account();
+
+  test_tx tx{2};
+  const rct::key shared = tx.pay(alice, 123456789);
+  tx.pay(alice, 5);
+  tx.tx.rct_signatures.outPk[1].mask = rct::commit(6, rct::identity());
+
+  std::vector<cryptonote::light_wallet::output> outputs;
+  std::vector<cryptonote::light_wallet::spend> spends;
+  cryptonote::light_wallet::scan(make_block(10, {tx.tx}), alice, {}, outputs, spends);
+
+  // the second commitment does not open, so that output is skipped
+  ASSERT_EQ(1u, outputs.size());
+  const cryptonote::light_wallet::output& out = outputs[0];
+  EXPECT_TRUE(out.rct);
+  EXPECT_EQ(0u, out.indexed_amount());
+  EXPECT_EQ(123456789u, out.amount);
+  EXPECT_EQ(tx.tx.rct_signatures.outPk[0].mask, out.commitment);
+  EXPECT_EQ(tx.tx.rct_signatures.ecdhInfo[0].amount, out.encrypted_amount);
+
+  // light wallets recover the mask by subtracting Hs(shared secret)
+  rct::key mask;
+  sc_sub(mask.bytes, out.encrypted_mask.bytes, rct::hash_to_scalar(shared).bytes);
+  EXPECT_EQ(rct::genCommitmentMask(shared), mask);
+}
+
+TEST(light_wallet, scan_spends)
+{
+  cryptonote::light_wallet::account alice = make_account();
+  alice.outputs.emplace_back();
+  alice.outputs.back().tx_pub_key = crypto::rand<crypto::public_key>();
+  alice.outputs.back().amount = 50;
+  alice.outputs.back().index = 3;
+  alice.outputs.back().global_index = 42;
+  alice.outputs.back().rct = true;
+  const cryptonote::light_wallet::output_lookup lookup{{{0, 42}, 0}};
+
+  const crypto::key_image key_image = crypto::rand<crypto::key_image>();
+  cryptonote::transaction tx;
+  tx.version = 2;
+  tx.vin.push_back(cryptonote::txin_to_key{0, {40, 2, 1}, key_image});
+  tx.vin.push_back(cryptonote::txin_to_key{0, {43, 1}, crypto::rand<crypto::key_image>()});
+
+  std::vector<cryptonote::light_wallet::output> outputs;
+  std::vector<cryptonote::light_wallet::spend> spends;
+  cryptonote::light_wallet::scan(make_block(11, {tx}), alice, lookup, outputs, spends);
+  EXPECT_TRUE(outputs.empty());
+  ASSERT_EQ(1u, spends.size());
+  EXPECT_EQ(key_image, spends[0].key_image);
+  EXPECT_EQ(alice.outputs[0].tx_pub_key, spends[0].tx_pub_key);
+  EXPECT_EQ(50u, spends[0].amount);
+  EXPECT_EQ(3u, spends[0].out_index);
+  EXPECT_EQ(2u, spends[0].mixin);
+  EXPECT_EQ(11u, spends[0].height);
+
+  // a clear amount output with the same global index is a different output
+  spends.clear();
+  tx.vin.resize(1);
+  boost::get<cryptonote::txin_to_key>(tx.vin[0]).amount = 50;
+  cryptonote::light_wallet::scan(make_block(11, {tx}), alice, lookup, outputs, spends);
+  EXPECT_TRUE(spends.empty());
+}
+
+TEST(light_wallet, scan_short_payment_id)
+{
+  const cryptonote::light_wallet::account alice = make_account();
+
+  test_tx tx{2};
+  crypto::hash8 payment_id = crypto::rand<crypto::hash8>();
+  const crypto::hash8 expected = payment_id;
+  ASSERT_TRUE(hw::get_device("default").encrypt_payment_id(payment_id, alice.address.m_view_public_key, tx.sec_key));
+
+  cryptonote::blobdata nonce;
+  cryptonote::set_encrypted_payment_id_to_tx_extra_nonce(nonce, payment_id);
+  ASSERT_TRUE(cryptonote::add_extra_nonce_to_tx_extra(tx.tx.extra, nonce));
+  tx.pay(alice, 1);
+
+  std::vector<cryptonote::light_wallet::output> outputs;
+  std::vector<cryptonote::light_wallet::spend> spends;
+  cryptonote::light_wallet::scan(make_block(10, {tx.tx}), alice, {}, outputs, spends);
+  ASSERT_EQ(1u, outputs.size());
+  EXPECT_EQ(0, std::memcmp(expected.data, outputs[0].payment_id.data, sizeof(expected.data)));
+}
+
+TEST(light_wallet, storage)
+{
+  const boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+  cryptonote::light_wallet::account alice = make_account();
+  alice.start_height = 7;
+  alice.outputs.emplace_back();
+  alice.outputs.back().key = crypto::rand<crypto::public_key>();
+  alice.outputs.back().amount = 12;
+  alice.spends.emplace_back();
+  alice.spends.back().key_image = crypto::rand<crypto::key_image>();
+
+  cryptonote::light_wallet::scan_state state{20, {crypto::rand<crypto::hash>()}};
+  {
+    cryptonote::light_wallet::storage store{dir.string()};
+    ASSERT_TRUE(store.store({std::addressof(alice)}, std::addressof(state)));
+  }
+
+  std::vector<cryptonote::light_wallet::account> accounts;
+  cryptonote::light_wallet::scan_state loaded{};
+  {
+    cryptonote::light_wallet::storage store{dir.string()};
+    ASSERT_TRUE(store.load(accounts, loaded));
+  }
+  boost::filesystem::remove_all(dir);
+
+  EXPECT_EQ(20u, loaded.height);
+  EXPECT_EQ(state.recent_ids, loaded.recent_ids);
+  ASSERT_EQ(1u, accounts.size());
+  EXPECT_EQ(alice.address, accounts[0].address);
+  EXPECT_EQ(alice.view_key, accounts[0].view_key);
+  EXPECT_EQ(7u, accounts[0].start_height);
+  ASSERT_EQ(1u, accounts[0].outputs.size());
+  EXPECT_EQ(alice.outputs[0].key, accounts[0].outputs[0].key);
+  EXPECT_EQ(12u, accounts[0].outputs[0].amount);
+  ASSERT_EQ(1u, accounts[0].spends.size());
+  EXPECT_EQ(alice.spends[0].key_image, accounts[0].spends[0].key_image);
+}
@@ -452,7 +452,7 @@ TEST(cryptonote_protocol_handler, race_condition)
     using handshake = nodetool::COMMAND_HANDSHAKE_T<core::sync>;
   };
   struct net_node_t: commands_handler_t, p2p_endpoint_t {
-    using span_t = epee::span<const uint8_t>;
+    using byte_slice_t = epee::byte_slice;
     using zone_t = epee::net_utils::zone;
     using uuid_t = boost::uuids::uuid;
     using relay_t = cryptonote::relay_method;
@@ -467,12 +467,12 @@ TEST(cryptonote_protocol_handler, race_condition)
     };
     shared_state_ptr shared_state;
     core_protocol_ptr core_protocol;
-    virtual int invoke(int command, const span_t in, epee::byte_stream &out, context_t &context) override {
+    virtual int invoke(int command, const byte_slice_t &in, epee::byte_stream &out, context_t &context) override {
       if (core_protocol) {
         if (command == messages::handshake::ID) {
           return epee::net_utils::buff_to_t_adapter<void, typename messages::handshake::request, typename messages::handshake::response>(
             command,
-            in,
+            epee::to_span(in),
             out,
             [this](int command, typename messages::handshake::request &in, typename messages::handshake::response &out, context_t &context){
               core_protocol->process_payload_sync_data(in.payload_data, context, true);
@@ -483,16 +483,16 @@ TEST(cryptonote_protocol_handler, race_condition)
           );
         }
         bool handled;
-        return core_protocol->handle_invoke_map(false, command, in, out, context, handled);
+        return core_protocol->handle_invoke_map(false, command, epee::to_span(in), out, context, handled);
       }
       else
         return {};
     }
-    virtual int notify(int command, const span_t in, context_t &context) override {
+    virtual int notify(int command, const byte_slice_t &in, context_t &context) override {
       if (core_protocol) {
         bool handled;
         epee::byte_stream out;
-        return core_protocol->handle_invoke_map(true, command, in, out, context, handled);
+        return core_protocol->handle_invoke_map(true, command, epee::to_span(in), out, context, handled);
       }
       else
         return {};
@@ -1054,10 +1054,10 @@ TEST(node_server, race_condition)
     using endpoint_t = boost::asio::ip::tcp::endpoint;
     using event_t = epee::simple_event;
     struct command_handler_t: epee::levin::levin_commands_handler<context_t> {
-      using span_t = epee::span<const uint8_t>;
+      using byte_slice_t = epee::byte_slice;
       using byte_stream_t = epee::byte_stream;
-      int invoke(int, const span_t, byte_stream_t &, context_t &) override { return {}; }
-      int notify(int, const span_t, context_t &) override { return {}; }
+      int invoke(int, const byte_slice_t &, byte_stream_t &, context_t &) override { return {}; }
+      int notify(int, const byte_slice_t &, context_t &) override { return {}; }
       void callback(context_t &) override {}
       void on_connection_new(context_t &) override {}
       void on_connection_close(context_t &) override {}
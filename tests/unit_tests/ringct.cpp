@@ -38,6 +38,7 @@
 #include "ringct/rctSigs.h"
 #include "ringct/rctOps.h"
 #include "device/device.hpp"
+#include "device/device_default.hpp"
 #include "string_tools.h"
 
 using namespace std;
@@ -495,6 +496,75 @@ TEST(ringct, simple)
         decodeRctSimple(s, amount_keys[1], 1, mask,  hw::get_device("default"));
 }
 
+namespace
+{
+  // software keys, but reported as a hardware device so inputs are signed one after the other
+  struct serial_device: hw::core::device_default
+  {
+    device_type get_type() const override { return device_type::LEDGER; }
+  };
+}
+
+TEST(ringct, CLSAG_parallel_matches_serial)
+{
+  const size_t n_inputs = 4, ring_size = 11;
+  ctkeyV sc;
+  ctkeyM mixRing(n_inputs);
+  std::vector<unsigned int> index;
+  vector<xmr_amount> inamounts, outamounts;
+  keyV destinations, amount_keys;
+  for (size_t n = 0; n < n_inputs; ++n)
+  {
+    ctkey sk, pk;
+    tie(sk, pk) = ctskpkGen(1000 + n);
+    sc.push_back(sk);
+    inamounts.push_back(1000 + n);
+    index.push_back(n * 3 % ring_size);
+    for (size_t i = 0; i < ring_size; ++i)
+    {
+      if (i == index.back())
+        mixRing[n].push_back(pk);
+      else
+        mixRing[n].push_back({pkGen(), pkGen()});
+    }
+  }
+  for (size_t n = 0; n < 2; ++n)
+  {
+    outamounts.push_back(1500 + n);
+    destinations.push_back(pkGen());
+    amount_keys.push_back(skGen());
+  }
+  const xmr_amount fee = 4006 - 1500 - 1501;
+
+  const rct::RCTConfig rct_config { RangeProofPaddedBulletproof, 3 };
+  const key message = skGen();
+  ctkeyV outSk;
+  const rctSig parallel = genRctSimple(message, sc, destinations, inamounts, outamounts, fee, mixRing, amount_keys, NULL, NULL, index, outSk, rct_config, hw::get_device("default"));
+  serial_device serial_dev;
+  const rctSig serial = genRctSimple(message, sc, destinations, inamounts, outamounts, fee, mixRing, amount_keys, NULL, NULL, index, outSk, rct_config, serial_dev);
+
+  ASSERT_EQ(RCTTypeCLSAG, parallel.type);
+  ASSERT_EQ(RCTTypeCLSAG, serial.type);
+  ASSERT_EQ(n_inputs, parallel.p.CLSAGs.size());
+  ASSERT_EQ(n_inputs, serial.p.CLSAGs.size());
+  for (size_t n = 0; n < n_inputs; ++n)
+  {
+    // nonces and masks are random, the key image is not
+    crypto::key_image expected;
+    generate_key_image(rct2pk(mixRing[n][index[n]].dest), rct2sk(sc[n].dest), expected);
+    EXPECT_EQ(ki2rct(expected), parallel.p.CLSAGs[n].I);
+    EXPECT_EQ(ki2rct(expected), serial.p.CLSAGs[n].I);
+    EXPECT_EQ(parallel.p.CLSAGs[n].s.size(), serial.p.CLSAGs[n].s.size());
+  }
+  EXPECT_TRUE(verRctSimple(parallel));
+  EXPECT_TRUE(verRctSimple(serial));
+
+  // each signature only holds with its own transaction
+  rctSig mixed = parallel;
+  mixed.p.CLSAGs[1] = serial.p.CLSAGs[1];
+  EXPECT_FALSE(verRctSimple(mixed));
+}
+
 static rct::rctSig make_sample_rct_sig(int n_inputs, const uint64_t input_amounts[], int n_outputs, const uint64_t output_amounts[], bool last_is_fee)
 {
     ctkeyV sc, pc;
@@ -1237,6 +1307,20 @@ TEST(ringct, H)
   ASSERT_EQ(memcmp(&p3, &ge_p3_H, sizeof(ge_p3)), 0);
 }
 
+TEST(ringct, H_table)
+{
+  for (int n = 0; n < 16; ++n)
+  {
+    const rct::key a = rct::skGen(), b = rct::skGen();
+    ASSERT_EQ(rct::scalarmultH_vartime(a), rct::scalarmultH(a));
+    rct::key aGbH;
+    rct::addKeys2(aGbH, a, b, rct::H);
+    ASSERT_EQ(aGbH, rct::addKeys(rct::scalarmultBase(a), rct::scalarmultKey(rct::H, b)));
+  }
+  ASSERT_EQ(rct::scalarmultH_vartime(rct::zero()), rct::identity());
+  ASSERT_EQ(rct::scalarmultH_vartime(rct::identity()), rct::H);
+}
+
 TEST(ringct, mul8)
 {
   ge_p3 p3;
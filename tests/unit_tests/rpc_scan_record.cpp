@@ -0,0 +1,269 @@
+// Copyright (c) 2020, The Monero Project
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "ringct/rctOps.h"
+#include "rpc/scan_record.h"
+#include "storages/portable_storage.h"
+#include "storages/portable_storage_template_helper.h"
+
+namespace
+{
+  typedef cryptonote::rpc::block_scan_record block_scan_record;
+
+  crypto::public_key make_pub_key()
+  {
+    crypto::public_key pub;
+    crypto::secret_key sec;
+    crypto::generate_keys(pub, sec);
+    return pub;
+  }
+
+  crypto::key_image make_key_image()
+  {
+    return rct::rct2ki(rct::pkGen());
+  }
+
+  cryptonote::transaction make_miner_tx(uint64_t amount)
+  {
+    cryptonote::transaction tx;
+    tx.version = 2;
+    tx.unlock_time = 70;
+    tx.vin.push_back(cryptonote::txin_gen{10});
+    tx.vout.push_back({amount, cryptonote::txout_to_key(make_pub_key())});
+    cryptonote::add_tx_pub_key_to_extra(tx, make_pub_key());
+    tx.rct_signatures.type = rct::RCTTypeNull;
+    return tx;
+  }
+
+  cryptonote::transaction make_rct_tx(uint8_t type, size_t inputs, size_t outputs, size_t additional)
+  {
+    cryptonote::transaction tx;
+    tx.version = 2;
+    tx.unlock_time = 0;
+    for (size_t i = 0; i < inputs; ++i)
+    {
+      cryptonote::txin_to_key in;
+      in.amount = 0;
+      in.key_offsets = {1, 2};
+      in.k_image = make_key_image();
+      tx.vin.push_back(in);
+    }
+    for (size_t i = 0; i < outputs; ++i)
+      tx.vout.push_back({0, cryptonote::txout_to_key(make_pub_key())});
+    cryptonote::add_tx_pub_key_to_extra(tx, make_pub_key());
+    if (additional)
+    {
+      std::vector<crypto::public_key> additional_pub_keys;
+      for (size_t i = 0; i < additional; ++i)
+        additional_pub_keys.push_back(make_pub_key());
+      cryptonote::add_additional_tx_pub_keys_to_extra(tx.extra, additional_pub_keys);
+    }
+    tx.rct_signatures.type = type;
+    for (size_t i = 0; i < outputs; ++i)
+    {
+      tx.rct_signatures.outPk.push_back({rct::pkGen(), rct::pkGen()});
+      tx.rct_signatures.ecdhInfo.push_back({rct::skGen(), rct::skGen()});
+    }
+    return tx;
+  }
+
+  template<typename T>
+  size_t get_blob_size(epee::serialization::portable_storage &ps, const char *name)
+  {
+    std::string blob;
+    if (!ps.get_value(name, blob, nullptr))
+      return size_t(-1);
+    return blob.size() / sizeof(T);
+  }
+}
+
+TEST(rpc_scan_record, columns)
+{
+  const cryptonote::transaction miner_tx = make_miner_tx(1000);
+  const cryptonote::transaction clsag_tx = make_rct_tx(rct::RCTTypeCLSAG, 2, 3, 3);
+  const cryptonote::transaction legacy_tx = make_rct_tx(rct::RCTTypeFull, 1, 2, 0);
+  const crypto::hash miner_tx_hash = crypto::rand<crypto::hash>(), clsag_tx_hash = crypto::rand<crypto::hash>(), legacy_tx_hash = crypto::rand<crypto::hash>();
+
+  block_scan_record record;
+  ASSERT_TRUE(cryptonote::rpc::add_to_scan_record(miner_tx, miner_tx_hash, record));
+  ASSERT_TRUE(cryptonote::rpc::add_to_scan_record(clsag_tx, clsag_tx_hash, record));
+  ASSERT_TRUE(cryptonote::rpc::add_to_scan_record(legacy_tx, legacy_tx_hash, record));
+
+  // one entry per tx, miner tx first
+  ASSERT_EQ(3, record.tx_hashes.size());
+  ASSERT_EQ(3, record.unlock_times.size());
+  ASSERT_EQ(3, record.rct_types.size());
+  ASSERT_EQ(3, record.tx_pub_keys.size());
+  ASSERT_EQ(3, record.additional_pub_key_counts.size());
+  ASSERT_EQ(3, record.input_counts.size());
+  ASSERT_EQ(3, record.output_counts.size());
+  ASSERT_EQ(miner_tx_hash, record.tx_hashes[0]);
+  ASSERT_EQ(clsag_tx_hash, record.tx_hashes[1]);
+  ASSERT_EQ(legacy_tx_hash, record.tx_hashes[2]);
+
+  // the miner tx has no key images, a cleartext amount, and no ringct columns
+  ASSERT_EQ(70, record.unlock_times[0]);
+  ASSERT_EQ(rct::RCTTypeNull, record.rct_types[0]);
+  ASSERT_EQ(cryptonote::get_tx_pub_key_from_extra(miner_tx), record.tx_pub_keys[0]);
+  ASSERT_EQ(0, record.input_counts[0]);
+  ASSERT_EQ(1, record.output_counts[0]);
+  ASSERT_EQ(1000, record.amounts[0]);
+  ASSERT_EQ(boost::get<cryptonote::txout_to_key>(miner_tx.vout[0].target).key, record.output_keys[0]);
+
+  ASSERT_EQ(rct::RCTTypeCLSAG, record.rct_types[1]);
+  ASSERT_EQ(rct::RCTTypeFull, record.rct_types[2]);
+  ASSERT_EQ((std::vector<uint64_t>{0, 3, 0}), record.additional_pub_key_counts);
+  ASSERT_EQ((std::vector<uint64_t>{0, 2, 1}), record.input_counts);
+  ASSERT_EQ((std::vector<uint64_t>{1, 3, 2}), record.output_counts);
+
+  // concatenated columns
+  ASSERT_EQ(3, record.additional_pub_keys.size());
+  ASSERT_EQ(cryptonote::get_additional_tx_pub_keys_from_extra(clsag_tx), record.additional_pub_keys);
+  ASSERT_EQ(3, record.key_images.size());
+  ASSERT_EQ(boost::get<cryptonote::txin_to_key>(clsag_tx.vin[0]).k_image, record.key_images[0]);
+  ASSERT_EQ(boost::get<cryptonote::txin_to_key>(legacy_tx.vin[0]).k_image, record.key_images[2]);
+  ASSERT_EQ(6, record.output_keys.size());
+  ASSERT_EQ(6, record.amounts.size());
+  ASSERT_EQ(boost::get<cryptonote::txout_to_key>(clsag_tx.vout[2].target).key, record.output_keys[3]);
+  ASSERT_EQ(5, record.commitments.size());
+  ASSERT_EQ(clsag_tx.rct_signatures.outPk[0].mask, record.commitments[0]);
+  ASSERT_EQ(legacy_tx.rct_signatures.outPk[1].mask, record.commitments[4]);
+
+  // compact ecdh for CLSAG: the first 8 bytes of the amount
+  ASSERT_EQ(3, record.encrypted_amounts.size());
+  for (size_t i = 0; i < 3; ++i)
+    ASSERT_EQ(0, memcmp(&record.encrypted_amounts[i], clsag_tx.rct_signatures.ecdhInfo[i].amount.bytes, sizeof(crypto::hash8)));
+
+  // legacy ecdh: mask then amount for each output
+  ASSERT_EQ(4, record.legacy_ecdh_info.size());
+  for (size_t i = 0; i < 2; ++i)
+  {
+    ASSERT_EQ(legacy_tx.rct_signatures.ecdhInfo[i].mask, record.legacy_ecdh_info[2 * i]);
+    ASSERT_EQ(legacy_tx.rct_signatures.ecdhInfo[i].amount, record.legacy_ecdh_info[2 * i + 1]);
+  }
+}
+
+TEST(rpc_scan_record, wire_layout)
+{
+  block_scan_record record;
+  record.block_id = crypto::rand<crypto::hash>();
+  record.timestamp = 1234;
+  ASSERT_TRUE(cryptonote::rpc::add_to_scan_record(make_miner_tx(5), crypto::rand<crypto::hash>(), record));
+  ASSERT_TRUE(cryptonote::rpc::add_to_scan_record(make_rct_tx(rct::RCTTypeBulletproof2, 3, 2, 2), crypto::rand<crypto::hash>(), record));
+  ASSERT_TRUE(cryptonote::rpc::add_to_scan_record(make_rct_tx(rct::RCTTypeBulletproof, 1, 2, 0), crypto::rand<crypto::hash>(), record));
+
+  epee::byte_slice blob;
+  ASSERT_TRUE(epee::serialization::store_t_to_binary(record, blob));
+  epee::serialization::portable_storage ps;
+  ASSERT_TRUE(ps.load_from_binary(epee::to_span(blob)));
+
+  // every column is a single POD blob
+  ASSERT_EQ(1, get_blob_size<crypto::hash>(ps, "block_id"));
+  ASSERT_EQ(3, get_blob_size<crypto::hash>(ps, "tx_hashes"));
+  ASSERT_EQ(3, get_blob_size<uint64_t>(ps, "unlock_times"));
+  ASSERT_EQ(3, get_blob_size<uint8_t>(ps, "rct_types"));
+  ASSERT_EQ(3, get_blob_size<crypto::public_key>(ps, "tx_pub_keys"));
+  ASSERT_EQ(3, get_blob_size<uint64_t>(ps, "additional_pub_key_counts"));
+  ASSERT_EQ(3, get_blob_size<uint64_t>(ps, "input_counts"));
+  ASSERT_EQ(3, get_blob_size<uint64_t>(ps, "output_counts"));
+  ASSERT_EQ(2, get_blob_size<crypto::public_key>(ps, "additional_pub_keys"));
+  ASSERT_EQ(4, get_blob_size<crypto::key_image>(ps, "key_images"));
+  ASSERT_EQ(5, get_blob_size<crypto::public_key>(ps, "output_keys"));
+  ASSERT_EQ(5, get_blob_size<uint64_t>(ps, "amounts"));
+  ASSERT_EQ(4, get_blob_size<rct::key>(ps, "commitments"));
+  ASSERT_EQ(2, get_blob_size<crypto::hash8>(ps, "encrypted_amounts"));
+  ASSERT_EQ(4, get_blob_size<rct::key>(ps, "legacy_ecdh_info"));
+
+  block_scan_record loaded;
+  ASSERT_TRUE(epee::serialization::load_t_from_binary(loaded, epee::to_span(blob)));
+  ASSERT_EQ(record.block_id, loaded.block_id);
+  ASSERT_EQ(record.timestamp, loaded.timestamp);
+  ASSERT_EQ(record.tx_hashes, loaded.tx_hashes);
+  ASSERT_EQ(record.output_keys, loaded.output_keys);
+  ASSERT_EQ(record.encrypted_amounts.size(), loaded.encrypted_amounts.size());
+  ASSERT_EQ(record.legacy_ecdh_info, loaded.legacy_ecdh_info);
+  ASSERT_EQ(cryptonote::rpc::get_scan_record_size(record), cryptonote::rpc::get_scan_record_size(loaded));
+}
+
+TEST(rpc_scan_record, invalid)
+{
+  block_scan_record record;
+  cryptonote::transaction tx = make_rct_tx(rct::RCTTypeCLSAG, 1, 2, 0);
+  tx.rct_signatures.ecdhInfo.pop_back();
+  ASSERT_FALSE(cryptonote::rpc::add_to_scan_record(tx, crypto::null_hash, record));
+
+  tx = make_miner_tx(1);
+  tx.vout[0].target = cryptonote::txout_to_scripthash();
+  ASSERT_FALSE(cryptonote::rpc::add_to_scan_record(tx, crypto::null_hash, record));
+}
+
+TEST(rpc_scan_record, block)
+{
+  cryptonote::block b;
+  b.timestamp = 4321;
+  b.miner_tx = make_miner_tx(2000);
+  const crypto::hash block_id = crypto::rand<crypto::hash>(), miner_tx_hash = crypto::rand<crypto::hash>();
+
+  std::vector<std::pair<crypto::hash, cryptonote::blobdata>> txs;
+  std::vector<cryptonote::transaction> parsed;
+  for (uint8_t type: {rct::RCTTypeCLSAG, rct::RCTTypeBulletproof})
+  {
+    parsed.push_back(make_rct_tx(type, 1, 2, 0));
+    txs.push_back({crypto::rand<crypto::hash>(), cryptonote::tx_to_blob(parsed.back())});
+  }
+
+  block_scan_record record;
+  ASSERT_TRUE(cryptonote::rpc::make_scan_record(b, block_id, miner_tx_hash, txs, false, record));
+  ASSERT_EQ(block_id, record.block_id);
+  ASSERT_EQ(4321, record.timestamp);
+  ASSERT_EQ((std::vector<crypto::hash>{miner_tx_hash, txs[0].first, txs[1].first}), record.tx_hashes);
+  ASSERT_EQ(2000, record.amounts[0]);
+  ASSERT_EQ(boost::get<cryptonote::txin_to_key>(parsed[1].vin[0]).k_image, record.key_images[1]);
+  ASSERT_EQ(parsed[1].rct_signatures.outPk[1].mask, record.commitments[3]);
+  ASSERT_EQ(2, record.encrypted_amounts.size());
+  ASSERT_EQ(4, record.legacy_ecdh_info.size());
+
+  // without the miner tx, the columns start with the first tx of the block
+  block_scan_record no_miner;
+  ASSERT_TRUE(cryptonote::rpc::make_scan_record(b, block_id, crypto::null_hash, txs, true, no_miner));
+  ASSERT_EQ((std::vector<crypto::hash>{txs[0].first, txs[1].first}), no_miner.tx_hashes);
+  ASSERT_EQ((std::vector<uint64_t>{2, 2}), no_miner.output_counts);
+  ASSERT_EQ(record.output_keys.size() - 1, no_miner.output_keys.size());
+  ASSERT_EQ(cryptonote::rpc::get_scan_record_size(record) - cryptonote::rpc::get_scan_record_size(no_miner),
+    sizeof(crypto::hash) + 4 * sizeof(uint64_t) + 1 + 2 * sizeof(crypto::public_key) + sizeof(uint64_t));
+
+  // a tx that does not parse fails the whole block
+  txs[1].second.resize(txs[1].second.size() / 2);
+  block_scan_record truncated;
+  ASSERT_FALSE(cryptonote::rpc::make_scan_record(b, block_id, miner_tx_hash, txs, false, truncated));
+}
@@ -35,6 +35,9 @@
 #include "crypto/crypto.h"
 #include "cryptonote_basic/account.h"
 #include "cryptonote_basic/cryptonote_basic_impl.h"
+#include "cryptonote_basic/subaddress_map.h"
+#include "serialization/binary_utils.h"
+#include "serialization/containers.h"
 #include "wallet/api/subaddress.h"
 
 class WalletSubaddress : public ::testing::Test 
@@ -101,3 +104,125 @@ TEST_F(WalletSubaddress, OutOfBoundsIndexes)
     EXPECT_STREQ("index.minor is out of bound", e.what());  
   }   
 }
+
+TEST_F(WalletSubaddress, BatchedKeysMatchSingleDerivation)
+{
+  hw::device &hwdev = w1.get_account().get_device();
+  const std::vector<crypto::public_key> pkeys = hwdev.get_subaddress_spend_public_keys(w1.get_account().get_keys(), 0, 0, 600);
+  ASSERT_EQ(600, pkeys.size());
+  for (uint32_t minor = 0; minor < pkeys.size(); ++minor)
+    EXPECT_EQ(w1.get_subaddress_spend_public_key({0, minor}), pkeys[minor]);
+
+  const std::vector<crypto::public_key> tail = hwdev.get_subaddress_spend_public_keys(w1.get_account().get_keys(), 1, 299, 301);
+  ASSERT_EQ(2, tail.size());
+  EXPECT_EQ(w1.get_subaddress_spend_public_key({1, 299}), tail[0]);
+  EXPECT_EQ(w1.get_subaddress_spend_public_key({1, 300}), tail[1]);
+}
+
+TEST_F(WalletSubaddress, IncrementalLookahead)
+{
+  // wider than the default lookahead the wallet was generated with
+  w1.set_subaddress_lookahead(2, 300);
+  for (int i = 0; i < 12; ++i)
+    w1.add_subaddress(0, "");
+  ASSERT_EQ(13, w1.get_num_subaddresses(0));
+  for (uint32_t minor = 0; minor < 12 + 300; ++minor)
+  {
+    const auto index = w1.get_subaddress_index(w1.get_subaddress({0, minor}));
+    ASSERT_TRUE(bool(index));
+    EXPECT_EQ(minor, index->minor);
+  }
+  EXPECT_FALSE(bool(w1.get_subaddress_index(w1.get_subaddress({0, 12 + 300}))));
+
+  w1.add_subaddress_account("");
+  EXPECT_TRUE(bool(w1.get_subaddress_index(w1.get_subaddress({2, 299}))));
+  EXPECT_FALSE(bool(w1.get_subaddress_index(w1.get_subaddress({2, 300}))));
+}
+
+TEST(subaddress_map, insert_find)
+{
+  cryptonote::subaddress_map map;
+  std::vector<crypto::public_key> keys(1000);
+  for (crypto::public_key &key : keys)
+    key = rct::rct2pk(rct::pkGen());
+  EXPECT_FALSE(map.find(keys[0]));
+
+  for (uint32_t i = 0; i < keys.size(); ++i)
+    map.insert(keys[i], {i % 7, i});
+  ASSERT_EQ(keys.size(), map.size());
+  for (uint32_t i = 0; i < keys.size(); ++i)
+  {
+    const cryptonote::subaddress_index *index = map.find(keys[i]);
+    ASSERT_TRUE(index);
+    EXPECT_EQ((cryptonote::subaddress_index{i % 7, i}), *index);
+    EXPECT_EQ(1, map.count(keys[i]));
+  }
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(0, map.count(rct::rct2pk(rct::pkGen())));
+  EXPECT_FALSE(map.find(crypto::null_pkey));
+
+  map.insert(keys[3], {1, 2});
+  EXPECT_EQ(keys.size(), map.size());
+  EXPECT_EQ((cryptonote::subaddress_index{1, 2}), *map.find(keys[3]));
+  EXPECT_EQ(keys.size(), std::distance(map.begin(), map.end()));
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.find(keys[3]));
+}
+
+TEST(subaddress_map, expanded)
+{
+  std::vector<crypto::public_key> keys(10);
+  for (crypto::public_key &key : keys)
+    key = rct::rct2pk(rct::pkGen());
+
+  cryptonote::subaddress_map map;
+  EXPECT_EQ(0, map.expanded(0));
+  map.insert(2, 0, {keys.begin(), keys.begin() + 4});
+  EXPECT_EQ(4, map.expanded(2));
+  map.insert(keys[4], {2, 6});
+  EXPECT_EQ(4, map.expanded(2));
+  map.insert(keys[5], {2, 4});
+  EXPECT_EQ(5, map.expanded(2));
+  map.insert(keys[6], {3, 1});
+  EXPECT_EQ(0, map.expanded(3));
+
+  // out of order entries are counted once the map is reindexed
+  map.insert(keys[7], {2, 5});
+  map.update_expanded();
+  EXPECT_EQ(7, map.expanded(2));
+  EXPECT_EQ(0, map.expanded(3));
+
+  std::unordered_map<crypto::public_key, cryptonote::subaddress_index> source;
+  for (uint32_t i = 0; i < keys.size(); ++i)
+    source[keys[i]] = {1, keys.size() - 1 - i};
+  const cryptonote::subaddress_map converted = source;
+  EXPECT_EQ(keys.size(), converted.size());
+  EXPECT_EQ(keys.size(), converted.expanded(1));
+}
+
+TEST(subaddress_map, serialization)
+{
+  serializable_unordered_map<crypto::public_key, cryptonote::subaddress_index> source;
+  for (uint32_t i = 0; i < 100; ++i)
+    source[rct::rct2pk(rct::pkGen())] = {i / 10, i % 10};
+
+  std::string blob;
+  ASSERT_TRUE(serialization::dump_binary(source, blob));
+  cryptonote::subaddress_map map;
+  ASSERT_TRUE(serialization::parse_binary(blob, map));
+  ASSERT_EQ(source.size(), map.size());
+  for (const auto &elem : source)
+  {
+    ASSERT_TRUE(map.find(elem.first));
+    EXPECT_EQ(elem.second, *map.find(elem.first));
+  }
+  EXPECT_EQ(10, map.expanded(9));
+
+  std::string blob2;
+  ASSERT_TRUE(serialization::dump_binary(map, blob2));
+  serializable_unordered_map<crypto::public_key, cryptonote::subaddress_index> back;
+  ASSERT_TRUE(serialization::parse_binary(blob2, back));
+  EXPECT_EQ(source, back);
+}
@@ -72,6 +72,51 @@ TEST(peer_list, peer_list_general)
 }
 
 
+TEST(peer_list, snapshot)
+{
+  nodetool::peerlist_manager plm;
+  plm.init(nodetool::peerlist_types{}, false);
+
+  ADD_WHITE_NODE(MAKE_IPV4_ADDRESS(123,43,12,1, 8080), 1, 100);
+  ADD_WHITE_NODE(MAKE_IPV4_ADDRESS(123,43,12,2, 8080), 2, 300);
+  ADD_WHITE_NODE(MAKE_IPV4_ADDRESS(124,43,12,3, 8080), 3, 200);
+  ADD_GRAY_NODE(MAKE_IPV4_ADDRESS(125,43,12,4, 8080), 4, 100);
+
+  const std::shared_ptr<const nodetool::peerlist_snapshot> white = plm.get_snapshot(true);
+  ASSERT_EQ(3u, white->peers.size());
+  EXPECT_EQ(white, plm.get_snapshot(true));
+  EXPECT_EQ(2u, white->peers[0].peer.id);
+  EXPECT_EQ(3u, white->peers[1].peer.id);
+  EXPECT_EQ(1u, white->peers[2].peer.id);
+  EXPECT_EQ("123.43.12.2", white->peers[0].host);
+  ASSERT_TRUE(bool(white->peers[0].class_b));
+  ASSERT_TRUE(bool(white->peers[2].class_b));
+  ASSERT_TRUE(bool(white->peers[1].class_b));
+  EXPECT_EQ(*white->peers[0].class_b, *white->peers[2].class_b);
+  EXPECT_NE(*white->peers[0].class_b, *white->peers[1].class_b);
+
+  nodetool::peerlist_entry pe;
+  ASSERT_TRUE(plm.get_white_peer_by_index(pe, 1));
+  EXPECT_EQ(3u, pe.id);
+  EXPECT_FALSE(plm.get_white_peer_by_index(pe, 3));
+  ASSERT_TRUE(plm.get_random_gray_peer(pe));
+  EXPECT_EQ(4u, pe.id);
+
+  // a gray entry sent again does not change anything
+  const std::shared_ptr<const nodetool::peerlist_snapshot> gray = plm.get_snapshot(false);
+  ADD_GRAY_NODE(MAKE_IPV4_ADDRESS(125,43,12,4, 8080), 4, 500);
+  EXPECT_EQ(gray, plm.get_snapshot(false));
+
+  // moving a peer to the white list replaces both, older copies stay as they were
+  ADD_WHITE_NODE(MAKE_IPV4_ADDRESS(125,43,12,4, 8080), 4, 400);
+  EXPECT_EQ(3u, white->peers.size());
+  EXPECT_EQ(1u, gray->peers.size());
+  EXPECT_EQ(4u, plm.get_snapshot(true)->peers.size());
+  EXPECT_EQ(4u, plm.get_snapshot(true)->peers[0].peer.id);
+  EXPECT_TRUE(plm.get_snapshot(false)->peers.empty());
+  EXPECT_FALSE(plm.get_random_gray_peer(pe));
+}
+
 TEST(peer_list, merge_peer_lists)
 {
   //([^ \t]*)\t([^ \t]*):([^ \t]*) \tlast_seen: d(\d+)\.h(\d+)\.m(\d+)\.s(\d+)\n
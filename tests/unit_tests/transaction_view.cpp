@@ -0,0 +1,206 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "cryptonote_basic/cryptonote_basic.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_basic/transaction_view.h"
+#include "ringct/rctTypes.h"
+#include "span.h"
+
+namespace
+{
+  template<typename T>
+  T fill(const std::uint8_t value)
+  {
+    T out;
+    std::memset(std::addressof(out), value, sizeof(out));
+    return out;
+  }
+
+  cryptonote::transaction make_prefix(const std::size_t version)
+  {
+    cryptonote::transaction tx{};
+    tx.version = version;
+    tx.unlock_time = 60;
+
+    cryptonote::txin_to_key in{};
+    in.amount = version == 1 ? 1000 : 0;
+    in.key_offsets = {300, 2, 70000};
+    in.k_image = fill<crypto::key_image>(0x11);
+    tx.vin.push_back(in);
+
+    for (std::uint8_t i = 0; i < 2; ++i)
+    {
+      cryptonote::tx_out out{};
+      out.amount = version == 1 ? 400 + i : 0;
+      out.target = cryptonote::txout_to_key{fill<crypto::public_key>(0x20 + i)};
+      tx.vout.push_back(out);
+    }
+
+    tx.extra = {0x01, 0x02, 0x03, 0x04};
+    return tx;
+  }
+
+  cryptonote::transaction make_v1()
+  {
+    cryptonote::transaction tx = make_prefix(1);
+    tx.signatures.resize(1);
+    tx.signatures[0].resize(3, fill<crypto::signature>(0x33));
+    return tx;
+  }
+
+  cryptonote::transaction make_clsag()
+  {
+    cryptonote::transaction tx = make_prefix(2);
+    rct::rctSig& rv = tx.rct_signatures;
+    rv.type = rct::RCTTypeCLSAG;
+    rv.txnFee = 12345;
+    rv.ecdhInfo.resize(2);
+    rv.ecdhInfo[0].amount = fill<rct::key>(0x40);
+    rv.ecdhInfo[1].amount = fill<rct::key>(0x41);
+    rv.outPk.resize(2);
+    rv.outPk[0].mask = rct::H; // expanded into the bulletproof, so must be points
+    rv.outPk[1].mask = rct::H;
+
+    rct::Bulletproof bp{};
+    bp.L.resize(7, fill<rct::key>(0x60));
+    bp.R.resize(7, fill<rct::key>(0x61));
+    rv.p.bulletproofs.push_back(bp);
+
+    rct::clsag clsag{};
+    clsag.s.resize(3, fill<rct::key>(0x70));
+    clsag.c1 = fill<rct::key>(0x71);
+    clsag.D = fill<rct::key>(0x72);
+    rv.p.CLSAGs.push_back(clsag);
+    rv.p.pseudoOuts.push_back(fill<rct::key>(0x73));
+    return tx;
+  }
+
+  epee::span<const std::uint8_t> to_span(const cryptonote::blobdata& blob)
+  {
+    return epee::strspan<std::uint8_t>(blob);
+  }
+}
+
+TEST(transaction_view, v1)
+{
+  const cryptonote::transaction tx = make_v1();
+  const cryptonote::blobdata blob = cryptonote::tx_to_blob(tx);
+
+  cryptonote::transaction_view view;
+  ASSERT_TRUE(view.parse(to_span(blob)));
+  EXPECT_EQ(1u, view.version());
+  EXPECT_EQ(60u, view.unlock_time());
+  ASSERT_EQ(1u, view.inputs().size());
+  EXPECT_EQ(1000u, view.inputs()[0].amount);
+  EXPECT_EQ(3u, view.inputs()[0].key_offsets_count);
+  EXPECT_EQ(boost::get<cryptonote::txin_to_key>(tx.vin[0]).k_image, *view.inputs()[0].key_image);
+  ASSERT_EQ(2u, view.outputs().size());
+  EXPECT_EQ(401u, view.outputs()[1].amount);
+  EXPECT_EQ(boost::get<cryptonote::txout_to_key>(tx.vout[1].target).key, *view.outputs()[1].key);
+  EXPECT_EQ(tx.extra.size(), view.extra().size());
+  EXPECT_EQ(3u * sizeof(crypto::signature), view.base().size());
+  EXPECT_TRUE(view.prunable().empty());
+
+  EXPECT_EQ(cryptonote::get_transaction_prefix_hash(tx), view.get_prefix_hash());
+  EXPECT_EQ(cryptonote::get_transaction_hash(tx), view.get_hash());
+
+  cryptonote::transaction copy;
+  ASSERT_TRUE(view.materialize(copy));
+  EXPECT_EQ(blob, cryptonote::tx_to_blob(copy));
+
+  EXPECT_FALSE(view.parse(to_span(blob.substr(0, blob.size() - 1))));
+  EXPECT_FALSE(view.parse(to_span(blob + '\0')));
+}
+
+TEST(transaction_view, clsag)
+{
+  const cryptonote::transaction tx = make_clsag();
+  const cryptonote::blobdata blob = cryptonote::tx_to_blob(tx);
+  const crypto::hash hash = cryptonote::get_transaction_hash(tx);
+
+  cryptonote::transaction_view view;
+  ASSERT_TRUE(view.parse(to_span(blob)));
+  EXPECT_EQ(2u, view.version());
+  EXPECT_EQ(rct::RCTTypeCLSAG, view.rct_type());
+  EXPECT_EQ(12345u, view.rct_fee());
+  EXPECT_EQ(tx.prefix_size, view.prefix().size());
+  EXPECT_EQ(tx.unprunable_size, view.prefix().size() + view.base().size());
+  EXPECT_FALSE(view.prunable().empty());
+
+  EXPECT_EQ(cryptonote::get_transaction_prefix_hash(tx), view.get_prefix_hash());
+  EXPECT_EQ(hash, view.get_hash());
+
+  cryptonote::transaction copy;
+  ASSERT_TRUE(view.materialize(copy));
+  EXPECT_EQ(blob, cryptonote::tx_to_blob(copy));
+
+  // pruned blobs are hashed with the hash of the prunable data given separately
+  const crypto::hash prunable_hash = crypto::cn_fast_hash(view.prunable().data(), view.prunable().size());
+  const cryptonote::blobdata pruned = blob.substr(0, tx.unprunable_size);
+  ASSERT_TRUE(view.parse(to_span(pruned), true));
+  EXPECT_TRUE(view.is_pruned());
+  EXPECT_TRUE(view.prunable().empty());
+  EXPECT_EQ(hash, view.get_pruned_hash(prunable_hash));
+  EXPECT_THROW(view.get_hash(), std::exception);
+  ASSERT_TRUE(view.materialize(copy));
+  EXPECT_TRUE(copy.pruned);
+}
+
+TEST(transaction_view, invalid)
+{
+  const cryptonote::blobdata blob = cryptonote::tx_to_blob(make_clsag());
+
+  cryptonote::transaction_view view;
+  EXPECT_FALSE(view.parse(nullptr));
+  EXPECT_FALSE(view.parse(to_span(blob.substr(0, 20))));
+
+  cryptonote::blobdata bad_version = blob;
+  bad_version[0] = 3;
+  EXPECT_FALSE(view.parse(to_span(bad_version)));
+
+  cryptonote::transaction tx = make_clsag();
+  tx.rct_signatures.type = rct::RCTTypeNull;
+  tx.rct_signatures.ecdhInfo.clear();
+  tx.rct_signatures.outPk.clear();
+  const cryptonote::blobdata null_rct = cryptonote::tx_to_blob(tx);
+  ASSERT_TRUE(view.parse(to_span(null_rct)));
+  EXPECT_EQ(cryptonote::get_transaction_hash(tx), view.get_hash());
+  EXPECT_FALSE(view.parse(to_span(null_rct + '\0')));
+
+  // the prunable part is only checked when materialized
+  ASSERT_TRUE(view.parse(to_span(blob.substr(0, blob.size() - 1))));
+  cryptonote::transaction copy;
+  EXPECT_FALSE(view.materialize(copy));
+}
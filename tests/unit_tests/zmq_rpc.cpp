@@ -754,6 +754,82 @@ TEST_F(zmq_pub, JsonTxpoolWeakPtrSkip)
   EXPECT_NO_THROW(cryptonote::listener::zmq_pub::txpool_add{pub}(std::move(events)));
 }
 
+TEST_F(zmq_pub, BinFullMinerTemplate)
+{
+  static constexpr const char topic[] = "\1bin-full-miner_template";
+  static constexpr const char prefix[] = "bin-full-miner_template:";
+
+  ASSERT_TRUE(sub_request(topic));
+
+  const cryptonote::block block = make_block();
+  cryptonote::miner_template_event event{};
+  event.header = block;
+  event.height = 533;
+  event.difficulty = cryptonote::difficulty_type{1} << 70;
+  event.seed_hash = crypto::rand<crypto::hash>();
+  event.median_weight = 300000;
+  event.already_generated_coins = 1000;
+  event.txs_weight = 2000;
+  event.fee = 30;
+  event.tx_hashes = {crypto::rand<crypto::hash>(), crypto::rand<crypto::hash>(), crypto::rand<crypto::hash>()};
+  event.miner_tx_branch = cryptonote::get_miner_tx_tree_branch(event.tx_hashes);
+
+  EXPECT_NO_THROW(cryptonote::listener::zmq_pub::miner_template{pub}(event));
+  EXPECT_TRUE(pub->relay_to_pub(relay.get(), dummy_pub.get()));
+
+  const auto messages = get_messages(dummy_client.get());
+  ASSERT_EQ(1u, messages.size());
+  ASSERT_EQ(0u, messages.front().compare(0, sizeof(prefix) - 1, prefix));
+
+  cryptonote::miner_template_event actual{};
+  ASSERT_TRUE(cryptonote::t_serializable_object_from_blob(actual, messages.front().substr(sizeof(prefix) - 1)));
+  EXPECT_EQ(block.major_version, actual.header.major_version);
+  EXPECT_EQ(block.minor_version, actual.header.minor_version);
+  EXPECT_EQ(block.timestamp, actual.header.timestamp);
+  EXPECT_EQ(block.prev_id, actual.header.prev_id);
+  EXPECT_EQ(event.height, actual.height);
+  EXPECT_EQ(event.difficulty, actual.difficulty);
+  EXPECT_EQ(event.seed_hash, actual.seed_hash);
+  EXPECT_EQ(event.median_weight, actual.median_weight);
+  EXPECT_EQ(event.already_generated_coins, actual.already_generated_coins);
+  EXPECT_EQ(event.txs_weight, actual.txs_weight);
+  EXPECT_EQ(event.fee, actual.fee);
+  EXPECT_EQ(event.tx_hashes, actual.tx_hashes);
+  EXPECT_EQ(event.miner_tx_branch, actual.miner_tx_branch);
+}
+
+TEST_F(zmq_pub, BinMinerTemplateWeakPtrSkip)
+{
+  static constexpr const char topic[] = "\1bin";
+
+  ASSERT_TRUE(sub_request(topic));
+
+  pub.reset();
+  EXPECT_NO_THROW(cryptonote::listener::zmq_pub::miner_template{pub}(cryptonote::miner_template_event{}));
+}
+
+TEST_F(zmq_pub, MinerTemplateWanted)
+{
+  static constexpr const char other_topic[] = "\1json-full-miner_data";
+  static constexpr const char topic[] = "\1bin";
+  static constexpr const char unsubscribe[] = "\0bin";
+
+  EXPECT_FALSE(cryptonote::listener::zmq_pub::miner_template_wanted{pub}());
+
+  ASSERT_TRUE(sub_request(other_topic));
+  EXPECT_FALSE(cryptonote::listener::zmq_pub::miner_template_wanted{pub}());
+
+  ASSERT_TRUE(sub_request(topic));
+  EXPECT_TRUE(cryptonote::listener::zmq_pub::miner_template_wanted{pub}());
+
+  ASSERT_TRUE(sub_request(unsubscribe));
+  EXPECT_FALSE(cryptonote::listener::zmq_pub::miner_template_wanted{pub}());
+
+  ASSERT_TRUE(sub_request(topic));
+  pub.reset();
+  EXPECT_FALSE(cryptonote::listener::zmq_pub::miner_template_wanted{pub}());
+}
+
 TEST_F(zmq_server, pub)
 {
   subscribe("json-minimal");
@@ -454,6 +454,13 @@ class Daemon(object):
         }
         return self.rpc.send_request('/is_key_image_spent', is_key_image_spent)
 
+    def get_output_key_indices(self, output_keys = [], client = ""):
+        get_output_key_indices = {
+            'output_keys': output_keys,
+            'client': client,
+        }
+        return self.rpc.send_request('/get_output_key_indices', get_output_key_indices)
+
     def save_bc(self):
         save_bc = {
         }
@@ -567,11 +574,12 @@ class Daemon(object):
         }
         return self.rpc.send_json_rpc_request(get_txpool_backlog)
 
-    def prune_blockchain(self, check = False):
+    def prune_blockchain(self, check = False, background = False):
         prune_blockchain = {
             'method': 'prune_blockchain',
             'params': {
                 'check': check,
+                'background': background,
             },
             'jsonrpc': '2.0', 
             'id': '0'
@@ -668,3 +676,36 @@ class Daemon(object):
             'id': '0'
         }
         return self.rpc.send_json_rpc_request(rpc_access_account)
+
+    def login(self, address, view_key, create_account = False):
+        login = {
+            'address': address,
+            'view_key': view_key,
+            'create_account': create_account,
+        }
+        return self.rpc.send_request('/login', login)
+
+    def get_address_info(self, address, view_key):
+        get_address_info = {
+            'address': address,
+            'view_key': view_key,
+        }
+        return self.rpc.send_request('/get_address_info', get_address_info)
+
+    def get_address_txs(self, address, view_key):
+        get_address_txs = {
+            'address': address,
+            'view_key': view_key,
+        }
+        return self.rpc.send_request('/get_address_txs', get_address_txs)
+
+    def get_unspent_outs(self, address, view_key, amount = '0', mixin = 0, use_dust = False, dust_threshold = '0'):
+        get_unspent_outs = {
+            'amount': amount,
+            'address': address,
+            'view_key': view_key,
+            'mixin': mixin,
+            'use_dust': use_dust,
+            'dust_threshold': dust_threshold,
+        }
+        return self.rpc.send_request('/get_unspent_outs', get_unspent_outs)
@@ -392,6 +392,18 @@ class Wallet(object):
         }
         return self.rpc.send_json_rpc_request(refresh)
 
+    def refresh_wallets(self, wallets = [], autosave = True):
+        refresh_wallets = {
+            'method': 'refresh_wallets',
+            'params' : {
+                'wallets': wallets,
+                'autosave': autosave,
+            },
+            'jsonrpc': '2.0', 
+            'id': '0'
+        }
+        return self.rpc.send_json_rpc_request(refresh_wallets)
+
     def incoming_transfers(self, transfer_type='all', account_index = 0, subaddr_indices = []):
         incoming_transfers = {
             'method': 'incoming_transfers',